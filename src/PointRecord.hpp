@@ -0,0 +1,49 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef POINTRECORD_HPP
+#define POINTRECORD_HPP
+
+#include <stdint.h>
+#include <cstdio>
+
+/*!
+* \brief Fixed-width binary point record
+*
+* Binary equivalent of the "x y z quality intensity [horizontalUncertainty verticalUncertainty]" text lines
+* exchanged between georeference and data-cleaning. Uncertainties are NaN when they were not computed.
+* Records are 40 bytes long and written in the host's byte order.
+*/
+typedef struct {
+    double x;
+    double y;
+    double z;
+    uint32_t quality;
+    int32_t intensity;
+    float horizontalUncertainty;
+    float verticalUncertainty;
+} PointRecord;
+
+static_assert(sizeof(PointRecord) == 40, "PointRecord must be 40 bytes long");
+
+/**Number of points processed at once by the batch filters*/
+#define POINT_BATCH_SIZE 4096
+
+/**
+* Reads up to maxCount point records from a file. Returns the number of complete records read
+*
+* @param file the file to read from
+* @param records destination of the records
+* @param maxCount maximum number of records to read
+* @param truncated set to true if the input ended in the middle of a record
+*/
+inline unsigned int readPointRecords(FILE * file, PointRecord * records, unsigned int maxCount, bool & truncated){
+    size_t bytes = fread(records, 1, maxCount * sizeof(PointRecord), file);
+
+    truncated = (bytes % sizeof(PointRecord)) != 0;
+
+    return bytes / sizeof(PointRecord);
+}
+
+#endif
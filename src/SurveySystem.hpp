@@ -68,6 +68,11 @@ public:
     return positionAccuracy;
   }
 
+  /**Returns the sound speed accuracy (m/s), 0 if the file does not give it*/
+  double getSoundSpeedAccuracy() {
+    return soundSpeedAccuracy;
+  }
+
   /**
   * Change the Survey system values by reading a file
   * Return false if the file is not valid
@@ -106,6 +111,9 @@ private:
 
   /**Vector3d of the Survey system position accuracy*/
   Eigen::Vector3d positionAccuracy;
+
+  /**Value of the Survey system sound speed accuracy (m/s)*/
+  double soundSpeedAccuracy = 0;
 };
 
 SurveySystem::SurveySystem() {
@@ -133,6 +141,7 @@ bool SurveySystem::readFile(const std::string & fileName) {
 
   double PitchRollAcc, HeadingAcc;
   double PosHorAcc, PosVerAcc;
+  double SoundSpeedAcc = 0;
 
   //double Eroll = 0, Epitch = 0, Eyaw = 0, Rroll = 0, Rpitch = 0, Ryaw = 0, Mroll = 0, Mpitch = 0, Myaw = 0;
 
@@ -184,6 +193,8 @@ bool SurveySystem::readFile(const std::string & fileName) {
         in >> PitchRollAcc;
       } else if (type == "HeadingAccuracy") {
         in >> HeadingAcc;
+      } else if (type == "SoundSpeedAccuracy") {
+        in >> SoundSpeedAcc;
       } else if (type == "RollAlignment") {
         in >> Patch_Roll;
       } else if (type == "PitchAlignment") {
@@ -227,6 +238,8 @@ attitudeAccuracy = new Attitude(0,PitchRollAcc, PitchRollAcc, HeadingAcc);
 
 positionAccuracy << PosHorAcc, PosHorAcc, PosVerAcc;
 
+soundSpeedAccuracy = SoundSpeedAcc;
+
 return true;
 }
 }
@@ -11,6 +11,10 @@
 
 #include "../sidescan/SidescanPing.hpp"
 
+#include "../sidescan/SnippetPing.hpp"
+
+#include "../watercolumn/WaterColumnPing.hpp"
+
 /*!
 * \brief Datagram event handler class
 * \author Guillaume Morissette
@@ -75,6 +79,18 @@ public:
 	*/
 	virtual void processPing(uint64_t microEpoch,long id, double beamAngle,double tiltAngle,double twoWayTravelTime,uint32_t quality,int32_t intensity){};
 
+	/**
+	* Sounding already raytraced by the sonar, from the transducer, horizontal and vertical along the vessel heading
+	* @param microEpoch Timestamp
+	* @param id Ping id
+	* @param alongTrack distance in meters, POSITIVE forward
+	* @param acrossTrack distance in meters, NEGATIVE to port (left) side, POSITIVE to starboard (right) side
+	* @param depth depth in meters from the transducer, POSITIVE down
+	* @param quality Quality flag
+	* @param intensity Intensity flag
+	*/
+	virtual void processBeamXYZ(uint64_t microEpoch,long id,double alongTrack,double acrossTrack,double depth,uint32_t quality,int32_t intensity){};
+
 	/**
 	* Convention for Swath
 	*
@@ -91,6 +107,22 @@ public:
         
         
         virtual void processSidescanData(SidescanPing * ping){}
+
+        /**
+         * Processes the water column samples of a ping. The parser reuses the ping for the next one:
+         * copy what must be kept after the call
+         *
+         * @param ping the water column ping
+         */
+        virtual void processWaterColumnData(WaterColumnPing & ping){}
+
+        /**
+         * Processes the backscatter snippets of a ping. Their samples point into the datagram:
+         * copy what must be kept after the call
+         *
+         * @param ping the snippet ping
+         */
+        virtual void processSnippetData(SnippetPing & ping){}
         
 };
 
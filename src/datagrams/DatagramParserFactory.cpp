@@ -14,7 +14,7 @@
 DatagramParser * DatagramParserFactory::build(std::string & fileName,DatagramEventHandler & handler){
         DatagramParser * parser;
 
-        if(StringUtils::ends_with(fileName.c_str(),".all")){
+        if(StringUtils::ends_with(fileName.c_str(),".all") || StringUtils::ends_with(fileName.c_str(),".wcd")){
                 parser = new KongsbergParser(handler);
         }
         else if(StringUtils::ends_with(fileName.c_str(),".xtf")){
@@ -8,7 +8,7 @@
 #include "KongsbergParser.hpp"
 
 
-KongsbergParser::KongsbergParser(DatagramEventHandler & processor):DatagramParser(processor){
+KongsbergParser::KongsbergParser(DatagramEventHandler & processor):DatagramParser(processor),waterColumnCounter(0),waterColumnDatagrams(0),waterColumnPending(false){
 
 }
 
@@ -28,14 +28,21 @@ void KongsbergParser::parse(std::string & filename){
       if(elementsRead == 1){
         //Check for starting character in datagram
         if(hdr.stx==STX){
-          //Allocate memory for the datagram's content
-          unsigned char * buffer = (unsigned char*)malloc(hdr.size-sizeof(KongsbergHeader)+sizeof(uint32_t));
+          //The datagram's content, in a buffer that only grows: a large .wcd file is read in constant memory
+          size_t contentSize = hdr.size-sizeof(KongsbergHeader)+sizeof(uint32_t);
 
-          elementsRead = fread(buffer,hdr.size-sizeof(KongsbergHeader)+sizeof(uint32_t),1,file);
+          if(datagramBuffer.size() < contentSize){
+            datagramBuffer.resize(contentSize);
+          }
 
-          processDatagram(hdr,buffer);
+          elementsRead = fread(datagramBuffer.data(),contentSize,1,file);
 
-          free(buffer);
+          //truncated file
+          if(elementsRead != 1){
+            break;
+          }
+
+          processDatagram(hdr,datagramBuffer.data());
         }
         else{
           printf("%02x",hdr.size);
@@ -45,6 +52,8 @@ void KongsbergParser::parse(std::string & filename){
       }
     }
 
+    discardPartialWaterColumn();
+
     fclose(file);
   }
   else{
@@ -236,8 +245,16 @@ void KongsbergParser::processDatagram(KongsbergHeader & hdr,unsigned char * data
     processSoundSpeedProfile(hdr,datagram);
     break;
 
+    case 'X':
+    processXYZ88(hdr,datagram);
+    break;
+
     case 'Y':
-    //processSeabedImageData(hdr,datagram);
+    processSeabedImageData(hdr,datagram);
+    break;
+
+    case 'k':
+    processWaterColumn107(hdr,datagram);
     break;
 
     default:
@@ -346,7 +363,47 @@ void KongsbergParser::processQualityFactor(KongsbergHeader & hdr,unsigned char *
 }
 
 void KongsbergParser::processSeabedImageData(KongsbergHeader & hdr,unsigned char * datagram){
-  //printf("TODO: parse Seabed Image Data\n");
+  //content before ETX and checksum
+  uint64_t dataSize = hdr.size - sizeof(KongsbergHeader) + sizeof(uint32_t) - 3;
+
+  if(dataSize < sizeof(KongsbergSeabedImage89)){
+    throw new Exception("Truncated seabed image datagram");
+  }
+
+  KongsbergSeabedImage89 * data = (KongsbergSeabedImage89*)datagram;
+  KongsbergSeabedImage89Entry * entries = (KongsbergSeabedImage89Entry*)(datagram + sizeof(KongsbergSeabedImage89));
+
+  //the amplitudes of all the beams follow the beam entries
+  uint64_t position = sizeof(KongsbergSeabedImage89) + (uint64_t)data->nbValidBeams * sizeof(KongsbergSeabedImage89Entry);
+
+  if(position > dataSize){
+    throw new Exception("Truncated seabed image datagram");
+  }
+
+  snippetPing.reset(convertTime(hdr.date,hdr.time),hdr.counter,SNIPPET_INT16,false);
+
+  for(unsigned int i=0;i<data->nbValidBeams;i++){
+    if(position + (uint64_t)entries[i].nbSamples * sizeof(int16_t) > dataSize){
+      throw new Exception("Truncated seabed image datagram");
+    }
+
+    //no beam angle nor range in this datagram
+    SnippetBeam beam;
+    beam.beamNumber = i;
+    beam.beamAngle = NAN;
+    beam.firstSample = 0;
+    beam.detectionSample = entries[i].centreSampleNumber;
+    beam.reversed = entries[i].sortingDirection < 0;
+    beam.sampleCount = entries[i].nbSamples;
+    beam.samples = datagram + position;
+    beam.footprints = NULL;
+
+    snippetPing.addBeam(beam);
+
+    position += (uint64_t)entries[i].nbSamples * sizeof(int16_t);
+  }
+
+  processor.processSnippetData(snippetPing);
 }
 
 void KongsbergParser::processRawRangeAndBeam78(KongsbergHeader & hdr,unsigned char * datagram){
@@ -356,20 +413,135 @@ void KongsbergParser::processRawRangeAndBeam78(KongsbergHeader & hdr,unsigned ch
 
   processor.processSwathStart((double)data->surfaceSoundSpeed / (double)10);
 
-  std::map<int,KongsbergRangeAndBeam78TxEntry*>  txEntries;
+  //tx entries by sector number, NULL for the sectors the datagram doesn't have
+  KongsbergRangeAndBeam78TxEntry * txEntries[KONGSBERG_MAX_TX_SECTORS] = {NULL};
 
   KongsbergRangeAndBeam78TxEntry* tx = (KongsbergRangeAndBeam78TxEntry*) (((unsigned char *)data)+sizeof(KongsbergRangeAndBeam78));
 
   for(unsigned int i=0;i< data->nbTxPackets; i++){
-    txEntries[tx[i].txSectorNumber] = &tx[i];
+    if(tx[i].txSectorNumber < KONGSBERG_MAX_TX_SECTORS){
+      txEntries[tx[i].txSectorNumber] = &tx[i];
+    }
     //printf("Tilt: %0.2f\n",(double)tx[i].tiltAngle/(double)100);
   }
 
   KongsbergRangeAndBeam78RxEntry * rx = (KongsbergRangeAndBeam78RxEntry*)    ((((unsigned char *)data)+sizeof(KongsbergRangeAndBeam78)) + (data->nbTxPackets * sizeof(KongsbergRangeAndBeam78TxEntry)));
 
+  unsigned int unknownSectorBeams = 0;
+
   for(unsigned int i=0;i<data->nbRxPackets;i++){
+    KongsbergRangeAndBeam78TxEntry * txEntry = (rx[i].txSectorNumber < KONGSBERG_MAX_TX_SECTORS) ? txEntries[rx[i].txSectorNumber] : NULL;
+
+    //no tilt angle for this beam
+    if(txEntry == NULL){
+      unknownSectorBeams++;
+      continue;
+    }
+
     //We'll hack-in the the beam angle as ID...Hail Satan!
-    processor.processPing(microEpoch,rx[i].beamAngle,(double)rx[i].beamAngle/(double)100,(double)txEntries[rx[i].txSectorNumber]->tiltAngle/(double)100,rx[i].twoWayTravelTime,rx[i].qualityFactor,rx[i].reflectivity * 0.5);
+    processor.processPing(microEpoch,rx[i].beamAngle,(double)rx[i].beamAngle/(double)100,(double)txEntry->tiltAngle/(double)100,rx[i].twoWayTravelTime,rx[i].qualityFactor,rx[i].reflectivity * 0.5);
+  }
+
+  if(unknownSectorBeams > 0){
+    fprintf(stderr,"%d beams of ping #%d have an unknown transmit sector\n",unknownSectorBeams,hdr.counter);
+  }
+}
+
+void KongsbergParser::processXYZ88(KongsbergHeader & hdr,unsigned char * datagram){
+  //content before ETX and checksum
+  uint64_t dataSize = hdr.size - sizeof(KongsbergHeader) + sizeof(uint32_t) - 3;
+
+  if(dataSize < sizeof(KongsbergXYZ88)){
+    throw new Exception("Truncated XYZ 88 datagram");
+  }
+
+  KongsbergXYZ88 * data = (KongsbergXYZ88*)datagram;
+
+  if(sizeof(KongsbergXYZ88) + (uint64_t)data->nbBeams * sizeof(KongsbergXYZ88Entry) > dataSize){
+    throw new Exception("Truncated XYZ 88 datagram");
+  }
+
+  uint64_t microEpoch = convertTime(hdr.date,hdr.time);
+
+  processor.processSwathStart((double)data->soundSpeed / (double)10);
+
+  KongsbergXYZ88Entry * beams = (KongsbergXYZ88Entry*) (((unsigned char *)data)+sizeof(KongsbergXYZ88));
+
+  for(unsigned int i=0;i<data->nbBeams;i++){
+    //invalid detection
+    if(beams[i].detectionInfo & 0x80){
+      continue;
+    }
+
+    //intensity scaled as in the raw range and beam datagram
+    processor.processBeamXYZ(microEpoch,i,beams[i].alongTrack,beams[i].acrossTrack,beams[i].depth,beams[i].qualityFactor,beams[i].reflectivity * 0.5);
+  }
+}
+
+void KongsbergParser::processWaterColumn107(KongsbergHeader & hdr,unsigned char * datagram){
+  //content before ETX and checksum
+  uint64_t dataSize = hdr.size - sizeof(KongsbergHeader) + sizeof(uint32_t) - 3;
+
+  if(dataSize < sizeof(KongsbergWaterColumn107)){
+    throw new Exception("Truncated water column datagram");
+  }
+
+  KongsbergWaterColumn107 * data = (KongsbergWaterColumn107*)datagram;
+
+  //the datagrams of a ping follow each other, with the same counter
+  if(waterColumnPending && (hdr.counter != waterColumnCounter || data->datagramNumber != waterColumnDatagrams + 1)){
+    discardPartialWaterColumn();
+  }
+
+  if(!waterColumnPending){
+    //a ping starts at its first datagram
+    if(data->datagramNumber != 1){
+      return;
+    }
+
+    waterColumnPing.reset(convertTime(hdr.date,hdr.time),hdr.counter,(double)data->samplingFrequency / (double)100,0,1,true,false);
+    waterColumnCounter = hdr.counter;
+    waterColumnDatagrams = 0;
+    waterColumnPending = true;
+  }
+
+  uint64_t position = sizeof(KongsbergWaterColumn107) + (uint64_t)data->nbTxSectors * sizeof(KongsbergWaterColumn107TxEntry);
+
+  for(unsigned int i=0;i<data->nbRxBeams;i++){
+    if(position + sizeof(KongsbergWaterColumn107RxEntry) > dataSize){
+      throw new Exception("Truncated water column datagram");
+    }
+
+    KongsbergWaterColumn107RxEntry * beam = (KongsbergWaterColumn107RxEntry*)(datagram + position);
+    position += sizeof(KongsbergWaterColumn107RxEntry);
+
+    if(position + beam->nbSamples > dataSize){
+      throw new Exception("Truncated water column datagram");
+    }
+
+    float * magnitudes = waterColumnPing.addBeam(beam->beamNumber,(double)beam->beamAngle / (double)100,beam->nbSamples,beam->startRangeSampleNumber);
+    int8_t * amplitudes = (int8_t*)(datagram + position);
+
+    //in 0.5 dB
+    for(uint16_t j=0;j<beam->nbSamples;j++){
+      magnitudes[j] = amplitudes[j] * 0.5f;
+    }
+
+    position += beam->nbSamples;
+  }
+
+  waterColumnDatagrams++;
+
+  if(waterColumnDatagrams == data->nbDatagrams){
+    processor.processWaterColumnData(waterColumnPing);
+    waterColumnPending = false;
+  }
+}
+
+void KongsbergParser::discardPartialWaterColumn(){
+  if(waterColumnPending){
+    fprintf(stderr,"Incomplete water column for ping #%d: %d datagrams read\n",waterColumnCounter,waterColumnDatagrams);
+    waterColumnPending = false;
   }
 }
 
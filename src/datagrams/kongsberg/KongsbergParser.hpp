@@ -10,12 +10,14 @@
 #include <cstdio>
 #include <iostream>
 #include <cmath>
-#include <map>
+#include <vector>
 
 #include "../DatagramParser.hpp"
 #include "../../utils/NmeaUtils.hpp"
 #include "../../utils/TimeUtils.hpp"
 #include "../../utils/Exception.hpp"
+#include "../../watercolumn/WaterColumnPing.hpp"
+#include "../../sidescan/SnippetPing.hpp"
 #include "KongsbergTypes.hpp"
 
 /*!
@@ -37,7 +39,7 @@ public:
 
   //interface methods
   /**
-  * Read the file and loop through it
+  * Read the file and loop through it, a .all file or its .wcd water column companion
   *
   * @param filename name of the file to read
   */
@@ -96,7 +98,7 @@ private:
   void processQualityFactor(KongsbergHeader & hdr,unsigned char * datagram);
 
   /**
-  * Processes the Seabed Image Data
+  * Processes the Seabed Image Data, handing the snippets of the swath over without copying their samples
   *
   * @param hdr the Kongsberg header
   * @param datagram the datagram
@@ -120,6 +122,28 @@ private:
   */
   void processRawRangeAndBeam78(KongsbergHeader & hdr,unsigned char * datagram);
 
+  /**
+  * Processes the soundings raytraced by the sonar
+  *
+  * @param hdr the Kongsberg header
+  * @param datagram the datagram
+  */
+  void processXYZ88(KongsbergHeader & hdr,unsigned char * datagram);
+
+  /**
+  * Processes a water column datagram, adding its beams to the water column ping
+  * and handing the ping over once its last datagram is read
+  *
+  * @param hdr the Kongsberg header
+  * @param datagram the datagram
+  */
+  void processWaterColumn107(KongsbergHeader & hdr,unsigned char * datagram);
+
+  /**
+  * Drops the water column ping being assembled if some of its datagrams are missing
+  */
+  void discardPartialWaterColumn();
+
   /**
   * Returns the timestamp in microsecond
   *
@@ -132,6 +156,24 @@ private:
   * Returns a human readable name for a given datagram tag
   */
   /*std::string getName(int tag);*/
+
+  /**Content of the current datagram, after the header, reused from one datagram to the next*/
+  std::vector<unsigned char> datagramBuffer;
+
+  /**Water column ping, filled again for each ping*/
+  WaterColumnPing waterColumnPing;
+
+  /**Counter of the water column ping being assembled*/
+  uint16_t waterColumnCounter;
+
+  /**Number of datagrams of the water column ping read so far*/
+  uint16_t waterColumnDatagrams;
+
+  /**True while a water column ping waits for its other datagrams*/
+  bool waterColumnPending;
+
+  /**Snippet ping, filled again for each swath*/
+  SnippetPing snippetPing;
 };
 
 #endif
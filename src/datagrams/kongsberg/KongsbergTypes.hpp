@@ -12,6 +12,9 @@
 #define STX 0x02
 #define ETX 0x03
 
+//Transmit sectors of a ping, at most
+#define KONGSBERG_MAX_TX_SECTORS 20
+
 #pragma pack(1)
 typedef struct{
     uint32_t            size; //Size is computed starting from STX, so it excludes this one
@@ -111,5 +114,90 @@ typedef struct{
 #pragma pack()
 
 
+#pragma pack(1)
+typedef struct{
+    uint16_t		heading; //in 0.01 degrees
+    uint16_t		soundSpeed; //at the transducer, in dm/s
+    float		transmitTransducerDepth; //re water level at time of ping, in meters
+    uint16_t		nbBeams;
+    uint16_t		nbValidDetections;
+    float		samplingFrequency; //in Hz
+    uint8_t		scanningInfo;
+    uint8_t		spare[3];
+} KongsbergXYZ88;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct{
+    float		depth; //from the transmit transducer, in meters
+    float		acrossTrack; //in meters, positive to starboard
+    float		alongTrack; //in meters, positive forward
+    uint16_t		detectionWindowLength; //in samples
+    uint8_t		qualityFactor;
+    int8_t		incidenceAngleAdjustment; //in 0.1 degrees
+    uint8_t		detectionInfo; //bit 7 set if the detection is invalid
+    int8_t		realTimeCleaningInfo;
+    int16_t		reflectivity; //in 0.1 dB
+} KongsbergXYZ88Entry;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct{
+    uint16_t		nbDatagrams; //datagrams of the ping
+    uint16_t		datagramNumber; //1 to nbDatagrams
+    uint16_t		nbTxSectors;
+    uint16_t		totalNbRxBeams; //beams of the ping
+    uint16_t		nbRxBeams; //beams of this datagram
+    uint16_t		soundSpeed; //in dm/s
+    uint32_t		samplingFrequency; //in 0.01 Hz
+    int16_t		txTimeHeave; //in cm
+    uint8_t		tvgFunction;
+    int8_t		tvgOffset; //in dB
+    uint8_t		scanningInfo;
+    uint8_t		spare[3];
+} KongsbergWaterColumn107;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct{
+    int16_t		tiltAngle; //in 0.01 degrees
+    uint16_t		centreFrequency; //in 10 Hz
+    uint8_t		txSectorNumber;
+    uint8_t		spare;
+} KongsbergWaterColumn107TxEntry;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct{
+    int16_t		beamAngle; //in 0.01 degrees
+    uint16_t		startRangeSampleNumber;
+    uint16_t		nbSamples; //followed by the amplitudes, int8_t in 0.5 dB
+    uint16_t		detectedRange; //in samples
+    uint8_t		txSectorNumber;
+    uint8_t		beamNumber;
+} KongsbergWaterColumn107RxEntry;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct{
+    float		samplingFrequency; //in Hz
+    uint16_t		rangeToNormalIncidence; //in samples
+    int16_t		normalIncidenceBS; //in 0.1 dB
+    int16_t		obliqueBS; //in 0.1 dB
+    uint16_t		txBeamwidthAlong; //in 0.1 degrees
+    uint16_t		tvgLawCrossoverAngle; //in 0.1 degrees
+    uint16_t		nbValidBeams;
+} KongsbergSeabedImage89;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct{
+    int8_t		sortingDirection; //1 if the first sample is the nearest, -1 if it is the farthest
+    uint8_t		detectionInfo;
+    uint16_t		nbSamples;
+    uint16_t		centreSampleNumber; //bottom detection, in the samples of the beam
+} KongsbergSeabedImage89Entry;
+#pragma pack()
+
 
 #endif // KONGSBERGTYPES_HPP
@@ -7,9 +7,13 @@
 
 #include "S7kParser.hpp"
 #include "../../utils/Exception.hpp"
+#include "../../utils/ByteSum.hpp"
+#include <algorithm>
 
-S7kParser::S7kParser(DatagramEventHandler & processor) : DatagramParser(processor) {
-
+S7kParser::S7kParser(DatagramEventHandler & processor) : DatagramParser(processor), timeWindowStart(0), timeWindowEnd(UINT64_MAX), bathymetryDeferred(false), rawDetectionSeen(false), checksumVerification(S7K_CHECKSUM_ALWAYS), checksumFailureCount(0) {
+    for (unsigned int i = 0; i < S7K_SETTINGS_RING_SIZE; i++) {
+        pingSettingsPending[i] = false;
+    }
 }
 
 S7kParser::~S7kParser() {
@@ -19,84 +23,218 @@ S7kParser::~S7kParser() {
 void S7kParser::parse(std::string & filename) {
     FILE * file = fopen(filename.c_str(), "rb");
 
+    checksumFailureCount = 0;
+    bathymetryDeferred = false;
+    rawDetectionSeen = false;
+    beamAcrossTrackAngles.clear();
+    beamAlongTrackAngles.clear();
+
     if (file) {
-        S7kDataRecordFrame drf;
-
-        while (!feof(file)) {
-
-            //Read the DRF
-            int nbItemsRead = fread(&drf, sizeof (S7kDataRecordFrame), 1, file);
-
-            //Check that we read the required amount of data
-            if (nbItemsRead == 1) {
-
-                //Sanity check on the DRF
-                if (drf.SyncPattern == SYNC_PATTERN) {
-                    processDataRecordFrame(drf);
-
-                    int dataSectionSize = drf.Size - sizeof (S7kDataRecordFrame); // includes checksum
-                    unsigned char * data = (unsigned char*) malloc(dataSectionSize);
-
-                    //Now read in the data section and the checksum
-                    nbItemsRead = fread(data, dataSectionSize, 1, file);
-
-                    //We can haz data
-                    if (nbItemsRead == 1) {
-
-                        //Verify it
-                        uint32_t checksum = *((uint32_t*) & data[dataSectionSize - sizeof (uint32_t)]);
-                        uint32_t computedChecksum = computeChecksum(&drf, data);
-
-                        if (checksum == computedChecksum) {
-                            processor.processDatagramTag(drf.RecordTypeIdentifier);
-
-			    //Process data according to record type
-                            if (drf.RecordTypeIdentifier == 1016) {
-                                //Attitude
-                                processAttitudeDatagram(drf, data);
-                            }
-			    else if (drf.RecordTypeIdentifier == 1003) {
-                                //Position
-                                processPositionDatagram(drf, data);
-                            }
-			    else if(drf.RecordTypeIdentifier == 7027) {
-                                //Ping
-				processPingDatagram(drf, data);
-                            }
-			    else if(drf.RecordTypeIdentifier == 7000){
-				//Sonar settings
-				processSonarSettingsDatagram(drf,data);
-			    }
-			    else if(drf.RecordTypeIdentifier == 1010){
-				//CTD
-                                processCtdDatagram(drf,data);
-                            }
-                            //TODO: process other stuff
-
-                        } else {
-                            printf("Checksum error\n");
-                            //Checksum error...lets ignore the packet for now
-                            //throw new Exception("Checksum error");
-                            continue;
-                        }
+        //A selective read jumps from record to record of the file catalog, if the file has one
+        if ((recordTypeFilter.size() > 0 || hasTimeWindow()) && readCatalog(file)) {
+            for (unsigned int i = 0; i < catalog.size(); i++) {
+                if (isSelectedRecord(catalog[i].recordType, catalog[i].timestamp)) {
+                    if (fseek(file, catalog[i].offset, SEEK_SET) != 0) {
+                        throw new Exception("Read error");
                     }
 
-                    free(data);
-                } else {
-                    throw new Exception("Couldn't find sync pattern");
+                    processNextRecord(file);
                 }
-            }//Negative items mean something went wrong
-            else if (nbItemsRead < 0) {
-                throw new Exception("Read error");
             }
+        }
+        else {
+            fseek(file, 0, SEEK_SET);
+
+            while (processNextRecord(file)) {
+
+            }
+        }
+
+        processDeferredBathymetry();
+
+        fclose(file);
 
-            //zero bytes means EOF. Nothing to do
+        if (checksumFailureCount > 0) {
+            fprintf(stderr, "%u records skipped for a checksum error in %s\n", checksumFailureCount, filename.c_str());
         }
     } else {
         throw new Exception("File not found");
     }
 }
 
+bool S7kParser::processNextRecord(FILE * file) {
+    S7kDataRecordFrame drf;
+
+    //Read the DRF
+    int nbItemsRead = fread(&drf, sizeof (S7kDataRecordFrame), 1, file);
+
+    //Check that we read the required amount of data
+    if (nbItemsRead == 1) {
+
+        //Sanity check on the DRF
+        if (drf.SyncPattern != SYNC_PATTERN) {
+            throw new Exception("Couldn't find sync pattern");
+        }
+
+        if (drf.Size < sizeof (S7kDataRecordFrame) + sizeof (uint32_t)) {
+            throw new Exception("Invalid record size");
+        }
+
+        unsigned int dataSectionSize = drf.Size - sizeof (S7kDataRecordFrame); // includes checksum
+
+        //Records not selected are skipped unread
+        if (!isSelectedRecord(drf.RecordTypeIdentifier, drf.Timestamp)) {
+            if (fseek(file, dataSectionSize, SEEK_CUR) != 0) {
+                throw new Exception("Read error");
+            }
+
+            return true;
+        }
+
+        processDataRecordFrame(drf);
+
+        //Now read in the data section and the checksum, in a buffer reused from record to record
+        if (recordData.size() < dataSectionSize) {
+            recordData.resize(dataSectionSize);
+        }
+
+        unsigned char * data = &recordData[0];
+        nbItemsRead = fread(data, dataSectionSize, 1, file);
+
+        //We can haz data
+        if (nbItemsRead == 1) {
+
+            //Verify it
+            bool verify = checksumVerification == S7K_CHECKSUM_ALWAYS || (checksumVerification == S7K_CHECKSUM_SUBSCRIBED && isSubscribedRecord(drf.RecordTypeIdentifier));
+            uint32_t checksum = *((uint32_t*) & data[dataSectionSize - sizeof (uint32_t)]);
+
+            if (!verify || checksum == computeChecksum(&drf, data)) {
+                processor.processDatagramTag(drf.RecordTypeIdentifier);
+
+                //Process data according to record type
+                if (drf.RecordTypeIdentifier == 1016) {
+                    //Attitude
+                    processAttitudeDatagram(drf, data);
+                }
+                else if (drf.RecordTypeIdentifier == 1003) {
+                    //Position
+                    processPositionDatagram(drf, data);
+                }
+                else if(drf.RecordTypeIdentifier == 7027) {
+                    //Ping
+                    processPingDatagram(drf, data);
+                }
+                else if(drf.RecordTypeIdentifier == 7000){
+                    //Sonar settings
+                    processSonarSettingsDatagram(drf,data);
+                }
+                else if(drf.RecordTypeIdentifier == 7004){
+                    //Beam geometry
+                    processBeamGeometryDatagram(drf,data);
+                }
+                else if(drf.RecordTypeIdentifier == 7006){
+                    //Bathymetric data
+                    processBathymetricDatagram(drf,data);
+                }
+                else if(drf.RecordTypeIdentifier == 7042){
+                    //Compressed water column
+                    processWaterColumnDatagram(drf,data);
+                }
+                else if(drf.RecordTypeIdentifier == 7028 || drf.RecordTypeIdentifier == 7058){
+                    //Snippets
+                    processSnippetDatagram(drf,data);
+                }
+                else if(drf.RecordTypeIdentifier == 1010){
+                    //CTD
+                    processCtdDatagram(drf,data);
+                }
+                //TODO: process other stuff
+
+            } else {
+                //Checksum error...lets ignore the packet, the count is reported at the end
+                checksumFailureCount++;
+            }
+        }
+
+        return true;
+    }//Negative items mean something went wrong
+    else if (nbItemsRead < 0) {
+        throw new Exception("Read error");
+    }
+
+    //zero bytes means EOF
+    return false;
+}
+
+bool S7kParser::readCatalog(std::string & filename) {
+    FILE * file = fopen(filename.c_str(), "rb");
+
+    if (!file) {
+        throw new Exception("File not found");
+    }
+
+    bool found = readCatalog(file);
+
+    fclose(file);
+
+    return found;
+}
+
+bool S7kParser::readCatalog(FILE * file) {
+    catalog.clear();
+
+    //The file header, first record of the file, points at the catalog in its optional data
+    S7kDataRecordFrame drf;
+
+    if (fseek(file, 0, SEEK_SET) != 0 || fread(&drf, sizeof (S7kDataRecordFrame), 1, file) != 1 || drf.SyncPattern != SYNC_PATTERN || drf.RecordTypeIdentifier != 7200) {
+        return false;
+    }
+
+    S7kFileHeaderOptionalData catalogLocation;
+
+    if (drf.OptionalDataOffset < sizeof (S7kDataRecordFrame) + sizeof (S7kFileHeader) || drf.OptionalDataOffset + sizeof (S7kFileHeaderOptionalData) > drf.Size - sizeof (uint32_t)) {
+        return false;
+    }
+
+    if (fseek(file, drf.OptionalDataOffset, SEEK_SET) != 0 || fread(&catalogLocation, sizeof (S7kFileHeaderOptionalData), 1, file) != 1 || catalogLocation.Offset == 0) {
+        return false;
+    }
+
+    //The catalog record
+    S7kFileCatalogRTH header;
+
+    if (fseek(file, catalogLocation.Offset, SEEK_SET) != 0 || fread(&drf, sizeof (S7kDataRecordFrame), 1, file) != 1 || drf.SyncPattern != SYNC_PATTERN || drf.RecordTypeIdentifier != 7300) {
+        return false;
+    }
+
+    if (fread(&header, sizeof (S7kFileCatalogRTH), 1, file) != 1 || sizeof (S7kDataRecordFrame) + sizeof (S7kFileCatalogRTH) + header.numberOfRecords * (uint64_t) sizeof (S7kFileCatalogRD) + sizeof (uint32_t) > drf.Size) {
+        return false;
+    }
+
+    catalog.resize(header.numberOfRecords);
+
+    if (header.numberOfRecords > 0 && fread(&catalog[0], sizeof (S7kFileCatalogRD), header.numberOfRecords, file) != header.numberOfRecords) {
+        catalog.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool S7kParser::isSelectedRecord(uint32_t recordTypeIdentifier, S7kTime & timestamp) {
+    if (recordTypeFilter.size() > 0 && std::find(recordTypeFilter.begin(), recordTypeFilter.end(), recordTypeIdentifier) == recordTypeFilter.end()) {
+        return false;
+    }
+
+    if (hasTimeWindow()) {
+        uint64_t microEpoch = extractMicroEpoch(timestamp);
+
+        return microEpoch >= timeWindowStart && microEpoch <= timeWindowEnd;
+    }
+
+    return true;
+}
+
 std::string S7kParser::getName(int tag)
 {
     switch(tag)
@@ -378,19 +516,28 @@ void S7kParser::processDataRecordFrame(S7kDataRecordFrame & drf) {
 }
 
 uint32_t S7kParser::computeChecksum(S7kDataRecordFrame * drf, unsigned char * data) {
-    uint32_t checksum = 0;
-
     unsigned int dataSize = drf->Size - sizeof (S7kDataRecordFrame) - sizeof (uint32_t); //exclude checksum
 
-    for (unsigned int i = 0; i< sizeof (S7kDataRecordFrame); i++) {
-        checksum += (unsigned char) ((unsigned char*) drf)[i];
-    }
+    return ByteSum::sum((unsigned char*) drf, sizeof (S7kDataRecordFrame)) + ByteSum::sum(data, dataSize);
+}
 
-    for (unsigned int i = 0; i < dataSize; i++) {
-        checksum += (unsigned char) data[i];
-    }
+bool S7kParser::isSubscribedRecord(uint32_t recordTypeIdentifier) {
+    switch (recordTypeIdentifier) {
+        case 1003:
+        case 1010:
+        case 1016:
+        case 7000:
+        case 7004:
+        case 7006:
+        case 7027:
+        case 7028:
+        case 7042:
+        case 7058:
+            return true;
 
-    return checksum;
+        default:
+            return false;
+    }
 }
 
 void S7kParser::processAttitudeDatagram(S7kDataRecordFrame & drf, unsigned char * data) {
@@ -415,10 +562,287 @@ void S7kParser::processAttitudeDatagram(S7kDataRecordFrame & drf, unsigned char
 void S7kParser::processSonarSettingsDatagram(S7kDataRecordFrame & drf, unsigned char * data){
     S7kSonarSettings * settings = (S7kSonarSettings*)data;
 
-    S7kSonarSettings * settingsCopy = (S7kSonarSettings *)malloc(sizeof(S7kSonarSettings));
-    memcpy(settingsCopy,settings,sizeof(S7kSonarSettings));
+    //Overwrites, thus evicts, any settings of a ping never received
+    unsigned int slot = settings->sequentialNumber % S7K_SETTINGS_RING_SIZE;
+    memcpy(&pingSettings[slot],settings,sizeof(S7kSonarSettings));
+    pingSettingsPending[slot] = true;
+}
+
+void S7kParser::processBeamGeometryDatagram(S7kDataRecordFrame & drf, unsigned char * data){
+    S7kBeamGeometryRTH * geometry = (S7kBeamGeometryRTH*)data;
+
+    unsigned int dataSize = drf.Size - sizeof (S7kDataRecordFrame) - sizeof (uint32_t);
+
+    if(dataSize < sizeof(S7kBeamGeometryRTH) || sizeof(S7kBeamGeometryRTH) + 4 * sizeof(float) * (uint64_t)geometry->numberOfBeams > dataSize){
+	throw new Exception("Truncated beam geometry");
+    }
+
+    float * verticalAngles = (float*)(data + sizeof(S7kBeamGeometryRTH));
+    float * horizontalAngles = verticalAngles + geometry->numberOfBeams;
+
+    beamAcrossTrackAngles.resize(geometry->numberOfBeams);
+    beamAlongTrackAngles.resize(geometry->numberOfBeams);
 
-    pingSettings.push_back(settingsCopy);
+    for(unsigned int i = 0;i<geometry->numberOfBeams;i++){
+	beamAlongTrackAngles[i] = verticalAngles[i]*R2D;
+	beamAcrossTrackAngles[i] = horizontalAngles[i]*R2D;
+    }
+}
+
+void S7kParser::processBathymetricDatagram(S7kDataRecordFrame & drf, unsigned char * data){
+    if(rawDetectionSeen){
+	return;
+    }
+
+    //the previous ping had no raw detections either
+    processDeferredBathymetry();
+
+    unsigned int dataSize = drf.Size - sizeof (S7kDataRecordFrame) - sizeof (uint32_t);
+
+    if(dataSize < sizeof(S7kBathymetricDataRTH)){
+	throw new Exception("Truncated bathymetric data");
+    }
+
+    deferredBathymetryFrame = drf;
+    deferredBathymetry.assign(data,data + dataSize);
+    bathymetryDeferred = true;
+}
+
+void S7kParser::processDeferredBathymetry(){
+    if(!bathymetryDeferred){
+	return;
+    }
+
+    bathymetryDeferred = false;
+
+    S7kDataRecordFrame & drf = deferredBathymetryFrame;
+    unsigned char * data = &deferredBathymetry[0];
+    unsigned int dataSize = deferredBathymetry.size();
+
+    S7kBathymetricDataRTH * swath = (S7kBathymetricDataRTH*)data;
+    uint32_t nEntries = swath->numberOfReceiverBeams;
+
+    if(sizeof(S7kBathymetricDataRTH) + (2 * sizeof(float) + sizeof(uint8_t)) * (uint64_t)nEntries > dataSize){
+	throw new Exception("Truncated bathymetric data");
+    }
+
+    float * ranges = (float*)(data + sizeof(S7kBathymetricDataRTH));
+    uint8_t * quality = (uint8_t*)(ranges + nEntries);
+    float * intensities = (float*)(quality + nEntries);
+
+    //Beam angles from the beam geometry, or else from the optional data
+    S7kBathymetricDataODRD * optionalBeams = NULL;
+
+    if(drf.OptionalDataOffset >= sizeof(S7kDataRecordFrame)){
+	uint64_t optionalStart = drf.OptionalDataOffset - sizeof(S7kDataRecordFrame);
+
+	if(optionalStart + sizeof(S7kBathymetricDataOD) + sizeof(S7kBathymetricDataODRD) * (uint64_t)nEntries <= dataSize){
+		optionalBeams = (S7kBathymetricDataODRD*)(data + optionalStart + sizeof(S7kBathymetricDataOD));
+	}
+    }
+
+    bool hasGeometry = beamAcrossTrackAngles.size() == nEntries;
+
+    if(!hasGeometry && !optionalBeams){
+	fprintf(stderr,"No beam geometry for ping #%d\n",swath->pingNumber);
+	return;
+    }
+
+    uint64_t microEpoch = extractMicroEpoch(drf);
+
+    processor.processSwathStart(swath->soundVelocity);
+
+    for(unsigned int i = 0;i<nEntries;i++){
+	//no detection
+	if(!(ranges[i] > 0)){
+		continue;
+	}
+
+	double beamAngle;
+	double tiltAngle;
+
+	if(hasGeometry){
+		beamAngle = beamAcrossTrackAngles[i];
+		tiltAngle = beamAlongTrackAngles[i];
+	}
+	else{
+		//unit vector of the beam in the sonar frame (forward, starboard, down)
+		double forward = sin(optionalBeams[i].pointingAngle) * cos(optionalBeams[i].azimuthAngle);
+		double starboard = sin(optionalBeams[i].pointingAngle) * sin(optionalBeams[i].azimuthAngle);
+		double down = cos(optionalBeams[i].pointingAngle);
+
+		tiltAngle = asin(forward)*R2D;
+		beamAngle = atan2(starboard,down)*R2D;
+	}
+
+	processor.processPing(microEpoch,(long)i,beamAngle,tiltAngle,ranges[i],quality[i],intensities[i]);
+    }
+}
+
+void S7kParser::processWaterColumnDatagram(S7kDataRecordFrame & drf, unsigned char * data){
+    unsigned int dataSize = drf.Size - sizeof (S7kDataRecordFrame) - sizeof (uint32_t);
+
+    if(dataSize < sizeof(S7kCompressedWaterColumnRTH)){
+	throw new Exception("Truncated water column data");
+    }
+
+    S7kCompressedWaterColumnRTH * header = (S7kCompressedWaterColumnRTH*)data;
+
+    if(header->flags & S7K_WATERCOLUMN_32_BIT){
+	fprintf(stderr,"Unsupported 32 bit water column for ping #%d\n",header->pingNumber);
+	return;
+    }
+
+    bool magnitudeOnly = header->flags & S7K_WATERCOLUMN_MAGNITUDE_ONLY;
+    bool eightBit = header->flags & S7K_WATERCOLUMN_8_BIT;
+    bool segmentNumbers = header->flags & S7K_WATERCOLUMN_SEGMENT_NUMBERS;
+
+    unsigned int sampleStride = 1;
+
+    if(header->flags & S7K_WATERCOLUMN_DOWNSAMPLING_TYPE){
+	sampleStride = (header->flags & S7K_WATERCOLUMN_DOWNSAMPLING_DIVISOR) >> 4;
+
+	if(sampleStride < 1){
+		sampleStride = 1;
+	}
+    }
+
+    unsigned int valueSize = eightBit ? 1 : 2;
+    unsigned int sampleSize = magnitudeOnly ? valueSize : 2 * valueSize;
+    unsigned int beamHeaderSize = sizeof(uint16_t) + (segmentNumbers ? sizeof(uint8_t) : 0) + sizeof(uint32_t);
+
+    waterColumnPing.reset(extractMicroEpoch(drf),header->pingNumber,header->sampleRate,header->firstSample,sampleStride,eightBit,!magnitudeOnly);
+
+    uint64_t position = sizeof(S7kCompressedWaterColumnRTH);
+
+    for(unsigned int i = 0;i<header->beams;i++){
+	if(position + beamHeaderSize > dataSize){
+		throw new Exception("Truncated water column data");
+	}
+
+	uint16_t beamNumber = *((uint16_t*)(data + position));
+	uint32_t sampleCount = *((uint32_t*)(data + position + beamHeaderSize - sizeof(uint32_t)));
+	position += beamHeaderSize;
+
+	if(position + (uint64_t)sampleCount * sampleSize > dataSize){
+		throw new Exception("Truncated water column data");
+	}
+
+	//beam angle from the last beam geometry, if it has this beam
+	double beamAngle = beamNumber < beamAcrossTrackAngles.size() ? beamAcrossTrackAngles[beamNumber] : NAN;
+
+	float * magnitudes = waterColumnPing.addBeam(beamNumber,beamAngle,sampleCount);
+	float * phases = waterColumnPing.getPhases(i);
+	unsigned char * samples = data + position;
+
+	if(eightBit){
+		if(magnitudeOnly){
+			for(uint32_t j = 0;j<sampleCount;j++){
+				magnitudes[j] = samples[j];
+			}
+		}
+		else{
+			for(uint32_t j = 0;j<sampleCount;j++){
+				magnitudes[j] = samples[2*j];
+				phases[j] = (int8_t)samples[2*j+1];
+			}
+		}
+	}
+	else{
+		if(magnitudeOnly){
+			for(uint32_t j = 0;j<sampleCount;j++){
+				magnitudes[j] = *((uint16_t*)(samples + 2*j));
+			}
+		}
+		else{
+			for(uint32_t j = 0;j<sampleCount;j++){
+				magnitudes[j] = *((uint16_t*)(samples + 4*j));
+				phases[j] = *((int16_t*)(samples + 4*j + 2));
+			}
+		}
+	}
+
+	position += (uint64_t)sampleCount * sampleSize;
+    }
+
+    processor.processWaterColumnData(waterColumnPing);
+}
+
+void S7kParser::processSnippetDatagram(S7kDataRecordFrame & drf, unsigned char * data){
+    unsigned int dataSize = drf.Size - sizeof (S7kDataRecordFrame) - sizeof (uint32_t);
+
+    bool calibrated = drf.RecordTypeIdentifier == 7058;
+    unsigned int headerSize = calibrated ? sizeof(S7kCalibratedSnippetRTH) : sizeof(S7kSnippetRTH);
+
+    if(dataSize < headerSize){
+	throw new Exception("Truncated snippet data");
+    }
+
+    uint32_t pingNumber;
+    uint16_t nEntries;
+    bool footprints = false;
+    SnippetSampleType sampleType = SNIPPET_FLOAT32;
+    unsigned int sampleSize = sizeof(float);
+
+    if(calibrated){
+	S7kCalibratedSnippetRTH * header = (S7kCalibratedSnippetRTH*)data;
+	pingNumber = header->pingNumber;
+	nEntries = header->numberOfDetectionPoints;
+	footprints = header->flags & 1;
+    }
+    else{
+	S7kSnippetRTH * header = (S7kSnippetRTH*)data;
+	pingNumber = header->pingNumber;
+	nEntries = header->numberOfDetectionPoints;
+	sampleType = (header->flags & 1) ? SNIPPET_UINT32 : SNIPPET_UINT16;
+	sampleSize = (header->flags & 1) ? sizeof(uint32_t) : sizeof(uint16_t);
+    }
+
+    if(headerSize + (uint64_t)nEntries * sizeof(S7kSnippetRD) > dataSize){
+	throw new Exception("Truncated snippet data");
+    }
+
+    S7kSnippetRD * descriptors = (S7kSnippetRD*)(data + headerSize);
+
+    snippetPing.reset(extractMicroEpoch(drf),pingNumber,sampleType,calibrated);
+
+    //samples of each beam one after the other, then their footprints
+    uint64_t position = headerSize + (uint64_t)nEntries * sizeof(S7kSnippetRD);
+
+    for(unsigned int pass = 0;pass < (footprints ? 2 : 1);pass++){
+	for(unsigned int i = 0;i<nEntries;i++){
+		if(descriptors[i].snippetEnd < descriptors[i].snippetStart){
+			throw new Exception("Invalid snippet");
+		}
+
+		uint32_t sampleCount = descriptors[i].snippetEnd - descriptors[i].snippetStart + 1;
+
+		if(position + (uint64_t)sampleCount * sampleSize > dataSize){
+			throw new Exception("Truncated snippet data");
+		}
+
+		if(pass == 0){
+			SnippetBeam beam;
+			beam.beamNumber = descriptors[i].beamDescriptor;
+			beam.beamAngle = beam.beamNumber < beamAcrossTrackAngles.size() ? beamAcrossTrackAngles[beam.beamNumber] : NAN;
+			beam.firstSample = descriptors[i].snippetStart;
+			beam.detectionSample = descriptors[i].detectionSample;
+			beam.reversed = false;
+			beam.sampleCount = sampleCount;
+			beam.samples = data + position;
+			beam.footprints = NULL;
+
+			snippetPing.addBeam(beam);
+		}
+		else{
+			snippetPing.getBeam(i).footprints = (const float*)(data + position);
+		}
+
+		position += (uint64_t)sampleCount * sampleSize;
+	}
+    }
+
+    processor.processSnippetData(snippetPing);
 }
 
 void S7kParser::processPositionDatagram(S7kDataRecordFrame & drf, unsigned char * data) {
@@ -441,14 +865,22 @@ void S7kParser::processPingDatagram(S7kDataRecordFrame & drf, unsigned char * da
     double tiltAngle = swath->transmissionAngle*R2D;
     double samplingRate = swath->samplingRate;
 
+    //Raw detections supersede the bathymetric data of the same ping
+    rawDetectionSeen = true;
+
+    if(bathymetryDeferred && ((S7kBathymetricDataRTH*)&deferredBathymetry[0])->pingNumber == swath->pingNumber){
+	bathymetryDeferred = false;
+    }
+
+    processDeferredBathymetry();
+
     S7kSonarSettings * settings = NULL;
 
-    for(auto i=pingSettings.begin();i!=pingSettings.end();i++){
-	if((*i)->sequentialNumber==swath->pingNumber){
-		settings = (*i);
-                pingSettings.remove((*i));
-		break;
-	}
+    unsigned int slot = swath->pingNumber % S7K_SETTINGS_RING_SIZE;
+
+    if(pingSettingsPending[slot] && pingSettings[slot].sequentialNumber == swath->pingNumber){
+	settings = &pingSettings[slot];
+	pingSettingsPending[slot] = false;
     }
 
     if(settings){
@@ -462,8 +894,6 @@ void S7kParser::processPingDatagram(S7kDataRecordFrame & drf, unsigned char * da
 		double intensity = swath->dataFieldSize > 22 ? ping->signalStrength : 0; 
 		processor.processPing(microEpoch,(long)ping->beamDescriptor,(double)ping->receptionAngle*R2D,tiltAngle,twoWayTravelTime,ping->quality,intensity);
         }
-
-        free(settings);
     }
     else{
 	fprintf(stderr,"No settings for ping #%d\n",swath->pingNumber);
@@ -471,9 +901,13 @@ void S7kParser::processPingDatagram(S7kDataRecordFrame & drf, unsigned char * da
 }
 
 uint64_t S7kParser::extractMicroEpoch(S7kDataRecordFrame & drf) {
-    long microSeconds = drf.Timestamp.Seconds * 1e6;
+    return extractMicroEpoch(drf.Timestamp);
+}
+
+uint64_t S7kParser::extractMicroEpoch(S7kTime & timestamp) {
+    long microSeconds = timestamp.Seconds * 1e6;
 
-    uint64_t res = TimeUtils::build_time(drf.Timestamp.Year, drf.Timestamp.Day, drf.Timestamp.Hours, drf.Timestamp.Minutes, microSeconds);
+    uint64_t res = TimeUtils::build_time(timestamp.Year, timestamp.Day, timestamp.Hours, timestamp.Minutes, microSeconds);
 
     return res;
 }
@@ -6,13 +6,26 @@
 #define S7KPARSER_HPP
 
 #include <cstdio>
+#include <vector>
 #include "../DatagramParser.hpp"
 #include "S7kTypes.hpp"
 #include "../../utils/TimeUtils.hpp"
 #include "../../utils/Constants.hpp"
-#include <list>
 #include "../../svp/SoundVelocityProfile.hpp"
 
+/**Which records have their checksum verified*/
+enum S7kChecksumVerification{
+    /**No record is verified*/
+    S7K_CHECKSUM_NEVER,
+    /**Only the records decoded into events for the handler are verified*/
+    S7K_CHECKSUM_SUBSCRIBED,
+    /**Every record is verified*/
+    S7K_CHECKSUM_ALWAYS
+};
+
+/**Number of sonar settings records kept while waiting for their ping, each in slot ping number modulo this size*/
+#define S7K_SETTINGS_RING_SIZE 64
+
 /*!
  * \brief S7k parser class extention of Datagram parser
  * \author Guillaume Labbe-Morissette, Jordan McManus
@@ -40,6 +53,46 @@ public:
 
     std::string getName(int tag);
 
+    /**
+     * Sets which records have their checksum verified (default: S7K_CHECKSUM_ALWAYS). Records failing it are skipped
+     *
+     * @param verification the records to verify
+     */
+    void setChecksumVerification(S7kChecksumVerification verification){ checksumVerification = verification; }
+
+    /**Returns the number of records skipped for a checksum error by the last parse*/
+    unsigned int getChecksumFailureCount(){ return checksumFailureCount; }
+
+    /**
+     * Only decodes the records of these types (default: empty, all types). Sonar settings (7000) are needed to decode raw detections (7027)
+     *
+     * @param types the record type identifiers
+     */
+    void setRecordTypeFilter(const std::vector<uint32_t> & types){ recordTypeFilter = types; }
+
+    /**
+     * Only decodes the records timestamped within a time window (default: all)
+     *
+     * @param start the first timestamp, in microseconds since the epoch
+     * @param end the last timestamp, in microseconds since the epoch
+     */
+    void setTimeWindow(uint64_t start, uint64_t end){ timeWindowStart = start; timeWindowEnd = end; }
+
+    /**
+     * Reads the file catalog (7300), pointed at by the file header (7200), without decoding any other record.
+     * parse() uses the catalog, when the file has one, to seek directly to the records of the type filter and time window
+     *
+     * @param filename name of the file to read
+     * @return true if the file has a catalog
+     */
+    bool readCatalog(std::string & filename);
+
+    /**Returns the entries of the last catalog read, one per record of the file*/
+    const std::vector<S7kFileCatalogRD> & getCatalog(){ return catalog; }
+
+    /**Returns the number of records of the file, according to the last catalog read*/
+    unsigned int getRecordCount(){ return catalog.size(); }
+
 protected:
 
     /**
@@ -81,6 +134,39 @@ protected:
      */
     void processSonarSettingsDatagram(S7kDataRecordFrame & drf, unsigned char * data);
 
+    /**
+     * Processes the Beam geometry, giving the beam angles of the following Bathymetric data
+     *
+     * @param drf the S7k data record frame
+     * @param data the datagram
+     */
+    void processBeamGeometryDatagram(S7kDataRecordFrame & drf, unsigned char * data);
+
+    /**
+     * Processes the Bathymetric data. Older files only have these instead of Raw detection data: they are
+     * deferred until the next ping and dropped if a Raw detection data of the same ping follows
+     *
+     * @param drf the S7k data record frame
+     * @param data the datagram
+     */
+    void processBathymetricDatagram(S7kDataRecordFrame & drf, unsigned char * data);
+
+    /**
+     * Processes the Compressed water column data into the water column ping, reused from ping to ping
+     *
+     * @param drf the S7k data record frame
+     * @param data the datagram
+     */
+    void processWaterColumnDatagram(S7kDataRecordFrame & drf, unsigned char * data);
+
+    /**
+     * Processes the Snippet data or Calibrated snippet data into the snippet ping, its samples pointing into the datagram
+     *
+     * @param drf the S7k data record frame
+     * @param data the datagram
+     */
+    void processSnippetDatagram(S7kDataRecordFrame & drf, unsigned char * data);
+
     /**
      * Processes the Sound Velocity Profile base on the Ctd
      *
@@ -105,6 +191,16 @@ private:
      */
     uint32_t computeChecksum(S7kDataRecordFrame * drf, unsigned char * data);
 
+    /**
+     * Returns true if records of this type are decoded into events for the handler
+     *
+     * @param recordTypeIdentifier the record type
+     */
+    bool isSubscribedRecord(uint32_t recordTypeIdentifier);
+
+    /**Turns the deferred Bathymetric data, if any, into ping events*/
+    void processDeferredBathymetry();
+
     /**
      * Gets the S7k data record frame
      *
@@ -112,9 +208,90 @@ private:
      */
     uint64_t extractMicroEpoch(S7kDataRecordFrame & drf);
 
-    //TODO Use a map instead
-    /**List of ping settings*/
-    std::list<S7kSonarSettings *> pingSettings;
+    /**
+     * Returns the timestamp in microseconds since the epoch
+     *
+     * @param timestamp the S7k timestamp
+     */
+    uint64_t extractMicroEpoch(S7kTime & timestamp);
+
+    /**
+     * Reads and processes the record at the current position of the file
+     *
+     * @param file the file
+     * @return false at the end of the file
+     */
+    bool processNextRecord(FILE * file);
+
+    /**
+     * Reads the file catalog of an open file
+     *
+     * @param file the file
+     * @return true if the file has a catalog
+     */
+    bool readCatalog(FILE * file);
+
+    /**
+     * Returns true if a record passes the type filter and time window
+     *
+     * @param recordTypeIdentifier the record type
+     * @param timestamp the record timestamp
+     */
+    bool isSelectedRecord(uint32_t recordTypeIdentifier, S7kTime & timestamp);
+
+    /**Returns true if a time window is set*/
+    bool hasTimeWindow(){ return timeWindowStart > 0 || timeWindowEnd < UINT64_MAX; }
+
+    /**Sonar settings waiting for their ping, in slot sequentialNumber % S7K_SETTINGS_RING_SIZE. A newer record evicts an unmatched one*/
+    S7kSonarSettings pingSettings[S7K_SETTINGS_RING_SIZE];
+
+    /**True if the slot of pingSettings holds settings not yet matched with their ping*/
+    bool pingSettingsPending[S7K_SETTINGS_RING_SIZE];
+
+    /**Data section of the record being processed, reused from record to record*/
+    std::vector<unsigned char> recordData;
+
+    /**Record types decoded, all if empty*/
+    std::vector<uint32_t> recordTypeFilter;
+
+    /**First timestamp decoded*/
+    uint64_t timeWindowStart;
+
+    /**Last timestamp decoded*/
+    uint64_t timeWindowEnd;
+
+    /**Entries of the file catalog*/
+    std::vector<S7kFileCatalogRD> catalog;
+
+    /**Across track angles of the beams of the last Beam geometry, in degrees*/
+    std::vector<double> beamAcrossTrackAngles;
+
+    /**Along track angles of the beams of the last Beam geometry, in degrees*/
+    std::vector<double> beamAlongTrackAngles;
+
+    /**Water column ping, filled again for each ping*/
+    WaterColumnPing waterColumnPing;
+
+    /**Snippet ping, filled again for each ping*/
+    SnippetPing snippetPing;
+
+    /**Data record frame of the deferred Bathymetric data*/
+    S7kDataRecordFrame deferredBathymetryFrame;
+
+    /**Data section of the deferred Bathymetric data*/
+    std::vector<unsigned char> deferredBathymetry;
+
+    /**True if a Bathymetric data waits for the next ping*/
+    bool bathymetryDeferred;
+
+    /**True once the file gave a Raw detection data: Bathymetric data are then ignored*/
+    bool rawDetectionSeen;
+
+    /**Which records have their checksum verified*/
+    S7kChecksumVerification checksumVerification;
+
+    /**Number of records skipped for a checksum error*/
+    unsigned int checksumFailureCount;
 };
 
 
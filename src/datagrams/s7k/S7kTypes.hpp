@@ -88,6 +88,28 @@ typedef struct { // p. 103
 } S7kFileHeaderOptionalData;
 #pragma pack()
 
+#pragma pack(1)
+typedef struct { // p. 104
+    uint32_t size;
+    uint16_t version;
+    uint32_t numberOfRecords;
+    uint32_t reserved;
+} S7kFileCatalogRTH;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct { // p. 104, one per record of the file
+    uint32_t size;
+    uint64_t offset;       // from the start of the file
+    uint16_t recordType;
+    uint16_t deviceIdentifier;
+    uint16_t systemEnumerator;
+    S7kTime  timestamp;
+    uint32_t recordCount;
+    uint16_t reserved[8];
+} S7kFileCatalogRD;
+#pragma pack()
+
 #pragma pack(1)
 typedef struct { // pp 25-26
     uint32_t DatumIdentifier;
@@ -170,6 +192,55 @@ typedef struct { // pp 76-77
 } S7kRawDetectionDataRD;
 #pragma pack()
 
+#pragma pack(1)
+typedef struct { // p. 46
+    uint64_t sonarId;
+    uint32_t numberOfBeams;
+    // followed by 4 float arrays of numberOfBeams entries, in radians: vertical direction (along track),
+    // horizontal direction (across track), -3dB beam width along Y and along X
+} S7kBeamGeometryRTH;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct { // pp 47-48
+    uint64_t sonarId;
+    uint32_t pingNumber;
+    uint16_t multiPingSequence;
+    uint32_t numberOfReceiverBeams;
+    uint8_t  layerCompensationFlag;
+    uint8_t  soundVelocityFlag;
+    float    soundVelocity;
+    // followed by numberOfReceiverBeams float ranges (two-way travel time in seconds), uint8_t quality
+    // and float intensities, then the detection filter arrays of newer record versions
+} S7kBathymetricDataRTH;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct { // p. 49, at OptionalDataOffset from the start of the record
+    float    frequency;
+    double   latitude;
+    double   longitude;
+    float    heading;
+    uint8_t  heightSource;
+    float    tide;
+    float    roll;
+    float    pitch;
+    float    heave;
+    float    vehicleDepth;
+    // followed by one S7kBathymetricDataODRD per receiver beam
+} S7kBathymetricDataOD;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct { // p. 49
+    float depth;
+    float alongTrackDistance;
+    float acrossTrackDistance;
+    float pointingAngle;   // from vertical, in radians
+    float azimuthAngle;    // clockwise from forward, in radians
+} S7kBathymetricDataODRD;
+#pragma pack()
+
 #pragma pack(1)
 typedef struct { //pp 40-41
     uint64_t sonarId;
@@ -215,6 +286,75 @@ typedef struct { //pp 40-41
 } S7kSonarSettings;
 #pragma pack()
 
+#pragma pack(1)
+typedef struct { // pp 92-94
+    uint64_t sonarId;
+    uint32_t pingNumber;
+    uint16_t multiPingSequence;
+    uint16_t beams;
+    uint32_t samples;            // before downsampling
+    uint32_t compressedSamples;  // after downsampling
+    uint32_t flags;              // see the S7K_WATERCOLUMN_ masks
+    uint32_t firstSample;
+    float    sampleRate;
+    float    compressionFactor;
+    uint32_t reserved;
+    // followed by, for each beam: uint16_t beam number, uint8_t segment number if S7K_WATERCOLUMN_SEGMENT_NUMBERS,
+    // uint32_t number of samples, then the samples (magnitude, then phase unless S7K_WATERCOLUMN_MAGNITUDE_ONLY)
+} S7kCompressedWaterColumnRTH;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct { // pp 78-79
+    uint64_t sonarId;
+    uint32_t pingNumber;
+    uint16_t multiPingSequence;
+    uint16_t numberOfDetectionPoints;
+    uint8_t  errorFlag;
+    uint8_t  controlFlags;
+    uint32_t flags;          // bit 0: 32 bit samples
+    uint32_t reserved[6];
+    // followed by numberOfDetectionPoints S7kSnippetRD, then the samples of each beam
+} S7kSnippetRTH;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct { // p. 79, also used by the calibrated snippet data
+    uint16_t beamDescriptor;
+    uint32_t snippetStart;
+    uint32_t detectionSample;
+    uint32_t snippetEnd;
+} S7kSnippetRD;
+#pragma pack()
+
+#pragma pack(1)
+typedef struct { // pp 97-98
+    uint64_t sonarId;
+    uint32_t pingNumber;
+    uint16_t multiPingSequence;
+    uint16_t numberOfDetectionPoints;
+    uint8_t  errorFlag;
+    uint32_t controlFlags;
+    uint32_t flags;          // bit 0: footprint areas included
+    uint32_t reserved[6];
+    // followed by numberOfDetectionPoints S7kSnippetRD, then the float samples of each beam, then
+    // their float footprint areas if included
+} S7kCalibratedSnippetRTH;
+#pragma pack()
+
+/**Only magnitudes, phases stripped*/
+#define S7K_WATERCOLUMN_MAGNITUDE_ONLY    0x0002
+/**Magnitudes in dB on 8 bits, phases on 8 bits*/
+#define S7K_WATERCOLUMN_8_BIT             0x0004
+/**Downsampling divisor, bits 4 to 7*/
+#define S7K_WATERCOLUMN_DOWNSAMPLING_DIVISOR 0x00F0
+/**Downsampling type, none if 0, bits 8 to 11*/
+#define S7K_WATERCOLUMN_DOWNSAMPLING_TYPE 0x0F00
+/**32 bit samples*/
+#define S7K_WATERCOLUMN_32_BIT            0x1000
+/**Beams carry a segment number*/
+#define S7K_WATERCOLUMN_SEGMENT_NUMBERS   0x4000
+
 #pragma pack(1)
 typedef struct{
     float  soundVelocity;
@@ -0,0 +1,188 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef BORESIGHTCALIBRATION_CPP
+#define BORESIGHTCALIBRATION_CPP
+
+#ifdef _WIN32
+#include "../utils/getopt.h"
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <string>
+#include <iostream>
+#include <vector>
+#include <Eigen/Dense>
+#include "../georeferencing/BoresightCalibrator.hpp"
+#include "../datagrams/DatagramParserFactory.hpp"
+#include "../svp/CarisSvpFile.hpp"
+#include "../utils/Exception.hpp"
+
+using namespace std;
+
+/**Shows the usage information about boresight-calibration*/
+void printUsage(){
+    std::cerr << "\n\
+  NAME\n\n\
+     boresight-calibration - Finds the boresight angles that make the lines of a patch test agree\n\n\
+  SYNOPSIS\n \
+       boresight-calibration [-x lever_arm_x] [-y lever_arm_y] [-z lever_arm_z] [-r roll_angle] [-p pitch_angle] [-h heading_angle] [-s svp_file] [-c cell_size] [-n min_soundings] [-t threads] file1 file2 ...\n\n\
+  DESCRIPTION\n \
+       Raytraces every beam of the lines once, then searches the roll, pitch and heading boresight angles (degrees) minimizing\n \
+       the mean square depth difference between the lines, gridded in a local geographic frame. Reciprocal lines over a\n \
+       flat seafloor give roll, over a slope pitch, and parallel lines over a feature heading.\n\n \
+       -r -p -h Initial boresight angles (default: 0)\n \
+       -s Use the sound velocity profiles of a CARIS SVP file instead of those of the lines\n \
+       -c Size of the grid cells the lines are compared on (default: 1)\n \
+       -n Number of soundings of each line a cell needs to be compared (default: 1)\n \
+       -t Number of threads (default: one per hardware thread)\n\n \
+  Copyright 2017-2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés" << std::endl;
+    exit(1);
+}
+
+/**
+ * Finds the boresight angles of the patch test lines given as parameters
+ *
+ * @param argc number of parameter
+ * @param argv value of the parameters
+ */
+int main(int argc,char** argv){
+    double leverArmX = 0.0;
+    double leverArmY = 0.0;
+    double leverArmZ = 0.0;
+    double roll = 0.0;
+    double pitch = 0.0;
+    double heading = 0.0;
+    double cellSize = 1.0;
+    unsigned int minimumSoundings = 1;
+    unsigned int threadCount = 0;
+    std::string svpFilename;
+    CarisSvpFile svps;
+
+    int index;
+    while((index=getopt(argc,argv,"x:y:z:r:p:h:s:c:n:t:"))!=-1)
+    {
+        switch(index)
+        {
+            case 'x':
+                if(sscanf(optarg,"%lf", &leverArmX) != 1)
+                {
+                    std::cerr << "Error: -x invalid lever arm X offset" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'y':
+                if(sscanf(optarg,"%lf", &leverArmY) != 1)
+                {
+                    std::cerr << "Error: -y invalid lever arm Y offset" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'z':
+                if(sscanf(optarg,"%lf", &leverArmZ) != 1)
+                {
+                    std::cerr << "Error: -z invalid lever arm Z offset" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'r':
+                if(sscanf(optarg,"%lf", &roll) != 1)
+                {
+                    std::cerr << "Error: -r invalid roll angle" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'p':
+                if(sscanf(optarg,"%lf", &pitch) != 1)
+                {
+                    std::cerr << "Error: -p invalid pitch angle" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'h':
+                if(sscanf(optarg,"%lf", &heading) != 1)
+                {
+                    std::cerr << "Error: -h invalid heading angle" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 's':
+                svpFilename = optarg;
+                if(!svps.readSvpFile(svpFilename))
+                {
+                    std::cerr << "Error: -s invalid SVP file" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'c':
+                if(sscanf(optarg,"%lf", &cellSize) != 1 || !(cellSize > 0))
+                {
+                    std::cerr << "Error: -c invalid cell size" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'n':
+                if(sscanf(optarg,"%u", &minimumSoundings) != 1)
+                {
+                    std::cerr << "Error: -n invalid number of soundings" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 't':
+                if(sscanf(optarg,"%u", &threadCount) != 1)
+                {
+                    std::cerr << "Error: -t invalid number of threads" << std::endl;
+                    printUsage();
+                }
+            break;
+        }
+    }
+
+    if(argc - optind < 2){
+        printUsage();
+    }
+
+    try{
+        BoresightCalibrator calibrator(cellSize,minimumSoundings,threadCount);
+
+        for(int i=optind;i<argc;i++){
+            std::string fileName(argv[i]);
+            DatagramParser * parser = DatagramParserFactory::build(fileName,calibrator.addLine());
+
+            std::cerr << "[+] Decoding " << fileName << std::endl;
+            parser->parse(fileName);
+
+            delete parser;
+        }
+
+        Eigen::Vector3d leverArm;
+        leverArm << leverArmX,leverArmY,leverArmZ;
+
+        calibrator.calibrate(leverArm,svps.getSvps(),roll,pitch,heading);
+
+        std::cerr << "[+] " << calibrator.getEvaluationCount() << " evaluations, " << calibrator.getComparedCellCount() << " compared cells" << std::endl;
+
+        printf("-r %.4f -p %.4f -h %.4f\n",roll,pitch,heading);
+    }
+    catch(Exception * error){
+        std::cerr << "[-] Error while calibrating the boresight: " << error->what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
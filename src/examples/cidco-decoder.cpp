@@ -7,6 +7,7 @@
 
 #include "../datagrams/DatagramParserFactory.hpp"
 #include "../svp/CarisSvpFile.hpp"
+#include "../utils/TextOutputBuffer.hpp"
 #include <iostream>
 #include <string>
 
@@ -51,8 +52,20 @@ private:
 	/**The current Surface sound speed*/
 	double            currentSurfaceSoundSpeed;
 
+	/**Buffered output of the heading file*/
+	TextOutputBuffer headingOutput;
+
+	/**Buffered output of the pitch roll file*/
+	TextOutputBuffer pitchRollOutput;
+
+	/**Buffered output of the position file*/
+	TextOutputBuffer positionOutput;
+
+	/**Buffered output of the multi beam file*/
+	TextOutputBuffer multibeamOutput;
+
 	/**Text value who the information of the pings*/
-	std::stringstream pingLine;
+	TextOutputBuffer pingLine;
 
 	/**Number of beams*/
 	int	          nbBeams = 0;
@@ -69,13 +82,22 @@ public:
 		pitchRollFile = fopen("PitchRoll.txt","w");
 		positionFile = fopen("AntPosition.txt","w");
 		multibeamFile = fopen("Multibeam.txt","w");
-		pingLine.precision(10);
+
+		headingOutput.setFile(headingFile);
+		pitchRollOutput.setFile(pitchRollFile);
+		positionOutput.setFile(positionFile);
+		multibeamOutput.setFile(multibeamFile);
 	}
 
 	/**Destroy the datagram printer and close all the files*/
 	~DatagramPrinter(){
 		//last pingLine didnt get printed
-		fprintf(multibeamFile,"%.6f\t%0.7f\t%d%s\n",microEpoch2daySeconds(currentMicroEpoch), currentSurfaceSoundSpeed, nbBeams,pingLine.str().c_str());
+		writeSwath(currentSurfaceSoundSpeed,pingLine.data(),pingLine.size());
+
+		headingOutput.flush();
+		pitchRollOutput.flush();
+		positionOutput.flush();
+		multibeamOutput.flush();
 
 		fclose(headingFile);
 		fclose(pitchRollFile);
@@ -93,8 +115,19 @@ public:
 	*/
 	void processAttitude(uint64_t microEpoch,double heading,double pitch,double roll){
 		//CIDCO file format separates these 2...
-		fprintf(pitchRollFile, "%.6f\t%.10lf\t%.10lf\n",microEpoch2daySeconds(microEpoch),pitch,roll);
-		fprintf(headingFile, "%.6f\t%.10lf\n",microEpoch2daySeconds(microEpoch),heading);
+		double daySeconds = microEpoch2daySeconds(microEpoch);
+
+		pitchRollOutput.appendFixed(daySeconds,6);
+		pitchRollOutput.appendChar('\t');
+		pitchRollOutput.appendFixed(pitch,10);
+		pitchRollOutput.appendChar('\t');
+		pitchRollOutput.appendFixed(roll,10);
+		pitchRollOutput.appendChar('\n');
+
+		headingOutput.appendFixed(daySeconds,6);
+		headingOutput.appendChar('\t');
+		headingOutput.appendFixed(heading,10);
+		headingOutput.appendChar('\n');
 	};
 
 	/**
@@ -106,7 +139,14 @@ public:
 	* @param height the position ellipsoidal height
 	*/
 	void processPosition(uint64_t microEpoch,double longitude,double latitude,double height){
-		fprintf(positionFile, "%.6f\t%.10lf\t%.10lf\t%.10lf\n",microEpoch2daySeconds(microEpoch),latitude,longitude,height);
+		positionOutput.appendFixed(microEpoch2daySeconds(microEpoch),6);
+		positionOutput.appendChar('\t');
+		positionOutput.appendFixed(latitude,10);
+		positionOutput.appendChar('\t');
+		positionOutput.appendFixed(longitude,10);
+		positionOutput.appendChar('\t');
+		positionOutput.appendFixed(height,10);
+		positionOutput.appendChar('\n');
 	};
 
 	/**
@@ -123,7 +163,12 @@ public:
 	void processPing(uint64_t microEpoch,long id, double beamAngle,double tiltAngle,double twoWayTravelTime,uint32_t quality,int32_t intensity){
 		currentMicroEpoch = microEpoch;
 		nbBeams++;
-		pingLine << "\t" << twoWayTravelTime << "\t" << beamAngle << "\t" << tiltAngle;
+		pingLine.appendChar('\t');
+		pingLine.appendGeneral(twoWayTravelTime,10);
+		pingLine.appendChar('\t');
+		pingLine.appendGeneral(beamAngle,10);
+		pingLine.appendChar('\t');
+		pingLine.appendGeneral(tiltAngle,10);
 	};
 
 	/**
@@ -134,13 +179,30 @@ public:
 	void processSwathStart(double surfaceSoundSpeed){
 		currentSurfaceSoundSpeed = surfaceSoundSpeed;
 		if(nbBeams > 0){
-			std::string cleanPingLine = StringUtils::trim(pingLine.str());
-			fprintf(multibeamFile,"%.6f\t%0.7f\t%d\t%s\n",microEpoch2daySeconds(currentMicroEpoch), surfaceSoundSpeed, nbBeams, cleanPingLine.c_str());
-			pingLine.str(std::string());
+			//the ping line starts with a separator, which is written as part of the swath header
+			writeSwath(surfaceSoundSpeed,pingLine.data(),pingLine.size());
+			pingLine.clear();
 			nbBeams=0;
 		}
 	};
 
+	/**
+	* Write a swath line (time, surface sound speed, number of beams, beams) on the multibeamFile
+	*
+	* @param surfaceSoundSpeed the surface sound speed
+	* @param beams the beams, each one preceded by a tab
+	* @param length the length of the beams text
+	*/
+	void writeSwath(double surfaceSoundSpeed,const char * beams,size_t length){
+		multibeamOutput.appendFixed(microEpoch2daySeconds(currentMicroEpoch),6);
+		multibeamOutput.appendChar('\t');
+		multibeamOutput.appendFixed(surfaceSoundSpeed,7);
+		multibeamOutput.appendChar('\t');
+		multibeamOutput.appendInteger(nbBeams);
+		multibeamOutput.appendString(beams,length);
+		multibeamOutput.appendChar('\n');
+	}
+
 	/**
 	* Make a file who contain the informations of a sound velocity profile
 	*
@@ -21,10 +21,16 @@
 #include <iostream>
 #include <Eigen/Dense>
 #include <fstream>
+#include <vector>
+#include <cmath>
 #include "../math/Interpolation.hpp"
 #include "../filter/QualityFilter.hpp"
 #include "../filter/IntensityFilter.hpp"
 #include "../filter/InsanePositionFilter.hpp"
+#include "../filter/FilterChain.hpp"
+#include "../filter/GridOutlierFilter.hpp"
+#include "../utils/TextOutputBuffer.hpp"
+#include "../PointRecord.hpp"
 
 using namespace std;
 
@@ -34,12 +40,58 @@ void printUsage(){
   NAME\n\n\
      data-cleaning - Filtre les points d'un nuage\n\n\
   SYNOPSIS\n \
-	   data-cleaning [-q QualityFilter] [-i IntensityFilter]\n\n\
-  DESCRIPTION\n\n \
+	   data-cleaning [-q QualityFilter] [-i IntensityFilter] [-g cellSize] [-k threshold] [-b] [-B]\n\n\
+  DESCRIPTION\n \
+	-g Reject depth outliers against the median of a grid of cells of the given size (reads all points before writing)\n \
+	-k Number of robust standard deviations beyond which the grid filter rejects a point (default: 3)\n \
+	-b Read binary point records (x,y,z as doubles, quality as uint32, intensity as int32, uncertainties as floats) instead of text\n \
+	-B Write binary point records instead of text\n\n \
   Copyright 2017-2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés" << std::endl;
 	exit(1);
 }
 
+/**
+ * Write the kept points of a batch
+ *
+ * @param output the output buffer
+ * @param points the points
+ * @param keepMask one bit per point, set if the point is kept
+ * @param binaryOutput true to write binary records instead of text
+ */
+void writePoints(TextOutputBuffer & output,const PointBatch & points,const uint64_t * keepMask,bool binaryOutput){
+        for(unsigned int i=0;i<points.count;i++){
+            if(!FilterChain::isKept(keepMask,i)){
+                continue;
+            }
+
+            if(binaryOutput){
+                PointRecord record = points.getRecord(i);
+                output.appendString((const char *)&record,sizeof(PointRecord));
+            }
+            else{
+                output.appendFixed(points.x[i],6);
+                output.appendChar(' ');
+                output.appendFixed(points.y[i],6);
+                output.appendChar(' ');
+                output.appendFixed(points.z[i],6);
+                output.appendChar(' ');
+                output.appendInteger((int32_t)points.quality[i]);
+                output.appendChar(' ');
+                output.appendInteger(points.intensity[i]);
+
+                //uncertainties are passed through when the input has them
+                if(!std::isnan(points.horizontalUncertainty[i])){
+                    output.appendChar(' ');
+                    output.appendFixed(points.horizontalUncertainty[i],6);
+                    output.appendChar(' ');
+                    output.appendFixed(points.verticalUncertainty[i],6);
+                }
+
+                output.appendChar('\n');
+            }
+        }
+}
+
 /**
  * Filter all points received on standard input
  *
@@ -51,14 +103,18 @@ int main(int argc,char** argv){
 	std::string line;
 
 	//Filter chain
-	std::list<PointFilter *> filters;
-        filters.push_back(new InsanePositionFilter());
+	FilterChain filters;
+        filters.addFilter(new InsanePositionFilter());
 
 	//TODO: load desired filters and parameters from command line
         int index;
         int quality;
         int intensity;
-        while((index=getopt(argc,argv,"q:i:"))!=-1)
+        double cellSize = 0;
+        double gridThreshold = 3.0;
+        bool binaryInput = false;
+        bool binaryOutput = false;
+        while((index=getopt(argc,argv,"q:i:g:k:bB"))!=-1)
         {
             switch(index)
             {
@@ -70,7 +126,7 @@ int main(int argc,char** argv){
                     }
                     else
                     {
-                        filters.push_back(new QualityFilter(quality));
+                        filters.addFilter(new QualityFilter(quality));
                     }
                 break;
 
@@ -82,36 +138,130 @@ int main(int argc,char** argv){
                     }
                     else
                     {
-                        filters.push_back(new IntensityFilter(intensity));
+                        filters.addFilter(new IntensityFilter(intensity));
+                    }
+                break;
+
+                case 'g':
+                    if(sscanf(optarg,"%lf", &cellSize) != 1 || cellSize <= 0)
+                    {
+                        std::cerr << "Error: -g invalid cell size parameter" << std::endl;
+                        printUsage();
+                    }
+                break;
+
+                case 'k':
+                    if(sscanf(optarg,"%lf", &gridThreshold) != 1 || gridThreshold <= 0)
+                    {
+                        std::cerr << "Error: -k invalid threshold parameter" << std::endl;
+                        printUsage();
                     }
                 break;
+
+                case 'b':
+                    binaryInput = true;
+                break;
+
+                case 'B':
+                    binaryOutput = true;
+                break;
             }
         }
+        TextOutputBuffer output(stdout);
+        std::vector<PointRecord> records(POINT_BATCH_SIZE);
+        PointBatch points;
+
+        //The grid filter needs every point before it can classify any: keep the survivors of the other filters aside
+        FilterChain gridFilters;
+        GridOutlierFilter * gridFilter = NULL;
+        FILE * spool = NULL;
+
+        if(cellSize > 0){
+            gridFilter = new GridOutlierFilter(cellSize,gridThreshold);
+            gridFilters.addFilter(gridFilter);
+
+            spool = tmpfile();
+
+            if(!spool){
+                std::cerr << "Error: cannot create temporary file for the grid filter" << std::endl;
+                return 1;
+            }
+        }
+
         unsigned int lineCount = 1;
-        while((std::getline(std::cin,line))&&(line!="0")){
-            double x,y,z;
-            uint32_t quality;
-            uint32_t intensity;
-
-            if(sscanf(line.c_str(),"%lf %lf %lf %d %d",&x,&y,&z,&quality,&intensity)==5){
-		bool doFilter = false;
-
-			//Apply filter chain
-		for(auto i = filters.begin();i!= filters.end();i++){
-                    if( (*i)->filterPoint(0,x,y,z,quality,intensity) ){
-			doFilter = true;
+        bool endOfInput = false;
+
+        while(!endOfInput){
+            points.clear();
+
+            if(binaryInput){
+                bool truncated;
+                unsigned int count = readPointRecords(stdin,&records[0],POINT_BATCH_SIZE,truncated);
+                points.setRecords(&records[0],count);
+                endOfInput = (count < POINT_BATCH_SIZE);
+
+                if(truncated){
+                    std::cerr << "Error: truncated record at end of input" << std::endl;
+                }
+            }
+            else{
+                while(points.count < POINT_BATCH_SIZE){
+                    if(!std::getline(std::cin,line) || line=="0"){
+                        endOfInput = true;
                         break;
                     }
-		}
 
-		if(!doFilter){
-                    printf("%.6lf %.6lf %.6lf %d %d\n",x,y,z,quality,intensity);
-		}
+                    double x,y,z;
+                    uint32_t quality;
+                    int32_t intensity;
+                    float horizontalUncertainty,verticalUncertainty;
+
+                    int fields = sscanf(line.c_str(),"%lf %lf %lf %u %d %f %f",&x,&y,&z,&quality,&intensity,&horizontalUncertainty,&verticalUncertainty);
+
+                    if(fields==5){
+                        points.add(x,y,z,quality,intensity);
+                    }
+                    else if(fields==7){
+                        points.add(x,y,z,quality,intensity,horizontalUncertainty,verticalUncertainty);
+                    }
+                    else{
+                        std::cerr << "Error at line " << lineCount << std::endl;
+                    }
+                    lineCount++;
+                }
+            }
+
+            //Apply filter chain
+            const uint64_t * keepMask = filters.apply(points);
+
+            if(gridFilter){
+                gridFilter->accumulate(points,keepMask);
+
+                for(unsigned int i=0;i<points.count;i++){
+                    if(FilterChain::isKept(keepMask,i)){
+                        PointRecord record = points.getRecord(i);
+                        fwrite(&record,sizeof(PointRecord),1,spool);
+                    }
+                }
             }
             else{
-		std::cerr << "Error at line " << lineCount << std::endl;
+                writePoints(output,points,keepMask,binaryOutput);
             }
-            lineCount++;
+        }
+
+        if(gridFilter){
+            gridFilter->reduce();
+            rewind(spool);
+
+            unsigned int count;
+            bool truncated;
+
+            while((count = readPointRecords(spool,&records[0],POINT_BATCH_SIZE,truncated)) > 0){
+                points.setRecords(&records[0],count);
+                writePoints(output,points,gridFilters.apply(points),binaryOutput);
+            }
+
+            fclose(spool);
         }
     }
 #endif
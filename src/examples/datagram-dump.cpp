@@ -85,6 +85,21 @@ public:
 		printf("X %lu %lu %.10lf %.10lf %.10f %u %d\n",microEpoch,id,beamAngle,tiltAngle,twoWayTravelTime,quality,intensity);
 	};
 
+	/**
+	* Shows the information of a sounding raytraced by the sonar
+	*
+	* @param microEpoch the ping timestamp
+	* @param id the ping id
+	* @param alongTrack the along track distance
+	* @param acrossTrack the across track distance
+	* @param depth the depth from the transducer
+	* @param quality the ping quality
+	* @param intensity the ping intensity
+	*/
+	void processBeamXYZ(uint64_t microEpoch,long id,double alongTrack,double acrossTrack,double depth,uint32_t quality,int32_t intensity){
+		printf("Z %lu %lu %.6lf %.6lf %.6lf %u %d\n",microEpoch,id,alongTrack,acrossTrack,depth,quality,intensity);
+	};
+
 	/**
 	* Shows the information of a swath
 	*
@@ -10,8 +10,12 @@
 #endif
 
 #include <fstream>
+#include <cstdlib>
+#include <climits>
+#include <cctype>
 #include <Eigen/Dense>
 #include "../georeferencing/DatagramGeoreferencer.hpp"
+#include "../georeferencing/DatagramGeoreferencerToSurface.hpp"
 #include "../datagrams/DatagramParserFactory.hpp"
 #include <iostream>
 #include <string>
@@ -21,6 +25,12 @@
 #include "../svp/SvpSelectionStrategy.hpp"
 #include "../svp/SvpNearestByTime.hpp"
 #include "../svp/SvpNearestByLocation.hpp"
+#include "../filter/PingQualityFilter.hpp"
+#include "../filter/DetectionFlagsFilter.hpp"
+#include "../filter/SwathWidthFilter.hpp"
+#include "../filter/TravelTimeFilter.hpp"
+#include "../SurveySystem.hpp"
+#include "../math/TotalPropagatedUncertainty.hpp"
 
 using namespace std;
 
@@ -30,15 +40,81 @@ void printUsage(){
 NAME\n\n\
 	georeference - Produces a georeferenced point cloud from binary multibeam echosounder datagrams files\n\n\
 SYNOPSIS\n \
-	georeference [-x lever_arm_x] [-y lever_arm_y] [-z lever_arm_z] [-r roll_angle] [-p pitch_angle] [-h heading_angle] [-s svp_file] [-S svpStrategy] file\n\n\
+	georeference [-x lever_arm_x] [-y lever_arm_y] [-z lever_arm_z] [-r roll_angle] [-p pitch_angle] [-h heading_angle] [-s svp_file] [-S svpStrategy] [-q min_quality] [-f detection_flags] [-w swath_width] [-t] [-u survey_system_file] [-B] [-O offsets_file] [-X] [-M node_spacing -A surface.asc [-U uncertainty.asc]] file\n\n\
 DESCRIPTION\n \
 	-L Use a local geographic frame (NED)\n \
 	-T Use a terrestrial geographic frame (WGS84 ECEF)\n \
-        -S choose one: nearestTime or nearestLocation\n\n \
+        -S choose one: nearestTime or nearestLocation\n \
+	-q Reject beams with a quality lower than min_quality before georeferencing them\n \
+	-f Reject beams whose quality field doesn't have all of the detection_flags bits set, in decimal or hexadecimal (ex: 0x3)\n \
+	-w Reject beams outside of a swath of swath_width degrees centered on nadir\n \
+	-t Reject beams with a zero or invalid two-way travel time\n \
+	-u Add the horizontal and vertical total propagated uncertainty (2 sigma) of each point, from the accuracies of the survey system file\n \
+	-B Write binary point records (x,y,z as doubles, quality as uint32, intensity as int32, uncertainties as floats) instead of text\n \
+	-O Also georeference with each line of offsets_file, \"lever_arm_x lever_arm_y lever_arm_z roll pitch heading output_file\",\n \
+	   reusing the decoded, interpolated and raytraced beams: only the lever arm and boresight are applied again\n \
+	-X Georeference the soundings raytraced by the sonar (Kongsberg XYZ 88) instead of raytracing the beams:\n \
+	   no sound velocity profile nor boresight is applied, only the vertical part of the lever arm\n \
+	-M Estimate a multiple hypothesis depth surface with nodes every node_spacing meters instead of writing the points.\n \
+	   Requires -L and -u, and writes the depth of the surface to the ESRI ASCII grid of -A\n \
+	-A Depth raster of the surface (-M)\n \
+	-U Also write the uncertainty (1 sigma) of the surface (-M) to an ESRI ASCII grid\n\n \
 Copyright 2017-2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés" << std::endl;
 	exit(1);
 }
 
+/**
+  * Georeferences the cached beams again for each line of an offsets file
+  *
+  * @param printer the georeferencer, its beams cached
+  * @param offsetsFilename file of "lever_arm_x lever_arm_y lever_arm_z roll pitch heading output_file" lines
+  * @param binaryOutput true if the points are written as binary records
+  */
+void regeoreference(DatagramGeoreferencer & printer, std::string & offsetsFilename, bool binaryOutput){
+        std::ifstream offsets(offsetsFilename.c_str());
+
+        if (!offsets) {
+            throw new Exception("Cannot open offsets file " + offsetsFilename);
+        }
+
+        std::string line;
+
+        while (std::getline(offsets, line)) {
+            double x, y, z, roll, pitch, heading;
+            char outputFilename[1024];
+
+            if (line.empty()) {
+                continue;
+            }
+
+            if (sscanf(line.c_str(), "%lf %lf %lf %lf %lf %lf %1023s", &x, &y, &z, &roll, &pitch, &heading, outputFilename) != 7) {
+                std::cerr << "[-] Invalid offsets line: " << line << std::endl;
+                continue;
+            }
+
+            FILE * file = fopen(outputFilename, binaryOutput ? "wb" : "w");
+
+            if (!file) {
+                throw new Exception("Cannot write " + std::string(outputFilename));
+            }
+
+            Eigen::Vector3d leverArm;
+            leverArm << x, y, z;
+
+            Attitude boresightAngles(0, roll, pitch, heading);
+            Eigen::Matrix3d boresight;
+            Boresight::buildMatrix(boresight, boresightAngles);
+
+            std::cerr << "[+] Georeferencing again to " << outputFilename << std::endl;
+
+            printer.setOutputFile(file);
+            printer.regeoreference(leverArm, boresight);
+            printer.setOutputFile(stdout);
+
+            fclose(file);
+        }
+}
+
 /**
   * declare the parser depending on argument receive
   * 
@@ -81,9 +157,33 @@ int main (int argc , char ** argv){
 	std::string	     svpFilename;
 	CarisSvpFile svps;
 
+        //Output format
+        bool binaryOutput = false;
+
+        //Beams rejected before georeferencing
+        std::vector<PingFilter*> pingFilters;
+        unsigned int minimumQuality;
+        unsigned int detectionFlags;
+        double swathWidth;
+
+        //Total propagated uncertainty
+        SurveySystem surveySystem;
+        TotalPropagatedUncertainty * uncertainty = NULL;
+
+        //Other lever arms and boresights to apply
+        std::string offsetsFilename;
+
+        //Soundings of the sonar instead of raytracing
+        bool beamXYZ = false;
+
+        //Multiple hypothesis surface instead of points
+        double nodeSpacing = 0;
+        std::string surfaceFilename;
+        std::string uncertaintyFilename;
+
         int index;
 
-        while((index=getopt(argc,argv,"x:y:z:r:p:h:s:S:LT"))!=-1)
+        while((index=getopt(argc,argv,"x:y:z:r:p:h:s:S:LTBq:f:w:tu:O:XM:A:U:"))!=-1)
         {
             switch(index)
             {
@@ -167,6 +267,82 @@ int main (int argc , char ** argv){
                 case 'T':
                     georef = new GeoreferencingTRF();
                 break;
+
+                case 'B':
+                    binaryOutput = true;
+                break;
+
+                case 'q':
+                    if (sscanf(optarg,"%u", &minimumQuality) != 1)
+                    {
+                        std::cerr << "Invalid minimum quality (-q)" << std::endl;
+                        printUsage();
+                    }
+                    pingFilters.push_back(new PingQualityFilter(minimumQuality));
+                break;
+
+                case 'f':
+                {
+                    //decimal, or hexadecimal with 0x: the whole argument must be a non-negative 32 bits value
+                    char * end = NULL;
+                    bool hexadecimal = (optarg[0] == '0' && (optarg[1] == 'x' || optarg[1] == 'X'));
+                    unsigned long flags = strtoul(optarg, &end, hexadecimal ? 16 : 10);
+
+                    if (!isdigit((unsigned char)optarg[0]) || end == optarg || *end != '\0' || flags > UINT_MAX)
+                    {
+                        std::cerr << "Invalid detection flags (-f)" << std::endl;
+                        printUsage();
+                    }
+                    detectionFlags = (unsigned int)flags;
+                    pingFilters.push_back(new DetectionFlagsFilter(detectionFlags));
+                }
+                break;
+
+                case 'w':
+                    if (sscanf(optarg,"%lf", &swathWidth) != 1 || swathWidth <= 0)
+                    {
+                        std::cerr << "Invalid swath width (-w)" << std::endl;
+                        printUsage();
+                    }
+                    pingFilters.push_back(new SwathWidthFilter(swathWidth));
+                break;
+
+                case 't':
+                    pingFilters.push_back(new TravelTimeFilter());
+                break;
+
+                case 'u':
+                    if (!surveySystem.readFile(optarg))
+                    {
+                        std::cerr << "Invalid survey system file (-u)" << std::endl;
+                        printUsage();
+                    }
+                    uncertainty = new TotalPropagatedUncertainty(surveySystem);
+                break;
+
+                case 'O':
+                    offsetsFilename = optarg;
+                break;
+
+                case 'X':
+                    beamXYZ = true;
+                break;
+
+                case 'M':
+                    if (sscanf(optarg,"%lf", &nodeSpacing) != 1 || nodeSpacing <= 0)
+                    {
+                        std::cerr << "Invalid node spacing (-M)" << std::endl;
+                        printUsage();
+                    }
+                break;
+
+                case 'A':
+                    surfaceFilename = optarg;
+                break;
+
+                case 'U':
+                    uncertaintyFilename = optarg;
+                break;
             }
         }
 
@@ -175,6 +351,18 @@ int main (int argc , char ** argv){
             georef = new GeoreferencingTRF();
         }
         
+        if(nodeSpacing > 0){
+            if(dynamic_cast<GeoreferencingLGF*>(georef) == NULL || uncertainty == NULL){
+                std::cerr << "The hypothesis surface (-M) requires the local geographic frame (-L) and a survey system file (-u)" << std::endl;
+                printUsage();
+            }
+
+            if(surfaceFilename.empty() || offsetsFilename.size() > 0){
+                std::cerr << "The hypothesis surface (-M) requires a depth raster (-A) and cannot be used with -O" << std::endl;
+                printUsage();
+            }
+        }
+
         if(svpStrategy == NULL){
             std::cerr << "[+] Using nearest in time sound velocity profile selection strategy by default" << std::endl;
             svpStrategy = new SvpNearestByTime();
@@ -183,7 +371,26 @@ int main (int argc , char ** argv){
         try
         {
             DatagramParser * parser = NULL;
-            DatagramGeoreferencer  printer(*georef, *svpStrategy);
+            HypothesisSurface * surface = NULL;
+            DatagramGeoreferencer * georeferencer = NULL;
+
+            if (nodeSpacing > 0) {
+                surface = new HypothesisSurface(nodeSpacing);
+                georeferencer = new DatagramGeoreferencerToSurface(*georef, *svpStrategy, *surface, *uncertainty);
+            }
+            else {
+                georeferencer = new DatagramGeoreferencer(*georef, *svpStrategy);
+            }
+
+            DatagramGeoreferencer & printer = *georeferencer;
+            printer.setBinaryOutput(binaryOutput);
+            printer.setUncertainty(uncertainty);
+            printer.setBeamCache(offsetsFilename.size() > 0);
+            printer.setBeamXYZ(beamXYZ);
+
+            for (unsigned int i = 0; i < pingFilters.size(); i++) {
+                printer.addPingFilter(pingFilters[i]);
+            }
 
             std::cerr << "[+] Decoding " << fileName << std::endl;
             std::ifstream inFile;
@@ -196,8 +403,6 @@ int main (int argc , char ** argv){
                 throw new Exception("File not found: << fileName");
             }
             parser->parse(fileName);
-            std::cout << std::setprecision(6);
-            std::cout << std::fixed;
 
             //Lever arm
             Eigen::Vector3d leverArm;
@@ -211,7 +416,22 @@ int main (int argc , char ** argv){
             //Do the georeference dance
             printer.georeference(leverArm, boresight, svps.getSvps());
 
+            if (offsetsFilename.size() > 0) {
+                regeoreference(printer, offsetsFilename, binaryOutput);
+            }
+
+            if (surface) {
+                std::cerr << "[+] Writing the hypothesis surface (" << surface->getTileCount() << " tiles) to " << surfaceFilename << std::endl;
+                surface->writeEsriAscii(surfaceFilename, SURFACE_DEPTH);
+
+                if (uncertaintyFilename.size() > 0) {
+                    surface->writeEsriAscii(uncertaintyFilename, SURFACE_UNCERTAINTY);
+                }
+            }
+
             delete parser;
+            delete georeferencer;
+            delete surface;
         }
         catch(Exception * error)
         {
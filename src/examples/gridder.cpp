@@ -0,0 +1,198 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef GRIDDER_CPP
+#define GRIDDER_CPP
+
+#ifdef _WIN32
+#include "../utils/getopt.h"
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <string>
+#include <iostream>
+#include <vector>
+#include "../gridding/TiledGrid.hpp"
+#include "../PointRecord.hpp"
+#include "../utils/Exception.hpp"
+
+using namespace std;
+
+/**Shows the usage information about gridder*/
+void printUsage(){
+    std::cerr << "\n\
+  NAME\n\n\
+     gridder - Adds georeferenced soundings to a bathymetric grid and exports it\n\n\
+  SYNOPSIS\n \
+       gridder -c cellSize [-m maxTilesInMemory] [-E] [-b] [-s statistic] [-a file.asc] [-f file] gridDirectory\n\n\
+  DESCRIPTION\n \
+       Reads points from standard input (x y z quality intensity), as written by georeference -L or data-cleaning.\n \
+       The grid directory keeps the cell statistics: running gridder again on it adds the new soundings.\n\n \
+       -c Size of the grid cells\n \
+       -m Number of tiles kept in memory (default: 64)\n \
+       -E Points are easting, northing, depth instead of north, east, down (local geographic frame)\n \
+       -b Read binary point records instead of text\n \
+       -s Statistic to export: mean (default), min, max, std or count\n \
+       -a Export the grid as an ESRI ASCII grid\n \
+       -f Export the grid as an ESRI binary grid (file.flt and file.hdr)\n\n \
+  Copyright 2017-2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés" << std::endl;
+    exit(1);
+}
+
+/**
+ * Grid all points received on standard input
+ *
+ * @param argc number of parameter
+ * @param argv value of the parameters
+ */
+int main(int argc,char** argv){
+    double cellSize = 0;
+    unsigned int maximumTilesInMemory = 64;
+    bool eastingNorthing = false;
+    bool binaryInput = false;
+    GridStatistic statistic = GRID_MEAN;
+    std::string asciiFilename;
+    std::string binaryFilename;
+
+    int index;
+    while((index=getopt(argc,argv,"c:m:Ebs:a:f:"))!=-1)
+    {
+        switch(index)
+        {
+            case 'c':
+                if(sscanf(optarg,"%lf", &cellSize) != 1 || cellSize <= 0)
+                {
+                    std::cerr << "Error: -c invalid cell size parameter" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'm':
+                if(sscanf(optarg,"%u", &maximumTilesInMemory) != 1 || maximumTilesInMemory == 0)
+                {
+                    std::cerr << "Error: -m invalid number of tiles" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'E':
+                eastingNorthing = true;
+            break;
+
+            case 'b':
+                binaryInput = true;
+            break;
+
+            case 's':
+            {
+                std::string name(optarg);
+
+                if(name == "mean") statistic = GRID_MEAN;
+                else if(name == "min") statistic = GRID_MINIMUM;
+                else if(name == "max") statistic = GRID_MAXIMUM;
+                else if(name == "std") statistic = GRID_STDDEV;
+                else if(name == "count") statistic = GRID_COUNT;
+                else{
+                    std::cerr << "Error: -s invalid statistic" << std::endl;
+                    printUsage();
+                }
+            }
+            break;
+
+            case 'a':
+                asciiFilename = optarg;
+            break;
+
+            case 'f':
+                binaryFilename = optarg;
+            break;
+        }
+    }
+
+    if(cellSize <= 0 || optind != argc - 1){
+        printUsage();
+    }
+
+    try{
+        TiledGrid grid(argv[optind],cellSize,maximumTilesInMemory);
+
+        std::vector<double> eastings;
+        std::vector<double> northings;
+        std::vector<double> depths;
+        std::vector<PointRecord> records(POINT_BATCH_SIZE);
+
+        std::string line;
+        unsigned int lineCount = 1;
+        uint64_t soundingCount = 0;
+        bool endOfInput = false;
+
+        while(!endOfInput){
+            if(binaryInput){
+                bool truncated;
+                unsigned int count = readPointRecords(stdin,&records[0],POINT_BATCH_SIZE,truncated);
+                endOfInput = (count < POINT_BATCH_SIZE);
+
+                if(truncated){
+                    std::cerr << "Error: truncated record at end of input" << std::endl;
+                }
+
+                for(unsigned int i=0;i<count;i++){
+                    eastings.push_back(eastingNorthing ? records[i].x : records[i].y);
+                    northings.push_back(eastingNorthing ? records[i].y : records[i].x);
+                    depths.push_back(records[i].z);
+                }
+            }
+            else{
+                if(!std::getline(std::cin,line) || line=="0"){
+                    endOfInput = true;
+                }
+                else{
+                    double x,y,z;
+
+                    if(sscanf(line.c_str(),"%lf %lf %lf",&x,&y,&z)==3){
+                        eastings.push_back(eastingNorthing ? x : y);
+                        northings.push_back(eastingNorthing ? y : x);
+                        depths.push_back(z);
+                    }
+                    else{
+                        std::cerr << "Error at line " << lineCount << std::endl;
+                    }
+                    lineCount++;
+                }
+            }
+
+            if(depths.size() >= (1 << 20) || (endOfInput && depths.size() > 0)){
+                grid.addSoundings(&eastings[0],&northings[0],&depths[0],depths.size());
+                soundingCount += depths.size();
+
+                eastings.clear();
+                northings.clear();
+                depths.clear();
+            }
+        }
+
+        grid.save();
+
+        std::cerr << "[+] Added " << soundingCount << " soundings, the grid has " << grid.getTileCount() << " tiles" << std::endl;
+
+        if(asciiFilename.size() > 0){
+            grid.writeEsriAscii(asciiFilename,statistic);
+        }
+
+        if(binaryFilename.size() > 0){
+            grid.writeEsriBinary(binaryFilename,statistic);
+        }
+    }
+    catch(Exception * error){
+        std::cerr << "[-] Error while gridding: " << error->what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
@@ -27,9 +27,20 @@
 class DatagramGeoreferencerToOstream : public DatagramGeoreferencer{
 public:
   /**Creates a datagram georeferencer*/
-  DatagramGeoreferencerToOstream( std::ostream & out )
-  : out( out )
+  DatagramGeoreferencerToOstream( std::ostream & out, Georeferencing & georef, SvpSelectionStrategy & svpStrategy )
+  : DatagramGeoreferencer( georef, svpStrategy )
   {
+    setOstream( out );
+  }
+
+  /**
+  * Sets the stream the georeferenced pings are written to, for instance before regeoreference()
+  *
+  * @param out the output stream
+  */
+  void setOstream( std::ostream & out )
+  {
+    this->out = &out;
     out << std::setprecision(6);
     out << std::fixed;
   }
@@ -44,16 +55,16 @@ public:
   * @param quality the quality flag
   * @param intensity the intensity flag
   */
-  virtual void processGeoreferencedPing(Eigen::Vector3d & georeferencedPing,uint32_t quality,int32_t intensity);
+  virtual void processGeoreferencedPing(Eigen::Vector3d & georeferencedPing,uint32_t quality,int32_t intensity,double horizontalUncertainty,double verticalUncertainty,int positionIndex,int attitudeIndex);
 
 private:
-  std::ostream & out; // ostream: can be used for a file or for std::cout
+  std::ostream * out; // ostream: can be used for a file or for std::cout
 
 
 };
 
-void DatagramGeoreferencerToOstream::processGeoreferencedPing(Eigen::Vector3d & georeferencedPing,uint32_t quality,int32_t intensity){
-  out << georeferencedPing(0) << " " << georeferencedPing(1) << " " << georeferencedPing(2)
+void DatagramGeoreferencerToOstream::processGeoreferencedPing(Eigen::Vector3d & georeferencedPing,uint32_t quality,int32_t intensity,double horizontalUncertainty,double verticalUncertainty,int positionIndex,int attitudeIndex){
+  *out << georeferencedPing(0) << " " << georeferencedPing(1) << " " << georeferencedPing(2)
   << " " << quality  << " " << intensity << std::endl;
 }
 
@@ -28,6 +28,7 @@
 #include "../../../utils/StringUtils.hpp"
 #include "../../../utils/Exception.hpp"
 #include "../../../math/Boresight.hpp"
+#include "../../../svp/SvpNearestByTime.hpp"
 
 
 const std::string MainWindow::lineEditNames[ nbValuesD ] = { "Lever arm X", "Lever arm Y", "Lever arm Z",
@@ -48,7 +49,11 @@ MainWindow::MainWindow(QWidget *parent) :
 
     outputFileNameEditedByUser( false ),
 
-    currentlyProcessing( false )
+    currentlyProcessing( false ),
+
+    georef( nullptr ),
+    svpStrategy( nullptr ),
+    printer( nullptr )
 {
 
 #ifdef __GNU__
@@ -130,6 +135,10 @@ MainWindow::~MainWindow()
         outFile << std::setprecision(6) << std::fixed << valuesD << std::endl;
     }
 
+    delete printer;
+    delete svpStrategy;
+    delete georef;
+
     delete ui;
 }
 
@@ -204,45 +213,59 @@ void MainWindow::on_Process_clicked()
 
             if (inFile)
             {
-                //TODO: allow selection between georeferencing modes
-                Georeferencing * georef = new GeoreferencingTRF();
+                Eigen::Vector3d leverArm = valuesD.head( 3 );
 
-                DatagramGeoreferencerToOstream printer( outFile ,georef );
+                Attitude boresightAngles( 0, valuesD(3), valuesD(4), valuesD(5) ); //Attitude boresightAngles(0,roll,pitch,heading);
+                Eigen::Matrix3d boresight;
+                Boresight::buildMatrix( boresight, boresightAngles );
 
-                if ( StringUtils::ends_with( inputFileName.c_str(),".all" ) )
+                if ( printer && cachedInputFileName == inputFileName )
                 {
-                    parser = new KongsbergParser(printer);
-                }
-                else if ( StringUtils::ends_with( inputFileName.c_str(),".xtf") )
-                {
-                    parser = new XtfParser(printer);
-                }
-                else if ( StringUtils::ends_with( inputFileName.c_str(),".s7k") )
-                {
-                    parser = new S7kParser(printer);
+                    // Same input file: only the lever arm and boresight are applied again
+                    printer->setOstream( outFile );
+                    printer->regeoreference( leverArm, boresight );
                 }
                 else
                 {
-                    throw new Exception("Unknown extension");
+                    delete printer;
+                    delete svpStrategy;
+                    delete georef;
+                    printer = nullptr;
+                    cachedInputFileName.clear();
+
+                    //TODO: allow selection between georeferencing modes
+                    georef = new GeoreferencingTRF();
+                    svpStrategy = new SvpNearestByTime();
+                    printer = new DatagramGeoreferencerToOstream( outFile, *georef, *svpStrategy );
+                    printer->setBeamCache( true );
+
+                    if ( StringUtils::ends_with( inputFileName.c_str(),".all" ) )
+                    {
+                        parser = new KongsbergParser(*printer);
+                    }
+                    else if ( StringUtils::ends_with( inputFileName.c_str(),".xtf") )
+                    {
+                        parser = new XtfParser(*printer);
+                    }
+                    else if ( StringUtils::ends_with( inputFileName.c_str(),".s7k") )
+                    {
+                        parser = new S7kParser(*printer);
+                    }
+                    else
+                    {
+                        throw new Exception("Unknown extension");
+                    }
+
+                    parser->parse( inputFileName );
+
+                    //TODO: get SVP
+                    std::vector<SoundVelocityProfile*> externalSvps;
+
+                    printer->georeference( leverArm, boresight, externalSvps );
+
+                    cachedInputFileName = inputFileName;
                 }
 
-                parser->parse( inputFileName );
-
-                Eigen::Vector3d leverArm = valuesD.head( 3 );
-
-//                std::cout << "\n" << valuesD(3)
-//                          << "\n" <<valuesD(4)
-//                          << "\n" <<valuesD(5) << "\n" << std::endl;
-
-
-                Attitude boresightAngles( 0, valuesD(3), valuesD(4), valuesD(5) ); //Attitude boresightAngles(0,roll,pitch,heading);
-                Eigen::Matrix3d boresight;
-                Boresight::buildMatrix( boresight, boresightAngles );
-
-                //TODO: get SVP
-
-                printer.georeference( leverArm, boresight,NULL );
-
                 qDebug() << "Done georeferencing \n" << tr( inputFileName.c_str() );
 
 
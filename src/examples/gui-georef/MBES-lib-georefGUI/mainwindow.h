@@ -15,6 +15,10 @@
 
 #include <Eigen/Dense>
 
+class Georeferencing;
+class SvpSelectionStrategy;
+class DatagramGeoreferencerToOstream;
+
 namespace Ui {
 class MainWindow;
 }
@@ -124,6 +128,13 @@ private:
     Eigen::VectorXd valuesD;
 
     bool currentlyProcessing;
+
+    // Input file decoded, interpolated and raytraced by the last processing, kept so that
+    // a lever arm or boresight change only applies the final transforms
+    std::string cachedInputFileName;
+    Georeferencing * georef;
+    SvpSelectionStrategy * svpStrategy;
+    DatagramGeoreferencerToOstream * printer;
 };
 
 #endif // MAINWINDOW_H
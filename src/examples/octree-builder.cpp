@@ -0,0 +1,145 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef OCTREEBUILDER_CPP
+#define OCTREEBUILDER_CPP
+
+#ifdef _WIN32
+#include "../utils/getopt.h"
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <string>
+#include <iostream>
+#include <vector>
+#include "../octree/OctreeBuilder.hpp"
+#include "../PointRecord.hpp"
+#include "../utils/Exception.hpp"
+
+using namespace std;
+
+/**Shows the usage information about octree-builder*/
+void printUsage(){
+    std::cerr << "\n\
+  NAME\n\n\
+     octree-builder - Builds a level of detail octree from georeferenced points, for the viewer\n\n\
+  SYNOPSIS\n \
+       octree-builder [-n maxNodePoints] [-c maxChunkPoints] [-t threads] [-b] octreeDirectory\n\n\
+  DESCRIPTION\n \
+       Reads points from standard input (x y z quality intensity), as written by georeference or data-cleaning.\n \
+       The points are spooled to disk, so the cloud does not need to fit in memory.\n\n \
+       -n Number of points above which a node is split (default: 20000)\n \
+       -c Number of points indexed in memory by each thread (default: 4194304)\n \
+       -t Number of threads (default: one per hardware thread)\n \
+       -b Read binary point records instead of text\n\n \
+  Copyright 2017-2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés" << std::endl;
+    exit(1);
+}
+
+/**
+ * Builds an octree from all points received on standard input
+ *
+ * @param argc number of parameter
+ * @param argv value of the parameters
+ */
+int main(int argc,char** argv){
+    unsigned int maximumNodePoints = 20000;
+    unsigned int maximumChunkPoints = 1 << 22;
+    unsigned int threadCount = 0;
+    bool binaryInput = false;
+
+    int index;
+    while((index=getopt(argc,argv,"n:c:t:b"))!=-1)
+    {
+        switch(index)
+        {
+            case 'n':
+                if(sscanf(optarg,"%u", &maximumNodePoints) != 1 || maximumNodePoints == 0)
+                {
+                    std::cerr << "Error: -n invalid number of points" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'c':
+                if(sscanf(optarg,"%u", &maximumChunkPoints) != 1 || maximumChunkPoints == 0)
+                {
+                    std::cerr << "Error: -c invalid number of points" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 't':
+                if(sscanf(optarg,"%u", &threadCount) != 1)
+                {
+                    std::cerr << "Error: -t invalid number of threads" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'b':
+                binaryInput = true;
+            break;
+        }
+    }
+
+    if(optind != argc - 1){
+        printUsage();
+    }
+
+    try{
+        OctreeBuilder builder(argv[optind],maximumNodePoints,maximumChunkPoints,threadCount);
+
+        std::vector<PointRecord> records(POINT_BATCH_SIZE);
+        std::string line;
+        unsigned int lineCount = 1;
+        bool endOfInput = false;
+
+        while(!endOfInput){
+            if(binaryInput){
+                bool truncated;
+                unsigned int count = readPointRecords(stdin,&records[0],POINT_BATCH_SIZE,truncated);
+                endOfInput = (count < POINT_BATCH_SIZE);
+
+                if(truncated){
+                    std::cerr << "Error: truncated record at end of input" << std::endl;
+                }
+
+                builder.addPoints(&records[0],count);
+            }
+            else{
+                if(!std::getline(std::cin,line) || line=="0"){
+                    endOfInput = true;
+                }
+                else{
+                    PointRecord record = {0,0,0,0,0,NAN,NAN};
+
+                    if(sscanf(line.c_str(),"%lf %lf %lf %u %d",&record.x,&record.y,&record.z,&record.quality,&record.intensity)==5){
+                        builder.addPoints(&record,1);
+                    }
+                    else{
+                        std::cerr << "Error at line " << lineCount << std::endl;
+                    }
+                    lineCount++;
+                }
+            }
+        }
+
+        builder.build();
+
+        OctreeStore store(argv[optind]);
+        std::cerr << "[+] Indexed " << store.getPointCount() << " points in " << store.getNodeCount() << " nodes" << std::endl;
+    }
+    catch(Exception * error){
+        std::cerr << "[-] Error while building the octree: " << error->what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,254 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef OVERLAPMATRIX_CPP
+#define OVERLAPMATRIX_CPP
+
+#ifdef _WIN32
+#include "../utils/getopt.h"
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <iomanip>
+#include "../geometry/MultiLineOverlap.hpp"
+#include "../gridding/OverlapStatistics.hpp"
+#include "../PointRecord.hpp"
+#include "../utils/Exception.hpp"
+
+using namespace std;
+
+/**Shows the usage information about overlap-matrix*/
+void printUsage(){
+    std::cerr << "\n\
+  NAME\n\n\
+     overlap-matrix - Finds the overlap between every pair of lines of a survey\n\n\
+  SYNOPSIS\n \
+       overlap-matrix [-p a,b,c,d] [-b] [-t threads] [-o pairs.csv] [-s statistics.csv] [-c cell_size] line1 line2 ...\n\n\
+  DESCRIPTION\n \
+       Reads the georeferenced points of each line (x y z quality intensity), as written by georeference or data-cleaning,\n \
+       and writes to standard output, as CSV, the percentage of the points of each line inside the hull of each other line.\n\n \
+       -p Projection plane ax + by + cz + d = 0 (default: 0,0,1,0, the horizontal plane of the local geographic frame)\n \
+       -b Read binary point records instead of text\n \
+       -t Number of threads (default: one per hardware thread)\n \
+       -o Write the number of points and mean height of the points of each overlapping pair\n \
+       -s Write the depth difference statistics of each overlapping pair, gridded on the projection plane\n \
+       -c Size of the grid cells of the depth difference statistics (default: 1)\n\n \
+  Copyright 2017-2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés" << std::endl;
+    exit(1);
+}
+
+/**
+ * Reads the points of a line
+ *
+ * @param filename the file name
+ * @param binaryInput true if the file holds binary point records
+ * @param points the points
+ */
+void readLine(std::string & filename,bool binaryInput,std::vector<PointRecord> & points){
+    FILE * file = fopen(filename.c_str(),binaryInput ? "rb" : "r");
+
+    if(!file){
+        throw new Exception("Cannot open " + filename);
+    }
+
+    if(binaryInput){
+        std::vector<PointRecord> records(POINT_BATCH_SIZE);
+        unsigned int count;
+        bool truncated = false;
+
+        while((count = readPointRecords(file,&records[0],POINT_BATCH_SIZE,truncated)) > 0){
+            points.insert(points.end(),records.begin(),records.begin() + count);
+        }
+
+        if(truncated){
+            std::cerr << "Error: truncated record at end of " << filename << std::endl;
+        }
+    }
+    else{
+        char line[1024];
+        unsigned int lineCount = 1;
+
+        while(fgets(line,sizeof(line),file)){
+            PointRecord point = {0,0,0,0,0,NAN,NAN};
+
+            if(sscanf(line,"%lf %lf %lf",&point.x,&point.y,&point.z) == 3){
+                points.push_back(point);
+            }
+            else if(std::string(line) != "0\n"){
+                std::cerr << "Error at line " << lineCount << " of " << filename << std::endl;
+            }
+
+            lineCount++;
+        }
+    }
+
+    fclose(file);
+}
+
+/**
+ * Gathers the points of a line inside the hull of another line, on the projection plane, the height as z
+ *
+ * @param points the points of the line on the projection plane
+ * @param indices the indices of the points inside the hull of the other line
+ * @param subset the gathered points
+ */
+void gatherOverlap(const std::vector<LinePoint2D> & points,const std::vector<uint64_t> & indices,std::vector<PointRecord> & subset){
+    subset.resize(indices.size());
+
+    for(uint64_t i=0;i<indices.size();i++){
+        const LinePoint2D & point = points[indices[i]];
+        subset[i].x = point.x;
+        subset[i].y = point.y;
+        subset[i].z = point.height;
+    }
+}
+
+/**
+ * Writes the depth difference statistics of each overlapping pair as CSV
+ *
+ * @param overlap the overlap analysis, with its point sets kept
+ * @param cellSize size of the grid cells
+ * @param threadCount number of threads
+ * @param out the output stream
+ */
+void writeStatistics(const MultiLineOverlap & overlap,double cellSize,unsigned int threadCount,std::ostream & out){
+    OverlapStatistics statistics(cellSize,1,threadCount);
+    std::vector<PointRecord> first,second;
+
+    out << "first,second,cells,meanDifference,rmsDifference,maximumAbsoluteDifference,specialOrderPassRate,order1PassRate,order2PassRate" << std::endl;
+    out << std::fixed << std::setprecision(3);
+
+    for(unsigned int p=0;p<overlap.getOverlaps().size();p++){
+        const LineOverlap & pair = overlap.getOverlaps()[p];
+
+        gatherOverlap(overlap.getLinePoints(pair.first),pair.firstIndices,first);
+        gatherOverlap(overlap.getLinePoints(pair.second),pair.secondIndices,second);
+        statistics.compute(first,second);
+
+        out << overlap.getLineName(pair.first) << "," << overlap.getLineName(pair.second) << ","
+            << statistics.getComparedCellCount() << ","
+            << statistics.getMeanDifference() << "," << statistics.getRmsDifference() << "," << statistics.getMaximumAbsoluteDifference() << ","
+            << 100 * statistics.getPassRate(IHO_SPECIAL_ORDER) << "," << 100 * statistics.getPassRate(IHO_ORDER_1) << "," << 100 * statistics.getPassRate(IHO_ORDER_2) << std::endl;
+    }
+}
+
+/**
+ * Finds the overlaps between all the lines given as parameters
+ *
+ * @param argc number of parameter
+ * @param argv value of the parameters
+ */
+int main(int argc,char** argv){
+    double a = 0;
+    double b = 0;
+    double c = 1;
+    double d = 0;
+    bool binaryInput = false;
+    unsigned int threadCount = 0;
+    std::string pairsFilename;
+    std::string statisticsFilename;
+    double cellSize = 1;
+
+    int index;
+    while((index=getopt(argc,argv,"p:bt:o:s:c:"))!=-1)
+    {
+        switch(index)
+        {
+            case 'p':
+                if(sscanf(optarg,"%lf,%lf,%lf,%lf", &a, &b, &c, &d) != 4)
+                {
+                    std::cerr << "Error: -p invalid projection plane" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'b':
+                binaryInput = true;
+            break;
+
+            case 't':
+                if(sscanf(optarg,"%u", &threadCount) != 1)
+                {
+                    std::cerr << "Error: -t invalid number of threads" << std::endl;
+                    printUsage();
+                }
+            break;
+
+            case 'o':
+                pairsFilename = optarg;
+            break;
+
+            case 's':
+                statisticsFilename = optarg;
+            break;
+
+            case 'c':
+                if(sscanf(optarg,"%lf", &cellSize) != 1 || !(cellSize > 0))
+                {
+                    std::cerr << "Error: -c invalid cell size" << std::endl;
+                    printUsage();
+                }
+            break;
+        }
+    }
+
+    if(argc - optind < 2){
+        printUsage();
+    }
+
+    try{
+        MultiLineOverlap overlap(a,b,c,d,statisticsFilename.size() > 0,threadCount);
+
+        for(int i=optind;i<argc;i++){
+            std::string filename(argv[i]);
+            std::vector<PointRecord> points;
+
+            readLine(filename,binaryInput,points);
+            overlap.addLine(filename,points);
+
+            std::cerr << "[+] " << filename << ": " << points.size() << " points, hull of " << overlap.getLineHull(overlap.getLineCount() - 1).size() << " vertices" << std::endl;
+        }
+
+        overlap.computeOverlaps();
+
+        std::cerr << "[+] " << overlap.getOverlaps().size() << " overlapping pairs" << std::endl;
+
+        overlap.writeMatrix(std::cout);
+
+        if(pairsFilename.size() > 0){
+            std::ofstream pairs(pairsFilename.c_str());
+
+            if(!pairs){
+                throw new Exception("Cannot write " + pairsFilename);
+            }
+
+            overlap.writePairs(pairs);
+        }
+
+        if(statisticsFilename.size() > 0){
+            std::ofstream statistics(statisticsFilename.c_str());
+
+            if(!statistics){
+                throw new Exception("Cannot write " + statisticsFilename);
+            }
+
+            writeStatistics(overlap,cellSize,threadCount,statistics);
+        }
+    }
+    catch(Exception * error){
+        std::cerr << "[-] Error while computing the overlaps: " << error->what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
@@ -39,6 +39,9 @@
 #include "../../utils/Exception.hpp"
 
 #include "../../geometry/HullOverlap.hpp"
+#include "../../geometry/ProjectionPlane.hpp"
+#include "../../gridding/OverlapStatistics.hpp"
+#include "../../PointRecord.hpp"
 
 #include "../viewer/smallUtilityFunctions.hpp"
 
@@ -52,10 +55,12 @@ void printUsage(){
 	NAME\n\n\
 	overlap - Displays the overlap area between two multibeam echosounder datagram files\n\n\
 	SYNOPSIS\n \
-	overlap [-x lever_arm_x] [-y lever_arm_y] [-z lever_arm_z] [-r roll_angle] [-p pitch_angle] [-h heading_angle] file1 file2 a b c d alpha1 alpha2\n\n\
+	overlap [-x lever_arm_x] [-y lever_arm_y] [-z lever_arm_z] [-r roll_angle] [-p pitch_angle] [-h heading_angle] [-g cell_size] file1 file2 a b c d alpha1 alpha2\n\n\
 	DESCRIPTION\n \
 	-L          Use a local geographic frame (NED)\n \
 	-T          Use a terrestrial geographic frame (WGS84 ECEF)\n \
+	-g          Grid the overlap on the projection plane with cells of this size and report the differences between the lines\n \
+	            of their heights above the plane (depths with -L and the plane 0 0 1 0)\n \
 	a, b, c, d  Coefficients to define the projection plane, ax + by + cz + d = 0\n \
 	alpha1      Concave hull computation parameter to use with file #1\n \
 	alpha2      Concave hull computation parameter to use with file #2\n\n \
@@ -65,6 +70,29 @@ void printUsage(){
 
 
 
+/**
+* Expresses points on the projection plane for the overlap statistics: x and y along the axes of the plane,
+* from its origin, and z the signed distance to the plane. Both lines must be projected by the same plane
+* to be gridded in the same frame, with -T as well as -L
+*
+* @param line the points
+* @param plane the projection plane
+* @param points the points on the projection plane
+*/
+void projectOnPlane( const pcl::PointCloud<pcl::PointXYZ> & line, const ProjectionPlane & plane, std::vector<PointRecord> & points )
+{
+    points.resize( line.points.size() );
+
+    for ( uint64_t i = 0; i < line.points.size(); i++ )
+    {
+        double x, y, height;
+        plane.project( Eigen::Vector3d( line.points[ i ].x, line.points[ i ].y, line.points[ i ].z ), x, y, height );
+
+        PointRecord projected = { x, y, height, 0, 0, NAN, NAN };
+        points[ i ] = projected;
+    }
+}
+
 /**
 * Declares the program depending on argument received
 *
@@ -96,12 +124,15 @@ int main( int argc, char* argv[] )
 	bool LorTPresent = false;
 	bool DoLGF = true;
 
+	//Overlap statistics grid, 0 for none
+	double cellSize = 0.0;
+
 
     // Read -L or -T, optional parameters preceded by "-"
 
 	int index;
 
-	while((index=getopt(argc,argv,"x:y:z:r:p:h:LT"))!=-1)
+	while((index=getopt(argc,argv,"x:y:z:r:p:h:g:LT"))!=-1)
 	{
 		switch(index)
 		{
@@ -153,6 +184,14 @@ int main( int argc, char* argv[] )
 				}
 				break;
 
+			case 'g':
+				if(sscanf(optarg,"%lf", &cellSize) != 1 || !(cellSize > 0))
+				{
+					std::cerr << "Invalid overlap statistics cell size (-g)" << std::endl;
+					printUsage();
+				}
+				break;
+
 			case 'L':
 				LorTPresent = true;
 				DoLGF = true;
@@ -323,6 +362,40 @@ int main( int argc, char* argv[] )
     std::cout << "Nb points line1 in both hulls: " << inBothHulls.first
         << "\nNb points line2 in both hulls: " << inBothHulls.second << "\n" << std::endl;
 
+    if( cellSize > 0 )
+    {
+        try
+        {
+            //raw x and y are ECEF with -T: grid on the projection plane instead
+            std::vector<PointRecord> line1OnPlane, line2OnPlane;
+
+            if ( line1InBothHulls->points.size() > 0 )
+            {
+                const pcl::PointXYZ & first = line1InBothHulls->points[ 0 ];
+                ProjectionPlane plane( a, b, c, d );
+                plane.setOrigin( Eigen::Vector3d( first.x, first.y, first.z ) );
+
+                projectOnPlane( *line1InBothHulls, plane, line1OnPlane );
+                projectOnPlane( *line2InBothHulls, plane, line2OnPlane );
+            }
+
+            OverlapStatistics statistics( cellSize );
+            statistics.compute( line1OnPlane, line2OnPlane );
+
+            std::cout << "Compared cells: " << statistics.getComparedCellCount()
+                << "\nMean depth difference: " << statistics.getMeanDifference()
+                << "\nRMS depth difference: " << statistics.getRmsDifference()
+                << "\nMax absolute depth difference: " << statistics.getMaximumAbsoluteDifference()
+                << "\nIHO special order pass rate: " << 100 * statistics.getPassRate( IHO_SPECIAL_ORDER ) << "%"
+                << "\nIHO order 1 pass rate: " << 100 * statistics.getPassRate( IHO_ORDER_1 ) << "%"
+                << "\nIHO order 2 pass rate: " << 100 * statistics.getPassRate( IHO_ORDER_2 ) << "%\n" << std::endl;
+        }
+        catch ( Exception * error )
+        {
+            std::cerr << "Error while computing the overlap statistics: " << error->what() << std::endl;
+        }
+    }
+
 
     std::chrono::high_resolution_clock::time_point tEnd = std::chrono::high_resolution_clock::now();
     cout << "\n\nTotal time: " << std::chrono::duration_cast<std::chrono::seconds>(tEnd - tStart).count() << "s" << endl;       
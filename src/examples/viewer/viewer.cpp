@@ -18,6 +18,8 @@
 #include <string>
 #include <iostream>
 #include <thread>
+#include <vector>
+#include <set>
 
 #include <algorithm>			// For max
 #include <initializer_list>		// To use as parameters to function max
@@ -33,6 +35,7 @@
 
 #include "../../utils/StringUtils.hpp"
 #include "../../math/Boresight.hpp"
+#include "../../octree/OctreeStore.hpp"
 
 #include "smallUtilityFunctions.hpp"
 
@@ -44,15 +47,105 @@ void printUsage(){
 	NAME\n\n\
 	viewer - Displays the point cloud from a multibeam echosounder datagram file\n\n\
 	SYNOPSIS\n \
-	viewer [-x lever_arm_x] [-y lever_arm_y] [-z lever_arm_z] [-r roll_angle] [-p pitch_angle] [-h heading_angle] fichier\n\n\
+	viewer [-x lever_arm_x] [-y lever_arm_y] [-z lever_arm_z] [-r roll_angle] [-p pitch_angle] [-h heading_angle] fichier\n \
+	viewer -o octree_directory [-b point_budget]\n\n\
 	DESCRIPTION\n \
 	-L Use a local geographic frame (NED)\n \
-	-T Use a terrestrial geographic frame (WGS84 ECEF)\n\n \
+	-T Use a terrestrial geographic frame (WGS84 ECEF)\n \
+	-o Stream the nodes of an octree built by octree-builder, depending on the camera distance\n \
+	-b Maximum number of points displayed from the octree (default: 5000000)\n\n \
 	Copyright 2017-2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés\n" << std::endl;
 	exit(1);
 }
 
 
+/**
+* Displays an octree built by octree-builder. At each frame, the nodes worth drawing from the current camera
+* position are selected within the point budget; nodes no longer selected are removed and a few of the newly
+* selected nodes are loaded, so the frame rate depends on the budget and not on the size of the octree
+*
+* @param directory the octree directory
+* @param pointBudget maximum number of points displayed
+*/
+void viewOctree(std::string directory, uint64_t pointBudget){
+	OctreeStore store(directory);
+
+	std::cout << "Octree: " << store.getPointCount() << " points in " << store.getNodeCount() << " nodes" << std::endl;
+
+	// Points are displayed relative to the lowest corner of the octree, to keep float precision with ECEF coordinates
+	const OctreeNode & root = store.getNode(0);
+	Eigen::Vector3d origin = root.minimum;
+	double cubeSize = root.size;
+
+	pcl::visualization::PCLVisualizer::Ptr viewer (new pcl::visualization::PCLVisualizer ("3D Viewer"));
+	viewer->setBackgroundColor ( 1.0, 1.0, 1.0 );
+	viewer->setSize( 1800, 1200 );
+	viewer->initCameraParameters();
+	viewer->addCoordinateSystem( cubeSize / 5.0, cubeSize / 2, cubeSize / 2, cubeSize / 2 );
+	viewer->setCameraPosition( cubeSize / 2, cubeSize / 2, -2 * cubeSize, cubeSize / 2, cubeSize / 2, cubeSize / 2, 0, -1, 0 );
+
+	// Nodes loaded per frame, so that moving the camera does not stall the display
+	const unsigned int nodesPerFrame = 8;
+
+	std::set<unsigned int> displayed;
+	std::vector<unsigned int> selected;
+	std::vector<PointRecord> points;
+
+	while ( !viewer->wasStopped() ){
+		std::vector<pcl::visualization::Camera> cameras;
+		viewer->getCameras( cameras );
+
+		Eigen::Vector3d camera = origin + Eigen::Vector3d( cameras[0].pos[0], cameras[0].pos[1], cameras[0].pos[2] );
+
+		// A node is worth drawing down to about a tenth of the field of view
+		store.selectNodes( camera, 0.1, pointBudget, selected );
+
+		std::set<unsigned int> wanted( selected.begin(), selected.end() );
+
+		for ( auto i = displayed.begin(); i != displayed.end(); ){
+			if ( wanted.count( *i ) == 0 ){
+				viewer->removePointCloud( store.getNode( *i ).name );
+				i = displayed.erase( i );
+			}
+			else{
+				i++;
+			}
+		}
+
+		// Selected nodes come coarsest first
+		unsigned int loaded = 0;
+
+		for ( unsigned int i = 0; i < selected.size() && loaded < nodesPerFrame; i++ ){
+			if ( displayed.count( selected[i] ) > 0 ){
+				continue;
+			}
+
+			store.readNode( selected[i], points );
+
+			pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
+			cloud->points.reserve( points.size() );
+
+			for ( unsigned int p = 0; p < points.size(); p++ ){
+				cloud->points.push_back( pcl::PointXYZ( points[p].x - origin(0), points[p].y - origin(1), points[p].z - origin(2) ) );
+			}
+
+			cloud->width = cloud->points.size();
+			cloud->height = 1;
+
+			const std::string & name = store.getNode( selected[i] ).name;
+			viewer->addPointCloud<pcl::PointXYZ> ( cloud, name );
+			viewer->setPointCloudRenderingProperties (pcl::visualization::PCL_VISUALIZER_COLOR, 0, 0, 1, name );
+			viewer->setPointCloudRenderingProperties (pcl::visualization::PCL_VISUALIZER_POINT_SIZE, 1, name );
+
+			displayed.insert( selected[i] );
+			loaded++;
+		}
+
+		viewer->spinOnce (100);
+	}
+}
+
+
 /**
 * Declares the viewer depending on argument received
 *
@@ -93,9 +186,12 @@ int main(int argc, char ** argv){
 	bool LorTPresent = false;
 	bool DoLGF = true;
 
+	std::string octreeDirectory;
+	unsigned long long pointBudget = 5000000;
+
 	int index;
 
-	while((index=getopt(argc,argv,"x:y:z:r:p:h:LT"))!=-1)
+	while((index=getopt(argc,argv,"x:y:z:r:p:h:LTo:b:"))!=-1)
 	{
 		switch(index)
 		{
@@ -156,7 +252,34 @@ int main(int argc, char ** argv){
 				LorTPresent = true;
 				DoLGF = false;
 				break;
+
+			case 'o':
+				octreeDirectory = optarg;
+				break;
+
+			case 'b':
+				if (sscanf(optarg,"%llu", &pointBudget) != 1 || pointBudget == 0)
+				{
+					std::cerr << "Invalid point budget (-b)" << std::endl;
+					printUsage();
+				}
+				break;
+		}
+	}
+
+	if( octreeDirectory.size() > 0 ){
+		try
+		{
+			viewOctree( octreeDirectory, pointBudget );
+		}
+		catch ( Exception * error )
+		{
+			cout << error->what();
+
+			exit( 1 );
 		}
+
+		return 0;
 	}
 
 	if( LorTPresent == false ){
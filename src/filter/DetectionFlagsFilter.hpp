@@ -0,0 +1,56 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef DETECTIONFLAGSFILTER_HPP
+#define DETECTIONFLAGSFILTER_HPP
+
+#include "PingFilter.hpp"
+
+/*!
+* \brief Detection flags filter class.
+*
+* Rejects beams whose quality field doesn't have all of the required bits set, for formats that
+* report detection flags in it (ex: bit 0 brightness and bit 1 colinearity in Reson 7027 records)
+*
+* Extends from the Ping filter class
+*/
+class DetectionFlagsFilter : public PingFilter{
+public:
+
+  /**
+  * Creates a detection flags filter
+  *
+  * @param requiredFlags the bits that must be set in the quality field
+  */
+  DetectionFlagsFilter(uint32_t requiredFlags) : requiredFlags(requiredFlags){
+
+  }
+
+  /**Destroys the detection flags filter*/
+  ~DetectionFlagsFilter(){
+
+  }
+
+  /**
+  * Returns true if any of the required flags is missing
+  *
+  * @param ping the ping
+  */
+  bool filterPing(Ping & ping){
+    return (ping.getQuality() & requiredFlags) != requiredFlags;
+  }
+
+  /**Returns a short description of the rule*/
+  const char * getDescription(){
+    return "detection flags";
+  }
+
+private:
+
+  /**Bits that must be set in the quality field*/
+  uint32_t requiredFlags;
+
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef FILTERCHAIN_HPP
+#define FILTERCHAIN_HPP
+
+#include <stdint.h>
+#include <vector>
+#include "PointFilter.hpp"
+#include "PointBatch.hpp"
+
+/*!
+* \brief Filter chain class
+*
+* Applies a list of point filters to batches of points. Each filter only sees the mask words
+* that still hold kept points, and the chain stops as soon as a batch is entirely rejected.
+*/
+class FilterChain{
+public:
+
+  /**Creates an empty filter chain*/
+  FilterChain() : keepMask(POINT_BATCH_SIZE / 64,0){
+
+  }
+
+  /**Destroys the filter chain and its filters*/
+  ~FilterChain(){
+    for(auto i = filters.begin();i != filters.end();i++){
+      delete *i;
+    }
+  }
+
+  /**
+  * Appends a filter to the chain. The chain takes ownership of the filter
+  *
+  * @param filter the filter
+  */
+  void addFilter(PointFilter * filter){
+    filters.push_back(filter);
+  }
+
+  /**
+  * Filters a batch of points. Returns the keep mask, with bit i (word i/64, bit i%64) set if point i is kept
+  *
+  * @param batch the points
+  */
+  const uint64_t * apply(const PointBatch & batch){
+    unsigned int words = batch.getMaskWords();
+
+    for(unsigned int w=0;w<words;w++){
+      keepMask[w] = ~(uint64_t)0;
+    }
+
+    //lanes past the end of the batch are never kept
+    if(batch.count % 64){
+      keepMask[words - 1] = ((uint64_t)1 << (batch.count % 64)) - 1;
+    }
+
+    for(auto i = filters.begin();i != filters.end() && anyKept(words);i++){
+      (*i)->filterBatch(batch,&keepMask[0]);
+    }
+
+    return &keepMask[0];
+  }
+
+  /**
+  * Returns true if point i is kept according to a keep mask
+  *
+  * @param mask the keep mask
+  * @param i index of the point
+  */
+  static bool isKept(const uint64_t * mask,unsigned int i){
+    return (mask[i >> 6] >> (i & 63)) & 1;
+  }
+
+private:
+
+  /**
+  * Returns true if any point of the current batch is still kept
+  *
+  * @param words number of mask words in the batch
+  */
+  bool anyKept(unsigned int words){
+    for(unsigned int w=0;w<words;w++){
+      if(keepMask[w]){
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**The filters, applied in order*/
+  std::vector<PointFilter *> filters;
+
+  /**Keep mask of the last batch*/
+  std::vector<uint64_t> keepMask;
+};
+
+#endif
@@ -0,0 +1,372 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef GRIDOUTLIERFILTER_HPP
+#define GRIDOUTLIERFILTER_HPP
+
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include "PointFilter.hpp"
+#include "PointBatch.hpp"
+#include "../gridding/TileKey.hpp"
+#include "../utils/ParallelFor.hpp"
+
+/*!
+* \brief Grid outlier filter class
+*
+* Bins soundings in a horizontal grid and rejects those whose depth is more than k robust standard
+* deviations (1.4826 * median absolute deviation) away from the median of their neighbourhood.
+*
+* The filter works in two passes: accumulate() is called for every point (streaming), then reduce()
+* sorts each tile's depths by cell into one flat array and computes the statistics of every cell in
+* parallel, tile by tile. Each cell's neighbourhood extends
+* by a halo of cells around it, reaching into adjacent tiles. Points can then be classified with
+* filterPoint() or filterBatch().
+*
+* Meant for local or projected frames (georeference -L), where z is a depth.
+*
+* Extends from the Point filter class
+*/
+class GridOutlierFilter : public PointFilter{
+public:
+
+  /**
+  * Creates a grid outlier filter
+  *
+  * @param cellSize size of the grid cells
+  * @param threshold number of robust standard deviations beyond which a point is rejected
+  * @param halo number of neighbouring cells on each side included in the statistics of a cell
+  * @param minimumPoints minimal number of points in a neighbourhood to reject anything in it
+  * @param minimumDeviation floor on the robust standard deviation, so flat areas don't reject tiny differences
+  */
+  GridOutlierFilter(double cellSize,double threshold = 3.0,unsigned int halo = 1,unsigned int minimumPoints = 5,double minimumDeviation = 0.01)
+  : cellSize(cellSize), threshold(threshold), halo(std::min(halo,(unsigned int)TILE_SIZE)), minimumPoints(minimumPoints), minimumDeviation(minimumDeviation){
+
+  }
+
+  /**Destroys the grid outlier filter*/
+  ~GridOutlierFilter(){
+    for(auto i = tiles.begin();i != tiles.end();i++){
+      delete i->second;
+    }
+  }
+
+  /**
+  * Adds a sounding to the grid. Soundings with non-finite coordinates are ignored
+  *
+  * @param x x position of the point
+  * @param y y position of the point
+  * @param z z position of the point
+  */
+  void accumulate(double x,double y,double z){
+    if(!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z)){
+      return;
+    }
+
+    int64_t cellX = cellIndex(x);
+    int64_t cellY = cellIndex(y);
+    TileKey key = {tileIndex(cellX,TILE_SIZE),tileIndex(cellY,TILE_SIZE)};
+
+    auto found = tiles.find(key);
+    GridTile * tile;
+
+    if(found == tiles.end()){
+      tile = new GridTile(z);
+      tiles[key] = tile;
+    }
+    else{
+      tile = found->second;
+    }
+
+    tile->pendingDepths.push_back((float)(z - tile->reference));
+    tile->pendingCells.push_back((uint16_t)cellOffset(cellX,cellY));
+  }
+
+  /**
+  * Adds the kept points of a batch to the grid
+  *
+  * @param batch the points
+  * @param keepMask one bit per point, set if the point is to be accumulated
+  */
+  void accumulate(const PointBatch & batch,const uint64_t * keepMask){
+    for(unsigned int i=0;i<batch.count;i++){
+      if((keepMask[i >> 6] >> (i & 63)) & 1){
+        accumulate(batch.x[i],batch.y[i],batch.z[i]);
+      }
+    }
+  }
+
+  /**
+  * Computes the median and robust standard deviation of every cell's neighbourhood, one tile per thread at a time.
+  * Soundings accumulated after a reduction are added to those of the previous ones
+  *
+  * @param threadCount number of threads, or 0 to use every hardware thread
+  */
+  void reduce(unsigned int threadCount = 0){
+    //link every tile to its neighbours once, so the workers never search the tile map
+    std::vector<GridTile *> work;
+
+    for(auto i = tiles.begin();i != tiles.end();i++){
+      for(int dy=-1;dy<=1;dy++){
+        for(int dx=-1;dx<=1;dx++){
+          TileKey neighbourKey = {i->first.x + dx,i->first.y + dy};
+          auto neighbour = tiles.find(neighbourKey);
+          i->second->neighbours[(dy + 1) * 3 + dx + 1] = (neighbour != tiles.end()) ? neighbour->second : NULL;
+        }
+      }
+
+      work.push_back(i->second);
+    }
+
+    if(threadCount == 0){
+      threadCount = ParallelFor::defaultThreadCount();
+    }
+
+    //every tile must be sorted by cell before any of its neighbours reads its halo
+    ParallelFor::run(work.size(),[&work](unsigned int i,unsigned int thread){
+      sortTile(*work[i]);
+    },threadCount);
+
+    std::vector<std::vector<float> > neighbourhoods(threadCount);
+
+    ParallelFor::run(work.size(),[this,&work,&neighbourhoods](unsigned int i,unsigned int thread){
+      reduceTile(*work[i],neighbourhoods[thread]);
+    },threadCount);
+  }
+
+  /**
+  * Returns true if the point is too far from the median depth of its neighbourhood.
+  * Points outside of the accumulated grid, or in sparse neighbourhoods, are kept
+  *
+  * @param microEpoch timestamp of the point
+  * @param x x position of the point
+  * @param y y position of the point
+  * @param z z position of the point
+  * @param quality quality of the point
+  * @param intensity intensity of the point
+  */
+  bool filterPoint(uint64_t microEpoch,double x,double y,double z, uint32_t quality,uint32_t intensity){
+    if(!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z)){
+      return false;
+    }
+
+    int64_t cellX = cellIndex(x);
+    int64_t cellY = cellIndex(y);
+    TileKey key = {tileIndex(cellX,TILE_SIZE),tileIndex(cellY,TILE_SIZE)};
+
+    auto found = tiles.find(key);
+
+    if(found == tiles.end()){
+      return false;
+    }
+
+    GridTile * tile = found->second;
+    unsigned int offset = cellOffset(cellX,cellY);
+
+    if(tile->deviation[offset] <= 0){
+      return false;
+    }
+
+    return std::fabs(z - tile->reference - tile->median[offset]) > threshold * tile->deviation[offset];
+  }
+
+  /**Returns the number of grid tiles holding soundings*/
+  unsigned int getTileCount() const{
+    return tiles.size();
+  }
+
+private:
+
+  /**Number of cells along each side of a tile*/
+  static const int TILE_SIZE = 64;
+
+  /*!
+  * \brief Grid tile
+  *
+  * Depths are stored as floats relative to the first depth seen in the tile: appended with their cell
+  * as they are accumulated, then sorted by cell into a single array before the reduction
+  */
+  class GridTile{
+  public:
+
+    /**
+    * Creates an empty tile
+    *
+    * @param reference depth from which the tile's depths are stored
+    */
+    GridTile(double reference) : reference(reference), cellStart(TILE_SIZE*TILE_SIZE + 1,0){
+      for(unsigned int i=0;i<TILE_SIZE*TILE_SIZE;i++){
+        median[i] = 0;
+        deviation[i] = -1;
+      }
+
+      for(unsigned int i=0;i<9;i++){
+        neighbours[i] = NULL;
+      }
+    }
+
+    /**Depth from which the tile's depths are stored*/
+    double reference;
+
+    /**Depths accumulated since the last reduction, relative to reference*/
+    std::vector<float> pendingDepths;
+
+    /**Cell offset of each pending depth*/
+    std::vector<uint16_t> pendingCells;
+
+    /**Depths sorted by cell, relative to reference*/
+    std::vector<float> depths;
+
+    /**Index of the first depth of each cell in depths, followed by the number of depths*/
+    std::vector<uint32_t> cellStart;
+
+    /**Median depth of each cell's neighbourhood, relative to reference*/
+    float median[TILE_SIZE*TILE_SIZE];
+
+    /**Robust standard deviation of each cell's neighbourhood, negative when there isn't enough data*/
+    float deviation[TILE_SIZE*TILE_SIZE];
+
+    /**The 3x3 block of tiles centered on this one, NULL where there is none*/
+    GridTile * neighbours[9];
+  };
+
+  /**
+  * Sorts the pending depths of a tile by cell, after the depths of the previous reductions (counting sort)
+  *
+  * @param tile the tile
+  */
+  static void sortTile(GridTile & tile){
+    if(tile.pendingCells.empty()){
+      return;
+    }
+
+    std::vector<uint32_t> start(TILE_SIZE*TILE_SIZE + 1,0);
+
+    for(unsigned int c=0;c<TILE_SIZE*TILE_SIZE;c++){
+      start[c + 1] = tile.cellStart[c + 1] - tile.cellStart[c];
+    }
+
+    for(unsigned int i=0;i<tile.pendingCells.size();i++){
+      start[tile.pendingCells[i] + 1]++;
+    }
+
+    for(unsigned int c=0;c<TILE_SIZE*TILE_SIZE;c++){
+      start[c + 1] += start[c];
+    }
+
+    std::vector<float> sorted(start[TILE_SIZE*TILE_SIZE]);
+    std::vector<uint32_t> next(start.begin(),start.end() - 1);
+
+    for(unsigned int c=0;c<TILE_SIZE*TILE_SIZE;c++){
+      for(uint32_t i=tile.cellStart[c];i<tile.cellStart[c + 1];i++){
+        sorted[next[c]++] = tile.depths[i];
+      }
+    }
+
+    for(unsigned int i=0;i<tile.pendingCells.size();i++){
+      sorted[next[tile.pendingCells[i]]++] = tile.pendingDepths[i];
+    }
+
+    tile.depths.swap(sorted);
+    tile.cellStart.swap(start);
+
+    //release the pending depths' memory
+    std::vector<float>().swap(tile.pendingDepths);
+    std::vector<uint16_t>().swap(tile.pendingCells);
+  }
+
+  /**
+  * Computes the statistics of the cells of a tile
+  *
+  * @param tile the tile
+  * @param neighbourhood scratch space for the depths of a neighbourhood
+  */
+  void reduceTile(GridTile & tile,std::vector<float> & neighbourhood){
+    int reach = (int)halo;
+
+    for(int cy=0;cy<TILE_SIZE;cy++){
+      for(int cx=0;cx<TILE_SIZE;cx++){
+        unsigned int offset = cy * TILE_SIZE + cx;
+
+        if(tile.cellStart[offset] == tile.cellStart[offset + 1]){
+          continue;
+        }
+
+        neighbourhood.clear();
+
+        for(int ny=cy-reach;ny<=cy+reach;ny++){
+          for(int nx=cx-reach;nx<=cx+reach;nx++){
+            //halo cells may lie in an adjacent tile
+            int tileDx = (nx < 0) ? -1 : ((nx >= TILE_SIZE) ? 1 : 0);
+            int tileDy = (ny < 0) ? -1 : ((ny >= TILE_SIZE) ? 1 : 0);
+            GridTile * source = tile.neighbours[(tileDy + 1) * 3 + tileDx + 1];
+
+            if(!source){
+              continue;
+            }
+
+            unsigned int sourceOffset = (ny - tileDy * TILE_SIZE) * TILE_SIZE + (nx - tileDx * TILE_SIZE);
+            float shift = (float)(source->reference - tile.reference);
+
+            for(uint32_t i=source->cellStart[sourceOffset];i<source->cellStart[sourceOffset + 1];i++){
+              neighbourhood.push_back(source->depths[i] + shift);
+            }
+          }
+        }
+
+        if(neighbourhood.size() < minimumPoints || neighbourhood.empty()){
+          continue;
+        }
+
+        size_t middle = neighbourhood.size() / 2;
+        std::nth_element(neighbourhood.begin(),neighbourhood.begin() + middle,neighbourhood.end());
+        float median = neighbourhood[middle];
+
+        for(unsigned int i=0;i<neighbourhood.size();i++){
+          neighbourhood[i] = std::fabs(neighbourhood[i] - median);
+        }
+
+        std::nth_element(neighbourhood.begin(),neighbourhood.begin() + middle,neighbourhood.end());
+
+        tile.median[offset] = median;
+        tile.deviation[offset] = (float)std::max(1.4826 * neighbourhood[middle],minimumDeviation);
+      }
+    }
+  }
+
+  /**Returns the grid cell index of a coordinate*/
+  int64_t cellIndex(double coordinate) const{
+    return (int64_t)std::floor(coordinate / cellSize);
+  }
+
+  /**Returns the offset of a cell inside its tile*/
+  static unsigned int cellOffset(int64_t cellX,int64_t cellY){
+    unsigned int localX = (unsigned int)(cellX - tileIndex(cellX,TILE_SIZE) * TILE_SIZE);
+    unsigned int localY = (unsigned int)(cellY - tileIndex(cellY,TILE_SIZE) * TILE_SIZE);
+    return localY * TILE_SIZE + localX;
+  }
+
+  /**Size of the grid cells*/
+  double cellSize;
+
+  /**Number of robust standard deviations beyond which a point is rejected*/
+  double threshold;
+
+  /**Number of neighbouring cells on each side included in a cell's statistics*/
+  unsigned int halo;
+
+  /**Minimal number of points in a neighbourhood to reject anything in it*/
+  unsigned int minimumPoints;
+
+  /**Floor on the robust standard deviation*/
+  double minimumDeviation;
+
+  /**Tiles holding soundings*/
+  std::unordered_map<TileKey,GridTile *,TileKeyHash,TileKeyEqual> tiles;
+};
+
+#endif
@@ -7,6 +7,13 @@
 
 #include "PointFilter.hpp"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**Coordinates beyond this absolute value are considered insane*/
+#define INSANE_POSITION_LIMIT (1.00*100000000)
+
 /*!
 * \brief Insane position filter class.
 * \author Emile Gagne
@@ -39,11 +46,59 @@ public:
   * @param intensity intensity of the point
   */
   bool filterPoint(uint64_t microEpoch,double x,double y,double z, uint32_t quality,uint32_t intensity){
-    bool insaneX = ((x>1.00*100000000)||(x<-1.00*100000000));
-    bool insaneY = ((y>1.00*100000000)||(y<-1.00*100000000));
-    bool insaneZ = ((z>1.00*100000000)||(z<-1.00*100000000));
+    bool insaneX = ((x>INSANE_POSITION_LIMIT)||(x<-INSANE_POSITION_LIMIT));
+    bool insaneY = ((y>INSANE_POSITION_LIMIT)||(y<-INSANE_POSITION_LIMIT));
+    bool insaneZ = ((z>INSANE_POSITION_LIMIT)||(z<-INSANE_POSITION_LIMIT));
     return (insaneX||insaneY||insaneZ);
   }
+
+  /**
+  * Filters a batch of points 64 at a time, two coordinates per SSE2 comparison when available.
+  * NaN coordinates are kept, like filterPoint does
+  *
+  * @param batch the points
+  * @param keepMask one bit per point, cleared if the point is removed
+  */
+  void filterBatch(const PointBatch & batch,uint64_t * keepMask){
+#ifdef __SSE2__
+    const __m128d maximum = _mm_set1_pd(INSANE_POSITION_LIMIT);
+    const __m128d minimum = _mm_set1_pd(-INSANE_POSITION_LIMIT);
+#endif
+
+    for(unsigned int w=0;w<batch.getMaskWords();w++){
+      if(!keepMask[w]){
+        continue;
+      }
+
+      const double * x = &batch.x[w * 64];
+      const double * y = &batch.y[w * 64];
+      const double * z = &batch.z[w * 64];
+      uint64_t rejected = 0;
+
+#ifdef __SSE2__
+      for(unsigned int i=0;i<64;i+=2){
+        __m128d lx = _mm_loadu_pd(x + i);
+        __m128d ly = _mm_loadu_pd(y + i);
+        __m128d lz = _mm_loadu_pd(z + i);
+
+        __m128d insane = _mm_or_pd(_mm_cmpgt_pd(lx,maximum),_mm_cmplt_pd(lx,minimum));
+        insane = _mm_or_pd(insane,_mm_or_pd(_mm_cmpgt_pd(ly,maximum),_mm_cmplt_pd(ly,minimum)));
+        insane = _mm_or_pd(insane,_mm_or_pd(_mm_cmpgt_pd(lz,maximum),_mm_cmplt_pd(lz,minimum)));
+
+        rejected |= (uint64_t)_mm_movemask_pd(insane) << i;
+      }
+#else
+      for(unsigned int i=0;i<64;i++){
+        bool insane = (x[i] > INSANE_POSITION_LIMIT) || (x[i] < -INSANE_POSITION_LIMIT) ||
+                      (y[i] > INSANE_POSITION_LIMIT) || (y[i] < -INSANE_POSITION_LIMIT) ||
+                      (z[i] > INSANE_POSITION_LIMIT) || (z[i] < -INSANE_POSITION_LIMIT);
+        rejected |= (uint64_t)insane << i;
+      }
+#endif
+
+      keepMask[w] &= ~rejected;
+    }
+  }
 };
 
 #endif
@@ -7,6 +7,10 @@
 
 #include "PointFilter.hpp"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /*!
 * \brief Intensity filter class.
 * \author Emile Gagne
@@ -45,6 +49,45 @@ public:
     return intensity < minimumIntensity;
   }
 
+  /**
+  * Filters a batch of points 64 at a time, four intensities per SSE2 comparison when available.
+  * Intensities are compared as unsigned values, like filterPoint does
+  *
+  * @param batch the points
+  * @param keepMask one bit per point, cleared if the point is removed
+  */
+  void filterBatch(const PointBatch & batch,uint64_t * keepMask){
+    const uint32_t threshold = minimumIntensity;
+#ifdef __SSE2__
+    //SSE2 only compares signed integers: flipping the sign bit of both sides gives the unsigned order
+    const __m128i signBit = _mm_set1_epi32((int)0x80000000);
+    const __m128i biasedThreshold = _mm_set1_epi32((int)(threshold ^ 0x80000000));
+#endif
+
+    for(unsigned int w=0;w<batch.getMaskWords();w++){
+      if(!keepMask[w]){
+        continue;
+      }
+
+      const int32_t * intensity = &batch.intensity[w * 64];
+      uint64_t rejected = 0;
+
+#ifdef __SSE2__
+      for(unsigned int i=0;i<64;i+=4){
+        __m128i lanes = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(intensity + i)),signBit);
+        __m128i low = _mm_cmplt_epi32(lanes,biasedThreshold);
+        rejected |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(low)) << i;
+      }
+#else
+      for(unsigned int i=0;i<64;i++){
+        rejected |= (uint64_t)((uint32_t)intensity[i] < threshold) << i;
+      }
+#endif
+
+      keepMask[w] &= ~rejected;
+    }
+  }
+
 private:
 
   /**Minimal intensity accepted*/
@@ -0,0 +1,39 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef PINGFILTER_HPP
+#define PINGFILTER_HPP
+
+#include "../Ping.hpp"
+
+/*!
+* \brief Ping filter class
+*
+* Rejects beams before they are georeferenced, so that they don't go through interpolation and raytracing
+*/
+class PingFilter{
+public:
+
+  /**Creates a ping filter*/
+  PingFilter(){
+
+  }
+
+  /**Destroys the ping filter*/
+  virtual ~PingFilter(){
+
+  }
+
+  /**
+  * Returns true if we removed this ping
+  *
+  * @param ping the ping
+  */
+  virtual bool filterPing(Ping & ping) = 0;
+
+  /**Returns a short description of the rule, for reports*/
+  virtual const char * getDescription() = 0;
+};
+
+#endif
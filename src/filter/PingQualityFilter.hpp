@@ -0,0 +1,53 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef PINGQUALITYFILTER_HPP
+#define PINGQUALITYFILTER_HPP
+
+#include "PingFilter.hpp"
+
+/*!
+* \brief Ping quality filter class.
+*
+* Extends from the Ping filter class
+*/
+class PingQualityFilter : public PingFilter{
+public:
+
+  /**
+  * Creates a ping quality filter
+  *
+  * @param minimumQuality the minimal quality accepted
+  */
+  PingQualityFilter(unsigned int minimumQuality) : minimumQuality(minimumQuality){
+
+  }
+
+  /**Destroys the ping quality filter*/
+  ~PingQualityFilter(){
+
+  }
+
+  /**
+  * Returns true if the quality of the ping is lower than the minimum accepted
+  *
+  * @param ping the ping
+  */
+  bool filterPing(Ping & ping){
+    return ping.getQuality() < minimumQuality;
+  }
+
+  /**Returns a short description of the rule*/
+  const char * getDescription(){
+    return "quality";
+  }
+
+private:
+
+  /**Minimal quality accepted*/
+  unsigned int minimumQuality;
+
+};
+
+#endif
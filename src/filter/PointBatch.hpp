@@ -0,0 +1,126 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef POINTBATCH_HPP
+#define POINTBATCH_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <cmath>
+#include "../PointRecord.hpp"
+
+/*!
+* \brief Point batch class
+*
+* Structure-of-arrays view of up to POINT_BATCH_SIZE points, as consumed by the batch filters.
+* The arrays are always POINT_BATCH_SIZE long (a multiple of 64) so that filters can work on whole
+* keep mask words; lanes past count hold stale but valid values.
+*/
+class PointBatch{
+public:
+
+  /**Creates an empty point batch*/
+  PointBatch() : x(POINT_BATCH_SIZE,0), y(POINT_BATCH_SIZE,0), z(POINT_BATCH_SIZE,0), quality(POINT_BATCH_SIZE,0), intensity(POINT_BATCH_SIZE,0), horizontalUncertainty(POINT_BATCH_SIZE,NAN), verticalUncertainty(POINT_BATCH_SIZE,NAN), count(0){
+
+  }
+
+  /**Destroys the point batch*/
+  ~PointBatch(){
+
+  }
+
+  /**
+  * Appends a point. Returns false if the batch is full
+  *
+  * @param px x position of the point
+  * @param py y position of the point
+  * @param pz z position of the point
+  * @param pquality quality of the point
+  * @param pintensity intensity of the point
+  * @param phorizontalUncertainty horizontal uncertainty of the point, NaN if unknown
+  * @param pverticalUncertainty vertical uncertainty of the point, NaN if unknown
+  */
+  bool add(double px,double py,double pz,uint32_t pquality,int32_t pintensity,float phorizontalUncertainty = NAN,float pverticalUncertainty = NAN){
+    if(count >= POINT_BATCH_SIZE){
+      return false;
+    }
+
+    x[count] = px;
+    y[count] = py;
+    z[count] = pz;
+    quality[count] = pquality;
+    intensity[count] = pintensity;
+    horizontalUncertainty[count] = phorizontalUncertainty;
+    verticalUncertainty[count] = pverticalUncertainty;
+    count++;
+
+    return true;
+  }
+
+  /**
+  * Replaces the batch content with binary point records
+  *
+  * @param records the records
+  * @param n number of records, at most POINT_BATCH_SIZE
+  */
+  void setRecords(const PointRecord * records,unsigned int n){
+    for(unsigned int i=0;i<n;i++){
+      x[i] = records[i].x;
+      y[i] = records[i].y;
+      z[i] = records[i].z;
+      quality[i] = records[i].quality;
+      intensity[i] = records[i].intensity;
+      horizontalUncertainty[i] = records[i].horizontalUncertainty;
+      verticalUncertainty[i] = records[i].verticalUncertainty;
+    }
+
+    count = n;
+  }
+
+  /**
+  * Returns point i as a binary point record
+  *
+  * @param i index of the point
+  */
+  PointRecord getRecord(unsigned int i) const{
+    PointRecord record = {x[i],y[i],z[i],quality[i],intensity[i],horizontalUncertainty[i],verticalUncertainty[i]};
+    return record;
+  }
+
+  /**Empties the batch*/
+  void clear(){
+    count = 0;
+  }
+
+  /**Number of keep mask words covering the batch*/
+  unsigned int getMaskWords() const{
+    return (count + 63) / 64;
+  }
+
+  /**x positions*/
+  std::vector<double> x;
+
+  /**y positions*/
+  std::vector<double> y;
+
+  /**z positions*/
+  std::vector<double> z;
+
+  /**qualities*/
+  std::vector<uint32_t> quality;
+
+  /**intensities*/
+  std::vector<int32_t> intensity;
+
+  /**horizontal uncertainties, NaN if unknown*/
+  std::vector<float> horizontalUncertainty;
+
+  /**vertical uncertainties, NaN if unknown*/
+  std::vector<float> verticalUncertainty;
+
+  /**Number of points in the batch*/
+  unsigned int count;
+};
+
+#endif
@@ -5,6 +5,9 @@
 #ifndef POINTFILTER_HPP
 #define POINTFILTER_HPP
 
+#include <stdint.h>
+#include "PointBatch.hpp"
+
 /*!
 * \brief Point filter class
 * \author Guillaume Labbe-Morissette
@@ -18,7 +21,7 @@ public:
   }
 
   /**Destroys the point filter*/
-  ~PointFilter(){
+  virtual ~PointFilter(){
 
   }
 
@@ -33,6 +36,29 @@ public:
   * @param intensity intensity of the point
   */
   virtual bool filterPoint(uint64_t microEpoch,double x,double y,double z, uint32_t quality,uint32_t intensity) = 0;
+
+  /**
+  * Filters a batch of points. Bit i of keepMask (word i/64, bit i%64) is cleared if point i is removed.
+  * Words that are already zero must be skipped, and bits already cleared must stay cleared
+  *
+  * @param batch the points
+  * @param keepMask one bit per point, set if the point is kept so far
+  */
+  virtual void filterBatch(const PointBatch & batch,uint64_t * keepMask){
+    for(unsigned int w=0;w<batch.getMaskWords();w++){
+      if(!keepMask[w]){
+        continue;
+      }
+
+      for(unsigned int bit=0;bit<64;bit++){
+        unsigned int i = w * 64 + bit;
+
+        if(((keepMask[w] >> bit) & 1) && filterPoint(0,batch.x[i],batch.y[i],batch.z[i],batch.quality[i],batch.intensity[i])){
+          keepMask[w] &= ~((uint64_t)1 << bit);
+        }
+      }
+    }
+  }
 };
 
 #endif
@@ -0,0 +1,56 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef SWATHWIDTHFILTER_HPP
+#define SWATHWIDTHFILTER_HPP
+
+#include <cmath>
+#include "PingFilter.hpp"
+
+/*!
+* \brief Swath width filter class.
+*
+* Rejects beams whose across track angle is outside of a swath centered on nadir
+*
+* Extends from the Ping filter class
+*/
+class SwathWidthFilter : public PingFilter{
+public:
+
+  /**
+  * Creates a swath width filter
+  *
+  * @param swathWidth total angular width of the swath to keep (degrees)
+  */
+  SwathWidthFilter(double swathWidth) : maximumAngle(swathWidth / 2){
+
+  }
+
+  /**Destroys the swath width filter*/
+  ~SwathWidthFilter(){
+
+  }
+
+  /**
+  * Returns true if the across track angle of the ping is outside of the swath
+  *
+  * @param ping the ping
+  */
+  bool filterPing(Ping & ping){
+    return std::fabs(ping.getAcrossTrackAngle()) > maximumAngle;
+  }
+
+  /**Returns a short description of the rule*/
+  const char * getDescription(){
+    return "swath width";
+  }
+
+private:
+
+  /**Largest across track angle accepted on either side (degrees)*/
+  double maximumAngle;
+
+};
+
+#endif
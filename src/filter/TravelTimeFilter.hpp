@@ -0,0 +1,47 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef TRAVELTIMEFILTER_HPP
+#define TRAVELTIMEFILTER_HPP
+
+#include <cmath>
+#include "PingFilter.hpp"
+
+/*!
+* \brief Travel time filter class.
+*
+* Rejects beams without a detection: zero, negative or invalid two-way travel times
+*
+* Extends from the Ping filter class
+*/
+class TravelTimeFilter : public PingFilter{
+public:
+
+  /**Creates a travel time filter*/
+  TravelTimeFilter(){
+
+  }
+
+  /**Destroys the travel time filter*/
+  ~TravelTimeFilter(){
+
+  }
+
+  /**
+  * Returns true if the two-way travel time of the ping isn't a positive number
+  *
+  * @param ping the ping
+  */
+  bool filterPing(Ping & ping){
+    double twoWayTravelTime = ping.getTwoWayTravelTime();
+    return !(twoWayTravelTime > 0) || !std::isfinite(twoWayTravelTime);
+  }
+
+  /**Returns a short description of the rule*/
+  const char * getDescription(){
+    return "two-way travel time";
+  }
+};
+
+#endif
@@ -0,0 +1,204 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef BOUNDINGBOXTREE_HPP
+#define BOUNDINGBOXTREE_HPP
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/**
+* 2D axis aligned bounding box
+*/
+typedef struct{
+    double minimumX;
+    double minimumY;
+    double maximumX;
+    double maximumY;
+} BoundingBox;
+
+/*!
+* \brief Bounding box tree class
+*
+* Static R-tree of 2D bounding boxes, bulk loaded with the Sort-Tile-Recursive method: the boxes are sorted
+* in vertical slices by x, each slice by y, and packed NODE_SIZE at a time, level by level up to the root.
+* Finds the boxes intersecting a query box without testing every box.
+*/
+class BoundingBoxTree{
+public:
+
+    /**Number of children per node*/
+    static const unsigned int NODE_SIZE = 8;
+
+    /**
+    * Builds the tree
+    *
+    * @param boxes the boxes, referred to by their index
+    */
+    BoundingBoxTree(const std::vector<BoundingBox> & boxes) : boxes(boxes){
+        std::vector<unsigned int> entries(boxes.size());
+
+        for(unsigned int i=0;i<entries.size();i++){
+            entries[i] = i;
+        }
+
+        //leaves point to the boxes, the nodes of each level above point to the nodes of the level below
+        std::vector<BoundingBox> levelBoxes = boxes;
+        unsigned int levelStart = 0;
+        bool leaf = true;
+
+        while(leaf || entries.size() > 1){
+            pack(levelBoxes,entries,leaf);
+            leaf = false;
+
+            entries.resize(nodes.size() - levelStart);
+            levelBoxes.resize(entries.size());
+
+            for(unsigned int i=0;i<entries.size();i++){
+                entries[i] = levelStart + i;
+                levelBoxes[i] = nodes[levelStart + i].box;
+            }
+
+            levelStart = nodes.size();
+
+            if(entries.empty()){
+                break;
+            }
+        }
+    }
+
+    /**Destroys the tree*/
+    ~BoundingBoxTree(){
+
+    }
+
+    /**
+    * Finds the boxes intersecting a box, touching included
+    *
+    * @param box the query box
+    * @param found the indices of the intersecting boxes, in increasing order
+    */
+    void query(const BoundingBox & box,std::vector<unsigned int> & found) const{
+        found.clear();
+
+        if(nodes.empty()){
+            return;
+        }
+
+        std::vector<unsigned int> stack(1,nodes.size() - 1);
+
+        while(!stack.empty()){
+            const Node & node = nodes[stack.back()];
+            stack.pop_back();
+
+            for(unsigned int c=node.firstChild;c<node.firstChild + node.childCount;c++){
+                unsigned int child = children[c];
+
+                if(node.leaf){
+                    if(intersects(boxes[child],box)){
+                        found.push_back(child);
+                    }
+                }
+                else if(intersects(nodes[child].box,box)){
+                    stack.push_back(child);
+                }
+            }
+        }
+
+        std::sort(found.begin(),found.end());
+    }
+
+    /**
+    * Returns true if two boxes intersect, touching included
+    *
+    * @param a a box
+    * @param b another box
+    */
+    static bool intersects(const BoundingBox & a,const BoundingBox & b){
+        return a.minimumX <= b.maximumX && b.minimumX <= a.maximumX && a.minimumY <= b.maximumY && b.minimumY <= a.maximumY;
+    }
+
+private:
+
+    /**Node of the tree*/
+    typedef struct{
+        BoundingBox box;
+        unsigned int firstChild;
+        unsigned int childCount;
+        bool leaf;
+    } Node;
+
+    /**
+    * Packs the entries of a level into nodes
+    *
+    * @param levelBoxes the box of each entry
+    * @param entries the entries (box indices for the leaves, node indices above)
+    * @param leaf true if the entries are boxes
+    */
+    void pack(const std::vector<BoundingBox> & levelBoxes,std::vector<unsigned int> & entries,bool leaf){
+        unsigned int count = entries.size();
+        unsigned int nodeCount = (count + NODE_SIZE - 1) / NODE_SIZE;
+        unsigned int sliceCount = std::max(1u,(unsigned int)std::ceil(std::sqrt((double)nodeCount)));
+        unsigned int sliceSize = sliceCount * NODE_SIZE;
+
+        std::vector<unsigned int> order(count);
+
+        for(unsigned int i=0;i<count;i++){
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(),order.end(),[&levelBoxes](unsigned int a,unsigned int b){
+            return getCenterX(levelBoxes[a]) < getCenterX(levelBoxes[b]);
+        });
+
+        for(unsigned int slice=0;slice<count;slice+=sliceSize){
+            std::stable_sort(order.begin() + slice,order.begin() + std::min(count,slice + sliceSize),[&levelBoxes](unsigned int a,unsigned int b){
+                return getCenterY(levelBoxes[a]) < getCenterY(levelBoxes[b]);
+            });
+
+            for(unsigned int first=slice;first<std::min(count,slice + sliceSize);first+=NODE_SIZE){
+                Node node;
+                node.firstChild = children.size();
+                node.childCount = 0;
+                node.leaf = leaf;
+                node.box = levelBoxes[order[first]];
+
+                for(unsigned int i=first;i<std::min(std::min(count,slice + sliceSize),first + NODE_SIZE);i++){
+                    const BoundingBox & box = levelBoxes[order[i]];
+                    node.box.minimumX = std::min(node.box.minimumX,box.minimumX);
+                    node.box.minimumY = std::min(node.box.minimumY,box.minimumY);
+                    node.box.maximumX = std::max(node.box.maximumX,box.maximumX);
+                    node.box.maximumY = std::max(node.box.maximumY,box.maximumY);
+
+                    children.push_back(entries[order[i]]);
+                    node.childCount++;
+                }
+
+                nodes.push_back(node);
+            }
+        }
+    }
+
+    /**Returns the center of a box along x*/
+    static double getCenterX(const BoundingBox & box){
+        return (box.minimumX + box.maximumX) / 2;
+    }
+
+    /**Returns the center of a box along y*/
+    static double getCenterY(const BoundingBox & box){
+        return (box.minimumY + box.maximumY) / 2;
+    }
+
+    /**The boxes*/
+    std::vector<BoundingBox> boxes;
+
+    /**Nodes, level by level from the leaves, the root last*/
+    std::vector<Node> nodes;
+
+    /**Children of the nodes: box indices for the leaves, node indices above*/
+    std::vector<unsigned int> children;
+};
+
+#endif
@@ -0,0 +1,288 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+ /*
+ * \author Christian Bouchard
+ */
+
+#ifndef CONVEXHULL_HPP
+#define CONVEXHULL_HPP
+
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "../utils/ParallelFor.hpp"
+
+
+//-----------------------------------------------------------------------------------
+// Andrew's monotone chain convex hull algorithm
+// Adapted from
+// https://en.wikibooks.org/wiki/Algorithm_Implementation/Geometry/Convex_hull/Monotone_chain#C++
+
+typedef float coord_t;      // coordinate type (Use float because pcl::PointXYZ's coordinates are float)
+typedef double coord2_t;    // must be big enough to hold 2*max(|coordinate|)^2
+
+struct PointAndrews
+{
+	coord_t x;
+    coord_t y;
+    uint64_t index;
+
+	bool operator <( const PointAndrews &p ) const
+    {
+		return x < p.x || (x == p.x && y < p.y);
+	}
+};
+
+
+// 3D cross product of OA and OB vectors, (i.e z-component of their "2D" cross product,
+// but remember that it is not defined in "2D").
+// Returns a positive value, if OAB makes a counter-clockwise turn,
+// negative for clockwise turn, and zero if the points are collinear.
+inline coord2_t cross( const PointAndrews &O, const PointAndrews &A, const PointAndrews &B )
+{
+	return (A.x - O.x) * (B.y - O.y) - (A.y - O.y) * (B.x - O.x);
+}
+
+// Returns a list of points on the convex hull in counter-clockwise order.
+// Note: the last point in the returned list is the same as the first one.
+// CB: vector points is modified by getting sorted.
+inline void AndrewsConvex_hull( std::vector<PointAndrews> & hull, std::vector<PointAndrews> & points )
+{
+	size_t n = points.size(), k = 0;
+
+    hull.clear();
+
+    if ( n <= 3 )
+    {
+        hull.reserve( n );
+
+        for ( size_t count = 0; count < n; count++ )
+            hull.push_back( points[ count ] );
+
+        return;
+    }
+
+    hull.resize( 2 * n );
+
+	// Sort points lexicographically
+	sort(points.begin(), points.end());
+
+	// Build lower hull
+	for (size_t i = 0; i < n; ++i)
+    {
+		while (k >= 2 && cross(hull[k-2], hull[k-1], points[i]) <= 0)
+            k--;
+
+		hull[k++] = points[i];
+	}
+
+	// Build upper hull
+	for (size_t i = n-1, t = k+1; i > 0; --i)
+    {
+		while (k >= t && cross(hull[k-2], hull[k-1], points[i-1]) <= 0)
+            k--;
+
+		hull[k++] = points[i-1];
+	}
+
+	hull.resize(k-1);
+
+}
+
+//-----------------------------------------------------------------------------------
+
+
+/*!
+* \brief Convex hull class
+*
+* Parallel Andrew's monotone chain for large point clouds, without copying and sorting every point:
+*
+* 1. Akl-Toussaint heuristic: the points with the lowest x, lowest y, highest x and highest y make a
+*    quadrilateral, and the points strictly inside it cannot be on the hull
+* 2. each thread computes the hull of the remaining points of its chunk of the cloud
+* 3. the hull of the chunk hulls is the hull of the cloud
+*
+* Gives the same vertices, in the same order, as AndrewsConvex_hull on the whole cloud (the index of a
+* vertex may differ when several points share its coordinates).
+*/
+class ConvexHull{
+public:
+
+    /**Number of points per parallel task*/
+    static const unsigned int POINTS_PER_TASK = 1 << 20;
+
+    /**
+    * Computes the convex hull of a point cloud. Points with NaN coordinates are ignored
+    *
+    * @param points the points, as a container of points with x and y members (e.g. pcl::PointCloud or a view computing them)
+    * @param hull the hull vertices in counter-clockwise order, with the index of each vertex in points
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    template<class Points>
+    static void computeAndrews(const Points & points,std::vector<PointAndrews> & hull,unsigned int threadCount = 0){
+        uint64_t count = points.size();
+        unsigned int taskCount = (count + POINTS_PER_TASK - 1) / POINTS_PER_TASK;
+
+        //too small to be worth it, and AndrewsConvex_hull keeps up to 3 points as they are
+        if(count <= 3){
+            std::vector<PointAndrews> all;
+
+            for(uint64_t i=0;i<count;i++){
+                PointAndrews point = makePoint(points[i],i);
+
+                if(!std::isnan(point.x) && !std::isnan(point.y)){
+                    all.push_back(point);
+                }
+            }
+
+            AndrewsConvex_hull(hull,all);
+            return;
+        }
+
+        //extreme points of each chunk: lowest x, lowest y, highest x, highest y
+        std::vector<PointAndrews> extremes(4 * taskCount);
+        std::vector<uint8_t> found(taskCount,0);
+
+        ParallelFor::run(taskCount,[&points,&extremes,&found,count](unsigned int task,unsigned int thread){
+            uint64_t end = std::min(count,(uint64_t)(task + 1) * POINTS_PER_TASK);
+            PointAndrews * extreme = &extremes[4 * task];
+
+            for(uint64_t i=(uint64_t)task * POINTS_PER_TASK;i<end;i++){
+                PointAndrews point = makePoint(points[i],i);
+
+                if(std::isnan(point.x) || std::isnan(point.y)){
+                    continue;
+                }
+
+                if(!found[task]){
+                    extreme[0] = extreme[1] = extreme[2] = extreme[3] = point;
+                    found[task] = 1;
+                }
+
+                if(point.x < extreme[0].x) extreme[0] = point;
+                if(point.y < extreme[1].y) extreme[1] = point;
+                if(point.x > extreme[2].x) extreme[2] = point;
+                if(point.y > extreme[3].y) extreme[3] = point;
+            }
+        },threadCount);
+
+        PointAndrews quadrilateral[4];
+        bool any = false;
+
+        for(unsigned int task=0;task<taskCount;task++){
+            if(!found[task]){
+                continue;
+            }
+
+            const PointAndrews * extreme = &extremes[4 * task];
+
+            if(!any){
+                std::copy(extreme,extreme + 4,quadrilateral);
+                any = true;
+            }
+
+            if(extreme[0].x < quadrilateral[0].x) quadrilateral[0] = extreme[0];
+            if(extreme[1].y < quadrilateral[1].y) quadrilateral[1] = extreme[1];
+            if(extreme[2].x > quadrilateral[2].x) quadrilateral[2] = extreme[2];
+            if(extreme[3].y > quadrilateral[3].y) quadrilateral[3] = extreme[3];
+        }
+
+        //hull of the points of each chunk outside the quadrilateral
+        std::vector<std::vector<PointAndrews> > chunkHulls(taskCount);
+
+        ParallelFor::run(taskCount,[&points,&chunkHulls,&quadrilateral,count](unsigned int task,unsigned int thread){
+            uint64_t end = std::min(count,(uint64_t)(task + 1) * POINTS_PER_TASK);
+            std::vector<PointAndrews> candidates;
+
+            for(uint64_t i=(uint64_t)task * POINTS_PER_TASK;i<end;i++){
+                PointAndrews point = makePoint(points[i],i);
+
+                if(!std::isnan(point.x) && !std::isnan(point.y) && !isInside(quadrilateral,point)){
+                    candidates.push_back(point);
+                }
+            }
+
+            AndrewsConvex_hull(chunkHulls[task],candidates);
+        },threadCount);
+
+        std::vector<PointAndrews> merged;
+
+        for(unsigned int task=0;task<taskCount;task++){
+            merged.insert(merged.end(),chunkHulls[task].begin(),chunkHulls[task].end());
+            std::vector<PointAndrews>().swap(chunkHulls[task]);
+        }
+
+        if(merged.size() > 3){
+            AndrewsConvex_hull(hull,merged);
+        }
+        else{
+            orderSmallHull(hull,merged);
+        }
+    }
+
+private:
+
+    /**
+    * Makes a hull point
+    *
+    * @param point a point with x and y members
+    * @param index index of the point
+    */
+    template<class Point>
+    static PointAndrews makePoint(const Point & point,uint64_t index){
+        PointAndrews hullPoint;
+        hullPoint.x = point.x;
+        hullPoint.y = point.y;
+        hullPoint.index = index;
+
+        return hullPoint;
+    }
+
+    /**
+    * Orders up to 3 hull candidates as the monotone chain would: counter-clockwise from the lowest point, without collinear points
+    *
+    * @param hull the hull vertices
+    * @param points the candidates
+    */
+    static void orderSmallHull(std::vector<PointAndrews> & hull,std::vector<PointAndrews> & points){
+        std::sort(points.begin(),points.end());
+        hull = points;
+
+        if(points.size() == 3){
+            coord2_t turn = cross(points[0],points[1],points[2]);
+
+            if(turn < 0){
+                std::swap(hull[1],hull[2]);
+            }
+            else if(turn == 0){
+                hull.erase(hull.begin() + 1);
+            }
+        }
+    }
+
+    /**
+    * Returns true if a point is strictly inside the quadrilateral (counter-clockwise), in double precision
+    *
+    * @param quadrilateral the quadrilateral
+    * @param point the point
+    */
+    static bool isInside(const PointAndrews * quadrilateral,const PointAndrews & point){
+        for(unsigned int i=0;i<4;i++){
+            const PointAndrews & a = quadrilateral[i];
+            const PointAndrews & b = quadrilateral[(i + 1) % 4];
+
+            double turn = ((double)b.x - a.x) * ((double)point.y - a.y) - ((double)b.y - a.y) * ((double)point.x - a.x);
+
+            if(!(turn > 0)){
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif
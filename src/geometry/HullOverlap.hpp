@@ -35,84 +35,77 @@
 #include <Eigen/Dense>
 #include <Eigen/Geometry> // For cross product
 
+#include "PreparedPolygon.hpp"
+#include "ConvexHull.hpp"
 
-//-----------------------------------------------------------------------------------
-// Andrew's monotone chain convex hull algorithm
-// Adapted from
-// https://en.wikibooks.org/wiki/Algorithm_Implementation/Geometry/Convex_hull/Monotone_chain#C++
 
-typedef float coord_t;      // coordinate type (Use float because pcl::PointXYZ's coordinates are float)
-typedef double coord2_t;    // must be big enough to hold 2*max(|coordinate|)^2
-
-struct PointAndrews
-{
-	coord_t x;
-    coord_t y;
-    uint64_t index;
-
-	bool operator <( const PointAndrews &p ) const
-    {
-		return x < p.x || (x == p.x && y < p.y);
-	}
-};
-
-
-// 3D cross product of OA and OB vectors, (i.e z-component of their "2D" cross product,
-// but remember that it is not defined in "2D").
-// Returns a positive value, if OAB makes a counter-clockwise turn,
-// negative for clockwise turn, and zero if the points are collinear.
-coord2_t cross( const PointAndrews &O, const PointAndrews &A, const PointAndrews &B )
-{
-	return (A.x - O.x) * (B.y - O.y) - (A.y - O.y) * (B.x - O.x);
-}
-
-// Returns a list of points on the convex hull in counter-clockwise order.
-// Note: the last point in the returned list is the same as the first one.
-// CB: vector points is modified by getting sorted.
-void AndrewsConvex_hull( std::vector<PointAndrews> & hull, std::vector<PointAndrews> & points )
+/**
+* Points of a line expressed in 2D on the projection plane, computed when accessed instead of stored.
+* vector1 and vector2 lie in the plane, so projecting the points on the plane first does not change
+* their 2D coordinates
+*/
+class LineInPlane2D
 {
-	size_t n = points.size(), k = 0;
 
-    hull.clear();
+public:
 
-    if ( n <= 3 )
+	/**
+	* Creates a view of a line in the projection plane
+	*
+	* @param line Point cloud of the line
+	* @param refPoint Reference point on the projection plane
+	* @param vector1 First orthonormal vector of the projection plane
+	* @param vector2 Second orthonormal vector of the projection plane
+	*/
+    LineInPlane2D( pcl::PointCloud<pcl::PointXYZ>::ConstPtr line, const pcl::PointXYZ & refPoint,
+                    const Eigen::Vector3d & vector1, const Eigen::Vector3d & vector2 )
+                    : line( line ), refPoint( refPoint ), vector1( vector1 ), vector2( vector2 )
     {
-        hull.reserve( n );
-
-        for ( int count = 0; count < n; count++ )
-            hull.push_back( points[ count ] );
+    }
 
-        return;
+    /**Returns the number of points*/
+    size_t size() const
+    {
+        return line->points.size();
     }
 
-    hull.resize( 2 * n );
+	/**
+	* Returns a point expressed in 2D on the projection plane
+	*
+	* @param count index of the point
+	*/
+    pcl::PointXYZ operator[]( size_t count ) const
+    {
+        const pcl::PointXYZ & pointIn = line->points[ count ];
+        pcl::PointXYZ point;
 
-	// Sort points lexicographically
-	sort(points.begin(), points.end());
+        point.x = ( pointIn.x - refPoint.x ) * vector1( 0 )
+                    + ( pointIn.y - refPoint.y ) * vector1( 1 )
+                    + ( pointIn.z - refPoint.z ) * vector1( 2 );
 
-	// Build lower hull
-	for (size_t i = 0; i < n; ++i)
-    {
-		while (k >= 2 && cross(hull[k-2], hull[k-1], points[i]) <= 0)
-            k--;
+        point.y = ( pointIn.x - refPoint.x ) * vector2( 0 )
+                    + ( pointIn.y - refPoint.y ) * vector2( 1 )
+                    + ( pointIn.z - refPoint.z ) * vector2( 2 );
 
-		hull[k++] = points[i];
-	}
+        point.z = 0;
 
-	// Build upper hull
-	for (size_t i = n-1, t = k+1; i > 0; --i)
-    {
-		while (k >= t && cross(hull[k-2], hull[k-1], points[i-1]) <= 0)
-            k--;
+        return point;
+    }
 
-		hull[k++] = points[i-1];
-	}
+private:
+
+    /**Point cloud of the line*/
+    pcl::PointCloud<pcl::PointXYZ>::ConstPtr line;
 
-	hull.resize(k-1);
+    /**Reference point on the projection plane*/
+    pcl::PointXYZ refPoint;
 
-}
+    /**First orthonormal vector of the projection plane*/
+    Eigen::Vector3d vector1;
 
-//-----------------------------------------------------------------------------------
+    /**Second orthonormal vector of the projection plane*/
+    Eigen::Vector3d vector2;
+};
 
 
 
@@ -214,6 +207,12 @@ public:
             line2InBothHull->clear();
 
 
+        // Andrew's hull does not need the projected clouds, the points are expressed in 2D when accessed.
+        // Only when the points are wanted: the point indices are used with the projected clouds
+        if ( minimalMemory && hullMethod == "Andrew's" && line1InBothHull != nullptr && line2InBothHull != nullptr )
+            return computeHullsAndPointsInBothHullsWithoutCopies( line1InBothHull, line2InBothHull );
+
+
         std::cout << "\nProjecting line 1 in plane\n" << std::endl;
 
         // Project line 1 in plane
@@ -282,13 +281,13 @@ public:
             std::cout << "\nFinding Hull 1\n" << std::endl;
 
             // Create a Hull for line 1
-            computeVerticesOfHullAndrews( line1InPlane2D, hull1Vertices, hull1PointIndices, ! minimalMemory );
+            computeVerticesOfHullAndrews( line1InPlane2D->points, hull1Vertices, hull1PointIndices, ! minimalMemory );
 
 
             std::cout << "Finding Hull 2\n" << std::endl;
 
             // Create a Concave Hull for line 2
-            computeVerticesOfHullAndrews( line2InPlane2D, hull2Vertices, hull2PointIndices, ! minimalMemory );
+            computeVerticesOfHullAndrews( line2InPlane2D->points, hull2Vertices, hull2PointIndices, ! minimalMemory );
         }
         else
         {
@@ -315,7 +314,7 @@ public:
             {
                 std::cout << "Finding points of Line 1 inside Hull 2\n\n" << std::endl;
 
-                findPointsInHullOnlyPoints( line1, line1InPlane2D, line1InBothHull, hull2Vertices );
+                findPointsInHullOnlyPoints( line1, line1InPlane2D->points, line1InBothHull, hull2Vertices );
 
                 // Delete the dynamically allocated memory
                 line1InPlane2D.reset();
@@ -326,7 +325,7 @@ public:
 
                 std::cout << "Finding points of Line 2 inside Hull 1\n\n" << std::endl;
 
-                findPointsInHullOnlyPoints( line2, line2InPlane2D, line2InBothHull, hull1Vertices );
+                findPointsInHullOnlyPoints( line2, line2InPlane2D->points, line2InBothHull, hull1Vertices );
 
                 // Delete the dynamically allocated memory
                 line2InPlane2D.reset();
@@ -346,12 +345,12 @@ public:
 
                 std::cout << "Finding points of Line 1 inside Hull 2 (and the indices)\n\n" << std::endl;
 
-                findPointsInHull( line1, line1InPlane2D, line1InBothHull, line1InBothHullPointIndices, hull2Vertices );
+                findPointsInHull( line1, line1InPlane2D->points, line1InBothHull, line1InBothHullPointIndices, hull2Vertices );
 
 
                 std::cout << "Finding points of Line 2 inside Hull 1 (and the indices)\n\n" << std::endl;
 
-                findPointsInHull( line2, line2InPlane2D, line2InBothHull, line2InBothHullPointIndices, hull1Vertices );
+                findPointsInHull( line2, line2InPlane2D->points, line2InBothHull, line2InBothHullPointIndices, hull1Vertices );
 
 
                 std::cout << "line1InBothHull->points.size(): " << line1InBothHull->points.size() << "\n"
@@ -368,12 +367,12 @@ public:
         {
             std::cout << "Finding indices of points of Line 1 inside Hull 2\n\n" << std::endl;
 
-            findPointsInHullOnlyPointIndices( line1InPlane2D, line1InBothHullPointIndices, hull2Vertices );
+            findPointsInHullOnlyPointIndices( line1InPlane2D->points, line1InBothHullPointIndices, hull2Vertices );
 
 
             std::cout << "Finding indices of points of Line 2 inside Hull 1\n\n" << std::endl;
 
-            findPointsInHullOnlyPointIndices( line2InPlane2D, line2InBothHullPointIndices, hull1Vertices );
+            findPointsInHullOnlyPointIndices( line2InPlane2D->points, line2InBothHullPointIndices, hull1Vertices );
 
 
             std::cout << "line1InBothHullPointIndices.size(): " << line1InBothHullPointIndices.size() << "\n"
@@ -675,27 +674,101 @@ private:
     }
 
 
+	/**
+	* Finds the points of each line in the hull of the other line, with Andrew's hull, without the
+    * projected clouds: points are expressed in 2D on the projection plane when accessed
+    *
+	* @param[out] line1InBothHull Point cloud of points in line #1 in the overlap area of the two lines
+	* @param[out] line2InBothHull Point cloud of points in line #2 in the overlap area of the two lines
+	*/
+    std::pair< uint64_t, uint64_t > computeHullsAndPointsInBothHullsWithoutCopies(
+                                                pcl::PointCloud<pcl::PointXYZ>::Ptr line1InBothHull,
+                                                pcl::PointCloud<pcl::PointXYZ>::Ptr line2InBothHull )
+    {
+        line1InPlane.reset();
+        line2InPlane.reset();
+        line1InPlane2D.reset();
+        line2InPlane2D.reset();
+
+        computeTwoVectorsAndRefPoint( projectPointInPlane( line1->points[ 0 ] ),
+                                        projectPointInPlane( line1->points[ line1->points.size() - 1 ] ) );
+
+        LineInPlane2D line1In2D( line1, refPoint, vector1, vector2 );
+        LineInPlane2D line2In2D( line2, refPoint, vector1, vector2 );
+
+        std::cout << "\nFinding Hull 1\n" << std::endl;
+
+        computeVerticesOfHullAndrews( line1In2D, hull1Vertices, hull1PointIndices, false );
+
+        std::cout << "Finding Hull 2\n" << std::endl;
+
+        computeVerticesOfHullAndrews( line2In2D, hull2Vertices, hull2PointIndices, false );
+
+        std::cout << "hull1Vertices->points.size(): " << hull1Vertices->points.size() << "\n"
+            << "hull2Vertices->points.size(): " << hull2Vertices->points.size() << "\n" << std::endl;
+
+        std::cout << "Finding points of Line 1 inside Hull 2\n\n" << std::endl;
+
+        findPointsInHullOnlyPoints( line1, line1In2D, line1InBothHull, hull2Vertices );
+
+        std::cout << "Finding points of Line 2 inside Hull 1\n\n" << std::endl;
+
+        findPointsInHullOnlyPoints( line2, line2In2D, line2InBothHull, hull1Vertices );
+
+        std::cout << "line1InBothHull->points.size(): " << line1InBothHull->points.size() << "\n"
+            << "line2InBothHull->points.size(): " << line2InBothHull->points.size() << "\n" << std::endl;
+
+        return std::make_pair( line1InBothHull->size(), line2InBothHull->size() );
+    }
+
+
+	/**
+	* Returns the projection of a point onto the plane
+    *
+    * @param[in] pointIn Point to project on the plane
+	*/
+    pcl::PointXYZ projectPointInPlane( const pcl::PointXYZ & pointIn ) const
+    {
+        Eigen::Vector3d normalToPlane( a, b, c );
+        Eigen::Vector3d point( pointIn.x, pointIn.y, pointIn.z );
+
+        point -= normalToPlane * ( normalToPlane.dot( point ) + d ) / normalToPlane.squaredNorm();
+
+        return pcl::PointXYZ( point( 0 ), point( 1 ), point( 2 ) );
+    }
+
+
 	/**
 	* Computes two vectors and sets a reference point used to express point positions on the
     * projection plane using only two dimensions
 	*/
     void computeTwoVectorsAndRefPoint()
+    {
+        computeTwoVectorsAndRefPoint( line1InPlane->points[ 0 ], line1InPlane->points[ line1InPlane->points.size() - 1 ] );
+    }
+
+
+	/**
+	* Computes two vectors and sets a reference point used to express point positions on the
+    * projection plane using only two dimensions
+    *
+    * @param[in] firstPoint First point of line #1, on the projection plane
+    * @param[in] lastPoint Last point of line #1, on the projection plane
+	*/
+    void computeTwoVectorsAndRefPoint( const pcl::PointXYZ & firstPoint, const pcl::PointXYZ & lastPoint )
     {
 
         // Two vectors and a reference point to span the projection plane
         // so that points in the projection plane can be expressed in
         // a coordinate system with vector1, vector2, and refPoint.
 
-        refPoint = line1InPlane->points[ 0 ];
+        refPoint = firstPoint;
 
         // Vector #1: from first point in line to last point in line, normalized
 
-        const uint64_t nbPointLine1 = line1InPlane->points.size();
-
-
-        vector1 << line1InPlane->points[ nbPointLine1 - 1 ].x - line1InPlane->points[ 0 ].x,
-                    line1InPlane->points[ nbPointLine1 - 1 ].y - line1InPlane->points[ 0 ].y,
-                    line1InPlane->points[ nbPointLine1 - 1 ].z - line1InPlane->points[ 0 ].z;
+        vector1 << lastPoint.x - firstPoint.x,
+                    lastPoint.y - firstPoint.y,
+                    lastPoint.z - firstPoint.z;
 
         std::cout << "vector1 before normalization:\n" << vector1 << "\n\n";
 
@@ -793,44 +866,24 @@ private:
 
 
 	/**
-	* Computes the vertices of a hull for points on the projection plane, using Andrew's monotone chain
+	* Computes the vertices of a hull for points on the projection plane, using Andrew's monotone chain in parallel
     *
-    * @param[in] cloudIn Point cloud on the projection plane expressed in 2D
+    * @param[in] cloudIn Points on the projection plane expressed in 2D (the points of a cloud, or a LineInPlane2D)
     * @param[out] hullVertices Computed vertices of the concave hull
     * @param[out] hullPointIndices Indices of the points in cloudIn making up the hull
     * @param[in] keepInformation bool variable, true to specify to put the indices of the points in cloudIn in hullPointIndices
 	*/
-    void computeVerticesOfHullAndrews( pcl::PointCloud<pcl::PointXYZ>::ConstPtr cloudIn,
+    template < class Points2D >
+    void computeVerticesOfHullAndrews( const Points2D & cloudIn,
                                         pcl::PointCloud<pcl::PointXYZ>::Ptr hullVertices,
                                         pcl::PointIndices & hullPointIndices, const bool keepInformation = true )
     {
-
-        std::cout << "\nBefore building vector for Andrews\n" << std::endl;
-
-        std::vector< PointAndrews > points;
-        points.reserve( cloudIn->size() );
-
-        for ( uint64_t count = 0; count < cloudIn->size(); count++ )
-        {
-            PointAndrews point;
-
-            point.x = cloudIn->points[ count ].x;
-            point.y = cloudIn->points[ count ].y;
-            point.index = count;
-
-            points.push_back( point );
-        }
-
-        std::cout << "\nBefore calling Andrews\n" << std::endl;
-
         std::vector< PointAndrews > hullAndrews;
-        AndrewsConvex_hull( hullAndrews, points );
+        ConvexHull::computeAndrews( cloudIn, hullAndrews );
 
         hullVertices->clear();
         hullVertices->reserve( hullAndrews.size() );
 
-        std::cout << "\nAfter calling Andrews\n" << std::endl;
-
         for ( uint64_t count = 0; count < hullAndrews.size(); count++ )
         {
             pcl::PointXYZ point;
@@ -864,28 +917,28 @@ private:
     * Provides the points and their indices within the original line
     *
     * @param[in] lineOriginal Point cloud of points on the line
-    * @param[in] cloudIn Point cloud on the projection plane expressed in 2D
+    * @param[in] cloudIn Points on the projection plane expressed in 2D (the points of a cloud, or a LineInPlane2D)
     * @param[out] cloudOut Point cloud of points on the line that are within the hull
     * @param[out] indexPointInHull Indices of the points on the line that are within the hull
     * @param[in] hullVertices Vertices of the concave hull
 	*/
+    template < class Points2D >
     void findPointsInHull( pcl::PointCloud<pcl::PointXYZ>::ConstPtr lineOriginal,
-                                pcl::PointCloud<pcl::PointXYZ>::ConstPtr cloudIn,
+                                const Points2D & cloudIn,
                                 pcl::PointCloud<pcl::PointXYZ>::Ptr cloudOut,
                                 std::vector< uint64_t > & indexPointInHull,
                                 pcl::PointCloud<pcl::PointXYZ>::ConstPtr hullVertices )
     {
         cloudOut->clear();
-        indexPointInHull.clear();
 
-        for ( uint64_t count = 0; count < cloudIn->points.size(); count++ )
-        {
-            if ( pcl::isXYPointIn2DXYPolygon( cloudIn->points[ count ], *hullVertices ) )
-            {
-                cloudOut->push_back( lineOriginal->points[ count ] );
-                indexPointInHull.push_back( count );
-            }
-        }
+        // Same result as pcl::isXYPointIn2DXYPolygon() on each point, without testing every hull edge
+        PreparedPolygon hull( hullVertices->points );
+        hull.findInside( cloudIn, indexPointInHull );
+
+        cloudOut->reserve( indexPointInHull.size() );
+
+        for ( uint64_t count = 0; count < indexPointInHull.size(); count++ )
+            cloudOut->push_back( lineOriginal->points[ indexPointInHull[ count ] ] );
 
     }
 
@@ -893,21 +946,17 @@ private:
 	/**
 	* Find indices of points that are within a concave hull.
     *
-    * @param[in] cloudIn Point cloud on the projection plane expressed in 2D
+    * @param[in] cloudIn Points on the projection plane expressed in 2D (the points of a cloud, or a LineInPlane2D)
     * @param[out] indexPointInHull Indices of the points on the line that are within the hull
     * @param[in] hullVertices Vertices of the concave hull
 	*/
-    void findPointsInHullOnlyPointIndices( pcl::PointCloud<pcl::PointXYZ>::ConstPtr cloudIn,
+    template < class Points2D >
+    void findPointsInHullOnlyPointIndices( const Points2D & cloudIn,
                                     std::vector< uint64_t > & indexPointInHull,
                                     pcl::PointCloud<pcl::PointXYZ>::ConstPtr hullVertices )
     {
-        indexPointInHull.clear();
-
-        for ( uint64_t count = 0; count < cloudIn->points.size(); count++ )
-        {
-            if ( pcl::isXYPointIn2DXYPolygon( cloudIn->points[ count ], *hullVertices ) )
-                indexPointInHull.push_back( count );
-        }
+        PreparedPolygon hull( hullVertices->points );
+        hull.findInside( cloudIn, indexPointInHull );
 
     }
 
@@ -915,22 +964,27 @@ private:
 	* Find points that are within a concave hull.
     *
     * @param[in] lineOriginal Point cloud of points on the line
-    * @param[in] cloudIn Point cloud on the projection plane expressed in 2D
+    * @param[in] cloudIn Points on the projection plane expressed in 2D (the points of a cloud, or a LineInPlane2D)
     * @param[out] cloudOut Point cloud of points on the line that are within the hull
     * @param[in] hullVertices Vertices of the concave hull
 	*/
+    template < class Points2D >
     void findPointsInHullOnlyPoints( pcl::PointCloud<pcl::PointXYZ>::ConstPtr lineOriginal,
-                                    pcl::PointCloud<pcl::PointXYZ>::ConstPtr cloudIn,
+                                    const Points2D & cloudIn,
                                     pcl::PointCloud<pcl::PointXYZ>::Ptr cloudOut,
                                     pcl::PointCloud<pcl::PointXYZ>::ConstPtr hullVertices )
     {
         cloudOut->clear();
 
-        for ( uint64_t count = 0; count < cloudIn->points.size(); count++ )
-        {
-            if ( pcl::isXYPointIn2DXYPolygon( cloudIn->points[ count ], *hullVertices ) )
-                cloudOut->push_back( lineOriginal->points[ count ] );
-        }
+        std::vector< uint64_t > indexPointInHull;
+
+        PreparedPolygon hull( hullVertices->points );
+        hull.findInside( cloudIn, indexPointInHull );
+
+        cloudOut->reserve( indexPointInHull.size() );
+
+        for ( uint64_t count = 0; count < indexPointInHull.size(); count++ )
+            cloudOut->push_back( lineOriginal->points[ indexPointInHull[ count ] ] );
 
     }
 
@@ -0,0 +1,331 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef MULTILINEOVERLAP_HPP
+#define MULTILINEOVERLAP_HPP
+
+#include <stdint.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <iomanip>
+#include <Eigen/Dense>
+#include "ConvexHull.hpp"
+#include "PreparedPolygon.hpp"
+#include "BoundingBoxTree.hpp"
+#include "ProjectionPlane.hpp"
+#include "../utils/ParallelFor.hpp"
+#include "../utils/Exception.hpp"
+
+/**
+* Point of a line expressed on the projection plane
+*/
+typedef struct{
+    float x;        /**<coordinate along the first axis of the plane*/
+    float y;        /**<coordinate along the second axis of the plane*/
+    float height;   /**<signed distance to the plane, along its normal*/
+} LinePoint2D;
+
+/**
+* Overlap between two lines
+*/
+typedef struct{
+    unsigned int first;                     /**<index of the first line*/
+    unsigned int second;                    /**<index of the second line, higher than first*/
+    uint64_t firstInSecond;                 /**<number of points of the first line inside the hull of the second*/
+    uint64_t secondInFirst;                 /**<number of points of the second line inside the hull of the first*/
+    double firstMeanHeight;                 /**<mean height of the points of the first line inside the hull of the second*/
+    double secondMeanHeight;                /**<mean height of the points of the second line inside the hull of the first*/
+    std::vector<uint64_t> firstIndices;     /**<indices of the points of the first line inside the hull of the second, if kept*/
+    std::vector<uint64_t> secondIndices;    /**<indices of the points of the second line inside the hull of the first, if kept*/
+} LineOverlap;
+
+/*!
+* \brief Multiple line overlap class
+*
+* Overlap analysis between all the lines of a survey, as HullOverlap does for two lines with Andrew's hull:
+* the points of each line inside the hull of the other line. Each line is projected on the plane and its
+* hull computed once, when it is added. The pairs whose hull bounding boxes intersect are then found with a
+* bounding box tree, and only those pairs are processed, in parallel.
+*/
+class MultiLineOverlap{
+public:
+
+    /**
+    * Creates a multiple line overlap analysis
+    *
+    * @param a projection plane coefficient 'a' in ax + by + cz + d = 0
+    * @param b projection plane coefficient 'b' in ax + by + cz + d = 0
+    * @param c projection plane coefficient 'c' in ax + by + cz + d = 0
+    * @param d projection plane coefficient 'd' in ax + by + cz + d = 0
+    * @param keepPointSets true to keep the indices of the points in each overlap
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    MultiLineOverlap(double a,double b,double c,double d,bool keepPointSets = false,unsigned int threadCount = 0)
+    : keepPointSets(keepPointSets), threadCount(threadCount), plane(a,b,c,d){
+
+    }
+
+    /**Destroys the multiple line overlap analysis*/
+    ~MultiLineOverlap(){
+
+    }
+
+    /**
+    * Adds a line: projects its points on the plane and computes its hull. Returns the index of the line
+    *
+    * @param name name of the line
+    * @param points the points, as a container of points with x, y and z members (e.g. pcl::PointCloud or std::vector<PointRecord>)
+    */
+    template<class Points>
+    unsigned int addLine(const std::string & name,const Points & points){
+        if(points.size() == 0){
+            throw new Exception("Line " + name + " has no points");
+        }
+
+        //points are expressed from the projection of the first point, to keep float precision
+        if(lines.empty()){
+            plane.setOrigin(Eigen::Vector3d(points[0].x,points[0].y,points[0].z));
+        }
+
+        lines.push_back(Line());
+
+        Line & line = lines.back();
+        line.name = name;
+        line.points.resize(points.size());
+
+        uint64_t count = points.size();
+
+        ParallelFor::run((count + PreparedPolygon::POINTS_PER_TASK - 1) / PreparedPolygon::POINTS_PER_TASK,[this,&points,&line,count](unsigned int task,unsigned int thread){
+            uint64_t end = std::min(count,(uint64_t)(task + 1) * PreparedPolygon::POINTS_PER_TASK);
+
+            for(uint64_t i=(uint64_t)task * PreparedPolygon::POINTS_PER_TASK;i<end;i++){
+                double x,y,height;
+                plane.project(Eigen::Vector3d(points[i].x,points[i].y,points[i].z),x,y,height);
+
+                line.points[i].x = x;
+                line.points[i].y = y;
+                line.points[i].height = height;
+            }
+        },threadCount);
+
+        ConvexHull::computeAndrews(line.points,line.hull,threadCount);
+
+        line.box.minimumX = line.box.minimumY = INFINITY;
+        line.box.maximumX = line.box.maximumY = -INFINITY;
+
+        for(unsigned int i=0;i<line.hull.size();i++){
+            line.box.minimumX = std::min(line.box.minimumX,(double)line.hull[i].x);
+            line.box.minimumY = std::min(line.box.minimumY,(double)line.hull[i].y);
+            line.box.maximumX = std::max(line.box.maximumX,(double)line.hull[i].x);
+            line.box.maximumY = std::max(line.box.maximumY,(double)line.hull[i].y);
+        }
+
+        return lines.size() - 1;
+    }
+
+    /**Finds the overlaps between every pair of lines*/
+    void computeOverlaps(){
+        overlaps.clear();
+
+        std::vector<BoundingBox> boxes(lines.size());
+        std::vector<PreparedPolygon> hulls;
+        hulls.reserve(lines.size());
+
+        for(unsigned int i=0;i<lines.size();i++){
+            boxes[i] = lines[i].box;
+            hulls.push_back(PreparedPolygon(lines[i].hull));
+        }
+
+        //candidate pairs: intersecting hull bounding boxes
+        BoundingBoxTree tree(boxes);
+        std::vector<std::pair<unsigned int,unsigned int> > pairs;
+        std::vector<unsigned int> found;
+
+        for(unsigned int i=0;i<lines.size();i++){
+            tree.query(boxes[i],found);
+
+            for(unsigned int j=0;j<found.size();j++){
+                if(found[j] > i){
+                    pairs.push_back(std::make_pair(i,found[j]));
+                }
+            }
+        }
+
+        std::vector<LineOverlap> results(pairs.size());
+
+        ParallelFor::run(pairs.size(),[this,&pairs,&hulls,&results](unsigned int p,unsigned int thread){
+            LineOverlap & overlap = results[p];
+            overlap.first = pairs[p].first;
+            overlap.second = pairs[p].second;
+
+            findPointsInHull(lines[overlap.first],hulls[overlap.second],overlap.firstInSecond,overlap.firstMeanHeight,overlap.firstIndices);
+            findPointsInHull(lines[overlap.second],hulls[overlap.first],overlap.secondInFirst,overlap.secondMeanHeight,overlap.secondIndices);
+        },threadCount);
+
+        //pairs whose hulls do not actually overlap are left out
+        for(unsigned int p=0;p<results.size();p++){
+            if(results[p].firstInSecond > 0 || results[p].secondInFirst > 0){
+                overlaps.push_back(LineOverlap());
+                std::swap(overlaps.back(),results[p]);
+            }
+        }
+    }
+
+    /**Returns the overlapping pairs of lines, ordered by first line then second line*/
+    const std::vector<LineOverlap> & getOverlaps() const{
+        return overlaps;
+    }
+
+    /**Returns the number of lines*/
+    unsigned int getLineCount() const{
+        return lines.size();
+    }
+
+    /**
+    * Returns the name of a line
+    *
+    * @param line index of the line
+    */
+    const std::string & getLineName(unsigned int line) const{
+        return lines[line].name;
+    }
+
+    /**
+    * Returns the number of points of a line
+    *
+    * @param line index of the line
+    */
+    uint64_t getLinePointCount(unsigned int line) const{
+        return lines[line].points.size();
+    }
+
+    /**
+    * Returns the points of a line expressed on the projection plane
+    *
+    * @param line index of the line
+    */
+    const std::vector<LinePoint2D> & getLinePoints(unsigned int line) const{
+        return lines[line].points;
+    }
+
+    /**
+    * Returns the hull of a line, on the projection plane
+    *
+    * @param line index of the line
+    */
+    const std::vector<PointAndrews> & getLineHull(unsigned int line) const{
+        return lines[line].hull;
+    }
+
+    /**
+    * Writes the overlap matrix as CSV: the percentage of the points of the row's line inside the hull of the column's line
+    *
+    * @param out the output stream
+    */
+    void writeMatrix(std::ostream & out) const{
+        std::vector<std::vector<double> > matrix(lines.size(),std::vector<double>(lines.size(),0));
+
+        for(unsigned int p=0;p<overlaps.size();p++){
+            const LineOverlap & overlap = overlaps[p];
+            matrix[overlap.first][overlap.second] = 100.0 * overlap.firstInSecond / lines[overlap.first].points.size();
+            matrix[overlap.second][overlap.first] = 100.0 * overlap.secondInFirst / lines[overlap.second].points.size();
+        }
+
+        out << "line";
+
+        for(unsigned int j=0;j<lines.size();j++){
+            out << "," << lines[j].name;
+        }
+
+        out << std::endl << std::fixed << std::setprecision(2);
+
+        for(unsigned int i=0;i<lines.size();i++){
+            out << lines[i].name;
+
+            for(unsigned int j=0;j<lines.size();j++){
+                out << ",";
+
+                if(i != j){
+                    out << matrix[i][j];
+                }
+            }
+
+            out << std::endl;
+        }
+    }
+
+    /**
+    * Writes the overlapping pairs as CSV
+    *
+    * @param out the output stream
+    */
+    void writePairs(std::ostream & out) const{
+        out << "first,second,firstPoints,secondPoints,firstInSecond,secondInFirst,firstMeanHeight,secondMeanHeight" << std::endl;
+        out << std::fixed << std::setprecision(3);
+
+        for(unsigned int p=0;p<overlaps.size();p++){
+            const LineOverlap & overlap = overlaps[p];
+
+            out << lines[overlap.first].name << "," << lines[overlap.second].name << ","
+                << lines[overlap.first].points.size() << "," << lines[overlap.second].points.size() << ","
+                << overlap.firstInSecond << "," << overlap.secondInFirst << ","
+                << overlap.firstMeanHeight << "," << overlap.secondMeanHeight << std::endl;
+        }
+    }
+
+private:
+
+    /**Line projected on the plane*/
+    typedef struct{
+        std::string name;
+        std::vector<LinePoint2D> points;
+        std::vector<PointAndrews> hull;
+        BoundingBox box;
+    } Line;
+
+    /**
+    * Finds the points of a line inside the hull of another line
+    *
+    * @param line the line
+    * @param hull the hull of the other line
+    * @param count the number of points inside the hull
+    * @param meanHeight the mean height of the points inside the hull
+    * @param indices the indices of the points inside the hull, if the point sets are kept
+    */
+    void findPointsInHull(const Line & line,const PreparedPolygon & hull,uint64_t & count,double & meanHeight,std::vector<uint64_t> & indices) const{
+        count = 0;
+        meanHeight = 0;
+        indices.clear();
+
+        for(uint64_t i=0;i<line.points.size();i++){
+            if(hull.contains(line.points[i].x,line.points[i].y)){
+                count++;
+                meanHeight += (line.points[i].height - meanHeight) / count;
+
+                if(keepPointSets){
+                    indices.push_back(i);
+                }
+            }
+        }
+    }
+
+    /**True to keep the indices of the points in each overlap*/
+    bool keepPointSets;
+
+    /**Number of threads, 0 for one per hardware thread*/
+    unsigned int threadCount;
+
+    /**The projection plane, its origin at the projection of the first point of the first line*/
+    ProjectionPlane plane;
+
+    /**The lines*/
+    std::vector<Line> lines;
+
+    /**The overlapping pairs*/
+    std::vector<LineOverlap> overlaps;
+};
+
+#endif
@@ -0,0 +1,251 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef PREPAREDPOLYGON_HPP
+#define PREPAREDPOLYGON_HPP
+
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "../utils/ParallelFor.hpp"
+
+/*!
+* \brief Prepared polygon class
+*
+* Point in polygon queries against a polygon with many vertices, for many points. The polygon's edges are
+* bucketed by x slabs of equal width, so that a point is only tested against the edges spanning its x
+* coordinate instead of every edge.
+*
+* The crossing test is the one of pcl::isXYPointIn2DXYPolygon, computed in double precision on the same
+* float coordinates: an edge from (x1,y1) to (x2,y2), x1 < x2, is crossed when x1 < x <= x2 and
+* (y - y1)(x2 - x1) < (y2 - y1)(x - x1). For polygons with finite vertices, the results are therefore
+* identical, including for points on the edges or at the vertices.
+*/
+class PreparedPolygon{
+public:
+
+    /**Number of points tested per parallel task*/
+    static const unsigned int POINTS_PER_TASK = 1 << 16;
+
+    /**
+    * Prepares a polygon
+    *
+    * @param polygon the vertices of the polygon, in order, as a container of points with x and y members (e.g. pcl::PointCloud)
+    */
+    template<class Polygon>
+    PreparedPolygon(const Polygon & polygon){
+        std::vector<double> x(polygon.size());
+        std::vector<double> y(polygon.size());
+
+        for(unsigned int i=0;i<polygon.size();i++){
+            x[i] = polygon[i].x;
+            y[i] = polygon[i].y;
+        }
+
+        prepare(x,y);
+    }
+
+    /**
+    * Prepares a polygon
+    *
+    * @param x the x coordinate of each vertex, in order
+    * @param y the y coordinate of each vertex
+    */
+    PreparedPolygon(const std::vector<double> & x,const std::vector<double> & y){
+        prepare(x,y);
+    }
+
+    /**Destroys the prepared polygon*/
+    ~PreparedPolygon(){
+
+    }
+
+    /**
+    * Returns true if a point is inside the polygon
+    *
+    * @param x the x coordinate of the point
+    * @param y the y coordinate of the point
+    */
+    bool contains(double x,double y) const{
+        //no edge spans x, also rejects NaN
+        if(!(x > minimumX && x <= maximumX)){
+            return false;
+        }
+
+        unsigned int slab = getSlab(x);
+        bool inside = false;
+
+        for(uint32_t i=slabStarts[slab];i<slabStarts[slab + 1];i++){
+            const Edge & edge = edges[slabEdges[i]];
+
+            if(edge.x1 < x && x <= edge.x2 && (y - edge.y1) * (edge.x2 - edge.x1) < (edge.y2 - edge.y1) * (x - edge.x1)){
+                inside = !inside;
+            }
+        }
+
+        return inside;
+    }
+
+    /**
+    * Finds the points inside the polygon, in parallel. The indices are in increasing order
+    *
+    * @param points the points, as a container of points with x and y members (e.g. pcl::PointCloud)
+    * @param inside the indices of the points inside the polygon
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    template<class Points>
+    void findInside(const Points & points,std::vector<uint64_t> & inside,unsigned int threadCount = 0) const{
+        uint64_t count = points.size();
+        std::vector<uint8_t> mask(count);
+
+        ParallelFor::run((count + POINTS_PER_TASK - 1) / POINTS_PER_TASK,[this,&points,&mask,count](unsigned int task,unsigned int thread){
+            uint64_t end = std::min(count,(uint64_t)(task + 1) * POINTS_PER_TASK);
+
+            for(uint64_t i=(uint64_t)task * POINTS_PER_TASK;i<end;i++){
+                mask[i] = contains(points[i].x,points[i].y);
+            }
+        },threadCount);
+
+        inside.clear();
+
+        for(uint64_t i=0;i<count;i++){
+            if(mask[i]){
+                inside.push_back(i);
+            }
+        }
+    }
+
+    /**Returns the number of edges*/
+    unsigned int getEdgeCount() const{
+        return edges.size();
+    }
+
+private:
+
+    /**Polygon edge, left end first*/
+    typedef struct{
+        double x1;
+        double y1;
+        double x2;
+        double y2;
+    } Edge;
+
+    /**
+    * Builds the edges and the slabs
+    *
+    * @param x the x coordinate of each vertex
+    * @param y the y coordinate of each vertex
+    */
+    void prepare(const std::vector<double> & x,const std::vector<double> & y){
+        minimumX = INFINITY;
+        maximumX = -INFINITY;
+
+        //the last vertex closes the polygon, vertical edges are never crossed
+        for(unsigned int i=0;i<x.size();i++){
+            unsigned int previous = (i == 0) ? x.size() - 1 : i - 1;
+
+            if(x[i] == x[previous] || std::isnan(x[i]) || std::isnan(x[previous])){
+                continue;
+            }
+
+            Edge edge;
+
+            if(x[i] > x[previous]){
+                edge.x1 = x[previous];
+                edge.y1 = y[previous];
+                edge.x2 = x[i];
+                edge.y2 = y[i];
+            }
+            else{
+                edge.x1 = x[i];
+                edge.y1 = y[i];
+                edge.x2 = x[previous];
+                edge.y2 = y[previous];
+            }
+
+            edges.push_back(edge);
+            minimumX = std::min(minimumX,edge.x1);
+            maximumX = std::max(maximumX,edge.x2);
+        }
+
+        slabCount = std::max((size_t)1,edges.size());
+
+        if(edges.empty() || !std::isfinite(maximumX - minimumX)){
+            //nothing to bucket, a single slab
+            slabWidth = 1;
+            slabCount = 1;
+        }
+        else{
+            slabWidth = (maximumX - minimumX) / slabCount;
+
+            if(!(slabWidth > 0)){
+                slabWidth = 1;
+                slabCount = 1;
+            }
+        }
+
+        //slab index is monotonic in x, so an edge spanning x lies in every slab from getSlab(x1) to getSlab(x2)
+        std::vector<uint32_t> counts(slabCount + 1,0);
+
+        for(unsigned int e=0;e<edges.size();e++){
+            for(unsigned int s=getSlab(edges[e].x1);s<=getSlab(edges[e].x2);s++){
+                counts[s + 1]++;
+            }
+        }
+
+        slabStarts.assign(slabCount + 1,0);
+
+        for(unsigned int s=0;s<slabCount;s++){
+            slabStarts[s + 1] = slabStarts[s] + counts[s + 1];
+        }
+
+        slabEdges.resize(slabStarts[slabCount]);
+        std::vector<uint32_t> next(slabStarts.begin(),slabStarts.end() - 1);
+
+        for(unsigned int e=0;e<edges.size();e++){
+            for(unsigned int s=getSlab(edges[e].x1);s<=getSlab(edges[e].x2);s++){
+                slabEdges[next[s]++] = e;
+            }
+        }
+    }
+
+    /**
+    * Returns the slab of an x coordinate
+    *
+    * @param x the x coordinate
+    */
+    unsigned int getSlab(double x) const{
+        double slab = std::floor((x - minimumX) / slabWidth);
+
+        if(!(slab > 0)){
+            return 0;
+        }
+
+        return (slab >= slabCount) ? slabCount - 1 : (unsigned int)slab;
+    }
+
+    /**Non-vertical edges of the polygon*/
+    std::vector<Edge> edges;
+
+    /**Lowest x of the edges*/
+    double minimumX;
+
+    /**Highest x of the edges*/
+    double maximumX;
+
+    /**Width of the slabs*/
+    double slabWidth;
+
+    /**Number of slabs*/
+    unsigned int slabCount;
+
+    /**Position of the first edge of each slab in slabEdges, followed by the total*/
+    std::vector<uint32_t> slabStarts;
+
+    /**Edges of each slab*/
+    std::vector<uint32_t> slabEdges;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef PROJECTIONPLANE_HPP
+#define PROJECTIONPLANE_HPP
+
+#include <Eigen/Dense>
+#include "../utils/Exception.hpp"
+
+/*!
+* \brief Projection plane class
+*
+* Expresses points on a plane ax + by + cz + d = 0: coordinates along two orthonormal axes of the plane,
+* from an origin on the plane, and the signed distance to the plane along its unit normal (the height).
+* The axes only depend on the plane, so points projected by planes of the same coefficients and origin
+* share the same 2D frame.
+*/
+class ProjectionPlane{
+public:
+
+    /**
+    * Creates a projection plane, its origin at the projection of the world origin
+    *
+    * @param a projection plane coefficient 'a' in ax + by + cz + d = 0
+    * @param b projection plane coefficient 'b' in ax + by + cz + d = 0
+    * @param c projection plane coefficient 'c' in ax + by + cz + d = 0
+    * @param d projection plane coefficient 'd' in ax + by + cz + d = 0
+    */
+    ProjectionPlane(double a,double b,double c,double d){
+        normal << a,b,c;
+
+        if(!(normal.norm() > 0)){
+            throw new Exception("The projection plane has no normal");
+        }
+
+        distance = d / normal.norm();
+        normal.normalize();
+
+        //first axis along the world axis least aligned with the normal
+        Eigen::Vector3d axis = Eigen::Vector3d::Zero();
+        Eigen::Vector3d::Index smallest;
+        normal.cwiseAbs().minCoeff(&smallest);
+        axis(smallest) = 1;
+
+        vector1 = normal.cross(axis).normalized();
+        vector2 = normal.cross(vector1);
+
+        setOrigin(Eigen::Vector3d::Zero());
+    }
+
+    /**Destroys the projection plane*/
+    ~ProjectionPlane(){
+
+    }
+
+    /**
+    * Moves the origin of the plane coordinates to the projection of a point, e.g. near the points to keep float precision
+    *
+    * @param point the point
+    */
+    void setOrigin(const Eigen::Vector3d & point){
+        origin = point - normal * getHeight(point);
+    }
+
+    /**
+    * Expresses a point on the plane
+    *
+    * @param point the point
+    * @param x the coordinate along the first axis of the plane
+    * @param y the coordinate along the second axis of the plane
+    * @param height the signed distance to the plane, along its normal
+    */
+    void project(const Eigen::Vector3d & point,double & x,double & y,double & height) const{
+        Eigen::Vector3d fromOrigin = point - origin;
+
+        x = fromOrigin.dot(vector1);
+        y = fromOrigin.dot(vector2);
+        height = getHeight(point);
+    }
+
+    /**
+    * Returns the signed distance of a point to the plane, along its normal
+    *
+    * @param point the point
+    */
+    double getHeight(const Eigen::Vector3d & point) const{
+        return normal.dot(point) + distance;
+    }
+
+private:
+
+    /**Unit normal of the plane*/
+    Eigen::Vector3d normal;
+
+    /**Signed distance term of the plane, for the unit normal*/
+    double distance;
+
+    /**First axis of the plane*/
+    Eigen::Vector3d vector1;
+
+    /**Second axis of the plane*/
+    Eigen::Vector3d vector2;
+
+    /**Origin of the coordinates on the plane*/
+    Eigen::Vector3d origin;
+};
+
+#endif
@@ -0,0 +1,432 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef BORESIGHTCALIBRATOR_HPP
+#define BORESIGHTCALIBRATOR_HPP
+
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <Eigen/Dense>
+#include "DatagramGeoreferencer.hpp"
+#include "Georeferencing.hpp"
+#include "../math/Boresight.hpp"
+#include "../svp/SvpNearestByTime.hpp"
+#include "../gridding/OverlapStatistics.hpp"
+#include "../utils/ParallelFor.hpp"
+#include "../utils/Exception.hpp"
+
+/**
+* Georeferenced beam of a patch test line, in the frame of the georeferencing
+*/
+typedef struct{
+    double x;   /**<first axis (north in a local geographic frame)*/
+    double y;   /**<second axis (east in a local geographic frame)*/
+    double z;   /**<third axis (down in a local geographic frame)*/
+} PatchTestPoint;
+
+/*!
+* \brief Patch test line class
+*
+* Collects the datagrams of one line of a patch test, like DatagramGeoreferencer, but only fills the beam cache:
+* every beam is raytraced once and kept in the IMU frame, before boresight. The line can then be georeferenced
+* again for another boresight with a rotation per beam, without interpolating or raytracing.
+*/
+class PatchTestLine : public DatagramGeoreferencer{
+public:
+
+    /**
+    * Creates a patch test line
+    *
+    * @param geo the georeferencing method, shared by all the lines of the patch test
+    * @param svpStrat the sound velocity profile selection strategy of this line
+    */
+    PatchTestLine(Georeferencing & geo,SvpSelectionStrategy & svpStrat) : DatagramGeoreferencer(geo,svpStrat){
+        setBeamCache(true);
+        leverArm.setZero();
+    }
+
+    /**Destroys the patch test line*/
+    ~PatchTestLine(){
+
+    }
+
+    /**
+    * Interpolates, raytraces and caches every beam of the line, once all the datagrams are read
+    *
+    * @param leverArm vector from the position reference point (PRP) to the acoustic center
+    * @param boresight the boresight matrix the beams are raytraced with
+    * @param externalSvps sound velocity profiles to use instead of those of the file, if any
+    */
+    void cacheBeams(Eigen::Vector3d & leverArm,Eigen::Matrix3d & boresight,std::vector<SoundVelocityProfile*> & externalSvps){
+        this->leverArm = leverArm;
+        georeference(leverArm,boresight,externalSvps);
+    }
+
+    /**
+    * Nothing to write: the beams of the swath are already cached
+    */
+    virtual void georeferenceSwath(unsigned int first,unsigned int last,Attitude & attitude,Position & position,SoundVelocityProfile & svp,Eigen::Vector3d & leverArm,Eigen::Matrix3d & boresight,int positionIndex,int attitudeIndex){
+
+    }
+
+    /**
+    * Georeferences the cached beams for a boresight matrix, in parallel
+    *
+    * @param boresight the boresight matrix
+    * @param points the georeferenced beams, swath by swath
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    void georeferenceBeams(const Eigen::Matrix3d & boresight,std::vector<PatchTestPoint> & points,unsigned int threadCount = 0) const{
+        std::vector<uint64_t> firstPoints(cachedSwaths.size() + 1,0);
+
+        for(unsigned int s=0;s<cachedSwaths.size();s++){
+            firstPoints[s + 1] = firstPoints[s] + (cachedSwaths[s].last - cachedSwaths[s].first);
+        }
+
+        points.resize(firstPoints.back());
+
+        static_assert(sizeof(PatchTestPoint) == 3 * sizeof(double),"PatchTestPoint must be three packed coordinates");
+
+        ParallelFor::run(cachedSwaths.size(),[this,&boresight,&points,&firstPoints](unsigned int s,unsigned int thread){
+            if(cachedSwaths[s].last > cachedSwaths[s].first){
+                transformCachedSwath(cachedSwaths[s],leverArm,boresight,&points[firstPoints[s]].x);
+            }
+        },threadCount);
+    }
+
+    /**Returns the number of cached beams*/
+    uint64_t getBeamCount() const{
+        uint64_t count = 0;
+
+        for(unsigned int s=0;s<cachedSwaths.size();s++){
+            count += cachedSwaths[s].last - cachedSwaths[s].first;
+        }
+
+        return count;
+    }
+
+private:
+
+    /**Lever arm the beams are georeferenced with*/
+    Eigen::Vector3d leverArm;
+};
+
+/*!
+* \brief Boresight calibrator class
+*
+* Patch test solver: finds the roll, pitch and heading boresight angles that make overlapping lines agree.
+* Each line is raytraced once and cached (PatchTestLine). The disagreement between the lines for a set of
+* angles is the mean square depth difference of the gridded overlaps of every pair of lines
+* (OverlapStatistics), weighted by the number of compared cells, and only needs the beams to be rotated.
+* The compared cells of each pair are kept at the best angles found so far: each of them that other angles
+* no longer compare counts at the pair's mean square difference at the best angles, whatever new cells
+* they compare, so that moving or shrinking the overlap is not rewarded on its own. The disagreement is minimized with a compass
+* search: each angle is moved by a step in both directions, and the step is halved when no move improves
+* the disagreement. The beams are then raytraced again at the solution and the search resumed from there
+* with a small step, which removes the error of rotating refracted rays.
+*
+* Lines are georeferenced in a local geographic frame (NED) shared by all of them.
+*/
+class BoresightCalibrator{
+public:
+
+    /**
+    * Creates a boresight calibrator
+    *
+    * @param cellSize size of the grid cells the lines are compared on
+    * @param minimumSoundings number of soundings of each line a cell needs to be compared
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    BoresightCalibrator(double cellSize = 1.0,unsigned int minimumSoundings = 1,unsigned int threadCount = 0)
+    : statistics(cellSize,minimumSoundings,threadCount), threadCount(threadCount), evaluationCount(0), comparedCells(0), lastMeanSquare(NAN){
+
+    }
+
+    /**Destroys the boresight calibrator and its lines*/
+    ~BoresightCalibrator(){
+        for(unsigned int i=0;i<lines.size();i++){
+            delete lines[i];
+            delete svpStrategies[i];
+        }
+    }
+
+    /**
+    * Adds a line, to be filled by a datagram parser
+    */
+    PatchTestLine & addLine(){
+        svpStrategies.push_back(new SvpNearestByTime());
+        lines.push_back(new PatchTestLine(georef,*svpStrategies.back()));
+
+        return *lines.back();
+    }
+
+    /**Returns the local geographic frame, whose centroid is computed from the first line if it is not set*/
+    GeoreferencingLGF & getGeoreferencing(){
+        return georef;
+    }
+
+    /**
+    * Finds the boresight angles. The lines must have been parsed
+    *
+    * @param leverArm vector from the position reference point (PRP) to the acoustic center
+    * @param externalSvps sound velocity profiles to use instead of those of the files, if any
+    * @param roll the roll angle in degrees: the initial guess, then the solution
+    * @param pitch the pitch angle in degrees: the initial guess, then the solution
+    * @param heading the heading angle in degrees: the initial guess, then the solution
+    * @param initialStep first step of the search, in degrees
+    * @param minimumStep the search stops when the step falls below this, in degrees
+    */
+    void calibrate(Eigen::Vector3d & leverArm,std::vector<SoundVelocityProfile*> & externalSvps,double & roll,double & pitch,double & heading,double initialStep = 1.0,double minimumStep = 0.005){
+        if(lines.size() < 2){
+            throw new Exception("A patch test needs at least two lines");
+        }
+
+        double angles[3] = {roll,pitch,heading};
+        Eigen::Matrix3d boresight;
+        buildMatrix(boresight,angles);
+
+        for(unsigned int i=0;i<lines.size();i++){
+            lines[i]->cacheBeams(leverArm,boresight,externalSvps);
+        }
+
+        evaluationCount = 0;
+        search(angles,initialStep,minimumStep);
+
+        //rotated rays are only exact at the raytraced boresight: raytrace at the solution and refine
+        buildMatrix(boresight,angles);
+
+        for(unsigned int i=0;i<lines.size();i++){
+            lines[i]->raytraceCache(boresight,threadCount);
+        }
+
+        search(angles,std::min(initialStep,REFINEMENT_STEPS * minimumStep),minimumStep);
+
+        roll = angles[0];
+        pitch = angles[1];
+        heading = angles[2];
+    }
+
+    /**
+    * Returns the disagreement between the lines for boresight angles, from the cached beams: the mean square
+    * depth difference of the compared cells of every pair of lines, with the cells no longer compared since the
+    * best angles of the last search penalized. NaN if the lines do not overlap
+    *
+    * @param roll the roll angle in degrees
+    * @param pitch the pitch angle in degrees
+    * @param heading the heading angle in degrees
+    */
+    double computeCost(double roll,double pitch,double heading){
+        double angles[3] = {roll,pitch,heading};
+        return evaluate(angles);
+    }
+
+    /**Returns the number of disagreement evaluations of the last calibration*/
+    unsigned int getEvaluationCount() const{
+        return evaluationCount;
+    }
+
+    /**Returns the number of compared cells of the last evaluation*/
+    uint64_t getComparedCellCount() const{
+        return comparedCells;
+    }
+
+    /**Returns the number of lines*/
+    unsigned int getLineCount() const{
+        return lines.size();
+    }
+
+    /**
+    * Returns a line
+    *
+    * @param line index of the line
+    */
+    PatchTestLine & getLine(unsigned int line){
+        return *lines[line];
+    }
+
+private:
+
+    /**The refinement search starts at this many minimum steps*/
+    static constexpr double REFINEMENT_STEPS = 8;
+
+    /**
+    * Builds the boresight matrix of angles
+    *
+    * @param boresight the boresight matrix
+    * @param angles roll, pitch and heading in degrees
+    */
+    static void buildMatrix(Eigen::Matrix3d & boresight,const double * angles){
+        Attitude boresightAngles(0,angles[0],angles[1],angles[2]);
+        Boresight::buildMatrix(boresight,boresightAngles);
+    }
+
+    /**
+    * Compass search from angles
+    *
+    * @param angles roll, pitch and heading in degrees: the start, then the best found
+    * @param step the first step, in degrees
+    * @param minimumStep the search stops when the step falls below this, in degrees
+    */
+    void search(double * angles,double step,double minimumStep){
+        evaluate(angles);
+        double best = keepReference();
+
+        if(std::isnan(best)){
+            throw new Exception("The patch test lines do not overlap");
+        }
+
+        while(step >= minimumStep){
+            bool improved = false;
+
+            for(unsigned int axis=0;axis<3;axis++){
+                for(int direction=-1;direction<=1;direction+=2){
+                    double candidate[3] = {angles[0],angles[1],angles[2]};
+                    candidate[axis] += direction * step;
+
+                    double cost = evaluate(candidate);
+
+                    if(cost < best){
+                        std::copy(candidate,candidate + 3,angles);
+                        best = keepReference();
+                        improved = true;
+                        break;
+                    }
+                }
+            }
+
+            if(!improved){
+                step /= 2;
+            }
+        }
+    }
+
+    /**
+    * Keeps the compared cells and mean square difference of each pair of the last evaluation, to count the lost cells from.
+    * Returns the disagreement of the last evaluation against this new reference, which has no lost cell: its plain mean square
+    */
+    double keepReference(){
+        referenceCells.swap(pairCells);
+        lostCellPenalties.swap(pairPenalties);
+
+        return lastMeanSquare;
+    }
+
+    /**
+    * Returns the disagreement between the lines for boresight angles
+    *
+    * @param angles roll, pitch and heading in degrees
+    */
+    double evaluate(const double * angles){
+        Eigen::Matrix3d boresight;
+        buildMatrix(boresight,angles);
+
+        points.resize(lines.size());
+
+        for(unsigned int i=0;i<lines.size();i++){
+            lines[i]->georeferenceBeams(boresight,points[i],threadCount);
+        }
+
+        pairCells.resize(lines.size() * (lines.size() - 1) / 2);
+        pairPenalties.clear();
+
+        double sum = 0;
+        double penalty = 0;
+        uint64_t lostCells = 0;
+        unsigned int pair = 0;
+        comparedCells = 0;
+
+        for(unsigned int i=0;i<lines.size();i++){
+            for(unsigned int j=i+1;j<lines.size();j++,pair++){
+                statistics.compute(points[i],points[j]);
+
+                uint64_t cells = statistics.getComparedCellCount();
+
+                if(cells > 0){
+                    sum += statistics.getRmsDifference() * statistics.getRmsDifference() * cells;
+                    comparedCells += cells;
+                }
+
+                statistics.getComparedCells(pairCells[pair]);
+                pairPenalties.push_back((cells > 0) ? statistics.getRmsDifference() * statistics.getRmsDifference() : 0);
+
+                if(pair < referenceCells.size()){
+                    uint64_t lost = countLostCells(referenceCells[pair],pairCells[pair]);
+                    penalty += lostCellPenalties[pair] * lost;
+                    lostCells += lost;
+                }
+            }
+        }
+
+        evaluationCount++;
+
+        lastMeanSquare = (comparedCells > 0) ? sum / comparedCells : NAN;
+
+        return (comparedCells > 0) ? (sum + penalty) / (comparedCells + lostCells) : NAN;
+    }
+
+    /**
+    * Returns the number of reference cells missing from the compared cells, both sorted
+    *
+    * @param reference the cells compared at the best angles
+    * @param cells the cells compared now
+    */
+    static uint64_t countLostCells(const std::vector<std::pair<int64_t,int64_t> > & reference,const std::vector<std::pair<int64_t,int64_t> > & cells){
+        uint64_t lost = 0;
+        size_t j = 0;
+
+        for(size_t i=0;i<reference.size();i++){
+            while(j < cells.size() && cells[j] < reference[i]){
+                j++;
+            }
+
+            if(j == cells.size() || reference[i] < cells[j]){
+                lost++;
+            }
+        }
+
+        return lost;
+    }
+
+    /**Local geographic frame shared by the lines*/
+    GeoreferencingLGF georef;
+
+    /**Sound velocity profile selection strategy of each line*/
+    std::vector<SvpSelectionStrategy*> svpStrategies;
+
+    /**The lines*/
+    std::vector<PatchTestLine*> lines;
+
+    /**Georeferenced beams of each line, for the current evaluation*/
+    std::vector<std::vector<PatchTestPoint> > points;
+
+    /**Gridded comparison of two lines*/
+    OverlapStatistics statistics;
+
+    /**Number of threads, 0 for one per hardware thread*/
+    unsigned int threadCount;
+
+    /**Number of disagreement evaluations*/
+    unsigned int evaluationCount;
+
+    /**Number of compared cells of the last evaluation*/
+    uint64_t comparedCells;
+
+    /**Mean square depth difference of the compared cells of the last evaluation, without the lost cells*/
+    double lastMeanSquare;
+
+    /**Compared cells of each pair of lines at the best angles, as row and column*/
+    std::vector<std::vector<std::pair<int64_t,int64_t> > > referenceCells;
+
+    /**Squared depth difference a lost cell of each pair of lines counts for: the mean square at the best angles*/
+    std::vector<double> lostCellPenalties;
+
+    /**Compared cells of each pair of lines of the last evaluation, as row and column*/
+    std::vector<std::vector<std::pair<int64_t,int64_t> > > pairCells;
+
+    /**Mean square depth difference of each pair of lines of the last evaluation*/
+    std::vector<double> pairPenalties;
+};
+
+#endif
@@ -13,6 +13,14 @@
 #include "../svp/SvpSelectionStrategy.hpp"
 #include "../datagrams/DatagramEventHandler.hpp"
 #include "../math/Interpolation.hpp"
+#include "../utils/TextOutputBuffer.hpp"
+#include "../PointRecord.hpp"
+#include "../filter/PingFilter.hpp"
+#include "../math/TotalPropagatedUncertainty.hpp"
+#include "../math/CoordinateTransform.hpp"
+#include "../utils/ParallelFor.hpp"
+#include "../utils/Exception.hpp"
+#include <limits>
 
 /*!
  * \brief Datagram Georeferencer class.
@@ -24,13 +32,26 @@ class DatagramGeoreferencer : public DatagramEventHandler {
 public:
 
     /**Create a datagram georeferencer*/
-    DatagramGeoreferencer(Georeferencing & geo, SvpSelectionStrategy & svpStrat) : georef(geo), svpStrategy(svpStrat) {
+    DatagramGeoreferencer(Georeferencing & geo, SvpSelectionStrategy & svpStrat) : georef(geo), svpStrategy(svpStrat), currentSurfaceSoundSpeed(0), output(stdout), binaryOutput(false), uncertainty(NULL), beamCacheEnabled(false), beamXYZEnabled(false) {
 
     }
 
-    /**Destroy the datagram georeferencer*/
+    /**Destroy the datagram georeferencer and its ping filters*/
     ~DatagramGeoreferencer() {
+        for (unsigned int i = 0; i < pingFilters.size(); i++) {
+            delete pingFilters[i];
+        }
+    }
 
+    /**
+     * Add a filter applied to every ping as it is received, before interpolation and raytracing.
+     * The georeferencer takes ownership of the filter
+     *
+     * @param filter the ping filter
+     */
+    void addPingFilter(PingFilter * filter) {
+        pingFilters.push_back(filter);
+        pingFilterCounts.push_back(0);
     }
 
     /**
@@ -69,9 +90,51 @@ public:
      * @param intensity the ping intensity
      */
     void processPing(uint64_t microEpoch, long id, double beamAngle, double tiltAngle, double twoWayTravelTime, uint32_t quality, int32_t intensity) {
-        pings.push_back(Ping(microEpoch, id, quality, intensity, currentSurfaceSoundSpeed, twoWayTravelTime, tiltAngle, beamAngle));
+        if (beamXYZEnabled) {
+            return;
+        }
+
+        Ping ping(microEpoch, id, quality, intensity, currentSurfaceSoundSpeed, twoWayTravelTime, tiltAngle, beamAngle);
+
+        if (!filterPing(ping)) {
+            pings.push_back(ping);
+        }
     };
 
+    /**
+     * Add a sounding computed by the sonar, with its vector, in the vectors pings and beamXYZ. Ignored unless
+     * setBeamXYZ() is enabled. The ping gets the angles and straight ray travel time of the vector, for the ping filters.
+     * The travel time is NaN until a swath start gives a valid surface sound speed
+     *
+     * @param microEpoch the ping timestamp
+     * @param id the ping id
+     * @param alongTrack the along track distance (m), positive forward
+     * @param acrossTrack the across track distance (m), positive to starboard
+     * @param depth the depth (m) from the transducer, positive down
+     * @param quality the ping quality
+     * @param intensity the ping intensity
+     */
+    void processBeamXYZ(uint64_t microEpoch, long id, double alongTrack, double acrossTrack, double depth, uint32_t quality, int32_t intensity) {
+        if (!beamXYZEnabled) {
+            return;
+        }
+
+        double range = sqrt(alongTrack * alongTrack + acrossTrack * acrossTrack + depth * depth);
+        double tiltAngle = (range > 0) ? asin(alongTrack / range) * R2D : 0;
+        double beamAngle = atan2(acrossTrack, depth) * R2D;
+
+        double twoWayTravelTime = (currentSurfaceSoundSpeed > 0) ? 2 * range / currentSurfaceSoundSpeed : NAN;
+
+        Ping ping(microEpoch, id, quality, intensity, currentSurfaceSoundSpeed, twoWayTravelTime, tiltAngle, beamAngle);
+
+        if (!filterPing(ping)) {
+            pings.push_back(ping);
+            beamXYZ.push_back(alongTrack);
+            beamXYZ.push_back(acrossTrack);
+            beamXYZ.push_back(depth);
+        }
+    }
+
     /**
      * Change the current surface sound speed
      * 
@@ -137,21 +200,38 @@ public:
         //Sort everything
         std::sort(positions.begin(), positions.end(), &Position::sortByTimestamp);
         std::sort(attitudes.begin(), attitudes.end(), &Attitude::sortByTimestamp);
-        std::sort(pings.begin(), pings.end(), &Ping::sortByTimestamp);
+        sortPings();
 
         fprintf(stderr, "[+] Position data points: %ld [%lu to %lu]\n", positions.size(), positions[0].getTimestamp(), positions[positions.size() - 1].getTimestamp());
         fprintf(stderr, "[+] Attitude data points: %ld [%lu to %lu]\n", attitudes.size(), attitudes[0].getTimestamp(), attitudes[attitudes.size() - 1].getTimestamp());
         fprintf(stderr, "[+] Ping data points: %ld [%lu to %lu]\n", pings.size(), (pings.size() > 0) ? pings[0].getTimestamp() : 0, (pings.size() > 0) ? pings[pings.size() - 1].getTimestamp() : 0);
 
+        for (unsigned int i = 0; i < pingFilters.size(); i++) {
+            fprintf(stderr, "[+] Beams rejected before georeferencing (%s): %lu\n", pingFilters[i]->getDescription(), pingFilterCounts[i]);
+        }
+
+        if (beamCacheEnabled) {
+            cachedSwaths.clear();
+
+            if (!beamXYZEnabled) {
+                cachedBeams.assign(3 * pings.size(), std::numeric_limits<double>::quiet_NaN());
+            }
+        }
+
         //interpolate attitudes and positions around pings
         unsigned int attitudeIndex = 0;
         unsigned int positionIndex = 0;
 
-        //Georef pings
-        for (auto i = pings.begin(); i != pings.end(); i++) {
+        //Georef pings, one swath (the pings sharing a timestamp) at a time
+        for (unsigned int first = 0; first < pings.size();) {
+            uint64_t timestamp = pings[first].getTimestamp();
+            unsigned int last = first + 1;
 
+            while (last < pings.size() && pings[last].getTimestamp() == timestamp) {
+                last++;
+            }
 
-            while (attitudeIndex + 1 < attitudes.size() && attitudes[attitudeIndex + 1].getTimestamp() < (*i).getTimestamp()) {
+            while (attitudeIndex + 1 < attitudes.size() && attitudes[attitudeIndex + 1].getTimestamp() < timestamp) {
                 attitudeIndex++;
             }
 
@@ -161,7 +241,7 @@ public:
                 break;
             }
 
-            while (positionIndex + 1 < positions.size() && positions[positionIndex + 1].getTimestamp() < (*i).getTimestamp()) {
+            while (positionIndex + 1 < positions.size() && positions[positionIndex + 1].getTimestamp() < timestamp) {
                 positionIndex++;
             }
 
@@ -171,9 +251,13 @@ public:
                 break;
             }
 
-            //No position or attitude smaller than ping, so discard this ping
-            if (positions[positionIndex].getTimestamp() > (*i).getTimestamp() || attitudes[attitudeIndex].getTimestamp() > (*i).getTimestamp()) {
-                std::cerr << "rejecting ping " << (*i).getId() << " " << (*i).getTimestamp() << " " << positions[positionIndex].getTimestamp() << " " << attitudes[attitudeIndex].getTimestamp() << std::endl;
+            //No position or attitude smaller than ping, so discard this swath
+            if (positions[positionIndex].getTimestamp() > timestamp || attitudes[attitudeIndex].getTimestamp() > timestamp) {
+                for (unsigned int i = first; i < last; i++) {
+                    std::cerr << "rejecting ping " << pings[i].getId() << " " << pings[i].getTimestamp() << " " << positions[positionIndex].getTimestamp() << " " << attitudes[attitudeIndex].getTimestamp() << std::endl;
+                }
+
+                first = last;
                 continue;
             }
 
@@ -183,22 +267,236 @@ public:
             Position & beforePosition = positions[positionIndex];
             Position & afterPosition = positions[positionIndex + 1];
 
-            Attitude * interpolatedAttitude = Interpolator::interpolateAttitude(beforeAttitude, afterAttitude, (*i).getTimestamp());
-            Position * interpolatedPosition = Interpolator::interpolatePosition(beforePosition, afterPosition, (*i).getTimestamp());
+            Attitude * interpolatedAttitude = Interpolator::interpolateAttitude(beforeAttitude, afterAttitude, timestamp);
+            Position * interpolatedPosition = Interpolator::interpolatePosition(beforePosition, afterPosition, timestamp);
+            SoundVelocityProfile * svp = svpStrategy.chooseSvp(*interpolatedPosition, pings[first]);
 
-            //georeference
-            Eigen::Vector3d georeferencedPing;
-            georef.georeference(georeferencedPing, *interpolatedAttitude, *interpolatedPosition, (*i), *(svpStrategy.chooseSvp(*interpolatedPosition, *i)), leverArm, boresight);
+            if (beamCacheEnabled) {
+                cacheSwath(first, last, *interpolatedAttitude, *interpolatedPosition, *svp, boresight, positionIndex, attitudeIndex);
+            }
 
-            processGeoreferencedPing(georeferencedPing, (*i).getQuality(), (*i).getIntensity(), positionIndex, attitudeIndex);
+            georeferenceSwath(first, last, *interpolatedAttitude, *interpolatedPosition, *svp, leverArm, boresight, positionIndex, attitudeIndex);
 
             delete interpolatedAttitude;
             delete interpolatedPosition;
+
+            first = last;
         }
+
+        output.flush();
     }
 
-    virtual void processGeoreferencedPing(Eigen::Vector3d & georeferencedPing, uint32_t quality, int32_t intensity, int positionIndex, int attitudeIndex) {
-        std::cout << georeferencedPing(0) << " " << georeferencedPing(1) << " " << georeferencedPing(2) << " " << quality << " " << intensity << std::endl;
+    /**
+     * Georeferences the pings of a swath, which share a timestamp, and hands them to processGeoreferencedPing
+     *
+     * @param first index of the first ping of the swath
+     * @param last index past the last ping of the swath
+     * @param attitude the attitude interpolated at the swath timestamp
+     * @param position the position interpolated at the swath timestamp
+     * @param svp the sound velocity profile chosen for the swath
+     * @param leverArm vector from the position reference point (PRP) to the acoustic center
+     * @param boresight the boresight matrix
+     * @param positionIndex index of the position preceding the swath
+     * @param attitudeIndex index of the attitude preceding the swath
+     */
+    virtual void georeferenceSwath(unsigned int first, unsigned int last, Attitude & attitude, Position & position, SoundVelocityProfile & svp, Eigen::Vector3d & leverArm, Eigen::Matrix3d & boresight, int positionIndex, int attitudeIndex) {
+        reserveSwath(last - first);
+
+        //georeference, from the cache when it was just filled
+        if (beamXYZEnabled) {
+            georeferenceXYZSwath(first, last, attitude, position, leverArm);
+        } else if (beamCacheEnabled) {
+            georeferenceCachedSwath(cachedSwaths.back(), leverArm, boresight);
+        } else {
+            for (unsigned int i = first; i < last; i++) {
+                georef.georeference(swathPoints[i - first], attitude, position, pings[i], svp, leverArm, boresight);
+            }
+        }
+
+        processGeoreferencedSwath(first, last, attitude, position, positionIndex, attitudeIndex);
+    }
+
+    /**
+     * Keeps what georeference() computes for each beam, so that regeoreference() can apply another lever arm
+     * or boresight without decoding, sorting, interpolating and raytracing again. Costs 24 bytes per beam
+     * and about 300 bytes per swath
+     *
+     * @param enabled true to keep the beams of the next georeference()
+     */
+    void setBeamCache(bool enabled) {
+        beamCacheEnabled = enabled;
+
+        if (!enabled) {
+            std::vector<CachedSwath>().swap(cachedSwaths);
+            std::vector<double>().swap(cachedBeams);
+        }
+    }
+
+    /**
+     * Georeferences the soundings computed by the sonar (processBeamXYZ) instead of raytracing the pings
+     * (processPing): the position, the heading and the vertical part of the lever arm are applied to their vectors,
+     * without a sound velocity profile. The sonar already compensated its mounting, roll and pitch, so the boresight
+     * is not applied
+     *
+     * @param enabled true to georeference the soundings of the sonar
+     */
+    void setBeamXYZ(bool enabled) {
+        beamXYZEnabled = enabled;
+    }
+
+    /**
+     * Georeferences the beams kept by the last georeference() again, for another lever arm or boresight, and hands
+     * them to processGeoreferencedPing. A lever arm change is exact. A boresight change rotates the raytraced beams,
+     * which is exact for a constant sound speed and otherwise neglects the change of refraction with the launch
+     * angle; raytraceCache() raytraces them again at a boresight
+     *
+     * @param leverArm vector from the position reference point (PRP) to the acoustic center
+     * @param boresight the boresight matrix
+     */
+    virtual void regeoreference(Eigen::Vector3d & leverArm, Eigen::Matrix3d & boresight) {
+        if (cachedSwaths.empty()) {
+            throw new Exception("No beam cache to georeference again: enable it before georeferencing");
+        }
+
+        for (unsigned int s = 0; s < cachedSwaths.size(); s++) {
+            CachedSwath & swath = cachedSwaths[s];
+
+            reserveSwath(swath.last - swath.first);
+
+            if (beamXYZEnabled) {
+                georeferenceXYZSwath(swath.first, swath.last, swath.attitude, swath.position, leverArm);
+            } else {
+                georeferenceCachedSwath(swath, leverArm, boresight);
+            }
+
+            processGeoreferencedSwath(swath.first, swath.last, swath.attitude, swath.position, swath.positionIndex, swath.attitudeIndex);
+        }
+
+        output.flush();
+    }
+
+    /**
+     * Raytraces the cached beams again, from their launch vectors, at another boresight, in parallel
+     *
+     * @param boresight the boresight matrix
+     * @param threadCount number of threads, or 0 for one per hardware thread
+     */
+    void raytraceCache(Eigen::Matrix3d & boresight, unsigned int threadCount = 0) {
+        //the soundings of the sonar are not raytraced
+        if (beamXYZEnabled) {
+            return;
+        }
+
+        ParallelFor::run(cachedSwaths.size(), [this, &boresight](unsigned int s, unsigned int thread) {
+            CachedSwath & swath = cachedSwaths[s];
+
+            for (unsigned int i = swath.first; i < swath.last; i++) {
+                raytraceBeam(i, swath, boresight);
+            }
+        }, threadCount);
+    }
+
+    /**
+     * Writes a swath of georeferenced pings, in swathPoints, with their uncertainty when it is computed
+     *
+     * @param first index of the first ping of the swath
+     * @param last index past the last ping of the swath
+     * @param attitude the attitude interpolated at the swath timestamp
+     * @param position the position interpolated at the swath timestamp
+     * @param positionIndex index of the position preceding the swath
+     * @param attitudeIndex index of the attitude preceding the swath
+     */
+    void processGeoreferencedSwath(unsigned int first, unsigned int last, Attitude & attitude, Position & position, int positionIndex, int attitudeIndex) {
+        unsigned int swathSize = last - first;
+
+        if (uncertainty) {
+            //back to vectors from the position reference point, for the whole swath at once
+            Eigen::Vector3d origin;
+            Eigen::Matrix3d toNED;
+            georef.getLocalFrame(origin, toNED, position);
+
+            for (unsigned int k = 0; k < swathSize; k++) {
+                Eigen::Vector3d beam = toNED * (swathPoints[k] - origin);
+                swathNorth[k] = beam(0);
+                swathEast[k] = beam(1);
+                swathDown[k] = beam(2);
+            }
+
+            uncertainty->computeSwath(attitude, pings[first].getSurfaceSoundSpeed(), &swathNorth[0], &swathEast[0], &swathDown[0], swathSize, &swathHorizontalUncertainty[0], &swathVerticalUncertainty[0]);
+        }
+
+        for (unsigned int i = first; i < last; i++) {
+            unsigned int k = i - first;
+            processGeoreferencedPing(swathPoints[k], pings[i].getQuality(), pings[i].getIntensity(), swathHorizontalUncertainty[k], swathVerticalUncertainty[k], positionIndex, attitudeIndex);
+        }
+    }
+
+    /**
+     * Writes a georeferenced ping to the standard output as "x y z quality intensity", with 6 decimals,
+     * followed by the horizontal and vertical uncertainty when they are computed,
+     * or as a PointRecord if binary output is enabled
+     *
+     * @param georeferencedPing the georeferenced ping
+     * @param quality the ping quality
+     * @param intensity the ping intensity
+     * @param horizontalUncertainty the horizontal uncertainty (2 sigma), NaN if it is not computed
+     * @param verticalUncertainty the vertical uncertainty (2 sigma), NaN if it is not computed
+     * @param positionIndex index of the position preceding the ping
+     * @param attitudeIndex index of the attitude preceding the ping
+     */
+    virtual void processGeoreferencedPing(Eigen::Vector3d & georeferencedPing, uint32_t quality, int32_t intensity, double horizontalUncertainty, double verticalUncertainty, int positionIndex, int attitudeIndex) {
+        if (binaryOutput) {
+            PointRecord point = {georeferencedPing(0), georeferencedPing(1), georeferencedPing(2), quality, intensity, (float) horizontalUncertainty, (float) verticalUncertainty};
+            output.appendString((const char *) &point, sizeof(PointRecord));
+            return;
+        }
+
+        output.appendFixed(georeferencedPing(0), 6);
+        output.appendChar(' ');
+        output.appendFixed(georeferencedPing(1), 6);
+        output.appendChar(' ');
+        output.appendFixed(georeferencedPing(2), 6);
+        output.appendChar(' ');
+        output.appendUnsigned(quality);
+        output.appendChar(' ');
+        output.appendInteger(intensity);
+
+        if (uncertainty) {
+            output.appendChar(' ');
+            output.appendFixed(horizontalUncertainty, 6);
+            output.appendChar(' ');
+            output.appendFixed(verticalUncertainty, 6);
+        }
+
+        output.appendChar('\n');
+    }
+
+    /**
+     * Selects binary PointRecord output instead of text
+     *
+     * @param binary true to write binary records
+     */
+    void setBinaryOutput(bool binary) {
+        binaryOutput = binary;
+    }
+
+    /**
+     * Computes the total propagated uncertainty of every ping. The georeferencer does not take ownership of the model
+     *
+     * @param model the uncertainty model, or NULL to disable it
+     */
+    void setUncertainty(TotalPropagatedUncertainty * model) {
+        uncertainty = model;
+    }
+
+    /**
+     * Sets where the georeferenced points are written, the standard output by default
+     *
+     * @param file the output file
+     */
+    void setOutputFile(FILE * file) {
+        output.flush();
+        output.setFile(file);
     }
 
     void setSvpStrategy(SvpSelectionStrategy& svpStrategy) {
@@ -208,6 +506,248 @@ public:
 
 protected:
 
+    /**
+     * Swath kept in the beam cache
+     */
+    struct CachedSwath {
+        Attitude attitude;          /**<attitude interpolated at the swath timestamp*/
+        Position position;          /**<position interpolated at the swath timestamp*/
+        SoundVelocityProfile * svp; /**<sound velocity profile chosen for the swath*/
+        Eigen::Vector3d origin;     /**<position in the georeferencing frame*/
+        Eigen::Matrix3d imu2ned;    /**<IMU to NED rotation, for raytracing*/
+        Eigen::Matrix3d imu2frame;  /**<IMU to georeferencing frame rotation*/
+        unsigned int first;         /**<index of the first ping of the swath*/
+        unsigned int last;          /**<index past the last ping of the swath*/
+        int positionIndex;          /**<index of the position preceding the swath*/
+        int attitudeIndex;          /**<index of the attitude preceding the swath*/
+
+        /**
+         * Creates a cached swath
+         *
+         * @param attitude the attitude interpolated at the swath timestamp
+         * @param position the position interpolated at the swath timestamp
+         * @param svp the sound velocity profile chosen for the swath
+         * @param origin the position in the georeferencing frame
+         * @param imu2ned the IMU to NED rotation
+         * @param imu2frame the IMU to georeferencing frame rotation
+         * @param first index of the first ping of the swath
+         * @param last index past the last ping of the swath
+         * @param positionIndex index of the position preceding the swath
+         * @param attitudeIndex index of the attitude preceding the swath
+         */
+        CachedSwath(Attitude & attitude, Position & position, SoundVelocityProfile * svp, const Eigen::Vector3d & origin, const Eigen::Matrix3d & imu2ned, const Eigen::Matrix3d & imu2frame, unsigned int first, unsigned int last, int positionIndex, int attitudeIndex)
+        : attitude(attitude), position(position), svp(svp), origin(origin), imu2ned(imu2ned), imu2frame(imu2frame), first(first), last(last), positionIndex(positionIndex), attitudeIndex(attitudeIndex) {
+        }
+    };
+
+    /**
+     * Applies the ping filters to a ping
+     *
+     * @param ping the ping
+     * @return true if a filter rejects the ping
+     */
+    bool filterPing(Ping & ping) {
+        for (unsigned int i = 0; i < pingFilters.size(); i++) {
+            if (pingFilters[i]->filterPing(ping)) {
+                pingFilterCounts[i]++;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Sorts the pings by timestamp, with their sonar vectors in beamXYZ if any
+     */
+    void sortPings() {
+        if (beamXYZ.empty()) {
+            std::sort(pings.begin(), pings.end(), &Ping::sortByTimestamp);
+            return;
+        }
+
+        //the soundings are usually in order already
+        if (std::is_sorted(pings.begin(), pings.end(), &Ping::sortByTimestamp)) {
+            return;
+        }
+
+        std::vector<unsigned int> order(pings.size());
+
+        for (unsigned int i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+            return pings[a].getTimestamp() < pings[b].getTimestamp();
+        });
+
+        std::vector<Ping> sortedPings;
+        std::vector<double> sortedXYZ(beamXYZ.size());
+        sortedPings.reserve(pings.size());
+
+        for (unsigned int i = 0; i < order.size(); i++) {
+            sortedPings.push_back(pings[order[i]]);
+            sortedXYZ[3 * i] = beamXYZ[3 * order[i]];
+            sortedXYZ[3 * i + 1] = beamXYZ[3 * order[i] + 1];
+            sortedXYZ[3 * i + 2] = beamXYZ[3 * order[i] + 2];
+        }
+
+        pings.swap(sortedPings);
+        beamXYZ.swap(sortedXYZ);
+    }
+
+    /**
+     * Georeferences the soundings of the sonar of a swath into swathPoints: origin + ned2frame * (0, 0, down) + heading2frame * beam,
+     * down being the vertical part of imu2ned * leverArm. The sonar gives the along and across track distances from the vessel
+     * reference point, which must be the position reference point, and the depth from the transmit transducer: only the
+     * vertical offset from the position reference point to the transducer is left to apply. The transmit transducer depth
+     * of the datagram, re water level, is not used since the positions are not referenced to the water level
+     *
+     * @param first index of the first ping of the swath
+     * @param last index past the last ping of the swath
+     * @param attitude the attitude interpolated at the swath timestamp
+     * @param position the position interpolated at the swath timestamp
+     * @param leverArm vector from the position reference point (PRP) to the transducer
+     */
+    void georeferenceXYZSwath(unsigned int first, unsigned int last, Attitude & attitude, Position & position, const Eigen::Vector3d & leverArm) {
+        Eigen::Vector3d origin;
+        Eigen::Matrix3d toNED;
+        georef.getLocalFrame(origin, toNED, position);
+
+        Eigen::Matrix3d imu2ned;
+        CoordinateTransform::getDCM(imu2ned, attitude);
+        Eigen::Vector3d transducerDepth(0, 0, (imu2ned * leverArm)(2));
+        origin += toNED.transpose() * transducerDepth;
+
+        //the sonar vectors are horizontal and vertical, along the heading
+        Attitude heading(attitude.getTimestamp(), 0, 0, attitude.getHeading());
+        Eigen::Matrix3d heading2ned;
+        CoordinateTransform::getDCM(heading2ned, heading);
+        Eigen::Matrix3d rotation = toNED.transpose() * heading2ned;
+
+        double r[9];
+
+        for (unsigned int k = 0; k < 9; k++) {
+            r[k] = rotation(k / 3, k % 3);
+        }
+
+        for (unsigned int i = first; i < last; i++) {
+            const double * u = &beamXYZ[3 * i];
+            double * point = swathPoints[i - first].data();
+            point[0] = origin(0) + r[0] * u[0] + r[1] * u[1] + r[2] * u[2];
+            point[1] = origin(1) + r[3] * u[0] + r[4] * u[1] + r[5] * u[2];
+            point[2] = origin(2) + r[6] * u[0] + r[7] * u[1] + r[8] * u[2];
+        }
+    }
+
+    /**
+     * Makes room for a swath in the swath buffers
+     *
+     * @param swathSize number of pings of the swath
+     */
+    void reserveSwath(unsigned int swathSize) {
+        if (swathPoints.size() < swathSize) {
+            swathPoints.resize(swathSize);
+            swathNorth.resize(swathSize);
+            swathEast.resize(swathSize);
+            swathDown.resize(swathSize);
+            swathHorizontalUncertainty.resize(swathSize, std::numeric_limits<double>::quiet_NaN());
+            swathVerticalUncertainty.resize(swathSize, std::numeric_limits<double>::quiet_NaN());
+        }
+    }
+
+    /**
+     * Adds a swath to the beam cache and raytraces its beams
+     *
+     * @param first index of the first ping of the swath
+     * @param last index past the last ping of the swath
+     * @param attitude the attitude interpolated at the swath timestamp
+     * @param position the position interpolated at the swath timestamp
+     * @param svp the sound velocity profile chosen for the swath
+     * @param boresight the boresight matrix
+     * @param positionIndex index of the position preceding the swath
+     * @param attitudeIndex index of the attitude preceding the swath
+     */
+    void cacheSwath(unsigned int first, unsigned int last, Attitude & attitude, Position & position, SoundVelocityProfile & svp, Eigen::Matrix3d & boresight, int positionIndex, int attitudeIndex) {
+        Eigen::Vector3d origin;
+        Eigen::Matrix3d toNED;
+        georef.getLocalFrame(origin, toNED, position);
+
+        Eigen::Matrix3d imu2ned;
+        CoordinateTransform::getDCM(imu2ned, attitude);
+
+        cachedSwaths.push_back(CachedSwath(attitude, position, &svp, origin, imu2ned, toNED.transpose() * imu2ned, first, last, positionIndex, attitudeIndex));
+
+        CachedSwath & swath = cachedSwaths.back();
+
+        //the soundings of the sonar are already in beamXYZ
+        if (beamXYZEnabled) {
+            return;
+        }
+
+        for (unsigned int i = first; i < last; i++) {
+            raytraceBeam(i, swath, boresight);
+        }
+    }
+
+    /**
+     * Raytraces a beam and caches its vector in the IMU frame, before boresight
+     *
+     * @param i index of the ping
+     * @param swath the swath of the ping
+     * @param boresight the boresight matrix
+     */
+    void raytraceBeam(unsigned int i, CachedSwath & swath, Eigen::Matrix3d & boresight) {
+        Eigen::Vector3d raytraced;
+        Raytracing::rayTrace(raytraced, pings[i], *swath.svp, boresight, swath.imu2ned);
+
+        Eigen::Vector3d vessel = boresight.transpose() * (swath.imu2ned.transpose() * raytraced);
+        cachedBeams[3 * i] = vessel(0);
+        cachedBeams[3 * i + 1] = vessel(1);
+        cachedBeams[3 * i + 2] = vessel(2);
+    }
+
+    /**
+     * Georeferences the cached beams of a swath into swathPoints: origin + imu2frame * (leverArm + boresight * beam)
+     *
+     * @param swath the swath
+     * @param leverArm vector from the position reference point (PRP) to the acoustic center
+     * @param boresight the boresight matrix
+     */
+    void georeferenceCachedSwath(const CachedSwath & swath, const Eigen::Vector3d & leverArm, const Eigen::Matrix3d & boresight) {
+        if (swath.last > swath.first) {
+            transformCachedSwath(swath, leverArm, boresight, swathPoints[0].data());
+        }
+    }
+
+    /**
+     * Georeferences the cached beams of a swath: origin + imu2frame * (leverArm + boresight * beam)
+     *
+     * @param swath the swath
+     * @param leverArm vector from the position reference point (PRP) to the acoustic center
+     * @param boresight the boresight matrix
+     * @param points the georeferenced beams, three coordinates per beam of the swath
+     */
+    void transformCachedSwath(const CachedSwath & swath, const Eigen::Vector3d & leverArm, const Eigen::Matrix3d & boresight, double * points) const {
+        Eigen::Vector3d origin = swath.origin + swath.imu2frame * leverArm;
+        Eigen::Matrix3d rotation = swath.imu2frame * boresight;
+
+        //plain arithmetic in the per beam loop, which is all that is left to do per beam
+        double r[9];
+
+        for (unsigned int k = 0; k < 9; k++) {
+            r[k] = rotation(k / 3, k % 3);
+        }
+
+        for (unsigned int i = swath.first; i < swath.last; i++) {
+            const double * u = &cachedBeams[3 * i];
+            double * point = points + 3 * (i - swath.first);
+            point[0] = origin(0) + r[0] * u[0] + r[1] * u[1] + r[2] * u[2];
+            point[1] = origin(1) + r[3] * u[0] + r[4] * u[1] + r[5] * u[2];
+            point[2] = origin(2) + r[6] * u[0] + r[7] * u[1] + r[8] * u[2];
+        }
+    }
+
     /**the georeferencing method */
     Georeferencing & georef;
     
@@ -228,6 +768,54 @@ protected:
 
     /**Vector of SoundVelocityProfile*/
     std::vector<SoundVelocityProfile*> svps;
+
+    /**Filters applied to the pings as they are received*/
+    std::vector<PingFilter*> pingFilters;
+
+    /**Number of pings rejected by each filter*/
+    std::vector<uint64_t> pingFilterCounts;
+
+    /**Buffered standard output for the georeferenced points*/
+    TextOutputBuffer output;
+
+    /**True if the georeferenced points are written as binary PointRecords*/
+    bool binaryOutput;
+
+    /**Uncertainty model, NULL if uncertainties are not computed*/
+    TotalPropagatedUncertainty * uncertainty;
+
+    /**Georeferenced pings of the current swath*/
+    std::vector<Eigen::Vector3d> swathPoints;
+
+    /**North component of the pings of the current swath, from the position reference point*/
+    std::vector<double> swathNorth;
+
+    /**East component of the pings of the current swath, from the position reference point*/
+    std::vector<double> swathEast;
+
+    /**Down component of the pings of the current swath, from the position reference point*/
+    std::vector<double> swathDown;
+
+    /**Horizontal uncertainty of the pings of the current swath*/
+    std::vector<double> swathHorizontalUncertainty;
+
+    /**Vertical uncertainty of the pings of the current swath*/
+    std::vector<double> swathVerticalUncertainty;
+
+    /**True if georeference() fills the beam cache*/
+    bool beamCacheEnabled;
+
+    /**Swaths of the beam cache*/
+    std::vector<CachedSwath> cachedSwaths;
+
+    /**Beam cache: raytraced vector of each ping in the IMU frame, before boresight, 3 values per ping*/
+    std::vector<double> cachedBeams;
+
+    /**True if the soundings of the sonar are georeferenced instead of the pings*/
+    bool beamXYZEnabled;
+
+    /**Vector of each sounding of the sonar, along track, across track and down, 3 values per ping*/
+    std::vector<double> beamXYZ;
 };
 
 #endif
@@ -0,0 +1,108 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef DATAGRAMGEOREFERENCERTOSURFACE_HPP
+#define DATAGRAMGEOREFERENCERTOSURFACE_HPP
+
+#include <vector>
+#include "DatagramGeoreferencer.hpp"
+#include "../gridding/HypothesisSurface.hpp"
+#include "../math/TotalPropagatedUncertainty.hpp"
+#include "../utils/Exception.hpp"
+
+/*!
+* \brief Datagram georeferencer to surface class
+*
+* Adds the georeferenced pings to a multiple hypothesis surface instead of writing them, each sounding
+* carrying its total propagated uncertainty. Requires the local geographic frame (GeoreferencingLGF):
+* north, east and down become the surface's northing, easting and depth.
+*
+* Extends from the Datagram georeferencer class
+*/
+class DatagramGeoreferencerToSurface : public DatagramGeoreferencer{
+public:
+
+    /**Number of soundings handed to the surface at once*/
+    static const unsigned int BATCH_SIZE = 1 << 18;
+
+    /**
+    * Creates a datagram georeferencer to surface
+    *
+    * @param geo the georeferencing method, in the local geographic frame
+    * @param svpStrat the sound velocity profile selection strategy
+    * @param surface the surface to update
+    * @param uncertainty the uncertainty model
+    */
+    DatagramGeoreferencerToSurface(Georeferencing & geo,SvpSelectionStrategy & svpStrat,HypothesisSurface & surface,TotalPropagatedUncertainty & uncertainty)
+    : DatagramGeoreferencer(geo,svpStrat), surface(surface){
+        if(dynamic_cast<GeoreferencingLGF*>(&geo) == NULL){
+            throw new Exception("Hypothesis surfaces require the local geographic frame");
+        }
+
+        setUncertainty(&uncertainty);
+        soundings.reserve(BATCH_SIZE);
+    }
+
+    /**Destroys the datagram georeferencer to surface*/
+    ~DatagramGeoreferencerToSurface(){
+
+    }
+
+    /**
+    * Georeferences all pings, then hands the remaining soundings to the surface
+    *
+    * @param leverArm the lever arm
+    * @param boresight the boresight matrix
+    * @param externalSvps sound velocity profiles to use instead of those of the file
+    */
+    virtual void georeference(Eigen::Vector3d & leverArm,Eigen::Matrix3d & boresight,std::vector<SoundVelocityProfile*> & externalSvps){
+        DatagramGeoreferencer::georeference(leverArm,boresight,externalSvps);
+        flushSoundings();
+    }
+
+    /**
+    * Queues a georeferenced ping and its uncertainty for the surface
+    *
+    * @param georeferencedPing the georeferenced ping (north, east, down)
+    * @param quality the ping quality
+    * @param intensity the ping intensity
+    * @param horizontalUncertainty the horizontal uncertainty (2 sigma)
+    * @param verticalUncertainty the vertical uncertainty (2 sigma)
+    * @param positionIndex index of the position preceding the ping
+    * @param attitudeIndex index of the attitude preceding the ping
+    */
+    virtual void processGeoreferencedPing(Eigen::Vector3d & georeferencedPing,uint32_t quality,int32_t intensity,double horizontalUncertainty,double verticalUncertainty,int positionIndex,int attitudeIndex){
+        UncertainSounding sounding;
+        sounding.easting = georeferencedPing(1);
+        sounding.northing = georeferencedPing(0);
+        sounding.depth = georeferencedPing(2);
+        sounding.horizontalVariance = (horizontalUncertainty / 2) * (horizontalUncertainty / 2);
+        sounding.verticalVariance = (verticalUncertainty / 2) * (verticalUncertainty / 2);
+
+        soundings.push_back(sounding);
+
+        if(soundings.size() >= BATCH_SIZE){
+            flushSoundings();
+        }
+    }
+
+private:
+
+    /**Hands the queued soundings to the surface*/
+    void flushSoundings(){
+        if(soundings.size() > 0){
+            surface.addSoundings(&soundings[0],soundings.size());
+        }
+
+        soundings.clear();
+    }
+
+    /**The surface*/
+    HypothesisSurface & surface;
+
+    /**Queued soundings*/
+    std::vector<UncertainSounding> soundings;
+};
+
+#endif
@@ -17,6 +17,9 @@
 */
 class Georeferencing{
 public:
+  /**Destroys the georeferencing*/
+  virtual ~Georeferencing(){};
+
   /**
   * Georeferences a ping
   *
@@ -29,6 +32,16 @@ public:
   *
   */
   virtual void georeference(Eigen::Vector3d & georeferencedPing,Attitude & attitude,Position & position,Ping & ping,SoundVelocityProfile & svp,Eigen::Vector3d & leverArm,Eigen::Matrix3d & boresight){};
+
+  /**
+  * Gives what brings the pings georeferenced at a position back to vectors from the position
+  * reference point, in NED: toNED * (georeferencedPing - origin)
+  *
+  * @param origin the position in the georeferencing frame
+  * @param toNED rotation from the georeferencing frame to NED at the position
+  * @param position the position of the ship in the TRF
+  */
+  virtual void getLocalFrame(Eigen::Vector3d & origin,Eigen::Matrix3d & toNED,Position & position){};
 };
 
 /*!
@@ -99,6 +112,21 @@ public:
 
     georeferencedPing = positionECEF + pingECEF + leverArmECEF;
   }
+
+  /**
+  * Gives the position in ECEF and the rotation from ECEF to NED at the position
+  *
+  * @param origin the position in ECEF
+  * @param toNED rotation from ECEF to NED at the position
+  * @param position the position of the ship in the TRF
+  */
+  void getLocalFrame(Eigen::Vector3d & origin,Eigen::Matrix3d & toNED,Position & position) {
+    CoordinateTransform::getPositionECEF(origin,position);
+
+    Eigen::Matrix3d ned2ecef;
+    CoordinateTransform::ned2ecef(ned2ecef,position);
+    toNED = ned2ecef.transpose();
+  }
 };
 
 
@@ -124,17 +152,9 @@ public:
         Eigen::Matrix3d imu2ned;
         CoordinateTransform::getDCM(imu2ned,attitude);
 
-	//Convert position's geographic coordinates to ECEF, and then from ECEF to NED
-        Eigen::Vector3d positionECEF;
-        CoordinateTransform::getPositionECEF(positionECEF,position);
-        
-#ifdef DEBUG
-        std::cerr << "Position ECEF: " << std::endl << positionECEF << std::endl << std::endl;
-#endif
-
-        Eigen::Vector3d centered = positionECEF-centroidECEF;    
-
-	Eigen::Vector3d positionNED = ecef2ned * centered;
+	//Convert position's geographic coordinates to NED
+	Eigen::Vector3d positionNED;
+	getPositionNED(positionNED,position);
 
         //Convert ping to NED
         Eigen::Vector3d pingNED;
@@ -147,6 +167,37 @@ public:
         georeferencedPing = positionNED + pingNED + leverArmNED;
     }
 
+    /**
+     * Converts a position's geographic coordinates to ECEF, and then from ECEF to NED around the centroid
+     *
+     * @param positionNED the position in the LGF
+     * @param position the position in the TRF
+     */
+    void getPositionNED(Eigen::Vector3d & positionNED,Position & position){
+        Eigen::Vector3d positionECEF;
+        CoordinateTransform::getPositionECEF(positionECEF,position);
+
+#ifdef DEBUG
+        std::cerr << "Position ECEF: " << std::endl << positionECEF << std::endl << std::endl;
+#endif
+
+        Eigen::Vector3d centered = positionECEF-centroidECEF;
+
+        positionNED = ecef2ned * centered;
+    }
+
+    /**
+     * Gives the position in the LGF. The LGF axes already are NED
+     *
+     * @param origin the position in the LGF
+     * @param toNED the identity
+     * @param position the position of the ship in the TRF
+     */
+    virtual void getLocalFrame(Eigen::Vector3d & origin,Eigen::Matrix3d & toNED,Position & position) {
+        getPositionNED(origin,position);
+        toNED.setIdentity();
+    }
+
     /**
      * Sets centroid and inits ECEF 2 NED matrix
      */
@@ -0,0 +1,511 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef HYPOTHESISSURFACE_HPP
+#define HYPOTHESISSURFACE_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <limits>
+#include <algorithm>
+#include "TiledGrid.hpp"
+#include "TileKey.hpp"
+#include "../utils/Exception.hpp"
+#include "../utils/ParallelFor.hpp"
+#include "../utils/TextOutputBuffer.hpp"
+
+/**
+* Sounding with its propagated uncertainty
+*/
+typedef struct{
+    double easting;
+    double northing;
+    double depth;
+    double horizontalVariance;
+    double verticalVariance;
+} UncertainSounding;
+
+/**
+* Depth hypothesis of a node. The estimate is tracked with a Kalman filter; the sample mean and variance
+* of the soundings that built it are kept with Welford's method
+*/
+typedef struct{
+    double mean;
+    double variance;
+    double sampleMean;
+    double sampleM2;
+    uint32_t count;
+    uint32_t reserved;
+} DepthHypothesis;
+
+/**
+* Depth retained for a node
+*/
+typedef struct{
+    double depth;
+    double uncertainty;
+    uint32_t hypothesisCount;
+    uint32_t soundingCount;
+} NodeEstimate;
+
+/**Layer of the surface written to a raster*/
+enum SurfaceLayer{
+    SURFACE_DEPTH,          /**<depth of the retained hypothesis*/
+    SURFACE_UNCERTAINTY,    /**<uncertainty of the retained hypothesis (1 sigma)*/
+    SURFACE_HYPOTHESES,     /**<number of hypotheses of the node*/
+    SURFACE_SOUNDINGS       /**<number of soundings that reached the node*/
+};
+
+/*!
+* \brief Multiple hypothesis surface class
+*
+* CUBE-like depth estimation on a regular grid of nodes. Each sounding updates every node within its
+* capture distance, with a vertical variance grown with the distance to the node and with the sounding's
+* horizontal uncertainty. At each node, a sounding joins the closest hypothesis when it is within the
+* innovation gate, and starts a new hypothesis otherwise. The hypothesis built by the most soundings is
+* retained.
+*
+* Nodes are stored in square tiles, allocated only where soundings fall. Soundings are added in batches
+* as they are georeferenced; the tiles reached by a batch are updated in parallel, each tile by a single
+* task in sounding order, so the result does not depend on the number of threads.
+*
+* This does not implement CUBE's median pre-filter queue nor its neighbourhood disambiguation.
+*/
+class HypothesisSurface{
+public:
+
+    /**Number of nodes along each side of a tile*/
+    static const int TILE_SIZE = 64;
+
+    /**Number of hypotheses per node above which soundings join the closest hypothesis regardless of the gate*/
+    static const unsigned int MAXIMUM_HYPOTHESES = 16;
+
+    /**
+    * Creates an empty surface
+    *
+    * @param nodeSpacing distance between nodes
+    * @param captureDistanceScale capture distance of a sounding, as a fraction of its depth
+    * @param minimumCaptureDistance smallest capture distance. Never less than half a node diagonal, so every sounding reaches its nearest node
+    * @param gate innovation gate, in standard deviations, for a sounding to join an hypothesis
+    * @param distanceExponent exponent of the growth of the variance with the distance to the node
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    HypothesisSurface(double nodeSpacing,double captureDistanceScale = 0.05,double minimumCaptureDistance = 0,double gate = 3.0,double distanceExponent = 2.0,unsigned int threadCount = 0)
+    : nodeSpacing(nodeSpacing), captureDistanceScale(captureDistanceScale), gate(gate), distanceExponent(distanceExponent), threadCount(threadCount){
+        if(!(nodeSpacing > 0)){
+            throw new Exception("Node spacing must be positive");
+        }
+
+        this->minimumCaptureDistance = std::max(minimumCaptureDistance,nodeSpacing * std::sqrt(2.0) / 2);
+    }
+
+    /**Destroys the surface*/
+    ~HypothesisSurface(){
+        for(auto i = tiles.begin();i != tiles.end();i++){
+            delete i->second;
+        }
+    }
+
+    /**
+    * Adds soundings to the surface. Soundings with non-finite values or without a positive vertical variance are ignored
+    *
+    * @param soundings the soundings
+    * @param count number of soundings
+    */
+    void addSoundings(const UncertainSounding * soundings,unsigned int count){
+        //group the soundings by the tiles their capture distance reaches
+        std::unordered_map<TileKey,std::vector<unsigned int>,TileKeyHash,TileKeyEqual> buckets;
+
+        for(unsigned int i=0;i<count;i++){
+            const UncertainSounding & sounding = soundings[i];
+
+            if(!std::isfinite(sounding.easting) || !std::isfinite(sounding.northing) || !std::isfinite(sounding.depth)
+               || !std::isfinite(sounding.horizontalVariance) || !(sounding.verticalVariance > 0) || !std::isfinite(sounding.verticalVariance)){
+                continue;
+            }
+
+            NodeRange range = getNodeRange(sounding);
+
+            for(int64_t tileY=tileIndex(range.firstY,TILE_SIZE);tileY<=tileIndex(range.lastY,TILE_SIZE);tileY++){
+                for(int64_t tileX=tileIndex(range.firstX,TILE_SIZE);tileX<=tileIndex(range.lastX,TILE_SIZE);tileX++){
+                    TileKey key = {tileX,tileY};
+                    buckets[key].push_back(i);
+                }
+            }
+        }
+
+        std::vector<HypothesisTile *> targets;
+        std::vector<const std::vector<unsigned int> *> targetSoundings;
+
+        for(auto i = buckets.begin();i != buckets.end();i++){
+            targets.push_back(acquireTile(i->first));
+            targetSoundings.push_back(&i->second);
+        }
+
+        //each tile is updated by a single task
+        ParallelFor::run(targets.size(),[this,&targets,&targetSoundings,soundings](unsigned int t,unsigned int thread){
+            HypothesisTile * tile = targets[t];
+            const std::vector<unsigned int> & indexes = *targetSoundings[t];
+
+            int64_t tileFirstX = tile->key.x * TILE_SIZE;
+            int64_t tileFirstY = tile->key.y * TILE_SIZE;
+
+            for(unsigned int s=0;s<indexes.size();s++){
+                const UncertainSounding & sounding = soundings[indexes[s]];
+                NodeRange range = getNodeRange(sounding);
+                double captureDistance2 = range.captureDistance * range.captureDistance;
+
+                int64_t firstX = std::max(range.firstX,tileFirstX);
+                int64_t lastX = std::min(range.lastX,tileFirstX + TILE_SIZE - 1);
+                int64_t firstY = std::max(range.firstY,tileFirstY);
+                int64_t lastY = std::min(range.lastY,tileFirstY + TILE_SIZE - 1);
+
+                for(int64_t y=firstY;y<=lastY;y++){
+                    double dy = y * nodeSpacing - sounding.northing;
+
+                    for(int64_t x=firstX;x<=lastX;x++){
+                        double dx = x * nodeSpacing - sounding.easting;
+                        double distance2 = dx * dx + dy * dy;
+
+                        if(distance2 <= captureDistance2){
+                            updateNode(tile->nodes[(y - tileFirstY) * TILE_SIZE + (x - tileFirstX)],sounding,std::sqrt(distance2));
+                        }
+                    }
+                }
+            }
+        },threadCount);
+    }
+
+    /**
+    * Returns the estimate of the node nearest to a position. The estimate depth is NaN if no sounding reached the node
+    *
+    * @param easting the easting
+    * @param northing the northing
+    */
+    NodeEstimate getNode(double easting,double northing) const{
+        int64_t x = (int64_t)std::floor(easting / nodeSpacing + 0.5);
+        int64_t y = (int64_t)std::floor(northing / nodeSpacing + 0.5);
+
+        return estimate(getHypotheses(x,y));
+    }
+
+    /**
+    * Returns the hypotheses of the node nearest to a position
+    *
+    * @param easting the easting
+    * @param northing the northing
+    */
+    std::vector<DepthHypothesis> getNodeHypotheses(double easting,double northing) const{
+        int64_t x = (int64_t)std::floor(easting / nodeSpacing + 0.5);
+        int64_t y = (int64_t)std::floor(northing / nodeSpacing + 0.5);
+
+        return getHypotheses(x,y);
+    }
+
+    /**
+    * Writes a layer of the surface as an ESRI ASCII grid (.asc), one cell per node
+    *
+    * @param filename the raster file name
+    * @param layer the layer to write
+    */
+    void writeEsriAscii(std::string filename,SurfaceLayer layer) const{
+        if(tiles.empty()){
+            throw new Exception("The surface is empty");
+        }
+
+        int64_t minimumTileX = tiles.begin()->first.x;
+        int64_t maximumTileX = minimumTileX;
+        int64_t minimumTileY = tiles.begin()->first.y;
+        int64_t maximumTileY = minimumTileY;
+
+        for(auto i = tiles.begin();i != tiles.end();i++){
+            minimumTileX = std::min(minimumTileX,i->first.x);
+            maximumTileX = std::max(maximumTileX,i->first.x);
+            minimumTileY = std::min(minimumTileY,i->first.y);
+            maximumTileY = std::max(maximumTileY,i->first.y);
+        }
+
+        FILE * file = fopen(filename.c_str(),"w");
+
+        if(!file){
+            throw new Exception("Cannot write raster file " + filename);
+        }
+
+        TextOutputBuffer output(file);
+
+        unsigned int tilesPerRow = maximumTileX - minimumTileX + 1;
+        unsigned int columns = tilesPerRow * TILE_SIZE;
+        char line[256];
+
+        //node centered cells
+        snprintf(line,sizeof(line),"ncols %u\nnrows %lld\nxllcorner %.10g\nyllcorner %.10g\ncellsize %.10g\nNODATA_value %d\n",
+            columns,
+            (long long)((maximumTileY - minimumTileY + 1) * TILE_SIZE),
+            (minimumTileX * TILE_SIZE - 0.5) * nodeSpacing,
+            (minimumTileY * TILE_SIZE - 0.5) * nodeSpacing,
+            nodeSpacing,
+            GRID_NODATA);
+
+        output.appendString(line);
+
+        std::vector<std::vector<float> > band(TILE_SIZE,std::vector<float>(columns));
+
+        for(int64_t tileY=maximumTileY;tileY>=minimumTileY;tileY--){
+            ParallelFor::run(tilesPerRow,[this,&band,minimumTileX,tileY,layer](unsigned int t,unsigned int thread){
+                TileKey key = {minimumTileX + t,tileY};
+                auto found = tiles.find(key);
+                unsigned int firstColumn = t * TILE_SIZE;
+
+                for(unsigned int row=0;row<TILE_SIZE;row++){
+                    if(found == tiles.end()){
+                        std::fill(band[row].begin() + firstColumn,band[row].begin() + firstColumn + TILE_SIZE,(float)GRID_NODATA);
+                        continue;
+                    }
+
+                    //band rows go from north to south, tile rows from south to north
+                    const std::vector<DepthHypothesis> * nodes = &found->second->nodes[(TILE_SIZE - 1 - row) * TILE_SIZE];
+
+                    for(unsigned int column=0;column<TILE_SIZE;column++){
+                        band[row][firstColumn + column] = (float)getLayer(estimate(nodes[column]),layer);
+                    }
+                }
+            },threadCount);
+
+            for(unsigned int row=0;row<TILE_SIZE;row++){
+                for(unsigned int i=0;i<columns;i++){
+                    if(i > 0){
+                        output.appendChar(' ');
+                    }
+
+                    output.appendGeneral(band[row][i],9);
+                }
+
+                output.appendChar('\n');
+            }
+        }
+
+        output.flush();
+        fclose(file);
+    }
+
+    /**Returns the number of allocated tiles*/
+    unsigned int getTileCount() const{
+        return tiles.size();
+    }
+
+    /**Returns the distance between nodes*/
+    double getNodeSpacing() const{
+        return nodeSpacing;
+    }
+
+    /**
+    * Returns the value of a layer for a node estimate, or GRID_NODATA if no sounding reached the node
+    *
+    * @param node the node estimate
+    * @param layer the layer
+    */
+    static double getLayer(const NodeEstimate & node,SurfaceLayer layer){
+        if(node.soundingCount == 0){
+            return GRID_NODATA;
+        }
+
+        switch(layer){
+            case SURFACE_DEPTH:
+                return node.depth;
+            case SURFACE_UNCERTAINTY:
+                return node.uncertainty;
+            case SURFACE_HYPOTHESES:
+                return node.hypothesisCount;
+            case SURFACE_SOUNDINGS:
+                return node.soundingCount;
+        }
+
+        return GRID_NODATA;
+    }
+
+    /**
+    * Returns the estimate of a node: the hypothesis built by the most soundings, the one with the smallest
+    * variance on ties. Its uncertainty is the larger of the estimate's standard deviation and of the
+    * standard deviation of its soundings
+    *
+    * @param hypotheses the hypotheses of the node
+    */
+    static NodeEstimate estimate(const std::vector<DepthHypothesis> & hypotheses){
+        NodeEstimate node = {std::numeric_limits<double>::quiet_NaN(),std::numeric_limits<double>::quiet_NaN(),(uint32_t)hypotheses.size(),0};
+
+        const DepthHypothesis * best = NULL;
+
+        for(unsigned int i=0;i<hypotheses.size();i++){
+            const DepthHypothesis & hypothesis = hypotheses[i];
+            node.soundingCount += hypothesis.count;
+
+            if(best == NULL || hypothesis.count > best->count || (hypothesis.count == best->count && hypothesis.variance < best->variance)){
+                best = &hypothesis;
+            }
+        }
+
+        if(best){
+            double sampleDeviation = (best->count > 1) ? std::sqrt(best->sampleM2 / (best->count - 1)) : 0;
+
+            node.depth = best->mean;
+            node.uncertainty = std::max(std::sqrt(best->variance),sampleDeviation);
+        }
+
+        return node;
+    }
+
+private:
+
+    /*!
+    * \brief Surface tile
+    */
+    class HypothesisTile{
+    public:
+
+        /**
+        * Creates a tile without hypotheses
+        *
+        * @param key the tile coordinates
+        */
+        HypothesisTile(TileKey key) : key(key), nodes(TILE_SIZE * TILE_SIZE){
+
+        }
+
+        /**Tile coordinates*/
+        TileKey key;
+
+        /**Hypotheses of each node, row by row from the south-west corner*/
+        std::vector<std::vector<DepthHypothesis> > nodes;
+    };
+
+    /**Nodes reached by a sounding*/
+    typedef struct{
+        int64_t firstX;
+        int64_t lastX;
+        int64_t firstY;
+        int64_t lastY;
+        double captureDistance;
+    } NodeRange;
+
+    /**
+    * Returns the nodes within the capture distance of a sounding
+    *
+    * @param sounding the sounding
+    */
+    NodeRange getNodeRange(const UncertainSounding & sounding) const{
+        NodeRange range;
+
+        range.captureDistance = std::max(minimumCaptureDistance,captureDistanceScale * std::fabs(sounding.depth));
+        range.firstX = (int64_t)std::ceil((sounding.easting - range.captureDistance) / nodeSpacing);
+        range.lastX = (int64_t)std::floor((sounding.easting + range.captureDistance) / nodeSpacing);
+        range.firstY = (int64_t)std::ceil((sounding.northing - range.captureDistance) / nodeSpacing);
+        range.lastY = (int64_t)std::floor((sounding.northing + range.captureDistance) / nodeSpacing);
+
+        return range;
+    }
+
+    /**
+    * Updates the hypotheses of a node with a sounding
+    *
+    * @param hypotheses the hypotheses of the node
+    * @param sounding the sounding
+    * @param distance distance between the sounding and the node
+    */
+    void updateNode(std::vector<DepthHypothesis> & hypotheses,const UncertainSounding & sounding,double distance) const{
+        //the sounding is less representative of the node the farther it is, counting its own horizontal uncertainty
+        double offset = (distance + std::sqrt(sounding.horizontalVariance)) / nodeSpacing;
+        double variance = sounding.verticalVariance * (1 + std::pow(offset,distanceExponent));
+
+        int closest = -1;
+        double closestInnovation = std::numeric_limits<double>::infinity();
+
+        for(unsigned int i=0;i<hypotheses.size();i++){
+            double innovation = std::fabs(sounding.depth - hypotheses[i].mean) / std::sqrt(hypotheses[i].variance + variance);
+
+            if(innovation < closestInnovation){
+                closest = i;
+                closestInnovation = innovation;
+            }
+        }
+
+        if(closest < 0 || (closestInnovation > gate && hypotheses.size() < MAXIMUM_HYPOTHESES)){
+            DepthHypothesis hypothesis = {sounding.depth,variance,sounding.depth,0,1,0};
+            hypotheses.push_back(hypothesis);
+            return;
+        }
+
+        DepthHypothesis & hypothesis = hypotheses[closest];
+
+        double gain = hypothesis.variance / (hypothesis.variance + variance);
+        hypothesis.mean += gain * (sounding.depth - hypothesis.mean);
+        hypothesis.variance = hypothesis.variance * variance / (hypothesis.variance + variance);
+
+        hypothesis.count++;
+        double delta = sounding.depth - hypothesis.sampleMean;
+        hypothesis.sampleMean += delta / hypothesis.count;
+        hypothesis.sampleM2 += delta * (sounding.depth - hypothesis.sampleMean);
+    }
+
+    /**
+    * Returns the hypotheses of a node, empty if no sounding reached it
+    *
+    * @param x the node column
+    * @param y the node row
+    */
+    std::vector<DepthHypothesis> getHypotheses(int64_t x,int64_t y) const{
+        TileKey key = {tileIndex(x,TILE_SIZE),tileIndex(y,TILE_SIZE)};
+        auto found = tiles.find(key);
+
+        if(found == tiles.end()){
+            return std::vector<DepthHypothesis>();
+        }
+
+        return found->second->nodes[(y - key.y * TILE_SIZE) * TILE_SIZE + (x - key.x * TILE_SIZE)];
+    }
+
+    /**
+    * Returns a tile, creating it if needed
+    *
+    * @param key the tile coordinates
+    */
+    HypothesisTile * acquireTile(const TileKey & key){
+        auto found = tiles.find(key);
+
+        if(found != tiles.end()){
+            return found->second;
+        }
+
+        HypothesisTile * tile = new HypothesisTile(key);
+        tiles[key] = tile;
+
+        return tile;
+    }
+
+    /**Distance between nodes*/
+    double nodeSpacing;
+
+    /**Capture distance of a sounding, as a fraction of its depth*/
+    double captureDistanceScale;
+
+    /**Smallest capture distance*/
+    double minimumCaptureDistance;
+
+    /**Innovation gate, in standard deviations*/
+    double gate;
+
+    /**Exponent of the growth of the variance with the distance to the node*/
+    double distanceExponent;
+
+    /**Number of threads, 0 for one per hardware thread*/
+    unsigned int threadCount;
+
+    /**Allocated tiles*/
+    std::unordered_map<TileKey,HypothesisTile *,TileKeyHash,TileKeyEqual> tiles;
+};
+
+#endif
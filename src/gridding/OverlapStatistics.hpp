@@ -0,0 +1,443 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef OVERLAPSTATISTICS_HPP
+#define OVERLAPSTATISTICS_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include "TiledGrid.hpp"
+#include "../utils/Exception.hpp"
+#include "../utils/ParallelFor.hpp"
+
+/**IHO S-44 survey order, for the allowed total vertical uncertainty*/
+enum IhoOrder{
+    IHO_SPECIAL_ORDER,  /**<a = 0.25 m, b = 0.0075*/
+    IHO_ORDER_1,        /**<orders 1a and 1b: a = 0.5 m, b = 0.013*/
+    IHO_ORDER_2         /**<a = 1.0 m, b = 0.023*/
+};
+
+/*!
+* \brief Overlap statistics class
+*
+* Depth disagreement between two overlapping lines, from the points of each line inside the hull of the
+* other one (HullOverlap::computePointsInBothHulls, or the point sets of MultiLineOverlap). Points are given
+* as x, y and depth (z), e.g. in the local geographic frame.
+*
+* Each line's points are binned on a shared grid covering the intersection of their extents, in one
+* parallel pass per line. Only the occupied cells are stored (one hash map of partial sums per thread,
+* merged afterwards), so memory follows the number of soundings rather than the area of the grid, whose
+* size is limited to 2^32 - 1 columns and rows. In each cell holding soundings
+* of both lines, the difference is the mean depth of the first line minus the mean depth of the second.
+* A cell passes an IHO order when the absolute difference is within the order's allowed total vertical
+* uncertainty, sqrt(a² + (b d)²), at the cell's mean depth d.
+*/
+class OverlapStatistics{
+public:
+
+    /**
+    * Creates an overlap statistics computation
+    *
+    * @param cellSize size of the grid cells
+    * @param minimumSoundings number of soundings of each line a cell needs to be compared
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    OverlapStatistics(double cellSize,unsigned int minimumSoundings = 1,unsigned int threadCount = 0)
+    : cellSize(cellSize), minimumSoundings(std::max(1u,minimumSoundings)), threadCount(threadCount){
+        if(!(cellSize > 0)){
+            throw new Exception("Invalid overlap statistics cell size");
+        }
+
+        clear();
+    }
+
+    /**Destroys the overlap statistics computation*/
+    ~OverlapStatistics(){
+
+    }
+
+    /**
+    * Computes the statistics of two overlapping point sets
+    *
+    * @param first the points of the first line inside the hull of the second, as a container of points with x, y and z members (e.g. pcl::PointCloud)
+    * @param second the points of the second line inside the hull of the first
+    */
+    template<class Points>
+    void compute(const Points & first,const Points & second){
+        clear();
+
+        //shared grid over the intersection of the two extents
+        double firstExtent[4],secondExtent[4];
+
+        if(!getExtent(first,firstExtent) || !getExtent(second,secondExtent)){
+            return;
+        }
+
+        double minimumX = std::max(firstExtent[0],secondExtent[0]);
+        double minimumY = std::max(firstExtent[1],secondExtent[1]);
+        double maximumX = std::min(firstExtent[2],secondExtent[2]);
+        double maximumY = std::min(firstExtent[3],secondExtent[3]);
+
+        if(minimumX > maximumX || minimumY > maximumY){
+            return;
+        }
+
+        double originColumn = std::floor(minimumX / cellSize);
+        double originRow = std::floor(minimumY / cellSize);
+        double columnCount = std::floor(maximumX / cellSize) - originColumn + 1;
+        double rowCount = std::floor(maximumY / cellSize) - originRow + 1;
+
+        if(!(columnCount <= UINT32_MAX && rowCount <= UINT32_MAX)){
+            throw new Exception("Overlap statistics grid too large, use a larger cell size");
+        }
+
+        originX = originColumn * cellSize;
+        originY = originRow * cellSize;
+        firstColumn = (int64_t)originColumn;
+        firstRow = (int64_t)originRow;
+        columns = (unsigned int)columnCount;
+        rows = (unsigned int)rowCount;
+
+        CellMap firstCells,secondCells;
+        binPoints(first,firstCells);
+        binPoints(second,secondCells);
+
+        //differences of the cells of both lines, sorted by cell for the lookups and for the statistics to be reproducible
+        for(CellMap::const_iterator cell=firstCells.begin();cell!=firstCells.end();cell++){
+            CellMap::const_iterator other = secondCells.find(cell->first);
+
+            if(other == secondCells.end() || cell->second.count < minimumSoundings || other->second.count < minimumSoundings){
+                continue;
+            }
+
+            double firstMean = cell->second.sum / cell->second.count;
+            double secondMean = other->second.sum / other->second.count;
+
+            CellDifference difference = {cell->first,firstMean - secondMean,(firstMean + secondMean) / 2};
+            differences.push_back(difference);
+        }
+
+        std::sort(differences.begin(),differences.end(),compareCells);
+
+        double sum = 0;
+        double squareSum = 0;
+
+        for(size_t i=0;i<differences.size();i++){
+            double difference = differences[i].difference;
+
+            comparedCells++;
+            sum += difference;
+            squareSum += difference * difference;
+            maximumAbsoluteDifference = std::max(maximumAbsoluteDifference,std::fabs(difference));
+
+            double depth = std::fabs(differences[i].depth);
+
+            for(unsigned int order=0;order<ORDER_COUNT;order++){
+                if(std::fabs(difference) <= getAllowedUncertainty((IhoOrder)order,depth)){
+                    passingCells[order]++;
+                }
+            }
+        }
+
+        if(comparedCells > 0){
+            meanDifference = sum / comparedCells;
+            rmsDifference = std::sqrt(squareSum / comparedCells);
+        }
+    }
+
+    /**Returns the number of cells holding soundings of both lines*/
+    uint64_t getComparedCellCount() const{
+        return comparedCells;
+    }
+
+    /**Returns the mean depth difference (first line minus second line), NaN if no cell was compared*/
+    double getMeanDifference() const{
+        return meanDifference;
+    }
+
+    /**Returns the root mean square depth difference, NaN if no cell was compared*/
+    double getRmsDifference() const{
+        return rmsDifference;
+    }
+
+    /**Returns the largest absolute depth difference*/
+    double getMaximumAbsoluteDifference() const{
+        return maximumAbsoluteDifference;
+    }
+
+    /**
+    * Returns the fraction of the compared cells within the allowed vertical uncertainty of an IHO order, NaN if no cell was compared
+    *
+    * @param order the IHO order
+    */
+    double getPassRate(IhoOrder order) const{
+        return (comparedCells > 0) ? (double)passingCells[order] / comparedCells : NAN;
+    }
+
+    /**
+    * Returns the allowed total vertical uncertainty (95%) of an IHO order
+    *
+    * @param order the IHO order
+    * @param depth the depth
+    */
+    static double getAllowedUncertainty(IhoOrder order,double depth){
+        static const double a[] = {0.25,0.5,1.0};
+        static const double b[] = {0.0075,0.013,0.023};
+
+        return std::sqrt(a[order] * a[order] + (b[order] * depth) * (b[order] * depth));
+    }
+
+    /**Returns the number of columns of the grid*/
+    unsigned int getColumnCount() const{
+        return columns;
+    }
+
+    /**Returns the number of rows of the grid*/
+    unsigned int getRowCount() const{
+        return rows;
+    }
+
+    /**
+    * Returns the depth difference of a cell, NaN if it was not compared
+    *
+    * @param column column of the cell, along x
+    * @param row row of the cell, along y
+    */
+    double getDifference(unsigned int column,unsigned int row) const{
+        CellDifference key = {(uint64_t)row * columns + column,0,0};
+        std::vector<CellDifference>::const_iterator cell = std::lower_bound(differences.begin(),differences.end(),key,compareCells);
+
+        return (cell != differences.end() && cell->cell == key.cell) ? cell->difference : NAN;
+    }
+
+    /**
+    * Returns the compared cells, as row and column on the grid of all the multiples of the cell size, so that the cells
+    * of two computations can be matched whatever their extents. They are sorted by row, then by column
+    *
+    * @param cells the row and column of each compared cell
+    */
+    void getComparedCells(std::vector<std::pair<int64_t,int64_t> > & cells) const{
+        cells.resize(differences.size());
+
+        for(size_t i=0;i<differences.size();i++){
+            cells[i].first = firstRow + (int64_t)(differences[i].cell / columns);
+            cells[i].second = firstColumn + (int64_t)(differences[i].cell % columns);
+        }
+    }
+
+    /**
+    * Writes the depth differences as an ESRI ASCII grid, x being the easting
+    *
+    * @param filename the file name
+    */
+    void writeEsriAscii(std::string filename) const{
+        FILE * file = fopen(filename.c_str(),"w");
+
+        if(!file){
+            throw new Exception("Cannot write " + filename);
+        }
+
+        fprintf(file,"ncols %u\nnrows %u\nxllcorner %.6f\nyllcorner %.6f\ncellsize %.6f\nNODATA_value %d\n",columns,rows,originX,originY,cellSize,GRID_NODATA);
+
+        //ESRI grids start with the northernmost row
+        for(int row=(int)rows-1;row>=0;row--){
+            for(unsigned int column=0;column<columns;column++){
+                double difference = getDifference(column,row);
+
+                if(std::isnan(difference)){
+                    fprintf(file,column == 0 ? "%d" : " %d",GRID_NODATA);
+                }
+                else{
+                    fprintf(file,column == 0 ? "%.3f" : " %.3f",difference);
+                }
+            }
+
+            fprintf(file,"\n");
+        }
+
+        fclose(file);
+    }
+
+private:
+
+    /**Number of IHO orders*/
+    static const unsigned int ORDER_COUNT = 3;
+
+    /**Number of points binned per parallel task*/
+    static const unsigned int POINTS_PER_TASK = 1 << 16;
+
+    /**Depth sum and sounding count of a cell*/
+    typedef struct{
+        double sum;
+        uint32_t count;
+    } CellSum;
+
+    /**Occupied cells, by index (row * columns + column)*/
+    typedef std::unordered_map<uint64_t,CellSum> CellMap;
+
+    /**Depth difference of a compared cell*/
+    typedef struct{
+        uint64_t cell;          /**<index of the cell, row * columns + column*/
+        double difference;      /**<mean depth of the first line minus mean depth of the second*/
+        double depth;           /**<mean depth of both lines*/
+    } CellDifference;
+
+    /**Orders the compared cells by index*/
+    static bool compareCells(const CellDifference & a,const CellDifference & b){
+        return a.cell < b.cell;
+    }
+
+    /**Resets the statistics*/
+    void clear(){
+        columns = 0;
+        rows = 0;
+        originX = 0;
+        originY = 0;
+        firstColumn = 0;
+        firstRow = 0;
+        comparedCells = 0;
+        meanDifference = NAN;
+        rmsDifference = NAN;
+        maximumAbsoluteDifference = 0;
+        differences.clear();
+
+        for(unsigned int order=0;order<ORDER_COUNT;order++){
+            passingCells[order] = 0;
+        }
+    }
+
+    /**
+    * Computes the extent of a point set. Returns false if it has no valid point
+    *
+    * @param points the points
+    * @param extent lowest x, lowest y, highest x and highest y
+    */
+    template<class Points>
+    static bool getExtent(const Points & points,double * extent){
+        extent[0] = extent[1] = INFINITY;
+        extent[2] = extent[3] = -INFINITY;
+
+        for(uint64_t i=0;i<(uint64_t)points.size();i++){
+            if(!isValid(points[i])){
+                continue;
+            }
+
+            extent[0] = std::min(extent[0],(double)points[i].x);
+            extent[1] = std::min(extent[1],(double)points[i].y);
+            extent[2] = std::max(extent[2],(double)points[i].x);
+            extent[3] = std::max(extent[3],(double)points[i].y);
+        }
+
+        return extent[0] <= extent[2];
+    }
+
+    /**Returns true if a point has finite coordinates*/
+    template<class Point>
+    static bool isValid(const Point & point){
+        return std::isfinite(point.x) && std::isfinite(point.y) && std::isfinite(point.z);
+    }
+
+    /**
+    * Sums the depths of the points of each occupied cell, in parallel: each thread fills its own map, and the maps are merged
+    *
+    * @param points the points
+    * @param cells the depth sum and point count of each occupied cell
+    */
+    template<class Points>
+    void binPoints(const Points & points,CellMap & cells) const{
+        uint64_t count = points.size();
+        unsigned int taskCount = (count + POINTS_PER_TASK - 1) / POINTS_PER_TASK;
+        unsigned int threads = std::max(1u,std::min((threadCount == 0) ? ParallelFor::defaultThreadCount() : threadCount,taskCount));
+
+        std::vector<CellMap> threadCells(threads);
+
+        ParallelFor::run(taskCount,[this,&points,&threadCells,count](unsigned int task,unsigned int thread){
+            CellMap & taskCells = threadCells[thread];
+            uint64_t end = std::min(count,(uint64_t)(task + 1) * POINTS_PER_TASK);
+
+            for(uint64_t i=(uint64_t)task * POINTS_PER_TASK;i<end;i++){
+                if(!isValid(points[i])){
+                    continue;
+                }
+
+                double column = std::floor((points[i].x - originX) / cellSize);
+                double row = std::floor((points[i].y - originY) / cellSize);
+
+                //only the intersection of the extents is gridded
+                if(column < 0 || row < 0 || column >= columns || row >= rows){
+                    continue;
+                }
+
+                CellSum & cell = taskCells[(uint64_t)row * columns + (uint64_t)column];
+                cell.sum += points[i].z;
+                cell.count++;
+            }
+        },threads);
+
+        cells.swap(threadCells[0]);
+
+        for(unsigned int t=1;t<threadCells.size();t++){
+            for(CellMap::const_iterator cell=threadCells[t].begin();cell!=threadCells[t].end();cell++){
+                CellSum & sum = cells[cell->first];
+                sum.sum += cell->second.sum;
+                sum.count += cell->second.count;
+            }
+
+            CellMap().swap(threadCells[t]);
+        }
+    }
+
+    /**Size of the grid cells*/
+    double cellSize;
+
+    /**Number of soundings of each line a cell needs to be compared*/
+    unsigned int minimumSoundings;
+
+    /**Number of threads, 0 for one per hardware thread*/
+    unsigned int threadCount;
+
+    /**Number of columns of the grid, along x*/
+    unsigned int columns;
+
+    /**Number of rows of the grid, along y*/
+    unsigned int rows;
+
+    /**Lowest x of the grid*/
+    double originX;
+
+    /**Lowest y of the grid*/
+    double originY;
+
+    /**Column of the first column of the grid, on the grid of all the multiples of the cell size*/
+    int64_t firstColumn;
+
+    /**Row of the first row of the grid, on the grid of all the multiples of the cell size*/
+    int64_t firstRow;
+
+    /**Number of cells holding soundings of both lines*/
+    uint64_t comparedCells;
+
+    /**Number of compared cells within each IHO order*/
+    uint64_t passingCells[ORDER_COUNT];
+
+    /**Mean depth difference*/
+    double meanDifference;
+
+    /**Root mean square depth difference*/
+    double rmsDifference;
+
+    /**Largest absolute depth difference*/
+    double maximumAbsoluteDifference;
+
+    /**Depth difference of each compared cell, by cell index*/
+    std::vector<CellDifference> differences;
+};
+
+#endif
@@ -0,0 +1,49 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef TILEKEY_HPP
+#define TILEKEY_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <functional>
+
+/**Coordinates of a tile of a tiled grid, in tiles*/
+typedef struct{
+    int64_t x;
+    int64_t y;
+} TileKey;
+
+/**Tile key equality*/
+struct TileKeyEqual{
+    bool operator()(const TileKey & a,const TileKey & b) const{
+        return a.x == b.x && a.y == b.y;
+    }
+};
+
+/**Tile key hash*/
+struct TileKeyHash{
+    size_t operator()(const TileKey & key) const{
+        return std::hash<int64_t>()(key.x * 73856093LL ^ key.y * 19349663LL);
+    }
+};
+
+/**Tile key order, row by row*/
+struct TileKeyLess{
+    bool operator()(const TileKey & a,const TileKey & b) const{
+        return (a.y < b.y) || (a.y == b.y && a.x < b.x);
+    }
+};
+
+/**
+* Returns the index of the tile holding a cell, rounding towards negative infinity
+*
+* @param cell the cell index
+* @param tileSize the number of cells along each side of a tile
+*/
+inline int64_t tileIndex(int64_t cell,int64_t tileSize){
+    return (cell >= 0) ? cell / tileSize : -((-cell + tileSize - 1) / tileSize);
+}
+
+#endif
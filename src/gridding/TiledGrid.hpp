@@ -0,0 +1,643 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef TILEDGRID_HPP
+#define TILEDGRID_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <limits>
+#include <algorithm>
+#include <sys/stat.h>
+#include "TileKey.hpp"
+#include "../utils/Exception.hpp"
+#include "../utils/ParallelFor.hpp"
+#include "../utils/TextOutputBuffer.hpp"
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+/**Cell value written to rasters where there is no data*/
+#define GRID_NODATA -9999
+
+/**Statistic written to a raster*/
+enum GridStatistic{
+    GRID_MEAN,      /**<mean depth*/
+    GRID_MINIMUM,   /**<smallest depth, the shoalest sounding when depths are positive down (local geographic frame)*/
+    GRID_MAXIMUM,   /**<largest depth*/
+    GRID_STDDEV,    /**<standard deviation of the depths*/
+    GRID_COUNT      /**<number of soundings*/
+};
+
+/**
+* Statistics of a grid cell. Mean and variance are accumulated with Welford's method
+*/
+typedef struct{
+    uint32_t count;
+    uint32_t reserved;
+    double mean;
+    double m2;
+    double minimum;
+    double maximum;
+} GridCell;
+
+/*!
+* \brief Tiled grid class
+*
+* Accumulates per-cell depth statistics of soundings given in easting, northing, depth (projected or
+* local geographic frame coordinates). Cells are grouped in square tiles; only a bounded number of tiles
+* stay in memory, the least recently used ones being written to the grid directory when evicted.
+*
+* The grid directory holds every tile and a header, so a grid can be reopened later and updated with
+* new lines without regridding the whole survey.
+*
+* Soundings are added in batches, whose tiles are updated in parallel. Rasters are written one row of
+* tiles at a time, the tiles of a row being rasterized in parallel.
+*/
+class TiledGrid{
+public:
+
+    /**Number of cells along each side of a tile*/
+    static const int TILE_SIZE = 256;
+
+    /**
+    * Opens a grid directory, creating it if needed
+    *
+    * @param directory the grid directory
+    * @param cellSize size of the cells. Must match the cell size of an existing grid
+    * @param maximumTilesInMemory number of tiles kept in memory before the least recently used is written to disk
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    TiledGrid(std::string directory,double cellSize,unsigned int maximumTilesInMemory = 64,unsigned int threadCount = 0)
+    : directory(directory), cellSize(cellSize), maximumTilesInMemory(std::max(1u,maximumTilesInMemory)), threadCount(threadCount){
+        if(!(cellSize > 0)){
+            throw new Exception("Grid cell size must be positive");
+        }
+
+#ifdef _WIN32
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(),0755);
+#endif
+
+        readHeader();
+    }
+
+    /**Writes every modified tile and the header to the grid directory, and destroys the grid*/
+    ~TiledGrid(){
+        try{
+            save();
+        }
+        catch(Exception * error){
+            std::cerr << "[-] Error while saving grid " << directory << ": " << error->what() << std::endl;
+        }
+
+        for(auto i = tiles.begin();i != tiles.end();i++){
+            delete i->second;
+        }
+    }
+
+    /**
+    * Adds soundings to the grid. Soundings with non-finite coordinates are ignored
+    *
+    * @param eastings easting of each sounding
+    * @param northings northing of each sounding
+    * @param depths depth of each sounding
+    * @param count number of soundings
+    */
+    void addSoundings(const double * eastings,const double * northings,const double * depths,unsigned int count){
+        //group the soundings by tile
+        std::unordered_map<TileKey,std::vector<unsigned int>,TileKeyHash,TileKeyEqual> buckets;
+
+        for(unsigned int i=0;i<count;i++){
+            if(!std::isfinite(eastings[i]) || !std::isfinite(northings[i]) || !std::isfinite(depths[i])){
+                continue;
+            }
+
+            TileKey key = {tileIndex(cellIndex(eastings[i]),TILE_SIZE),tileIndex(cellIndex(northings[i]),TILE_SIZE)};
+            buckets[key].push_back(i);
+        }
+
+        std::vector<TileKey> keys;
+
+        for(auto i = buckets.begin();i != buckets.end();i++){
+            keys.push_back(i->first);
+        }
+
+        //no more tiles at once than what can stay in memory
+        for(unsigned int first=0;first<keys.size();first+=maximumTilesInMemory){
+            unsigned int last = std::min((unsigned int)keys.size(),first + maximumTilesInMemory);
+            std::vector<GridTile *> resident;
+            std::vector<const std::vector<unsigned int> *> residentPoints;
+
+            for(unsigned int k=first;k<last;k++){
+                resident.push_back(acquireTile(keys[k]));
+                residentPoints.push_back(&buckets[keys[k]]);
+            }
+
+            //each tile is updated by a single task
+            ParallelFor::run(resident.size(),[this,&resident,&residentPoints,eastings,northings,depths](unsigned int t,unsigned int thread){
+                GridTile * tile = resident[t];
+                const std::vector<unsigned int> & points = *residentPoints[t];
+
+                for(unsigned int p=0;p<points.size();p++){
+                    unsigned int i = points[p];
+                    int64_t cellX = cellIndex(eastings[i]) - tile->key.x * TILE_SIZE;
+                    int64_t cellY = cellIndex(northings[i]) - tile->key.y * TILE_SIZE;
+                    addToCell(tile->cells[cellY * TILE_SIZE + cellX],depths[i]);
+                }
+
+                tile->modified = true;
+            },threadCount);
+        }
+    }
+
+    /**
+    * Returns the statistics of the cell containing a position. The cell is empty if no sounding fell in it
+    *
+    * @param easting the easting
+    * @param northing the northing
+    */
+    GridCell getCell(double easting,double northing){
+        int64_t cellX = cellIndex(easting);
+        int64_t cellY = cellIndex(northing);
+        TileKey key = {tileIndex(cellX,TILE_SIZE),tileIndex(cellY,TILE_SIZE)};
+
+        if(knownTiles.find(key) == knownTiles.end()){
+            GridCell empty = emptyCell();
+            return empty;
+        }
+
+        GridTile * tile = acquireTile(key);
+        return tile->cells[(cellY - key.y * TILE_SIZE) * TILE_SIZE + (cellX - key.x * TILE_SIZE)];
+    }
+
+    /**Writes every modified tile and the header to the grid directory*/
+    void save(){
+        for(auto i = tiles.begin();i != tiles.end();i++){
+            writeTile(*i->second);
+        }
+
+        writeHeader();
+    }
+
+    /**
+    * Writes a statistic of the grid as an ESRI ASCII grid (.asc)
+    *
+    * @param filename the raster file name
+    * @param statistic the statistic to write
+    */
+    void writeEsriAscii(std::string filename,GridStatistic statistic){
+        RasterExtent extent = getExtent();
+        FILE * file = fopen(filename.c_str(),"w");
+
+        if(!file){
+            throw new Exception("Cannot write raster file " + filename);
+        }
+
+        TextOutputBuffer output(file);
+
+        writeEsriHeader(output,extent);
+
+        writeRaster(extent,statistic,[&output](const std::vector<float> & row){
+            for(unsigned int i=0;i<row.size();i++){
+                if(i > 0){
+                    output.appendChar(' ');
+                }
+
+                output.appendGeneral(row[i],9);
+            }
+
+            output.appendChar('\n');
+        });
+
+        output.flush();
+        fclose(file);
+    }
+
+    /**
+    * Writes a statistic of the grid as an ESRI binary grid: 32 bit floats in the host's byte order in
+    * filename.flt, described by filename.hdr
+    *
+    * @param filename the raster file name, without extension
+    * @param statistic the statistic to write
+    */
+    void writeEsriBinary(std::string filename,GridStatistic statistic){
+        RasterExtent extent = getExtent();
+        FILE * header = fopen((filename + ".hdr").c_str(),"w");
+        FILE * data = fopen((filename + ".flt").c_str(),"wb");
+
+        if(!header || !data){
+            if(header) fclose(header);
+            if(data) fclose(data);
+            throw new Exception("Cannot write raster file " + filename);
+        }
+
+        {
+            TextOutputBuffer output(header);
+            writeEsriHeader(output,extent);
+            uint16_t byteOrder = 1;
+            output.appendString((*(uint8_t *)&byteOrder == 1) ? "byteorder LSBFIRST\n" : "byteorder MSBFIRST\n");
+        }
+
+        writeRaster(extent,statistic,[data](const std::vector<float> & row){
+            fwrite(&row[0],sizeof(float),row.size(),data);
+        });
+
+        fclose(header);
+        fclose(data);
+    }
+
+    /**Returns the number of tiles holding soundings, in memory or on disk*/
+    unsigned int getTileCount() const{
+        return knownTiles.size();
+    }
+
+    /**Returns the number of tiles currently in memory*/
+    unsigned int getTilesInMemory() const{
+        return tiles.size();
+    }
+
+    /**Returns the size of the cells*/
+    double getCellSize() const{
+        return cellSize;
+    }
+
+    /**
+    * Returns the value of a statistic for a cell, or GRID_NODATA if the cell is empty
+    *
+    * @param cell the cell
+    * @param statistic the statistic
+    */
+    static double getStatistic(const GridCell & cell,GridStatistic statistic){
+        if(cell.count == 0){
+            return GRID_NODATA;
+        }
+
+        switch(statistic){
+            case GRID_MEAN:
+                return cell.mean;
+            case GRID_MINIMUM:
+                return cell.minimum;
+            case GRID_MAXIMUM:
+                return cell.maximum;
+            case GRID_STDDEV:
+                return (cell.count > 1) ? std::sqrt(cell.m2 / (cell.count - 1)) : 0;
+            case GRID_COUNT:
+                return cell.count;
+        }
+
+        return GRID_NODATA;
+    }
+
+private:
+
+    /*!
+    * \brief Grid tile
+    */
+    class GridTile{
+    public:
+
+        /**
+        * Creates an empty tile
+        *
+        * @param key the tile coordinates
+        */
+        GridTile(TileKey key) : key(key), cells(TILE_SIZE * TILE_SIZE,emptyCell()), modified(false){
+
+        }
+
+        /**Tile coordinates*/
+        TileKey key;
+
+        /**Cells, row by row from the south-west corner*/
+        std::vector<GridCell> cells;
+
+        /**True if the tile changed since it was last written*/
+        bool modified;
+
+        /**Position of the tile in the least recently used list*/
+        std::list<TileKey>::iterator usage;
+    };
+
+    /**Cell range covered by the tiles of the grid*/
+    typedef struct{
+        int64_t minimumTileX;
+        int64_t minimumTileY;
+        int64_t maximumTileX;
+        int64_t maximumTileY;
+    } RasterExtent;
+
+    /**Returns a cell without soundings*/
+    static GridCell emptyCell(){
+        GridCell cell = {0,0,0,0,std::numeric_limits<double>::infinity(),-std::numeric_limits<double>::infinity()};
+        return cell;
+    }
+
+    /**
+    * Adds a depth to the statistics of a cell
+    *
+    * @param cell the cell
+    * @param depth the depth
+    */
+    static void addToCell(GridCell & cell,double depth){
+        cell.count++;
+
+        double delta = depth - cell.mean;
+        cell.mean += delta / cell.count;
+        cell.m2 += delta * (depth - cell.mean);
+
+        cell.minimum = std::min(cell.minimum,depth);
+        cell.maximum = std::max(cell.maximum,depth);
+    }
+
+    /**
+    * Returns a tile in memory, reading it from disk or creating it if needed, and marks it as the most recently used
+    *
+    * @param key the tile coordinates
+    */
+    GridTile * acquireTile(const TileKey & key){
+        auto found = tiles.find(key);
+
+        if(found != tiles.end()){
+            usage.splice(usage.begin(),usage,found->second->usage);
+            return found->second;
+        }
+
+        while(tiles.size() >= maximumTilesInMemory){
+            evictTile();
+        }
+
+        GridTile * tile = new GridTile(key);
+
+        if(knownTiles.find(key) != knownTiles.end()){
+            readTile(*tile);
+        }
+        else{
+            knownTiles.insert(key);
+        }
+
+        usage.push_front(key);
+        tile->usage = usage.begin();
+        tiles[key] = tile;
+
+        return tile;
+    }
+
+    /**Writes the least recently used tile to disk and removes it from memory*/
+    void evictTile(){
+        TileKey key = usage.back();
+        usage.pop_back();
+
+        auto found = tiles.find(key);
+        writeTile(*found->second);
+        delete found->second;
+        tiles.erase(found);
+    }
+
+    /**
+    * Returns the file holding a tile
+    *
+    * @param key the tile coordinates
+    */
+    std::string getTileFilename(const TileKey & key) const{
+        std::stringstream filename;
+        filename << directory << "/tile_" << key.x << "_" << key.y << ".bin";
+        return filename.str();
+    }
+
+    /**
+    * Writes a tile to disk if it changed since it was read
+    *
+    * @param tile the tile
+    */
+    void writeTile(GridTile & tile){
+        if(!tile.modified){
+            return;
+        }
+
+        std::string filename = getTileFilename(tile.key);
+        FILE * file = fopen(filename.c_str(),"wb");
+
+        if(!file){
+            throw new Exception("Cannot write grid tile " + filename);
+        }
+
+        fwrite(&tile.cells[0],sizeof(GridCell),tile.cells.size(),file);
+        fclose(file);
+
+        tile.modified = false;
+    }
+
+    /**
+    * Reads a tile from disk
+    *
+    * @param tile the tile, with its key set
+    */
+    void readTile(GridTile & tile) const{
+        std::string filename = getTileFilename(tile.key);
+        FILE * file = fopen(filename.c_str(),"rb");
+
+        if(!file){
+            throw new Exception("Cannot read grid tile " + filename);
+        }
+
+        size_t read = fread(&tile.cells[0],sizeof(GridCell),tile.cells.size(),file);
+        fclose(file);
+
+        if(read != tile.cells.size()){
+            throw new Exception("Truncated grid tile " + filename);
+        }
+    }
+
+    /**Reads the grid header, if the grid already exists*/
+    void readHeader(){
+        std::string filename = directory + "/grid.txt";
+        FILE * file = fopen(filename.c_str(),"r");
+
+        if(!file){
+            return;
+        }
+
+        double existingCellSize;
+        int existingTileSize;
+        unsigned int tileCount;
+
+        if(fscanf(file,"cellSize %lf\ntileSize %d\ntiles %u\n",&existingCellSize,&existingTileSize,&tileCount) != 3){
+            fclose(file);
+            throw new Exception("Invalid grid header " + filename);
+        }
+
+        if(existingTileSize != TILE_SIZE || std::fabs(existingCellSize - cellSize) > 1e-9 * cellSize){
+            fclose(file);
+            throw new Exception("Grid " + directory + " was created with a different cell size");
+        }
+
+        for(unsigned int i=0;i<tileCount;i++){
+            long long x,y;
+
+            if(fscanf(file,"%lld %lld\n",&x,&y) != 2){
+                fclose(file);
+                throw new Exception("Invalid grid header " + filename);
+            }
+
+            TileKey key = {x,y};
+            knownTiles.insert(key);
+        }
+
+        fclose(file);
+    }
+
+    /**Writes the grid header*/
+    void writeHeader(){
+        std::string filename = directory + "/grid.txt";
+        FILE * file = fopen(filename.c_str(),"w");
+
+        if(!file){
+            throw new Exception("Cannot write grid header " + filename);
+        }
+
+        fprintf(file,"cellSize %.17g\ntileSize %d\ntiles %u\n",cellSize,TILE_SIZE,(unsigned int)knownTiles.size());
+
+        for(auto i = knownTiles.begin();i != knownTiles.end();i++){
+            fprintf(file,"%lld %lld\n",(long long)i->x,(long long)i->y);
+        }
+
+        fclose(file);
+    }
+
+    /**Returns the range of tiles holding soundings*/
+    RasterExtent getExtent() const{
+        if(knownTiles.empty()){
+            throw new Exception("The grid is empty");
+        }
+
+        RasterExtent extent = {knownTiles.begin()->x,knownTiles.begin()->y,knownTiles.begin()->x,knownTiles.begin()->y};
+
+        for(auto i = knownTiles.begin();i != knownTiles.end();i++){
+            extent.minimumTileX = std::min(extent.minimumTileX,i->x);
+            extent.maximumTileX = std::max(extent.maximumTileX,i->x);
+            extent.minimumTileY = std::min(extent.minimumTileY,i->y);
+            extent.maximumTileY = std::max(extent.maximumTileY,i->y);
+        }
+
+        return extent;
+    }
+
+    /**
+    * Writes the ESRI grid header fields shared by the ASCII and binary formats
+    *
+    * @param output the output
+    * @param extent the raster extent
+    */
+    void writeEsriHeader(TextOutputBuffer & output,const RasterExtent & extent) const{
+        char line[256];
+
+        snprintf(line,sizeof(line),"ncols %lld\nnrows %lld\nxllcorner %.10g\nyllcorner %.10g\ncellsize %.10g\nNODATA_value %d\n",
+            (long long)((extent.maximumTileX - extent.minimumTileX + 1) * TILE_SIZE),
+            (long long)((extent.maximumTileY - extent.minimumTileY + 1) * TILE_SIZE),
+            extent.minimumTileX * TILE_SIZE * cellSize,
+            extent.minimumTileY * TILE_SIZE * cellSize,
+            cellSize,
+            GRID_NODATA);
+
+        output.appendString(line);
+    }
+
+    /**
+    * Produces the raster rows from north to south. Each row of tiles is rasterized in parallel, one tile per task
+    *
+    * @param extent the raster extent
+    * @param statistic the statistic to write
+    * @param writeRow called with each row of the raster, in order
+    */
+    void writeRaster(const RasterExtent & extent,GridStatistic statistic,const std::function<void(const std::vector<float> &)> & writeRow){
+        //tiles are read from the directory during rasterization, so it must be up to date
+        save();
+
+        unsigned int tilesPerRow = extent.maximumTileX - extent.minimumTileX + 1;
+        unsigned int columns = tilesPerRow * TILE_SIZE;
+        std::vector<std::vector<float> > band(TILE_SIZE,std::vector<float>(columns));
+
+        for(int64_t tileY=extent.maximumTileY;tileY>=extent.minimumTileY;tileY--){
+            ParallelFor::run(tilesPerRow,[this,&band,&extent,tileY,statistic](unsigned int t,unsigned int thread){
+                TileKey key = {extent.minimumTileX + t,tileY};
+                unsigned int firstColumn = t * TILE_SIZE;
+
+                if(knownTiles.find(key) == knownTiles.end()){
+                    for(unsigned int row=0;row<TILE_SIZE;row++){
+                        std::fill(band[row].begin() + firstColumn,band[row].begin() + firstColumn + TILE_SIZE,(float)GRID_NODATA);
+                    }
+                    return;
+                }
+
+                //rasterize from memory when possible, otherwise from disk without touching the cache
+                const GridTile * tile;
+                GridTile * loaded = NULL;
+                auto found = tiles.find(key);
+
+                if(found != tiles.end()){
+                    tile = found->second;
+                }
+                else{
+                    loaded = new GridTile(key);
+                    readTile(*loaded);
+                    tile = loaded;
+                }
+
+                for(unsigned int row=0;row<TILE_SIZE;row++){
+                    //band rows go from north to south, tile rows from south to north
+                    const GridCell * cells = &tile->cells[(TILE_SIZE - 1 - row) * TILE_SIZE];
+
+                    for(unsigned int column=0;column<TILE_SIZE;column++){
+                        band[row][firstColumn + column] = (float)getStatistic(cells[column],statistic);
+                    }
+                }
+
+                delete loaded;
+            },threadCount);
+
+            for(unsigned int row=0;row<TILE_SIZE;row++){
+                writeRow(band[row]);
+            }
+        }
+    }
+
+    /**Returns the cell index of a coordinate*/
+    int64_t cellIndex(double coordinate) const{
+        return (int64_t)std::floor(coordinate / cellSize);
+    }
+
+    /**The grid directory*/
+    std::string directory;
+
+    /**Size of the cells*/
+    double cellSize;
+
+    /**Number of tiles kept in memory*/
+    unsigned int maximumTilesInMemory;
+
+    /**Number of threads, 0 for one per hardware thread*/
+    unsigned int threadCount;
+
+    /**Tiles in memory*/
+    std::unordered_map<TileKey,GridTile *,TileKeyHash,TileKeyEqual> tiles;
+
+    /**Tiles in memory, most recently used first*/
+    std::list<TileKey> usage;
+
+    /**Every tile of the grid, in memory or on disk*/
+    std::set<TileKey,TileKeyLess> knownTiles;
+};
+
+#endif
@@ -0,0 +1,202 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef TOTALPROPAGATEDUNCERTAINTY_HPP
+#define TOTALPROPAGATEDUNCERTAINTY_HPP
+
+#include <cmath>
+#include <Eigen/Dense>
+#include "../SurveySystem.hpp"
+#include "../Attitude.hpp"
+#include "CoordinateTransform.hpp"
+#include "../utils/Constants.hpp"
+#include "../utils/Exception.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*!
+* \brief Total propagated uncertainty class
+*
+* First order propagation of the survey system accuracies to the soundings of a swath. Each sounding is
+* given by its raytraced vector r from the position reference point (north, east, down), which carries
+* the beam geometry and the refraction through the sound velocity profile. Its errors are:
+*
+* - positioning: the horizontal and vertical position accuracies
+* - roll: r rotated about the vessel's x axis, (R ex) x r
+* - pitch: r rotated about the pitch axis, (Rz ey) x r
+* - heading: r rotated about the down axis, ez x r
+* - sound speed: r scaled by the relative sound speed error at the transducer
+*
+* Rotation axes are computed once per swath; the beams of the swath are then processed two at a time
+* with SSE2 when available. Accuracies and uncertainties are at 2 sigma, as in the survey system file.
+*/
+class TotalPropagatedUncertainty{
+public:
+
+    /**
+    * Creates a total propagated uncertainty model
+    *
+    * @param horizontalPositionAccuracy horizontal position accuracy in meters
+    * @param verticalPositionAccuracy vertical position accuracy in meters
+    * @param rollAccuracy roll accuracy in degrees
+    * @param pitchAccuracy pitch accuracy in degrees
+    * @param headingAccuracy heading accuracy in degrees
+    * @param soundSpeedAccuracy sound speed accuracy at the transducer in m/s
+    */
+    TotalPropagatedUncertainty(double horizontalPositionAccuracy,double verticalPositionAccuracy,double rollAccuracy,double pitchAccuracy,double headingAccuracy,double soundSpeedAccuracy){
+        setAccuracies(horizontalPositionAccuracy,verticalPositionAccuracy,rollAccuracy,pitchAccuracy,headingAccuracy,soundSpeedAccuracy);
+    }
+
+    /**
+    * Creates a total propagated uncertainty model from the accuracies of a survey system
+    *
+    * @param system the survey system, read from its file
+    */
+    TotalPropagatedUncertainty(SurveySystem & system){
+        Attitude * attitudeAccuracy = system.getAttitudeAccuracy();
+
+        if(attitudeAccuracy == NULL){
+            throw new Exception("The survey system has no accuracy values");
+        }
+
+        Eigen::Vector3d & positionAccuracy = system.getPositionAccuracy();
+
+        setAccuracies(positionAccuracy(0),positionAccuracy(2),attitudeAccuracy->getRoll(),attitudeAccuracy->getPitch(),attitudeAccuracy->getHeading(),system.getSoundSpeedAccuracy());
+    }
+
+    /**
+    * Computes the horizontal and vertical uncertainty (2 sigma) of every sounding of a swath
+    *
+    * @param attitude the attitude of the swath
+    * @param soundSpeed the surface sound speed of the swath
+    * @param north north component of each sounding's vector from the position reference point
+    * @param east east component of each sounding's vector
+    * @param down down component of each sounding's vector
+    * @param count number of soundings
+    * @param horizontalUncertainty the horizontal uncertainty of each sounding
+    * @param verticalUncertainty the vertical uncertainty of each sounding
+    */
+    void computeSwath(Attitude & attitude,double soundSpeed,const double * north,const double * east,const double * down,unsigned int count,double * horizontalUncertainty,double * verticalUncertainty) const{
+        Eigen::Matrix3d imu2ned;
+        CoordinateTransform::getDCM(imu2ned,attitude);
+
+        //roll axis, pitch axis (heading only) and per swath variances
+        double ax = imu2ned(0,0);
+        double ay = imu2ned(1,0);
+        double az = imu2ned(2,0);
+        double px = -attitude.getSh();
+        double py = attitude.getCh();
+
+        double relativeSoundSpeedVariance = (soundSpeed > 0) ? soundSpeedVariance / (soundSpeed * soundSpeed) : 0;
+        double rangeVariance = headingVariance + relativeSoundSpeedVariance;
+
+        unsigned int i = 0;
+
+#ifdef __SSE2__
+        const __m128d vax = _mm_set1_pd(ax);
+        const __m128d vay = _mm_set1_pd(ay);
+        const __m128d vaz = _mm_set1_pd(az);
+        const __m128d vpx = _mm_set1_pd(px);
+        const __m128d vpy = _mm_set1_pd(py);
+        const __m128d vrollVariance = _mm_set1_pd(rollVariance);
+        const __m128d vpitchVariance = _mm_set1_pd(pitchVariance);
+        const __m128d vrangeVariance = _mm_set1_pd(rangeVariance);
+        const __m128d vrelativeSoundSpeedVariance = _mm_set1_pd(relativeSoundSpeedVariance);
+        const __m128d vhorizontalPositionVariance = _mm_set1_pd(horizontalPositionVariance);
+        const __m128d vverticalPositionVariance = _mm_set1_pd(verticalPositionVariance);
+        const __m128d two = _mm_set1_pd(2.0);
+
+        for(;i+1<count;i+=2){
+            __m128d n = _mm_loadu_pd(north + i);
+            __m128d e = _mm_loadu_pd(east + i);
+            __m128d d = _mm_loadu_pd(down + i);
+
+            __m128d rollX = _mm_sub_pd(_mm_mul_pd(vay,d),_mm_mul_pd(vaz,e));
+            __m128d rollY = _mm_sub_pd(_mm_mul_pd(vaz,n),_mm_mul_pd(vax,d));
+            __m128d rollZ = _mm_sub_pd(_mm_mul_pd(vax,e),_mm_mul_pd(vay,n));
+            __m128d pitchZ = _mm_sub_pd(_mm_mul_pd(vpx,e),_mm_mul_pd(vpy,n));
+            __m128d d2 = _mm_mul_pd(d,d);
+            __m128d range2 = _mm_add_pd(_mm_mul_pd(n,n),_mm_mul_pd(e,e));
+
+            __m128d vertical = _mm_add_pd(vverticalPositionVariance,_mm_mul_pd(vrollVariance,_mm_mul_pd(rollZ,rollZ)));
+            vertical = _mm_add_pd(vertical,_mm_mul_pd(vpitchVariance,_mm_mul_pd(pitchZ,pitchZ)));
+            vertical = _mm_add_pd(vertical,_mm_mul_pd(vrelativeSoundSpeedVariance,d2));
+
+            __m128d horizontal = _mm_add_pd(vhorizontalPositionVariance,_mm_mul_pd(vrollVariance,_mm_add_pd(_mm_mul_pd(rollX,rollX),_mm_mul_pd(rollY,rollY))));
+            horizontal = _mm_add_pd(horizontal,_mm_mul_pd(vpitchVariance,d2));
+            horizontal = _mm_add_pd(horizontal,_mm_mul_pd(vrangeVariance,range2));
+
+            _mm_storeu_pd(horizontalUncertainty + i,_mm_mul_pd(two,_mm_sqrt_pd(horizontal)));
+            _mm_storeu_pd(verticalUncertainty + i,_mm_mul_pd(two,_mm_sqrt_pd(vertical)));
+        }
+#endif
+
+        for(;i<count;i++){
+            double n = north[i];
+            double e = east[i];
+            double d = down[i];
+
+            double rollX = ay * d - az * e;
+            double rollY = az * n - ax * d;
+            double rollZ = ax * e - ay * n;
+            double pitchZ = px * e - py * n;
+            double d2 = d * d;
+            double range2 = n * n + e * e;
+
+            double vertical = verticalPositionVariance + rollVariance * rollZ * rollZ + pitchVariance * pitchZ * pitchZ + relativeSoundSpeedVariance * d2;
+            double horizontal = horizontalPositionVariance + rollVariance * (rollX * rollX + rollY * rollY) + pitchVariance * d2 + rangeVariance * range2;
+
+            horizontalUncertainty[i] = 2 * std::sqrt(horizontal);
+            verticalUncertainty[i] = 2 * std::sqrt(vertical);
+        }
+    }
+
+private:
+
+    /**
+    * Stores the 1 sigma variances of the accuracies
+    *
+    * @param horizontalPositionAccuracy horizontal position accuracy in meters
+    * @param verticalPositionAccuracy vertical position accuracy in meters
+    * @param rollAccuracy roll accuracy in degrees
+    * @param pitchAccuracy pitch accuracy in degrees
+    * @param headingAccuracy heading accuracy in degrees
+    * @param soundSpeedAccuracy sound speed accuracy in m/s
+    */
+    void setAccuracies(double horizontalPositionAccuracy,double verticalPositionAccuracy,double rollAccuracy,double pitchAccuracy,double headingAccuracy,double soundSpeedAccuracy){
+        horizontalPositionVariance = square(horizontalPositionAccuracy / 2);
+        verticalPositionVariance = square(verticalPositionAccuracy / 2);
+        rollVariance = square(rollAccuracy * D2R / 2);
+        pitchVariance = square(pitchAccuracy * D2R / 2);
+        headingVariance = square(headingAccuracy * D2R / 2);
+        soundSpeedVariance = square(soundSpeedAccuracy / 2);
+    }
+
+    /**Returns the square of a value*/
+    static double square(double value){
+        return value * value;
+    }
+
+    /**Horizontal position variance (m²)*/
+    double horizontalPositionVariance;
+
+    /**Vertical position variance (m²)*/
+    double verticalPositionVariance;
+
+    /**Roll variance (rad²)*/
+    double rollVariance;
+
+    /**Pitch variance (rad²)*/
+    double pitchVariance;
+
+    /**Heading variance (rad²)*/
+    double headingVariance;
+
+    /**Sound speed variance (m²/s²)*/
+    double soundSpeedVariance;
+};
+
+#endif
@@ -0,0 +1,620 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef OCTREEBUILDER_HPP
+#define OCTREEBUILDER_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <sys/stat.h>
+#include "OctreeStore.hpp"
+#include "../PointRecord.hpp"
+#include "../utils/Exception.hpp"
+#include "../utils/ParallelFor.hpp"
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+/*!
+* \brief Octree builder class
+*
+* Builds an on-disk level of detail octree (see OctreeStore) from a point cloud that does not need to fit in memory:
+*
+* 1. the points are spooled to a temporary file while their bounds are computed
+* 2. the points are counted on a 128x128x128 grid, which splits the cube into chunks of at most maximumChunkPoints
+* 3. the points are distributed to one temporary file per chunk
+* 4. the chunks are indexed in parallel, one chunk in memory per task: each chunk is split until nodes hold at most
+*    maximumNodePoints, then each node takes a subsample of its children's points, one per cell of a 128x128x128 grid
+* 5. the nodes above the chunks take their subsamples from the chunk roots
+*
+* Coordinates are stored as integers in millimeters (or coarser for very large extents) from the lowest corner of the cube.
+*/
+class OctreeBuilder{
+public:
+
+    /**Number of cells along each side of the sampling grid of a node*/
+    static const unsigned int SAMPLING_RESOLUTION = 128;
+
+    /**Level of the grid on which points are counted to make the chunks (2^7 = 128 cells per side)*/
+    static const unsigned int COUNTING_LEVEL = 7;
+
+    /**
+    * Creates an octree builder
+    *
+    * @param directory the octree directory, created if needed
+    * @param maximumNodePoints number of points above which a node is split
+    * @param maximumChunkPoints number of points above which the cube is split further into chunks, bounding the memory used per thread
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    OctreeBuilder(std::string directory,unsigned int maximumNodePoints = 20000,unsigned int maximumChunkPoints = 1 << 22,unsigned int threadCount = 0)
+    : directory(directory), maximumNodePoints(std::max(1u,maximumNodePoints)), maximumChunkPoints(std::max(1u,maximumChunkPoints)), threadCount(threadCount), pointCount(0){
+        minimum = Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity());
+        maximum = Eigen::Vector3d::Constant(-std::numeric_limits<double>::infinity());
+
+        spool = tmpfile();
+
+        if(!spool){
+            throw new Exception("Cannot create temporary file for the octree");
+        }
+    }
+
+    /**Destroys the octree builder*/
+    ~OctreeBuilder(){
+        if(spool){
+            fclose(spool);
+        }
+    }
+
+    /**
+    * Adds points to the octree. Points with non-finite coordinates are ignored
+    *
+    * @param points the points
+    * @param count number of points
+    */
+    void addPoints(const PointRecord * points,unsigned int count){
+        for(unsigned int i=0;i<count;i++){
+            if(!std::isfinite(points[i].x) || !std::isfinite(points[i].y) || !std::isfinite(points[i].z)){
+                continue;
+            }
+
+            Eigen::Vector3d position(points[i].x,points[i].y,points[i].z);
+            minimum = minimum.cwiseMin(position);
+            maximum = maximum.cwiseMax(position);
+
+            if(fwrite(&points[i],sizeof(PointRecord),1,spool) != 1){
+                throw new Exception("Cannot write the octree temporary file");
+            }
+
+            pointCount++;
+        }
+    }
+
+    /**Builds the octree from all the points added*/
+    void build(){
+        if(pointCount == 0){
+            throw new Exception("The octree has no points");
+        }
+
+#ifdef _WIN32
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(),0755);
+#endif
+
+        chooseCube();
+        countPoints();
+        makeChunks(0,0,0,0,"r");
+        distributePoints();
+
+        //index the chunks, largest first for a better balance
+        std::vector<unsigned int> order(chunks.size());
+
+        for(unsigned int i=0;i<order.size();i++){
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(),order.end(),[this](unsigned int a,unsigned int b){
+            return chunks[a].pointCount > chunks[b].pointCount;
+        });
+
+        ParallelFor::run(order.size(),[this,&order](unsigned int t,unsigned int thread){
+            indexChunk(chunks[order[t]]);
+        },threadCount);
+
+        //nodes above the chunks
+        std::vector<OctreePoint> rootPoints;
+        buildUpperNode(0,0,0,0,"r",rootPoints);
+        writeNode("r",rootPoints,hierarchy);
+
+        writeHierarchy();
+    }
+
+private:
+
+    /**Part of the cube indexed by a single task*/
+    typedef struct{
+        std::string name;
+        unsigned int level;
+        uint32_t minimum[3];
+        uint64_t pointCount;
+        std::string filename;
+        std::vector<OctreePoint> rootPoints;
+        std::vector<std::pair<std::string,uint64_t> > hierarchy;
+        bool split;
+    } Chunk;
+
+    /**Chooses the cube and the coordinate units*/
+    void chooseCube(){
+        double extent = std::max((maximum - minimum).maxCoeff(),1e-3);
+
+        //millimeters, unless the cube would not fit in 31 bits
+        scale = 1e-3;
+        sizeBits = 0;
+
+        while(sizeBits < 31 && std::ldexp(scale,sizeBits) <= extent){
+            sizeBits++;
+        }
+
+        if(std::ldexp(scale,sizeBits) <= extent){
+            scale = extent * (1 + 1e-9) / std::ldexp(1.0,31);
+        }
+
+        offset = minimum;
+        countingLevel = std::min((unsigned int)COUNTING_LEVEL,sizeBits);
+    }
+
+    /**
+    * Converts a point to octree units
+    *
+    * @param record the point
+    */
+    OctreePoint quantize(const PointRecord & record) const{
+        uint32_t limit = (uint32_t)((1ULL << sizeBits) - 1);
+        OctreePoint point;
+
+        point.x = std::min(limit,(uint32_t)std::floor((record.x - offset(0)) / scale));
+        point.y = std::min(limit,(uint32_t)std::floor((record.y - offset(1)) / scale));
+        point.z = std::min(limit,(uint32_t)std::floor((record.z - offset(2)) / scale));
+        point.quality = record.quality;
+        point.intensity = record.intensity;
+
+        return point;
+    }
+
+    /**
+    * Returns the counting grid cell of a point
+    *
+    * @param point the point
+    */
+    uint32_t getCountingCell(const OctreePoint & point) const{
+        unsigned int shift = sizeBits - countingLevel;
+        return (((point.x >> shift) << (2 * countingLevel)) | ((point.y >> shift) << countingLevel) | (point.z >> shift));
+    }
+
+    /**Counts the points on the counting grid and sums the counts for the coarser levels*/
+    void countPoints(){
+        counts.resize(countingLevel + 1);
+
+        for(unsigned int level=0;level<=countingLevel;level++){
+            counts[level].assign(1ULL << (3 * level),0);
+        }
+
+        forEachSpooledPoint([this](const OctreePoint & point){
+            counts[countingLevel][getCountingCell(point)]++;
+        });
+
+        for(int level=countingLevel-1;level>=0;level--){
+            uint32_t cells = 1 << level;
+
+            for(uint32_t x=0;x<cells;x++){
+                for(uint32_t y=0;y<cells;y++){
+                    for(uint32_t z=0;z<cells;z++){
+                        uint64_t sum = 0;
+
+                        for(unsigned int child=0;child<8;child++){
+                            sum += counts[level + 1][getCellIndex(level + 1,2 * x + ((child >> 2) & 1),2 * y + ((child >> 1) & 1),2 * z + (child & 1))];
+                        }
+
+                        counts[level][getCellIndex(level,x,y,z)] = sum;
+                    }
+                }
+            }
+        }
+    }
+
+    /**Returns the index of a cell of a counting level*/
+    static uint64_t getCellIndex(unsigned int level,uint32_t x,uint32_t y,uint32_t z){
+        return ((uint64_t)x << (2 * level)) | ((uint64_t)y << level) | z;
+    }
+
+    /**
+    * Splits the cube into chunks of at most maximumChunkPoints, down to the counting level
+    *
+    * @param level level of the node
+    * @param x,y,z cell of the node at its level
+    * @param name name of the node
+    */
+    void makeChunks(unsigned int level,uint32_t x,uint32_t y,uint32_t z,std::string name){
+        uint64_t count = counts[level][getCellIndex(level,x,y,z)];
+
+        if(count == 0){
+            return;
+        }
+
+        if(count <= maximumChunkPoints || level == countingLevel){
+            Chunk chunk;
+            chunk.name = name;
+            chunk.level = level;
+            chunk.minimum[0] = x << (sizeBits - level);
+            chunk.minimum[1] = y << (sizeBits - level);
+            chunk.minimum[2] = z << (sizeBits - level);
+            chunk.pointCount = count;
+            chunk.filename = directory + "/chunk_" + name + ".tmp";
+            chunks.push_back(chunk);
+            return;
+        }
+
+        for(unsigned int child=0;child<8;child++){
+            makeChunks(level + 1,2 * x + ((child >> 2) & 1),2 * y + ((child >> 1) & 1),2 * z + (child & 1),name + (char)('0' + child));
+        }
+    }
+
+    /**Writes every point to the temporary file of its chunk*/
+    void distributePoints(){
+        //chunk of each counting cell
+        std::vector<int32_t> cellChunks(counts[countingLevel].size(),-1);
+
+        for(unsigned int c=0;c<chunks.size();c++){
+            unsigned int shift = countingLevel - chunks[c].level;
+            uint32_t cells = 1 << shift;
+            uint32_t firstX = chunks[c].minimum[0] >> (sizeBits - countingLevel);
+            uint32_t firstY = chunks[c].minimum[1] >> (sizeBits - countingLevel);
+            uint32_t firstZ = chunks[c].minimum[2] >> (sizeBits - countingLevel);
+
+            for(uint32_t x=0;x<cells;x++){
+                for(uint32_t y=0;y<cells;y++){
+                    for(uint32_t z=0;z<cells;z++){
+                        cellChunks[getCellIndex(countingLevel,firstX + x,firstY + y,firstZ + z)] = c;
+                    }
+                }
+            }
+
+            remove(chunks[c].filename.c_str());
+        }
+
+        //points are buffered per chunk, and appended to the chunk files when the buffers fill up
+        std::vector<std::vector<OctreePoint> > buffers(chunks.size());
+
+        forEachSpooledPoint([this,&cellChunks,&buffers](const OctreePoint & point){
+            int32_t c = cellChunks[getCountingCell(point)];
+            buffers[c].push_back(point);
+
+            if(buffers[c].size() >= 4096){
+                appendToChunk(chunks[c],buffers[c]);
+            }
+        });
+
+        for(unsigned int c=0;c<chunks.size();c++){
+            appendToChunk(chunks[c],buffers[c]);
+        }
+
+        fclose(spool);
+        spool = NULL;
+    }
+
+    /**
+    * Appends points to the temporary file of a chunk and empties the buffer
+    *
+    * @param chunk the chunk
+    * @param points the points
+    */
+    void appendToChunk(Chunk & chunk,std::vector<OctreePoint> & points){
+        if(points.empty()){
+            return;
+        }
+
+        FILE * file = fopen(chunk.filename.c_str(),"ab");
+
+        if(!file || fwrite(&points[0],sizeof(OctreePoint),points.size(),file) != points.size()){
+            if(file) fclose(file);
+            throw new Exception("Cannot write octree chunk " + chunk.filename);
+        }
+
+        fclose(file);
+        points.clear();
+    }
+
+    /**
+    * Reads the spooled points, in octree units
+    *
+    * @param process called with each point
+    */
+    void forEachSpooledPoint(const std::function<void(const OctreePoint &)> & process){
+        rewind(spool);
+
+        std::vector<PointRecord> records(POINT_BATCH_SIZE);
+        unsigned int count;
+        bool truncated;
+
+        while((count = readPointRecords(spool,&records[0],POINT_BATCH_SIZE,truncated)) > 0){
+            for(unsigned int i=0;i<count;i++){
+                process(quantize(records[i]));
+            }
+        }
+    }
+
+    /**
+    * Builds the nodes of a chunk. The chunk root is kept in memory for the nodes above the chunks
+    *
+    * @param chunk the chunk
+    */
+    void indexChunk(Chunk & chunk){
+        std::vector<OctreePoint> points(chunk.pointCount);
+        FILE * file = fopen(chunk.filename.c_str(),"rb");
+
+        if(!file || fread(&points[0],sizeof(OctreePoint),points.size(),file) != points.size()){
+            if(file) fclose(file);
+            throw new Exception("Cannot read octree chunk " + chunk.filename);
+        }
+
+        fclose(file);
+        remove(chunk.filename.c_str());
+
+        chunk.split = buildNode(chunk.level,chunk.minimum,chunk.name,points,chunk.hierarchy);
+        chunk.rootPoints.swap(points);
+    }
+
+    /**
+    * Builds a node and its descendants. Descendants are written, the node's own points are left in points.
+    * Returns true if the node was split
+    *
+    * @param level level of the node
+    * @param nodeMinimum lowest corner of the node, in octree units
+    * @param name name of the node
+    * @param points the points of the node and its descendants, replaced by the node's own points
+    * @param nodes receives the name and number of points of the written nodes
+    */
+    bool buildNode(unsigned int level,const uint32_t * nodeMinimum,const std::string & name,std::vector<OctreePoint> & points,std::vector<std::pair<std::string,uint64_t> > & nodes){
+        if(points.size() <= maximumNodePoints || level >= sizeBits){
+            return false;
+        }
+
+        unsigned int half = sizeBits - level - 1;
+        std::vector<std::vector<OctreePoint> > children(8);
+
+        for(unsigned int i=0;i<points.size();i++){
+            unsigned int child = (((points[i].x - nodeMinimum[0]) >> half) << 2) | (((points[i].y - nodeMinimum[1]) >> half) << 1) | ((points[i].z - nodeMinimum[2]) >> half);
+            children[child].push_back(points[i]);
+        }
+
+        std::vector<OctreePoint>().swap(points);
+
+        bool split[8] = {false,false,false,false,false,false,false,false};
+
+        for(unsigned int child=0;child<8;child++){
+            if(children[child].empty()){
+                continue;
+            }
+
+            uint32_t childMinimum[3] = {nodeMinimum[0] + (((child >> 2) & 1) << half),nodeMinimum[1] + (((child >> 1) & 1) << half),nodeMinimum[2] + ((child & 1) << half)};
+            split[child] = buildNode(level + 1,childMinimum,name + (char)('0' + child),children[child],nodes);
+        }
+
+        sampleChildren(level,nodeMinimum,children,points);
+
+        //children left empty by the sampling are kept only if they have descendants
+        for(unsigned int child=0;child<8;child++){
+            if(!children[child].empty() || split[child]){
+                writeNode(name + (char)('0' + child),children[child],nodes);
+            }
+        }
+
+        return true;
+    }
+
+    /**
+    * Builds a node above the chunks and its descendants, from the chunk roots. Returns true if the node has descendants
+    *
+    * @param level level of the node
+    * @param x,y,z cell of the node at its level
+    * @param name name of the node
+    * @param points receives the node's own points
+    */
+    bool buildUpperNode(unsigned int level,uint32_t x,uint32_t y,uint32_t z,const std::string & name,std::vector<OctreePoint> & points){
+        for(unsigned int c=0;c<chunks.size();c++){
+            if(chunks[c].name == name){
+                points.swap(chunks[c].rootPoints);
+                hierarchy.insert(hierarchy.end(),chunks[c].hierarchy.begin(),chunks[c].hierarchy.end());
+                return chunks[c].split;
+            }
+        }
+
+        std::vector<std::vector<OctreePoint> > children(8);
+        bool split[8] = {false,false,false,false,false,false,false,false};
+
+        for(unsigned int child=0;child<8;child++){
+            uint32_t childX = 2 * x + ((child >> 2) & 1);
+            uint32_t childY = 2 * y + ((child >> 1) & 1);
+            uint32_t childZ = 2 * z + (child & 1);
+
+            if(counts[level + 1][getCellIndex(level + 1,childX,childY,childZ)] > 0){
+                split[child] = buildUpperNode(level + 1,childX,childY,childZ,name + (char)('0' + child),children[child]);
+            }
+        }
+
+        uint32_t nodeMinimum[3] = {x << (sizeBits - level),y << (sizeBits - level),z << (sizeBits - level)};
+        sampleChildren(level,nodeMinimum,children,points);
+
+        for(unsigned int child=0;child<8;child++){
+            if(!children[child].empty() || split[child]){
+                writeNode(name + (char)('0' + child),children[child],hierarchy);
+            }
+        }
+
+        return true;
+    }
+
+    /**
+    * Moves to a node one point per cell of its sampling grid, the one closest to the cell center, taken from its children
+    *
+    * @param level level of the node
+    * @param nodeMinimum lowest corner of the node, in octree units
+    * @param children the points of each child, from which the sampled points are removed
+    * @param points receives the sampled points
+    */
+    void sampleChildren(unsigned int level,const uint32_t * nodeMinimum,std::vector<std::vector<OctreePoint> > & children,std::vector<OctreePoint> & points){
+        double cellSize = std::ldexp(1.0,sizeBits - level) / SAMPLING_RESOLUTION;
+
+        //closest point of each cell: child, index and squared distance to the cell center
+        std::unordered_map<uint64_t,std::pair<uint64_t,double> > cells;
+
+        for(unsigned int child=0;child<8;child++){
+            for(unsigned int i=0;i<children[child].size();i++){
+                const OctreePoint & point = children[child][i];
+                double position[3] = {(double)(point.x - nodeMinimum[0]),(double)(point.y - nodeMinimum[1]),(double)(point.z - nodeMinimum[2])};
+                uint64_t key = 0;
+                double distance = 0;
+
+                for(unsigned int axis=0;axis<3;axis++){
+                    uint64_t cell = std::min((uint64_t)(position[axis] / cellSize),(uint64_t)SAMPLING_RESOLUTION - 1);
+                    double offset = position[axis] - (cell + 0.5) * cellSize;
+                    key = key * SAMPLING_RESOLUTION + cell;
+                    distance += offset * offset;
+                }
+
+                auto found = cells.find(key);
+
+                if(found == cells.end() || distance < found->second.second){
+                    cells[key] = std::make_pair(((uint64_t)child << 32) | i,distance);
+                }
+            }
+        }
+
+        std::vector<std::vector<bool> > selected(8);
+
+        for(unsigned int child=0;child<8;child++){
+            selected[child].assign(children[child].size(),false);
+        }
+
+        for(auto i = cells.begin();i != cells.end();i++){
+            selected[i->second.first >> 32][i->second.first & 0xFFFFFFFF] = true;
+        }
+
+        //keep the points in their original order
+        points.clear();
+
+        for(unsigned int child=0;child<8;child++){
+            unsigned int kept = 0;
+
+            for(unsigned int i=0;i<children[child].size();i++){
+                if(selected[child][i]){
+                    points.push_back(children[child][i]);
+                }
+                else{
+                    children[child][kept++] = children[child][i];
+                }
+            }
+
+            children[child].resize(kept);
+        }
+    }
+
+    /**
+    * Writes the points of a node
+    *
+    * @param name name of the node
+    * @param points the points
+    * @param nodes receives the name and number of points of the node
+    */
+    void writeNode(const std::string & name,const std::vector<OctreePoint> & points,std::vector<std::pair<std::string,uint64_t> > & nodes){
+        std::string filename = directory + "/" + name + ".bin";
+        FILE * file = fopen(filename.c_str(),"wb");
+
+        if(!file || (points.size() > 0 && fwrite(&points[0],sizeof(OctreePoint),points.size(),file) != points.size())){
+            if(file) fclose(file);
+            throw new Exception("Cannot write octree node " + filename);
+        }
+
+        fclose(file);
+
+        nodes.push_back(std::make_pair(name,(uint64_t)points.size()));
+    }
+
+    /**Writes the octree header and the list of nodes, parents before children*/
+    void writeHierarchy(){
+        std::sort(hierarchy.begin(),hierarchy.end(),[](const std::pair<std::string,uint64_t> & a,const std::pair<std::string,uint64_t> & b){
+            return (a.first.size() < b.first.size()) || (a.first.size() == b.first.size() && a.first < b.first);
+        });
+
+        std::string filename = directory + "/octree.txt";
+        FILE * file = fopen(filename.c_str(),"w");
+
+        if(!file){
+            throw new Exception("Cannot write octree header " + filename);
+        }
+
+        fprintf(file,"scale %.17g\noffset %.17g %.17g %.17g\nsizeBits %u\nnodes %u\n",scale,offset(0),offset(1),offset(2),sizeBits,(unsigned int)hierarchy.size());
+
+        for(unsigned int i=0;i<hierarchy.size();i++){
+            fprintf(file,"%s %llu\n",hierarchy[i].first.c_str(),(unsigned long long)hierarchy[i].second);
+        }
+
+        fclose(file);
+    }
+
+    /**The octree directory*/
+    std::string directory;
+
+    /**Number of points above which a node is split*/
+    unsigned int maximumNodePoints;
+
+    /**Number of points above which the cube is split into smaller chunks*/
+    unsigned int maximumChunkPoints;
+
+    /**Number of threads, 0 for one per hardware thread*/
+    unsigned int threadCount;
+
+    /**Temporary file holding the points until the bounds are known*/
+    FILE * spool;
+
+    /**Number of points added*/
+    uint64_t pointCount;
+
+    /**Lowest coordinates of the points*/
+    Eigen::Vector3d minimum;
+
+    /**Highest coordinates of the points*/
+    Eigen::Vector3d maximum;
+
+    /**Size of the coordinate units*/
+    double scale;
+
+    /**Position of the lowest corner of the cube*/
+    Eigen::Vector3d offset;
+
+    /**The cube side is 2^sizeBits units*/
+    unsigned int sizeBits;
+
+    /**Level of the counting grid, lower than COUNTING_LEVEL for tiny cubes*/
+    unsigned int countingLevel;
+
+    /**Number of points per cell, for each level down to the counting level*/
+    std::vector<std::vector<uint64_t> > counts;
+
+    /**Chunks*/
+    std::vector<Chunk> chunks;
+
+    /**Name and number of points of every written node*/
+    std::vector<std::pair<std::string,uint64_t> > hierarchy;
+};
+
+#endif
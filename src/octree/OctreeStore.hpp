@@ -0,0 +1,278 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef OCTREESTORE_HPP
+#define OCTREESTORE_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <queue>
+#include <map>
+#include <limits>
+#include <Eigen/Dense>
+#include "../PointRecord.hpp"
+#include "../utils/Exception.hpp"
+
+/**
+* Point of an octree node. Coordinates are integers in units of the octree scale, from the octree offset
+*/
+typedef struct{
+    uint32_t x;
+    uint32_t y;
+    uint32_t z;
+    uint32_t quality;
+    int32_t intensity;
+} OctreePoint;
+
+static_assert(sizeof(OctreePoint) == 20, "OctreePoint must be 20 bytes long");
+
+/**
+* Node of an octree hierarchy
+*/
+typedef struct{
+    std::string name;           /**<r followed by the index (0 to 7) of each child on the path from the root*/
+    unsigned int level;         /**<depth of the node, 0 for the root*/
+    uint64_t pointCount;        /**<number of points stored in the node*/
+    Eigen::Vector3d minimum;    /**<lowest corner of the node's cube*/
+    double size;                /**<side of the node's cube*/
+    int children[8];            /**<index of each child, -1 if absent*/
+} OctreeNode;
+
+/*!
+* \brief Octree store class
+*
+* Reads an on-disk level of detail octree, as written by OctreeBuilder. Similar to the Potree layout:
+* the directory holds octree.txt, which describes the cube and lists the nodes, and one file per node
+* (name.bin) holding OctreePoints.
+*
+* Every point is stored in exactly one node. The root holds a coarse subsample of the whole cloud, and each
+* level down adds the points needed to double the density, so drawing a node and all of its ancestors gives
+* a uniform density at that node's level of detail.
+*/
+class OctreeStore{
+public:
+
+    /**
+    * Opens an octree directory
+    *
+    * @param directory the octree directory
+    */
+    OctreeStore(std::string directory) : directory(directory){
+        std::string filename = directory + "/octree.txt";
+        FILE * file = fopen(filename.c_str(),"r");
+
+        if(!file){
+            throw new Exception("Cannot read octree " + filename);
+        }
+
+        unsigned int nodeCount;
+
+        if(fscanf(file,"scale %lf\noffset %lf %lf %lf\nsizeBits %u\nnodes %u\n",&scale,&offset(0),&offset(1),&offset(2),&sizeBits,&nodeCount) != 6 || sizeBits > 31){
+            fclose(file);
+            throw new Exception("Invalid octree header " + filename);
+        }
+
+        std::map<std::string,int> indexes;
+        char name[64];
+        unsigned long long pointCount;
+
+        for(unsigned int i=0;i<nodeCount;i++){
+            if(fscanf(file,"%63s %llu\n",name,&pointCount) != 2 || name[0] != 'r'){
+                fclose(file);
+                throw new Exception("Invalid octree header " + filename);
+            }
+
+            OctreeNode node;
+            node.name = name;
+            node.level = node.name.size() - 1;
+            node.pointCount = pointCount;
+            node.minimum = offset;
+            node.size = getCubeSize();
+
+            for(unsigned int c=0;c<8;c++){
+                node.children[c] = -1;
+            }
+
+            for(unsigned int l=1;l<node.name.size();l++){
+                int child = node.name[l] - '0';
+
+                if(child < 0 || child > 7){
+                    fclose(file);
+                    throw new Exception("Invalid octree node name " + node.name);
+                }
+
+                node.size /= 2;
+                node.minimum(0) += ((child >> 2) & 1) * node.size;
+                node.minimum(1) += ((child >> 1) & 1) * node.size;
+                node.minimum(2) += (child & 1) * node.size;
+            }
+
+            indexes[node.name] = nodes.size();
+            nodes.push_back(node);
+            totalPointCount += pointCount;
+        }
+
+        fclose(file);
+
+        //link the children, parents are listed before their children
+        for(unsigned int i=0;i<nodes.size();i++){
+            if(nodes[i].level == 0){
+                continue;
+            }
+
+            auto parent = indexes.find(nodes[i].name.substr(0,nodes[i].name.size() - 1));
+
+            if(parent == indexes.end()){
+                throw new Exception("Octree node " + nodes[i].name + " has no parent");
+            }
+
+            nodes[parent->second].children[nodes[i].name.back() - '0'] = i;
+        }
+
+        if(nodes.empty() || nodes[0].name != "r"){
+            throw new Exception("Octree " + directory + " has no root");
+        }
+    }
+
+    /**Destroys the octree store*/
+    ~OctreeStore(){
+
+    }
+
+    /**Returns the number of nodes*/
+    unsigned int getNodeCount() const{
+        return nodes.size();
+    }
+
+    /**Returns the number of points of the octree*/
+    uint64_t getPointCount() const{
+        return totalPointCount;
+    }
+
+    /**
+    * Returns a node. The root is node 0
+    *
+    * @param index index of the node
+    */
+    const OctreeNode & getNode(unsigned int index) const{
+        return nodes[index];
+    }
+
+    /**Returns the side of the octree's cube*/
+    double getCubeSize() const{
+        return std::ldexp(scale,sizeBits);
+    }
+
+    /**
+    * Selects the nodes to draw for a camera position, coarsest first. Nodes are taken by decreasing apparent
+    * size (size over distance to the camera), down to minimumApparentSize, until the point budget is spent.
+    * Only nodes whose parent is selected are considered, so the selection is a subtree rooted at node 0.
+    * The work depends on the budget, not on the size of the octree
+    *
+    * @param camera the camera position
+    * @param minimumApparentSize smallest apparent size of a node worth drawing
+    * @param pointBudget maximum number of points to draw
+    * @param selected the indexes of the selected nodes
+    */
+    void selectNodes(const Eigen::Vector3d & camera,double minimumApparentSize,uint64_t pointBudget,std::vector<unsigned int> & selected) const{
+        selected.clear();
+
+        std::priority_queue<std::pair<double,unsigned int> > candidates;
+        candidates.push(std::make_pair(getApparentSize(nodes[0],camera),0u));
+
+        uint64_t pointCount = 0;
+
+        while(!candidates.empty()){
+            double apparentSize = candidates.top().first;
+            unsigned int index = candidates.top().second;
+            candidates.pop();
+
+            //the root is always drawn
+            if(index != 0 && (apparentSize < minimumApparentSize || pointCount + nodes[index].pointCount > pointBudget)){
+                continue;
+            }
+
+            selected.push_back(index);
+            pointCount += nodes[index].pointCount;
+
+            for(unsigned int c=0;c<8;c++){
+                if(nodes[index].children[c] >= 0){
+                    const OctreeNode & child = nodes[nodes[index].children[c]];
+                    candidates.push(std::make_pair(getApparentSize(child,camera),(unsigned int)nodes[index].children[c]));
+                }
+            }
+        }
+    }
+
+    /**
+    * Reads the points of a node
+    *
+    * @param index index of the node
+    * @param points the points of the node
+    */
+    void readNode(unsigned int index,std::vector<PointRecord> & points) const{
+        const OctreeNode & node = nodes[index];
+        std::string filename = directory + "/" + node.name + ".bin";
+        FILE * file = fopen(filename.c_str(),"rb");
+
+        if(!file){
+            throw new Exception("Cannot read octree node " + filename);
+        }
+
+        std::vector<OctreePoint> stored(node.pointCount);
+        size_t read = (stored.size() > 0) ? fread(&stored[0],sizeof(OctreePoint),stored.size(),file) : 0;
+        fclose(file);
+
+        if(read != stored.size()){
+            throw new Exception("Truncated octree node " + filename);
+        }
+
+        points.resize(stored.size());
+
+        for(unsigned int i=0;i<stored.size();i++){
+            PointRecord point = {offset(0) + stored[i].x * scale,offset(1) + stored[i].y * scale,offset(2) + stored[i].z * scale,
+                                 stored[i].quality,stored[i].intensity,NAN,NAN};
+            points[i] = point;
+        }
+    }
+
+private:
+
+    /**
+    * Returns the size of a node over its distance to the camera
+    *
+    * @param node the node
+    * @param camera the camera position
+    */
+    static double getApparentSize(const OctreeNode & node,const Eigen::Vector3d & camera){
+        Eigen::Vector3d center = node.minimum + Eigen::Vector3d::Constant(node.size / 2);
+        double radius = node.size * std::sqrt(3.0) / 2;
+        double distance = std::max((center - camera).norm() - radius,node.size * 1e-3);
+
+        return node.size / distance;
+    }
+
+    /**The octree directory*/
+    std::string directory;
+
+    /**Size of the coordinate units*/
+    double scale;
+
+    /**Position of the lowest corner of the cube*/
+    Eigen::Vector3d offset;
+
+    /**The cube side is 2^sizeBits units*/
+    unsigned int sizeBits;
+
+    /**Nodes, parents before children*/
+    std::vector<OctreeNode> nodes;
+
+    /**Number of points of the octree*/
+    uint64_t totalPointCount = 0;
+};
+
+#endif
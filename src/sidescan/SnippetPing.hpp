@@ -0,0 +1,166 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef SNIPPETPING_HPP
+#define SNIPPETPING_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+/**Type of the snippet samples, as recorded*/
+enum SnippetSampleType{
+    /**Unsigned 16 bit magnitudes*/
+    SNIPPET_UINT16,
+    /**Unsigned 32 bit magnitudes*/
+    SNIPPET_UINT32,
+    /**Float backscatter*/
+    SNIPPET_FLOAT32,
+    /**Signed 16 bit amplitudes, in 0.1 dB*/
+    SNIPPET_INT16
+};
+
+/*!
+* \brief Snippet beam
+*
+* Samples of a beam around its bottom detection
+*/
+typedef struct {
+    /**Beam number given by the sonar*/
+    uint32_t     beamNumber;
+
+    /**Across track angle of the beam in degrees, NaN if unknown*/
+    double       beamAngle;
+
+    /**Number of the first sample since transmission, 0 if the sonar does not give it*/
+    uint32_t     firstSample;
+
+    /**Number of the bottom detection sample since transmission, or in the samples if firstSample is not given*/
+    uint32_t     detectionSample;
+
+    /**True if the samples are recorded from the farthest to the nearest*/
+    bool         reversed;
+
+    /**Number of samples*/
+    uint32_t     sampleCount;
+
+    /**The samples, in the datagram*/
+    const void * samples;
+
+    /**Footprint area of each sample in square meters, in the datagram, NULL if unknown*/
+    const float * footprints;
+} SnippetBeam;
+
+/*!
+* \brief Snippet ping class
+*
+* Backscatter snippets of the beams of a ping. The samples are not copied: the beams point into the datagram, in their
+* recorded type, so they are only valid during the call that gives the ping to the handler. A parser keeps a single
+* snippet ping and fills it again for each ping.
+*/
+class SnippetPing{
+public:
+
+    /**Creates an empty snippet ping*/
+    SnippetPing() : timestamp(0), pingNumber(0), sampleType(SNIPPET_UINT16), calibrated(false) {}
+
+    /**
+    * Empties the ping for new data, keeping the memory of its beams
+    *
+    * @param newTimestamp the ping timestamp
+    * @param newPingNumber the ping number
+    * @param newSampleType the type of the samples
+    * @param newCalibrated true if the samples are calibrated backscatter
+    */
+    void reset(uint64_t newTimestamp,uint32_t newPingNumber,SnippetSampleType newSampleType,bool newCalibrated){
+        timestamp = newTimestamp;
+        pingNumber = newPingNumber;
+        sampleType = newSampleType;
+        calibrated = newCalibrated;
+
+        beams.clear();
+    }
+
+    /**
+    * Adds a beam
+    *
+    * @param beam the beam, its samples pointing into the datagram
+    */
+    void addBeam(SnippetBeam & beam){ beams.push_back(beam); }
+
+    /**Returns the ping timestamp*/
+    uint64_t getTimestamp(){ return timestamp; }
+
+    /**Returns the ping number*/
+    uint32_t getPingNumber(){ return pingNumber; }
+
+    /**Returns the type of the samples*/
+    SnippetSampleType getSampleType(){ return sampleType; }
+
+    /**Returns true if the samples are calibrated backscatter*/
+    bool isCalibrated(){ return calibrated; }
+
+    /**Returns the number of beams*/
+    unsigned int getBeamCount(){ return beams.size(); }
+
+    /**
+    * Returns a beam
+    *
+    * @param index the beam index, from 0 to getBeamCount() - 1
+    */
+    SnippetBeam & getBeam(unsigned int index){ return beams[index]; }
+
+    /**
+    * Returns the samples of a beam as recorded, T matching the sample type
+    *
+    * @param index the beam index, from 0 to getBeamCount() - 1
+    */
+    template<typename T>
+    const T * getSamples(unsigned int index){ return (const T *)beams[index].samples; }
+
+    /**
+    * Returns a sample of a beam, whatever the sample type, from the nearest
+    *
+    * @param index the beam index, from 0 to getBeamCount() - 1
+    * @param sample the sample index, from 0 to the beam's sampleCount - 1
+    */
+    double getSample(unsigned int index,unsigned int sample){
+        if(beams[index].reversed){
+            sample = beams[index].sampleCount - 1 - sample;
+        }
+
+        switch(sampleType){
+            case SNIPPET_UINT16:
+                return getSamples<uint16_t>(index)[sample];
+
+            case SNIPPET_UINT32:
+                return getSamples<uint32_t>(index)[sample];
+
+            case SNIPPET_INT16:
+                return getSamples<int16_t>(index)[sample];
+
+            default:
+                return getSamples<float>(index)[sample];
+        }
+    }
+
+private:
+
+    /**Ping timestamp*/
+    uint64_t timestamp;
+
+    /**Ping number*/
+    uint32_t pingNumber;
+
+    /**Type of the samples*/
+    SnippetSampleType sampleType;
+
+    /**True if the samples are calibrated backscatter*/
+    bool calibrated;
+
+    /**Beams of the ping*/
+    std::vector<SnippetBeam> beams;
+};
+
+#endif
@@ -17,6 +17,9 @@
 
 class SvpSelectionStrategy {
 public:    
+    /**Destroys the strategy*/
+    virtual ~SvpSelectionStrategy() {}
+
     virtual SoundVelocityProfile * chooseSvp(Position & position, Ping & ping)=0;
     virtual void addSvp(SoundVelocityProfile * svp)=0;
 };
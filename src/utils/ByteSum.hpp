@@ -0,0 +1,71 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef BYTESUM_HPP
+#define BYTESUM_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*!
+* \brief Byte sum class
+*
+* Sums unsigned bytes, as in the checksums of the sonar file formats. The sum of absolute differences
+* instruction (psadbw) adds 32 bytes at a time with AVX2 or 16 with SSE2 when available, in 64 bit
+* lanes that cannot overflow; the remaining bytes are added one at a time.
+*/
+class ByteSum{
+public:
+
+    /**
+    * Returns the sum of the bytes, modulo 2^32
+    *
+    * @param data the bytes
+    * @param size the number of bytes
+    */
+    static uint32_t sum(const unsigned char * data,size_t size){
+        uint64_t total = 0;
+        size_t i = 0;
+
+#ifdef __AVX2__
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i lanes = _mm256_setzero_si256();
+
+        for(;i + 32 <= size;i += 32){
+            __m256i bytes = _mm256_loadu_si256((const __m256i *)(data + i));
+            lanes = _mm256_add_epi64(lanes,_mm256_sad_epu8(bytes,zero));
+        }
+
+        uint64_t partial[4];
+        _mm256_storeu_si256((__m256i *)partial,lanes);
+        total = partial[0] + partial[1] + partial[2] + partial[3];
+#elif defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lanes = _mm_setzero_si128();
+
+        for(;i + 16 <= size;i += 16){
+            __m128i bytes = _mm_loadu_si128((const __m128i *)(data + i));
+            lanes = _mm_add_epi64(lanes,_mm_sad_epu8(bytes,zero));
+        }
+
+        uint64_t partial[2];
+        _mm_storeu_si128((__m128i *)partial,lanes);
+        total = partial[0] + partial[1];
+#endif
+
+        for(;i < size;i++){
+            total += data[i];
+        }
+
+        return (uint32_t)total;
+    }
+};
+
+#endif
@@ -0,0 +1,243 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef FLOATFORMATTER_HPP
+#define FLOATFORMATTER_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+
+/*!
+* \brief Float formatter class
+*
+* Formats doubles to text without going through printf or iostreams. The output is byte-identical
+* to printf's "%.Nf" and "%.Ng" conversions: values whose rounding cannot be decided exactly from
+* a double product (ties, huge magnitudes, NaN, infinities) are handed to snprintf.
+*/
+class FloatFormatter{
+public:
+
+    /**Maximum number of characters (including the terminating null) written by a fixed or general conversion of precision 17 or less*/
+    static const unsigned int MAX_LENGTH = 336;
+
+    /**Highest precision handled without snprintf*/
+    static const unsigned int MAX_FAST_PRECISION = 18;
+
+    /**
+    * Writes value with a fixed number of decimals, as printf("%.*f") would.
+    * Returns the number of characters written, excluding the terminating null
+    *
+    * @param out destination, must hold at least MAX_LENGTH characters
+    * @param value the value to format
+    * @param precision number of decimals
+    */
+    static unsigned int formatFixed(char * out, double value, unsigned int precision){
+        if(precision <= MAX_FAST_PRECISION && std::isfinite(value)){
+            double scaled = std::fabs(value) * powersOfTen()[precision];
+
+            //below 2^52 the integral and fractional parts of the product are exact
+            if(scaled < 4503599627370496.0){
+                double integral = std::floor(scaled);
+                double fraction = scaled - integral;
+
+                //the product carries at most half an ulp of error: only decide the rounding when it can't flip
+                if(std::fabs(fraction - 0.5) > scaled * 2.220446049250313e-16){
+                    uint64_t rounded = (uint64_t)integral + ((fraction > 0.5) ? 1 : 0);
+
+                    char * p = out;
+
+                    if(std::signbit(value)){
+                        *p++ = '-';
+                    }
+
+                    p += writeUnsigned(p, rounded / integerPowersOfTen()[precision]);
+
+                    if(precision > 0){
+                        *p++ = '.';
+                        writeZeroPadded(p, rounded % integerPowersOfTen()[precision], precision);
+                        p += precision;
+                    }
+
+                    *p = 0;
+
+                    return p - out;
+                }
+            }
+        }
+
+        return snprintf(out, MAX_LENGTH, "%.*f", (int)precision, value);
+    }
+
+    /**
+    * Writes value with a number of significant digits, as printf("%.*g") would.
+    * Returns the number of characters written, excluding the terminating null
+    *
+    * @param out destination, must hold at least MAX_LENGTH characters
+    * @param value the value to format
+    * @param precision number of significant digits
+    */
+    static unsigned int formatGeneral(char * out, double value, unsigned int precision){
+        if(precision == 0){
+            precision = 1;
+        }
+
+        if(precision <= 15 && std::isfinite(value)){
+            double magnitude = std::fabs(value);
+
+            if(magnitude == 0){
+                char * p = out;
+
+                if(std::signbit(value)){
+                    *p++ = '-';
+                }
+
+                *p++ = '0';
+                *p = 0;
+
+                return p - out;
+            }
+
+            //%g uses fixed notation when the decimal exponent is within [-4,precision[.
+            //Stay one exponent short of the upper bound so that rounding up can't switch to scientific notation
+            const double * powers = decimalExponents();
+            int maxExponent = (int)precision - 2;
+
+            if(magnitude >= powers[0] && maxExponent >= -4 && magnitude < powers[maxExponent + 5]){
+                int exponent = -4;
+
+                while(magnitude >= powers[exponent + 5]){
+                    exponent++;
+                }
+
+                //powers of ten below 1 aren't exact doubles: don't trust the exponent right next to a boundary
+                if(magnitude > powers[exponent + 4] * (1 + 1e-12) && magnitude < powers[exponent + 5] * (1 - 1e-12)){
+                    unsigned int length = formatFixed(out, value, precision - 1 - exponent);
+
+                    //drop trailing zeros and a dangling decimal point
+                    while(out[length - 1] == '0'){
+                        length--;
+                    }
+
+                    if(out[length - 1] == '.'){
+                        length--;
+                    }
+
+                    out[length] = 0;
+
+                    return length;
+                }
+            }
+        }
+
+        return snprintf(out, MAX_LENGTH, "%.*g", (int)precision, value);
+    }
+
+    /**
+    * Writes the shortest "%g" representation that reads back to the same double.
+    * Returns the number of characters written, excluding the terminating null
+    *
+    * @param out destination, must hold at least MAX_LENGTH characters
+    * @param value the value to format
+    */
+    static unsigned int formatShortest(char * out, double value){
+        unsigned int length = 0;
+
+        //%g drops trailing zeros, so 15 digits already yields the shortest form of anything that fits in it
+        for(unsigned int precision = 15; precision <= 17; precision++){
+            length = formatGeneral(out, value, precision);
+
+            if(strtod(out, NULL) == value){
+                break;
+            }
+        }
+
+        return length;
+    }
+
+    /**
+    * Writes an unsigned integer in decimal. Returns the number of characters written (no terminating null)
+    *
+    * @param out destination, must hold at least 20 characters
+    * @param value the value to write
+    */
+    static unsigned int writeUnsigned(char * out, uint64_t value){
+        char digits[20];
+        unsigned int n = 0;
+
+        do{
+            digits[n++] = '0' + (value % 10);
+            value /= 10;
+        } while(value > 0);
+
+        for(unsigned int i = 0; i < n; i++){
+            out[i] = digits[n - 1 - i];
+        }
+
+        return n;
+    }
+
+    /**
+    * Writes a signed integer in decimal. Returns the number of characters written (no terminating null)
+    *
+    * @param out destination, must hold at least 20 characters
+    * @param value the value to write
+    */
+    static unsigned int writeSigned(char * out, int64_t value){
+        if(value < 0){
+            *out = '-';
+            return 1 + writeUnsigned(out + 1, (uint64_t)0 - (uint64_t)value);
+        }
+
+        return writeUnsigned(out, (uint64_t)value);
+    }
+
+private:
+
+    /**
+    * Writes exactly width digits of value, left-padded with zeros
+    *
+    * @param out destination
+    * @param value the value to write, smaller than 10^width
+    * @param width number of digits
+    */
+    static void writeZeroPadded(char * out, uint64_t value, unsigned int width){
+        for(unsigned int i = width; i > 0; i--){
+            out[i - 1] = '0' + (value % 10);
+            value /= 10;
+        }
+    }
+
+    /**Returns 10^0 to 10^18 as doubles. All of them are exact*/
+    static const double * powersOfTen(){
+        static const double powers[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+            1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+        };
+        return powers;
+    }
+
+    /**Returns 10^0 to 10^18 as integers*/
+    static const uint64_t * integerPowersOfTen(){
+        static const uint64_t powers[] = {
+            1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+            1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+            100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+            1000000000000000000ULL
+        };
+        return powers;
+    }
+
+    /**Returns 10^-4 to 10^15, the decimal exponent boundaries for which %g stays in fixed notation*/
+    static const double * decimalExponents(){
+        static const double powers[] = {
+            1e-4, 1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5,
+            1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+        };
+        return powers;
+    }
+};
+
+#endif
@@ -0,0 +1,97 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef PARALLELFOR_HPP
+#define PARALLELFOR_HPP
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <exception>
+
+/*!
+* \brief Parallel loop helper
+*
+* Runs task(index,threadIndex) for every index in [0,count[ on a set of threads that pick the next
+* index as soon as they are done with the previous one, so uneven tasks (tiles, line pairs...) balance out.
+* threadIndex identifies the worker, for per-thread scratch space.
+*
+* A task that throws stops the loop: the workers take no new index, and the first exception thrown,
+* such as an Exception *, is thrown again to the caller once they are done.
+*/
+class ParallelFor{
+public:
+
+    /**
+    * Returns the number of threads to use when 0 is requested
+    */
+    static unsigned int defaultThreadCount(){
+        return std::max(1u,std::thread::hardware_concurrency());
+    }
+
+    /**
+    * Runs task on every index, in parallel. Returns when all tasks are done, or throws the first exception of a task
+    *
+    * @param count number of tasks
+    * @param task the task, called with the task index and the worker index
+    * @param threadCount number of threads, or 0 for one per hardware thread
+    */
+    static void run(unsigned int count,const std::function<void(unsigned int,unsigned int)> & task,unsigned int threadCount = 0){
+        if(threadCount == 0){
+            threadCount = defaultThreadCount();
+        }
+
+        threadCount = std::min(threadCount,count);
+
+        //not worth a thread
+        if(threadCount <= 1){
+            for(unsigned int i=0;i<count;i++){
+                task(i,0);
+            }
+
+            return;
+        }
+
+        std::atomic<unsigned int> next(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr firstError;
+        std::mutex errorMutex;
+        std::vector<std::thread> workers;
+
+        for(unsigned int t=0;t<threadCount;t++){
+            workers.push_back(std::thread([&next,&failed,&firstError,&errorMutex,&task,count,t](){
+                unsigned int i;
+
+                try{
+                    while(!failed && (i = next++) < count){
+                        task(i,t);
+                    }
+                }
+                catch(...){
+                    //an exception leaving a thread would terminate the program: keep it for the caller
+                    std::lock_guard<std::mutex> lock(errorMutex);
+
+                    if(!firstError){
+                        firstError = std::current_exception();
+                    }
+
+                    failed = true;
+                }
+            }));
+        }
+
+        for(unsigned int t=0;t<workers.size();t++){
+            workers[t].join();
+        }
+
+        if(firstError){
+            std::rethrow_exception(firstError);
+        }
+    }
+};
+
+#endif
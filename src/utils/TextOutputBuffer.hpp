@@ -0,0 +1,195 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef TEXTOUTPUTBUFFER_HPP
+#define TEXTOUTPUTBUFFER_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include "FloatFormatter.hpp"
+
+/*!
+* \brief Text output buffer class
+*
+* Accumulates formatted text in a large reusable buffer and writes it to a file in big blocks.
+* When no file is given, the buffer simply grows and its content can be read back with data() and size().
+*/
+class TextOutputBuffer{
+public:
+
+    /**Default buffer capacity*/
+    static const unsigned int DEFAULT_CAPACITY = 1 << 20;
+
+    /**
+    * Creates a text output buffer
+    *
+    * @param file the file to write to, or NULL to keep the text in memory
+    * @param capacity size of the buffer
+    */
+    TextOutputBuffer(FILE * file = NULL, unsigned int capacity = DEFAULT_CAPACITY) : file(file), length(0){
+        buffer.resize(capacity > 2 * FloatFormatter::MAX_LENGTH ? capacity : 2 * FloatFormatter::MAX_LENGTH);
+    }
+
+    /**Flushes remaining text and destroys the text output buffer*/
+    ~TextOutputBuffer(){
+        flush();
+    }
+
+    /**
+    * Changes the file to write to. Pending text is flushed to the previous file first
+    *
+    * @param newFile the new file
+    */
+    void setFile(FILE * newFile){
+        flush();
+        file = newFile;
+    }
+
+    /**
+    * Appends a value with a fixed number of decimals ("%.*f")
+    *
+    * @param value the value
+    * @param precision number of decimals
+    */
+    void appendFixed(double value, unsigned int precision){
+        reserve(FloatFormatter::MAX_LENGTH);
+        length += FloatFormatter::formatFixed(&buffer[length], value, precision);
+    }
+
+    /**
+    * Appends a value with a number of significant digits ("%.*g")
+    *
+    * @param value the value
+    * @param precision number of significant digits
+    */
+    void appendGeneral(double value, unsigned int precision){
+        reserve(FloatFormatter::MAX_LENGTH);
+        length += FloatFormatter::formatGeneral(&buffer[length], value, precision);
+    }
+
+    /**
+    * Appends the shortest representation of a value that reads back exactly
+    *
+    * @param value the value
+    */
+    void appendShortest(double value){
+        reserve(FloatFormatter::MAX_LENGTH);
+        length += FloatFormatter::formatShortest(&buffer[length], value);
+    }
+
+    /**
+    * Appends a signed integer
+    *
+    * @param value the value
+    */
+    void appendInteger(int64_t value){
+        reserve(24);
+        length += FloatFormatter::writeSigned(&buffer[length], value);
+    }
+
+    /**
+    * Appends an unsigned integer
+    *
+    * @param value the value
+    */
+    void appendUnsigned(uint64_t value){
+        reserve(24);
+        length += FloatFormatter::writeUnsigned(&buffer[length], value);
+    }
+
+    /**
+    * Appends a character
+    *
+    * @param c the character
+    */
+    void appendChar(char c){
+        reserve(1);
+        buffer[length++] = c;
+    }
+
+    /**
+    * Appends n characters
+    *
+    * @param text the characters
+    * @param n number of characters
+    */
+    void appendString(const char * text, size_t n){
+        if(file && n > buffer.size()){
+            flush();
+            fwrite(text, 1, n, file);
+            return;
+        }
+
+        reserve(n);
+        memcpy(&buffer[length], text, n);
+        length += n;
+    }
+
+    /**
+    * Appends a null terminated string
+    *
+    * @param text the string
+    */
+    void appendString(const char * text){
+        appendString(text, strlen(text));
+    }
+
+    /**Writes the buffered text to the file*/
+    void flush(){
+        if(file && length > 0){
+            fwrite(&buffer[0], 1, length, file);
+        }
+
+        if(file){
+            length = 0;
+        }
+    }
+
+    /**Discards the buffered text*/
+    void clear(){
+        length = 0;
+    }
+
+    /**Returns the buffered text. It is not null terminated*/
+    const char * data() const{
+        return &buffer[0];
+    }
+
+    /**Returns the number of buffered characters*/
+    size_t size() const{
+        return length;
+    }
+
+private:
+
+    /**
+    * Makes room for n more characters, either by flushing to the file or by growing the buffer
+    *
+    * @param n number of characters needed
+    */
+    void reserve(size_t n){
+        if(length + n > buffer.size()){
+            if(file){
+                flush();
+            }
+
+            if(length + n > buffer.size()){
+                buffer.resize(2 * (length + n));
+            }
+        }
+    }
+
+    /**File to write to*/
+    FILE * file;
+
+    /**The buffer*/
+    std::vector<char> buffer;
+
+    /**Number of buffered characters*/
+    size_t length;
+};
+
+#endif
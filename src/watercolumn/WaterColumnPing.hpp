@@ -0,0 +1,196 @@
+/*
+* Copyright 2019 © Centre Interdisciplinaire de développement en Cartographie des Océans (CIDCO), Tous droits réservés
+*/
+
+#ifndef WATERCOLUMNPING_HPP
+#define WATERCOLUMNPING_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+/*!
+* \brief Water column beam
+*
+* Location of the samples of a beam in its water column ping
+*/
+typedef struct {
+    /**Beam number given by the sonar*/
+    uint32_t beamNumber;
+
+    /**Across track angle of the beam in degrees, NaN if unknown*/
+    double   beamAngle;
+
+    /**Index of the first sample of the beam in the sample arrays of the ping*/
+    uint64_t firstSampleIndex;
+
+    /**Number of the first sample of the beam since transmission*/
+    uint32_t firstSample;
+
+    /**Number of samples of the beam*/
+    uint32_t sampleCount;
+} WaterColumnBeam;
+
+/*!
+* \brief Water column ping class
+*
+* Sample arrays of all the beams of a ping. A parser keeps a single water column ping and fills it again for each ping:
+* its arrays only grow, so the memory used stays that of the largest ping, whatever the size of the file. A handler
+* must copy what it keeps beyond the call that gives it the ping.
+*
+* Sample j of a beam was received at sample number firstSample + j * sampleStride since transmission, that is
+* (firstSample + j * sampleStride) / sampleRate seconds, firstSample being that of the beam.
+*/
+class WaterColumnPing{
+public:
+
+    /**Creates an empty water column ping*/
+    WaterColumnPing() : timestamp(0), pingNumber(0), sampleRate(0), firstSample(0), sampleStride(1), decibel(false), phase(false) {}
+
+    /**
+    * Empties the ping for new data, keeping the memory of its arrays
+    *
+    * @param newTimestamp the ping timestamp
+    * @param newPingNumber the ping number
+    * @param newSampleRate the sample rate, in Hz
+    * @param newFirstSample number of the first sample since transmission
+    * @param newSampleStride number of samples between two kept samples of a downsampled ping, 1 otherwise
+    * @param newDecibel true if the magnitudes are in dB
+    * @param newPhase true if the ping has phases
+    */
+    void reset(uint64_t newTimestamp,uint32_t newPingNumber,double newSampleRate,uint32_t newFirstSample,unsigned int newSampleStride,bool newDecibel,bool newPhase){
+        timestamp = newTimestamp;
+        pingNumber = newPingNumber;
+        sampleRate = newSampleRate;
+        firstSample = newFirstSample;
+        sampleStride = newSampleStride;
+        decibel = newDecibel;
+        phase = newPhase;
+
+        beams.clear();
+        magnitudes.clear();
+        phases.clear();
+    }
+
+    /**
+    * Adds a beam starting at the first sample of the ping and returns its magnitudes, to be filled by the caller
+    *
+    * @param beamNumber the beam number
+    * @param beamAngle across track angle of the beam in degrees, NaN if unknown
+    * @param sampleCount the number of samples
+    */
+    float * addBeam(uint32_t beamNumber,double beamAngle,uint32_t sampleCount){
+        return addBeam(beamNumber,beamAngle,sampleCount,firstSample);
+    }
+
+    /**
+    * Adds a beam and returns its magnitudes, to be filled by the caller
+    *
+    * @param beamNumber the beam number
+    * @param beamAngle across track angle of the beam in degrees, NaN if unknown
+    * @param sampleCount the number of samples
+    * @param beamFirstSample number of the first sample of the beam since transmission
+    */
+    float * addBeam(uint32_t beamNumber,double beamAngle,uint32_t sampleCount,uint32_t beamFirstSample){
+        WaterColumnBeam beam;
+        beam.beamNumber = beamNumber;
+        beam.beamAngle = beamAngle;
+        beam.firstSampleIndex = magnitudes.size();
+        beam.firstSample = beamFirstSample;
+        beam.sampleCount = sampleCount;
+        beams.push_back(beam);
+
+        magnitudes.resize(magnitudes.size() + sampleCount);
+
+        if(phase){
+            phases.resize(magnitudes.size());
+        }
+
+        return magnitudes.data() + beam.firstSampleIndex;
+    }
+
+    /**Returns the ping timestamp*/
+    uint64_t getTimestamp(){ return timestamp; }
+
+    /**Returns the ping number*/
+    uint32_t getPingNumber(){ return pingNumber; }
+
+    /**Returns the sample rate, in Hz*/
+    double getSampleRate(){ return sampleRate; }
+
+    /**Returns the number of the first sample of the ping since transmission*/
+    uint32_t getFirstSample(){ return firstSample; }
+
+    /**Returns the number of samples between two kept samples*/
+    unsigned int getSampleStride(){ return sampleStride; }
+
+    /**Returns true if the magnitudes are in dB*/
+    bool isDecibel(){ return decibel; }
+
+    /**Returns true if the ping has phases*/
+    bool hasPhase(){ return phase; }
+
+    /**Returns the number of beams*/
+    unsigned int getBeamCount(){ return beams.size(); }
+
+    /**
+    * Returns a beam
+    *
+    * @param index the beam index, from 0 to getBeamCount() - 1
+    */
+    WaterColumnBeam & getBeam(unsigned int index){ return beams[index]; }
+
+    /**
+    * Returns the magnitudes of a beam
+    *
+    * @param index the beam index, from 0 to getBeamCount() - 1
+    */
+    float * getMagnitudes(unsigned int index){ return magnitudes.data() + beams[index].firstSampleIndex; }
+
+    /**
+    * Returns the phases of a beam, NULL if the ping has none
+    *
+    * @param index the beam index, from 0 to getBeamCount() - 1
+    */
+    float * getPhases(unsigned int index){ return phase ? phases.data() + beams[index].firstSampleIndex : NULL; }
+
+    /**Returns the number of samples of all the beams*/
+    uint64_t getSampleCount(){ return magnitudes.size(); }
+
+    /**Returns the capacity of the sample arrays, in samples*/
+    uint64_t getSampleCapacity(){ return magnitudes.capacity(); }
+
+private:
+
+    /**Ping timestamp*/
+    uint64_t timestamp;
+
+    /**Ping number*/
+    uint32_t pingNumber;
+
+    /**Sample rate, in Hz*/
+    double sampleRate;
+
+    /**Number of the first sample of the ping since transmission*/
+    uint32_t firstSample;
+
+    /**Number of samples between two kept samples*/
+    unsigned int sampleStride;
+
+    /**True if the magnitudes are in dB*/
+    bool decibel;
+
+    /**True if the ping has phases*/
+    bool phase;
+
+    /**Beams of the ping*/
+    std::vector<WaterColumnBeam> beams;
+
+    /**Magnitudes of all the beams, one after the other*/
+    std::vector<float> magnitudes;
+
+    /**Phases of all the beams, one after the other*/
+    std::vector<float> phases;
+};
+
+#endif
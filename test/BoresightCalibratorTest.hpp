@@ -0,0 +1,104 @@
+/*
+ * File:   BoresightCalibratorTest.hpp
+ *
+ * Tests the patch test solver on simulated lines, from the simulated survey lines of DatagramGeoreferencerTest.hpp
+ */
+#include <cmath>
+#include <vector>
+#include <Eigen/Dense>
+#include "../src/georeferencing/BoresightCalibrator.hpp"
+#include "../src/math/Boresight.hpp"
+#include "../src/svp/SoundVelocityProfile.hpp"
+#include "../src/utils/Constants.hpp"
+#include "catch.hpp"
+
+TEST_CASE("Test that the patch test solver recovers the boresight of simulated lines")
+{
+    Eigen::Vector3d leverArm;
+    leverArm << 1.2,-0.4,2.1;
+
+    Attitude trueAngles(0,0.8,-0.6,1.2);
+    Eigen::Matrix3d trueBoresight;
+    Boresight::buildMatrix(trueBoresight,trueAngles);
+
+    SoundVelocityProfile * svp = new SoundVelocityProfile();
+    svp->setTimestamp(1000000000);
+    svp->add(0,1480);
+    svp->add(15000,1480);
+    std::vector<SoundVelocityProfile*> svps(1,svp);
+
+    BoresightCalibrator calibrator(0.5,1,4);
+    Position centroid(0,48.4,-68.5,0);
+    calibrator.getGeoreferencing().setCentroid(centroid);
+
+    //reciprocal lines on the same track, and a parallel line
+    simulateSurveyLine(calibrator.addLine(),calibrator.getGeoreferencing(),0,false,leverArm,trueBoresight);
+    simulateSurveyLine(calibrator.addLine(),calibrator.getGeoreferencing(),0,true,leverArm,trueBoresight);
+    simulateSurveyLine(calibrator.addLine(),calibrator.getGeoreferencing(),40,false,leverArm,trueBoresight);
+
+    double roll = 0;
+    double pitch = 0;
+    double heading = 0;
+    calibrator.calibrate(leverArm,svps,roll,pitch,heading,1.0,0.01);
+
+    REQUIRE(calibrator.getLine(0).getBeamCount() == 120 * 201);
+    REQUIRE(std::fabs(roll - 0.8) < 0.05);
+    REQUIRE(std::fabs(pitch + 0.6) < 0.05);
+    REQUIRE(std::fabs(heading - 1.2) < 0.15);
+
+    //the lines agree at the solution far better than without boresight
+    REQUIRE(calibrator.computeCost(roll,pitch,heading) < calibrator.computeCost(0,0,0) / 10);
+
+    delete svp;
+}
+
+TEST_CASE("Test that rotating the cached beams matches raytracing them again")
+{
+    Eigen::Vector3d leverArm;
+    leverArm << 0.5,0.3,-1.0;
+
+    Attitude trueAngles(0,-1.0,0.5,-2.0);
+    Eigen::Matrix3d trueBoresight;
+    Boresight::buildMatrix(trueBoresight,trueAngles);
+
+    Eigen::Matrix3d identity = Eigen::Matrix3d::Identity();
+
+    SoundVelocityProfile * svp = new SoundVelocityProfile();
+    svp->setTimestamp(1000000000);
+    svp->add(0,1480);
+    svp->add(15000,1480);
+    std::vector<SoundVelocityProfile*> svps(1,svp);
+
+    GeoreferencingLGF georef;
+    Position centroid(0,48.4,-68.5,0);
+    georef.setCentroid(centroid);
+
+    SvpNearestByTime strategy;
+    PatchTestLine line(georef,strategy);
+    simulateSurveyLine(line,georef,0,false,leverArm,trueBoresight);
+
+    //with a constant sound speed, the rays are straight: rotation is exact
+    line.cacheBeams(leverArm,identity,svps);
+
+    std::vector<PatchTestPoint> rotated,raytraced;
+    line.georeferenceBeams(trueBoresight,rotated,2);
+    line.raytraceCache(trueBoresight,2);
+    line.georeferenceBeams(trueBoresight,raytraced,1);
+
+    REQUIRE(rotated.size() == raytraced.size());
+
+    double largest = 0;
+
+    for(unsigned int i=0;i<rotated.size();i++){
+        largest = std::max(largest,std::fabs(rotated[i].x - raytraced[i].x));
+        largest = std::max(largest,std::fabs(rotated[i].y - raytraced[i].y));
+        largest = std::max(largest,std::fabs(rotated[i].z - raytraced[i].z));
+
+        //and the beams land back on the simulated seafloor
+        REQUIRE(std::fabs(raytraced[i].z - simulatedDepth(raytraced[i].x,raytraced[i].y)) < 1e-3);
+    }
+
+    REQUIRE(largest < 1e-6);
+
+    delete svp;
+}
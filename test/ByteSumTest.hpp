@@ -0,0 +1,55 @@
+/*
+ * File:   ByteSumTest.hpp
+ *
+ * Tests the byte sum kernel against a byte at a time sum
+ */
+#include <cstdlib>
+#include <vector>
+#include "../src/utils/ByteSum.hpp"
+#include "catch.hpp"
+
+TEST_CASE("Test that the byte sum matches a byte at a time sum")
+{
+    std::vector<unsigned char> bytes(100000);
+    srand(42);
+
+    for(unsigned int i=0;i<bytes.size();i++){
+        bytes[i] = rand() % 256;
+    }
+
+    //every length and alignment around the vector widths
+    for(unsigned int offset=0;offset<33;offset++){
+        for(unsigned int size=0;size<200;size++){
+            uint32_t expected = 0;
+
+            for(unsigned int i=0;i<size;i++){
+                expected += bytes[offset + i];
+            }
+
+            REQUIRE(ByteSum::sum(&bytes[offset],size) == expected);
+        }
+    }
+
+    uint32_t expected = 0;
+
+    for(unsigned int i=0;i<bytes.size();i++){
+        expected += bytes[i];
+    }
+
+    REQUIRE(ByteSum::sum(&bytes[0],bytes.size()) == expected);
+}
+
+TEST_CASE("Test that the byte sum wraps around like a 32 bit checksum")
+{
+    //2^32 / 255 bytes of 255 overflow 32 bits
+    std::vector<unsigned char> bytes(16843010 + 3,255);
+
+    uint32_t expected = 0;
+
+    for(unsigned int i=0;i<bytes.size();i++){
+        expected += bytes[i];
+    }
+
+    REQUIRE(ByteSum::sum(&bytes[0],bytes.size()) == expected);
+    REQUIRE((uint64_t)bytes.size() * 255 > 0xFFFFFFFFull);
+}
@@ -0,0 +1,111 @@
+/*
+ * File:   ConvexHullTest.hpp
+ *
+ * Tests the parallel Andrew's monotone chain convex hull
+ */
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "../src/geometry/ConvexHull.hpp"
+#include "catch.hpp"
+
+/**2D point with float coordinates, as pcl::PointXYZ*/
+typedef struct{
+    float x;
+    float y;
+} HullTestPoint;
+
+/**Compares the parallel hull with AndrewsConvex_hull on the whole cloud*/
+static void compareWithAndrews(const std::vector<HullTestPoint> & points,unsigned int threadCount){
+    std::vector<PointAndrews> all;
+
+    for(unsigned int i=0;i<points.size();i++){
+        PointAndrews point;
+        point.x = points[i].x;
+        point.y = points[i].y;
+        point.index = i;
+        all.push_back(point);
+    }
+
+    std::vector<PointAndrews> expected;
+    AndrewsConvex_hull(expected,all);
+
+    std::vector<PointAndrews> hull;
+    ConvexHull::computeAndrews(points,hull,threadCount);
+
+    REQUIRE(hull.size() == expected.size());
+
+    for(unsigned int i=0;i<hull.size();i++){
+        REQUIRE(hull[i].x == expected[i].x);
+        REQUIRE(hull[i].y == expected[i].y);
+        REQUIRE(points[hull[i].index].x == hull[i].x);
+        REQUIRE(points[hull[i].index].y == hull[i].y);
+    }
+}
+
+TEST_CASE("Test that the parallel convex hull matches Andrew's monotone chain on a swath")
+{
+    //a swath along a curved track, over several chunks
+    std::vector<HullTestPoint> points;
+    srand(5);
+
+    for(unsigned int i=0;i<2500000;i++){
+        double along = ((double)rand() / RAND_MAX) * 2000;
+        double across = ((double)rand() / RAND_MAX) * 200 - 100;
+        HullTestPoint point = {(float)(along + 0.2 * across),(float)(across + 0.0001 * along * along)};
+        points.push_back(point);
+    }
+
+    compareWithAndrews(points,1);
+    compareWithAndrews(points,4);
+}
+
+TEST_CASE("Test the parallel convex hull with collinear, duplicate and few points")
+{
+    //integer grid: many collinear points on the hull
+    std::vector<HullTestPoint> grid;
+
+    for(int x=0;x<300;x++){
+        for(int y=0;y<200;y++){
+            HullTestPoint point = {(float)x,(float)(y + x / 3)};
+            grid.push_back(point);
+        }
+    }
+
+    compareWithAndrews(grid,3);
+
+    //a triangle filled with points, only 3 hull vertices
+    std::vector<HullTestPoint> triangle;
+
+    for(int x=0;x<100;x++){
+        for(int y=0;y<=x;y++){
+            HullTestPoint point = {(float)x,(float)y};
+            triangle.push_back(point);
+        }
+    }
+
+    compareWithAndrews(triangle,2);
+
+    //up to 3 points are kept as they are
+    std::vector<HullTestPoint> few = {{3,1},{0,0},{1,2}};
+    compareWithAndrews(few,2);
+
+    //NaN points are ignored
+    std::vector<HullTestPoint> withNaN = {{0,0},{NAN,5},{4,0},{4,4},{0,4},{2,2}};
+    std::vector<PointAndrews> hull;
+    ConvexHull::computeAndrews(withNaN,hull);
+
+    REQUIRE(hull.size() == 4);
+
+    for(unsigned int i=0;i<hull.size();i++){
+        REQUIRE(hull[i].index != 1);
+    }
+
+    //including when there are too few points for the parallel pass
+    std::vector<HullTestPoint> fewWithNaN = {{3,1},{NAN,NAN},{1,2}};
+    ConvexHull::computeAndrews(fewWithNaN,hull);
+
+    REQUIRE(hull.size() == 2);
+    REQUIRE(hull[0].index != 1);
+    REQUIRE(hull[1].index != 1);
+}
@@ -20,6 +20,15 @@
 #include <fstream>
 #include "catch.hpp"
 #include "../src/utils/Exception.hpp"
+#include "../src/filter/InsanePositionFilter.hpp"
+#include "../src/filter/QualityFilter.hpp"
+#include "../src/filter/IntensityFilter.hpp"
+#include "../src/filter/FilterChain.hpp"
+#include "../src/filter/GridOutlierFilter.hpp"
+#include "../src/filter/PingQualityFilter.hpp"
+#include "../src/filter/TravelTimeFilter.hpp"
+#include "../src/filter/SwathWidthFilter.hpp"
+#include "../src/filter/DetectionFlagsFilter.hpp"
 using namespace std;
 #ifdef _WIN32
 static string dataBinexec("..\\bin\\data-cleaning.exe");
@@ -259,3 +268,210 @@ TEST_CASE("test with no lines who respect the filters")
     }
     REQUIRE(lineCount==0);
 }
+
+/**Test that the binary record mode gives the same points as the text mode*/
+TEST_CASE("test binary input and output")
+{
+    std::ifstream inFile;
+    inFile.open("test/data/dataCleanTest.dat");
+    REQUIRE(inFile);
+    string input = "cat test/data/dataCleanTest.dat | ./";
+    string param = " -q 8";
+    std::stringstream text = DataSystem_call(std::string(input+dataBinexec+param));
+    std::stringstream binary = DataSystem_call(std::string(input+dataBinexec+param+" -B | ./"+dataBinexec+" -b"));
+    REQUIRE(text.str().size()>0);
+    REQUIRE(binary.str()==text.str());
+}
+
+/**Test that the uncertainties of the points are passed through, in text and binary mode*/
+TEST_CASE("test uncertainty pass-through")
+{
+    string input = "printf '1.000000 2.000000 3.000000 9 10 0.125000 0.250000\\n4.000000 5.000000 6.000000 9 10\\n' | ./";
+    std::stringstream text = DataSystem_call(std::string(input+dataBinexec));
+    std::stringstream binary = DataSystem_call(std::string(input+dataBinexec+" -B | ./"+dataBinexec+" -b"));
+    REQUIRE(text.str()=="1.000000 2.000000 3.000000 9 10 0.125000 0.250000\n4.000000 5.000000 6.000000 9 10\n");
+    REQUIRE(binary.str()==text.str());
+}
+
+/**Test that the batch filters remove the same points as the point by point filters*/
+TEST_CASE("test batch filters")
+{
+    PointBatch batch;
+
+    for(unsigned int i=0;i<130;i++){
+        double x = (i % 7 == 0) ? 2e8 : i;
+        double y = (i % 11 == 0) ? -2e8 : -(double)i;
+        double z = (i % 23 == 0) ? std::nan("") : i * 0.5;
+        int32_t intensity = (i % 5 == 0) ? -1 : (int32_t)(i % 17);
+        batch.add(x,y,z,i % 13,intensity);
+    }
+
+    std::vector<PointFilter*> filters;
+    filters.push_back(new InsanePositionFilter());
+    filters.push_back(new QualityFilter(4));
+    filters.push_back(new IntensityFilter(3));
+
+    for(unsigned int f=0;f<filters.size();f++){
+        uint64_t keepMask[3] = {~(uint64_t)0,0,~(uint64_t)0};
+        filters[f]->filterBatch(batch,keepMask);
+
+        for(unsigned int i=0;i<130;i++){
+            bool expected = (i < 64 || i >= 128) && !filters[f]->filterPoint(0,batch.x[i],batch.y[i],batch.z[i],batch.quality[i],batch.intensity[i]);
+            REQUIRE(FilterChain::isKept(keepMask,i) == expected);
+        }
+
+        delete filters[f];
+    }
+}
+
+/**Test that the filter chain applies every filter and never keeps points past the end of the batch*/
+TEST_CASE("test filter chain")
+{
+    PointBatch batch;
+
+    for(unsigned int i=0;i<100;i++){
+        batch.add(i,i,(i == 50) ? 3e8 : i,i % 10,i % 4);
+    }
+
+    FilterChain chain;
+    chain.addFilter(new InsanePositionFilter());
+    chain.addFilter(new QualityFilter(5));
+    chain.addFilter(new IntensityFilter(2));
+
+    const uint64_t * keepMask = chain.apply(batch);
+
+    for(unsigned int i=0;i<128;i++){
+        bool expected = i < 100 && i != 50 && (i % 10) >= 5 && (i % 4) >= 2;
+        REQUIRE(FilterChain::isKept(keepMask,i) == expected);
+    }
+}
+
+/**Test that the grid outlier filter removes spikes and keeps the surface around them*/
+TEST_CASE("test grid outlier filter")
+{
+    GridOutlierFilter filter(1.0);
+
+    //sloped surface with some noise, straddling tile boundaries and the origin
+    std::vector<Eigen::Vector3d> points;
+    for(int i=-150;i<150;i++){
+        for(int j=-20;j<20;j++){
+            double x = i * 0.5;
+            double y = j * 0.5;
+            points.push_back(Eigen::Vector3d(x,y,10 + 0.01 * x + 0.02 * ((i * 7 + j * 13) % 5)));
+        }
+    }
+
+    //spikes, one of them right on a tile boundary
+    points.push_back(Eigen::Vector3d(12.25,3.25,25));
+    points.push_back(Eigen::Vector3d(-64.0,-0.25,2));
+    points.push_back(Eigen::Vector3d(63.9,0.1,-5));
+
+    for(unsigned int i=0;i<points.size();i++){
+        filter.accumulate(points[i](0),points[i](1),points[i](2));
+    }
+
+    filter.reduce(3);
+
+    unsigned int rejected = 0;
+    for(unsigned int i=0;i<points.size()-3;i++){
+        if(filter.filterPoint(0,points[i](0),points[i](1),points[i](2),0,0)){
+            rejected++;
+        }
+    }
+
+    REQUIRE(rejected == 0);
+
+    for(unsigned int i=points.size()-3;i<points.size();i++){
+        REQUIRE(filter.filterPoint(0,points[i](0),points[i](1),points[i](2),0,0));
+    }
+
+    //points outside the grid can't be judged
+    REQUIRE(filter.filterPoint(0,1000,1000,1000,0,0) == false);
+
+    //soundings accumulated after a reduction join those already reduced
+    GridOutlierFilter twoPasses(1.0);
+
+    for(unsigned int i=0;i<points.size();i+=2){
+        twoPasses.accumulate(points[i](0),points[i](1),points[i](2));
+    }
+
+    twoPasses.reduce(2);
+
+    for(unsigned int i=1;i<points.size();i+=2){
+        twoPasses.accumulate(points[i](0),points[i](1),points[i](2));
+    }
+
+    twoPasses.reduce(2);
+
+    for(unsigned int i=0;i<points.size();i++){
+        REQUIRE(twoPasses.filterPoint(0,points[i](0),points[i](1),points[i](2),0,0) == filter.filterPoint(0,points[i](0),points[i](1),points[i](2),0,0));
+    }
+}
+
+/**Test the grid outlier filter from the command line*/
+TEST_CASE("test with the grid filter parameter")
+{
+    string output = "cat test/data/dataCleanTest.dat | ./";
+    std::stringstream plain = DataSystem_call(std::string(output+dataBinexec));
+    std::stringstream grid = DataSystem_call(std::string(output+dataBinexec+" -g 1 -k 3"));
+    REQUIRE(grid.str().size()>0);
+    REQUIRE(grid.str()==plain.str());
+
+    //gently sloped seabed of 2 x 2 meters with a spike in its middle
+    std::string seabedFile("build/test/gridOutlierTest.dat");
+    std::ofstream seabed(seabedFile.c_str());
+    std::string expected;
+    char record[128];
+
+    for(int i=0;i<20;i++){
+        for(int j=0;j<20;j++){
+            double x = i * 0.1;
+            double y = j * 0.1;
+            double z = 10 + 0.01 * i;
+            seabed << x << " " << y << " " << z << " 1 2" << std::endl;
+
+            snprintf(record,sizeof(record),"%f %f %f 1 2\n",x,y,z);
+            expected += record;
+        }
+    }
+
+    seabed << "1.05 1.05 30 3 4" << std::endl;
+    seabed.close();
+
+    std::stringstream spiked = DataSystem_call(std::string("cat "+seabedFile+" | ./"+dataBinexec));
+    REQUIRE(spiked.str()==expected+"1.050000 1.050000 30.000000 3 4\n");
+
+    std::stringstream cleaned = DataSystem_call(std::string("cat "+seabedFile+" | ./"+dataBinexec+" -g 1 -k 3"));
+    REQUIRE(cleaned.str()==expected);
+
+    std::stringstream ss = DataSystem_call(std::string(output+dataBinexec+" -g abc 2>&1"));
+    string line;
+    getline(ss,line);
+    REQUIRE(line=="Error: -g invalid cell size parameter");
+}
+
+/**Test the filters applied to pings before georeferencing*/
+TEST_CASE("test ping filters")
+{
+    //Ping(microEpoch, id, quality, intensity, surfaceSoundSpeed, twoWayTravelTime, alongTrackAngle, acrossTrackAngle)
+    Ping good(0,1,3,50,1500,0.05,0,30);
+    Ping lowQuality(0,2,1,50,1500,0.05,0,30);
+    Ping noDetection(0,3,3,50,1500,0,0,30);
+    Ping outerBeam(0,4,3,50,1500,0.05,0,-65);
+
+    PingQualityFilter quality(2);
+    REQUIRE(!quality.filterPing(good));
+    REQUIRE(quality.filterPing(lowQuality));
+
+    TravelTimeFilter travelTime;
+    REQUIRE(!travelTime.filterPing(good));
+    REQUIRE(travelTime.filterPing(noDetection));
+
+    SwathWidthFilter swath(120);
+    REQUIRE(!swath.filterPing(good));
+    REQUIRE(swath.filterPing(outerBeam));
+
+    DetectionFlagsFilter flags(0x3);
+    REQUIRE(!flags.filterPing(good));
+    REQUIRE(flags.filterPing(lowQuality));
+}
@@ -0,0 +1,162 @@
+/*
+ * File:   DatagramGeoreferencerTest.hpp
+ *
+ * Tests the datagram georeferencer on simulated survey lines
+ */
+#include <cmath>
+#include <vector>
+#include <Eigen/Dense>
+#include "../src/georeferencing/DatagramGeoreferencer.hpp"
+#include "../src/georeferencing/Georeferencing.hpp"
+#include "../src/svp/SvpNearestByTime.hpp"
+#include "../src/svp/SoundVelocityProfile.hpp"
+#include "../src/math/Boresight.hpp"
+#include "../src/math/CoordinateTransform.hpp"
+#include "../src/utils/Constants.hpp"
+#include "catch.hpp"
+
+/**Depth of the simulated seafloor, in the local geographic frame*/
+double simulatedDepth(double north,double east){
+    return 30 + 0.25 * north + 1.0 * sin(east / 9) * cos(north / 13);
+}
+
+/**
+ * Simulates a line surveyed northward or southward along an easting, with a constant sound speed of 1480 m/s
+ *
+ * @param line the georeferencer receiving the datagrams
+ * @param georef the local geographic frame, its centroid set
+ * @param east easting of the line
+ * @param southward true to survey the line southward
+ * @param leverArm the lever arm
+ * @param boresight the boresight of the simulated sonar
+ */
+void simulateSurveyLine(DatagramGeoreferencer & line,GeoreferencingLGF & georef,double east,bool southward,Eigen::Vector3d & leverArm,Eigen::Matrix3d & boresight){
+    Position * centroid = georef.getCentroid();
+    uint64_t start = 1000000000;
+    unsigned int swathCount = 120;
+
+    line.processSwathStart(1480);
+
+    for(unsigned int s=0;s<=swathCount;s++){
+        uint64_t timestamp = start + s * 500000;
+        double north = southward ? 60.0 - s : -60.0 + s;
+
+        //roughly on the centroid's tangent plane; the exact position in the frame is computed below
+        Position position(timestamp,centroid->getLatitude() + north / 6371000 * R2D,centroid->getLongitude() + east / (6371000 * cos(centroid->getLatitude() * D2R)) * R2D,0);
+        Attitude attitude(timestamp,1.5 * sin(s / 7.0),0.8 * cos(s / 11.0),southward ? 180 : 0);
+
+        line.processPosition(timestamp,position.getLongitude(),position.getLatitude(),0);
+        line.processAttitude(timestamp,attitude.getHeading(),attitude.getPitch(),attitude.getRoll());
+
+        if(s == swathCount){
+            break;
+        }
+
+        Eigen::Vector3d origin;
+        georef.getPositionNED(origin,position);
+
+        Eigen::Matrix3d imu2ned;
+        CoordinateTransform::getDCM(imu2ned,attitude);
+        origin += imu2ned * leverArm;
+
+        for(int beam=-100;beam<=100;beam++){
+            double beamAngle = beam * 0.6;
+            Eigen::Vector3d launch;
+            CoordinateTransform::sonar2cartesian(launch,0,beamAngle,1.0);
+            launch = imu2ned * (boresight * launch);
+
+            //range to the seafloor along the straight ray
+            double low = 0;
+            double high = 500;
+
+            for(unsigned int i=0;i<40;i++){
+                double range = (low + high) / 2;
+                Eigen::Vector3d point = origin + range * launch;
+
+                if(point(2) < simulatedDepth(point(0),point(1))){
+                    low = range;
+                }
+                else{
+                    high = range;
+                }
+            }
+
+            line.processPing(timestamp,beam,beamAngle,0,2 * low / 1480,0,0);
+        }
+    }
+}
+
+/**Keeps the georeferenced pings instead of writing them*/
+class CapturingGeoreferencer : public DatagramGeoreferencer{
+public:
+    CapturingGeoreferencer(Georeferencing & geo,SvpSelectionStrategy & svpStrat) : DatagramGeoreferencer(geo,svpStrat){}
+
+    void processGeoreferencedPing(Eigen::Vector3d & georeferencedPing,uint32_t quality,int32_t intensity,double horizontalUncertainty,double verticalUncertainty,int positionIndex,int attitudeIndex){
+        points.push_back(georeferencedPing);
+    }
+
+    std::vector<Eigen::Vector3d> points;
+};
+
+TEST_CASE("Test that re-georeferencing from the beam cache matches a full georeferencing")
+{
+    Eigen::Vector3d leverArm;
+    leverArm << 0.5,0.3,-1.0;
+
+    Eigen::Vector3d otherLeverArm;
+    otherLeverArm << -2.0,1.5,0.7;
+
+    Attitude angles(0,0.4,-0.2,0.9);
+    Eigen::Matrix3d boresight;
+    Boresight::buildMatrix(boresight,angles);
+
+    Attitude otherAngles(0,-1.1,0.6,-1.5);
+    Eigen::Matrix3d otherBoresight;
+    Boresight::buildMatrix(otherBoresight,otherAngles);
+
+    SoundVelocityProfile * svp = new SoundVelocityProfile();
+    svp->setTimestamp(1000000000);
+    svp->add(0,1480);
+    svp->add(15000,1480);
+    std::vector<SoundVelocityProfile*> svps(1,svp);
+
+    GeoreferencingLGF georef;
+    Position centroid(0,48.4,-68.5,0);
+    georef.setCentroid(centroid);
+
+    SvpNearestByTime cachedStrategy,strategy,otherStrategy;
+    CapturingGeoreferencer cached(georef,cachedStrategy);
+    CapturingGeoreferencer reference(georef,strategy);
+    CapturingGeoreferencer otherReference(georef,otherStrategy);
+
+    simulateSurveyLine(cached,georef,0,false,leverArm,boresight);
+    simulateSurveyLine(reference,georef,0,false,leverArm,boresight);
+    simulateSurveyLine(otherReference,georef,0,false,leverArm,boresight);
+
+    //regeoreferencing needs the cache
+    REQUIRE_THROWS(cached.regeoreference(otherLeverArm,otherBoresight));
+
+    cached.setBeamCache(true);
+    cached.georeference(leverArm,boresight,svps);
+    reference.georeference(leverArm,boresight,svps);
+    otherReference.georeference(otherLeverArm,otherBoresight,svps);
+
+    REQUIRE(cached.points.size() == 120 * 201);
+    REQUIRE(reference.points.size() == cached.points.size());
+
+    for(unsigned int i=0;i<cached.points.size();i++){
+        REQUIRE((cached.points[i] - reference.points[i]).norm() < 1e-6);
+    }
+
+    //another lever arm and boresight, without raytracing
+    cached.points.clear();
+    cached.regeoreference(otherLeverArm,otherBoresight);
+
+    REQUIRE(cached.points.size() == otherReference.points.size());
+
+    for(unsigned int i=0;i<cached.points.size();i++){
+        REQUIRE((cached.points[i] - otherReference.points[i]).norm() < 1e-6);
+    }
+
+    delete svp;
+}
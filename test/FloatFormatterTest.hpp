@@ -0,0 +1,132 @@
+/*
+ * File:   FloatFormatterTest.hpp
+ *
+ * Tests that the float formatter matches printf
+ */
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include "../src/utils/FloatFormatter.hpp"
+#include "../src/utils/TextOutputBuffer.hpp"
+#include "catch.hpp"
+
+/**Values on which the fast paths are most likely to go wrong*/
+static std::vector<double> floatFormatterEdgeCases(){
+    std::vector<double> values = {
+        0.0, -0.0, 0.5, -0.5, 1.5, 2.5, 0.125, 0.0000005, -0.0000005, 0.0000015, 1e-7, -1e-7,
+        0.1, 0.2, 0.3, 1.0, 9.9999995, 99.9999995, 999999.9999995, 0.00001, 0.0001, 0.00099999999995,
+        1e-5, 9.99999999995e-5, 123456789.123456789, 4503599627.370496, 4503599627370495.5, 1e15, 1e16,
+        1e22, 1e300, -1e300, 5e-324, 2.2250738585072014e-308, 1234.5678901234567,
+        -46.8142336100, -71.2027722200, 1499.123456, 0.0123456789015
+    };
+
+    values.push_back(std::numeric_limits<double>::infinity());
+    values.push_back(-std::numeric_limits<double>::infinity());
+    values.push_back(std::numeric_limits<double>::quiet_NaN());
+    values.push_back(std::numeric_limits<double>::max());
+
+    return values;
+}
+
+/**Deterministic pseudo-random values spread over many magnitudes*/
+static std::vector<double> floatFormatterRandomValues(){
+    std::vector<double> values;
+    uint64_t state = 88172645463325252ULL;
+
+    for(unsigned int i = 0; i < 20000; i++){
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        double mantissa = (double)(state >> 11) / 9007199254740992.0;
+        int exponent = (int)(state % 24) - 8;
+
+        values.push_back(((state & 1) ? -1 : 1) * mantissa * std::pow(10.0, exponent));
+    }
+
+    return values;
+}
+
+TEST_CASE("Test the float formatter fixed precision against printf")
+{
+    std::vector<double> values = floatFormatterEdgeCases();
+    std::vector<double> random = floatFormatterRandomValues();
+    values.insert(values.end(), random.begin(), random.end());
+
+    char expected[FloatFormatter::MAX_LENGTH];
+    char actual[FloatFormatter::MAX_LENGTH];
+
+    for(unsigned int precision = 0; precision <= 12; precision++){
+        for(unsigned int i = 0; i < values.size(); i++){
+            int expectedLength = snprintf(expected, sizeof(expected), "%.*f", (int)precision, values[i]);
+            unsigned int actualLength = FloatFormatter::formatFixed(actual, values[i], precision);
+
+            INFO("precision " << precision << " expected " << expected);
+            REQUIRE(std::string(actual) == std::string(expected));
+            REQUIRE(actualLength == (unsigned int)expectedLength);
+        }
+    }
+}
+
+TEST_CASE("Test the float formatter significant digits against printf")
+{
+    std::vector<double> values = floatFormatterEdgeCases();
+    std::vector<double> random = floatFormatterRandomValues();
+    values.insert(values.end(), random.begin(), random.end());
+
+    char expected[FloatFormatter::MAX_LENGTH];
+    char actual[FloatFormatter::MAX_LENGTH];
+
+    for(unsigned int precision = 1; precision <= 17; precision++){
+        for(unsigned int i = 0; i < values.size(); i++){
+            int expectedLength = snprintf(expected, sizeof(expected), "%.*g", (int)precision, values[i]);
+            unsigned int actualLength = FloatFormatter::formatGeneral(actual, values[i], precision);
+
+            INFO("precision " << precision << " expected " << expected);
+            REQUIRE(std::string(actual) == std::string(expected));
+            REQUIRE(actualLength == (unsigned int)expectedLength);
+        }
+    }
+}
+
+TEST_CASE("Test the float formatter shortest round trip")
+{
+    char text[FloatFormatter::MAX_LENGTH];
+
+    FloatFormatter::formatShortest(text, 0.1);
+    REQUIRE(std::string(text) == "0.1");
+
+    FloatFormatter::formatShortest(text, 0.1 + 0.2);
+    REQUIRE(std::string(text) == "0.30000000000000004");
+
+    std::vector<double> values = floatFormatterRandomValues();
+
+    for(unsigned int i = 0; i < values.size(); i++){
+        FloatFormatter::formatShortest(text, values[i]);
+        REQUIRE(strtod(text, NULL) == values[i]);
+    }
+}
+
+TEST_CASE("Test the text output buffer")
+{
+    TextOutputBuffer line(NULL, 16);
+
+    for(unsigned int i = 0; i < 100; i++){
+        line.appendFixed(-1.25, 3);
+        line.appendChar(' ');
+        line.appendInteger(-42);
+        line.appendChar(' ');
+        line.appendUnsigned(4294967295U);
+        line.appendString("\n");
+    }
+
+    std::string text(line.data(), line.size());
+    REQUIRE(text.size() == 100 * strlen("-1.250 -42 4294967295\n"));
+    REQUIRE(text.substr(0, 22) == "-1.250 -42 4294967295\n");
+
+    line.clear();
+    REQUIRE(line.size() == 0);
+}
@@ -0,0 +1,121 @@
+/*
+ * File:   HypothesisSurfaceTest.hpp
+ *
+ * Tests the multiple hypothesis surface
+ */
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <Eigen/Dense>
+#include "../src/gridding/HypothesisSurface.hpp"
+#include "../src/math/TotalPropagatedUncertainty.hpp"
+#include "../src/georeferencing/DatagramGeoreferencerToSurface.hpp"
+#include "../src/datagrams/xtf/XtfParser.hpp"
+#include "../src/svp/SvpNearestByTime.hpp"
+#include "../src/svp/CarisSvpFile.hpp"
+#include "catch.hpp"
+
+/**Soundings on a flat seabed, with a cluster of blunders around one node*/
+static std::vector<UncertainSounding> makeSurfaceSoundings(unsigned int count,unsigned int seed){
+    std::vector<UncertainSounding> soundings;
+    srand(seed);
+
+    for(unsigned int i=0;i<count;i++){
+        UncertainSounding sounding;
+        sounding.easting = ((double)rand() / RAND_MAX) * 150 - 50;
+        sounding.northing = ((double)rand() / RAND_MAX) * 80 - 10;
+        sounding.depth = 20 + (((double)rand() / RAND_MAX) - 0.5) * 0.1;
+        sounding.horizontalVariance = 0.01;
+        sounding.verticalVariance = 0.0025;
+        soundings.push_back(sounding);
+    }
+
+    for(unsigned int i=0;i<5;i++){
+        UncertainSounding blunder = {10.0,10.0,12.0,0.01,0.0025};
+        soundings.push_back(blunder);
+    }
+
+    return soundings;
+}
+
+TEST_CASE("Test that the hypothesis surface keeps the seabed and sets blunders aside")
+{
+    std::vector<UncertainSounding> soundings = makeSurfaceSoundings(60000,1);
+
+    HypothesisSurface surface(1.0);
+    surface.addSoundings(&soundings[0],soundings.size());
+
+    //negative and positive node indexes, on several tiles
+    REQUIRE(surface.getTileCount() == 9);
+
+    NodeEstimate node = surface.getNode(5.2,4.9);
+    REQUIRE(node.hypothesisCount == 1);
+    REQUIRE(std::fabs(node.depth - 20) < 0.05);
+    REQUIRE(node.uncertainty > 0);
+    REQUIRE(node.uncertainty < 0.1);
+
+    //the blunders start their own hypothesis, which is not retained
+    NodeEstimate blunderNode = surface.getNode(10,10);
+    REQUIRE(blunderNode.hypothesisCount == 2);
+    REQUIRE(std::fabs(blunderNode.depth - 20) < 0.05);
+
+    std::vector<DepthHypothesis> hypotheses = surface.getNodeHypotheses(10,10);
+    REQUIRE(hypotheses.size() == 2);
+    REQUIRE((hypotheses[0].mean == 12.0 || hypotheses[1].mean == 12.0));
+
+    REQUIRE(surface.getNode(1000,1000).soundingCount == 0);
+    REQUIRE(HypothesisSurface::getLayer(surface.getNode(1000,1000),SURFACE_DEPTH) == GRID_NODATA);
+}
+
+TEST_CASE("Test that the hypothesis surface does not depend on the number of threads or batches")
+{
+    std::vector<UncertainSounding> soundings = makeSurfaceSoundings(20000,2);
+
+    HypothesisSurface single(1.0,0.05,0,3.0,2.0,1);
+    single.addSoundings(&soundings[0],soundings.size());
+
+    HypothesisSurface parallel(1.0,0.05,0,3.0,2.0,4);
+    parallel.addSoundings(&soundings[0],10000);
+    parallel.addSoundings(&soundings[10000],soundings.size() - 10000);
+
+    for(double northing=-10;northing<=70;northing+=3.7){
+        for(double easting=-50;easting<=100;easting+=4.3){
+            NodeEstimate a = single.getNode(easting,northing);
+            NodeEstimate b = parallel.getNode(easting,northing);
+
+            REQUIRE(a.soundingCount == b.soundingCount);
+            REQUIRE(a.hypothesisCount == b.hypothesisCount);
+
+            if(a.soundingCount > 0){
+                REQUIRE(a.depth == b.depth);
+                REQUIRE(a.uncertainty == b.uncertainty);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test the hypothesis surface fed by the georeferencer")
+{
+    GeoreferencingLGF georef;
+    SvpNearestByTime svpStrategy;
+    HypothesisSurface surface(1.0);
+    TotalPropagatedUncertainty uncertainty(0.1,0.15,0.05,0.05,0.05,0.5);
+    DatagramGeoreferencerToSurface georeferencer(georef,svpStrategy,surface,uncertainty);
+
+    XtfParser parser(georeferencer);
+    std::string file("test/data/xtf/0009 - 150708_R2Testing - 0001.xtf");
+    parser.parse(file);
+
+    Eigen::Vector3d leverArm(0,0,0);
+    Eigen::Matrix3d boresight = Eigen::Matrix3d::Identity();
+    CarisSvpFile svps;
+    std::string svpFile("test/data/rayTracingTestData/SVP-0.svp");
+    REQUIRE(svps.readSvpFile(svpFile));
+    georeferencer.georeference(leverArm,boresight,svps.getSvps());
+
+    REQUIRE(surface.getTileCount() > 0);
+
+    GeoreferencingTRF trf;
+    REQUIRE_THROWS(DatagramGeoreferencerToSurface(trf,svpStrategy,surface,uncertainty));
+}
@@ -13,6 +13,19 @@
 #include "catch.hpp"
 #include "../src/datagrams/DatagramEventHandler.hpp"
 #include "../src/datagrams/kongsberg/KongsbergParser.hpp"
+#include "../src/datagrams/DatagramParserFactory.hpp"
+#include "../src/georeferencing/DatagramGeoreferencer.hpp"
+#include "../src/georeferencing/Georeferencing.hpp"
+#include "../src/svp/SvpNearestByTime.hpp"
+#include "../src/math/Boresight.hpp"
+#include "../src/math/CoordinateTransform.hpp"
+#include "../src/utils/Constants.hpp"
+#include <Eigen/Dense>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <limits>
 
 TEST_CASE("test the function KongsbergParser::getName")
 {
@@ -105,3 +118,648 @@ TEST_CASE ("test the Kongsberg parser with a valid datagram")
         REQUIRE(false);
     }
 }
+
+/**
+ * Appends a datagram to an in-memory .all file, with its header, ETX and checksum
+ *
+ * @param file the file
+ * @param type the datagram type
+ * @param data the datagram content, after the header
+ * @param size the size of the content
+ * @param counter the datagram counter
+ */
+void appendKongsbergDatagram(std::vector<unsigned char> & file,unsigned char type,const void * data,uint32_t size,uint16_t counter = 0){
+    KongsbergHeader hdr;
+    memset(&hdr,0,sizeof(KongsbergHeader));
+    hdr.size = sizeof(KongsbergHeader) - sizeof(uint32_t) + size + 3;
+    hdr.stx = STX;
+    hdr.type = type;
+    hdr.modelNumber = 2040;
+    hdr.date = 20190430;
+    hdr.time = 45000000;
+    hdr.counter = counter;
+    hdr.serialNumber = 101;
+
+    size_t start = file.size();
+    file.resize(start + sizeof(KongsbergHeader) + size + 3);
+    memcpy(&file[start],&hdr,sizeof(KongsbergHeader));
+    memcpy(&file[start + sizeof(KongsbergHeader)],data,size);
+
+    //checksum of the bytes between STX and ETX
+    uint16_t checksum = 0;
+
+    for(size_t i = start + 5;i < start + sizeof(KongsbergHeader) + size;i++){
+        checksum += file[i];
+    }
+
+    file[start + sizeof(KongsbergHeader) + size] = ETX;
+    memcpy(&file[start + sizeof(KongsbergHeader) + size + 1],&checksum,sizeof(uint16_t));
+}
+
+/**
+ * Writes an in-memory .all file
+ *
+ * @param filename the file name
+ * @param file the file
+ */
+void writeKongsbergFile(std::string & filename,std::vector<unsigned char> & file){
+    FILE * out = fopen(filename.c_str(),"wb");
+    REQUIRE(out != NULL);
+    fwrite(&file[0],1,file.size(),out);
+    fclose(out);
+}
+
+/**Keeps the swaths and soundings decoded by a parser*/
+class KongsbergTestHandler : public DatagramEventHandler{
+public:
+    void processSwathStart(double surfaceSoundSpeed){
+        swathSoundSpeeds.push_back(surfaceSoundSpeed);
+    }
+
+    void processPing(uint64_t microEpoch,long id,double beamAngle,double tiltAngle,double twoWayTravelTime,uint32_t quality,int32_t intensity){
+        beamAngles.push_back(beamAngle);
+        tiltAngles.push_back(tiltAngle);
+        twoWayTravelTimes.push_back(twoWayTravelTime);
+    }
+
+    void processBeamXYZ(uint64_t microEpoch,long id,double alongTrack,double acrossTrack,double depth,uint32_t quality,int32_t intensity){
+        timestamps.push_back(microEpoch);
+        ids.push_back(id);
+        alongTracks.push_back(alongTrack);
+        acrossTracks.push_back(acrossTrack);
+        depths.push_back(depth);
+        qualities.push_back(quality);
+        intensities.push_back(intensity);
+    }
+
+    std::vector<double> swathSoundSpeeds;
+    std::vector<uint64_t> timestamps;
+    std::vector<long> ids;
+    std::vector<double> alongTracks;
+    std::vector<double> acrossTracks;
+    std::vector<double> depths;
+    std::vector<uint32_t> qualities;
+    std::vector<int32_t> intensities;
+    std::vector<double> beamAngles;
+    std::vector<double> tiltAngles;
+    std::vector<double> twoWayTravelTimes;
+};
+
+TEST_CASE ("test the Kongsberg parser with XYZ 88 datagrams")
+{
+    std::vector<unsigned char> data(sizeof(KongsbergXYZ88) + 4 * sizeof(KongsbergXYZ88Entry) + 1,0);
+
+    KongsbergXYZ88 * xyz = (KongsbergXYZ88*)&data[0];
+    xyz->heading = 9000;
+    xyz->soundSpeed = 14825;
+    xyz->nbBeams = 4;
+    xyz->nbValidDetections = 3;
+
+    KongsbergXYZ88Entry * beams = (KongsbergXYZ88Entry*)&data[sizeof(KongsbergXYZ88)];
+
+    for(unsigned int i=0;i<4;i++){
+        beams[i].depth = 20 + i;
+        beams[i].acrossTrack = -15 + 10.0 * i;
+        beams[i].alongTrack = 0.25 * i;
+        beams[i].qualityFactor = 10 + i;
+        beams[i].reflectivity = -200 - 10 * i;
+    }
+
+    //invalid detection
+    beams[2].detectionInfo = 0x80;
+
+    std::vector<unsigned char> file;
+    appendKongsbergDatagram(file,'X',&data[0],data.size());
+
+    std::string filename("KongsbergParserTestXYZ88.all");
+    writeKongsbergFile(filename,file);
+
+    KongsbergTestHandler handler;
+    KongsbergParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.swathSoundSpeeds.size() == 1);
+    REQUIRE(handler.swathSoundSpeeds[0] == 1482.5);
+
+    REQUIRE(handler.ids.size() == 3);
+    REQUIRE(handler.ids[0] == 0);
+    REQUIRE(handler.ids[1] == 1);
+    REQUIRE(handler.ids[2] == 3);
+
+    for(unsigned int k=0;k<3;k++){
+        unsigned int i = handler.ids[k];
+        REQUIRE(handler.timestamps[k] == handler.timestamps[0]);
+        REQUIRE(handler.depths[k] == 20 + i);
+        REQUIRE(handler.acrossTracks[k] == -15 + 10.0 * i);
+        REQUIRE(handler.alongTracks[k] == 0.25 * i);
+        REQUIRE(handler.qualities[k] == 10 + i);
+        REQUIRE(handler.intensities[k] == (int32_t)((-200 - 10.0 * i) * 0.5));
+    }
+
+    //more beams than the datagram holds
+    xyz->nbBeams = 5;
+    file.clear();
+    appendKongsbergDatagram(file,'X',&data[0],data.size());
+    writeKongsbergFile(filename,file);
+
+    KongsbergTestHandler truncatedHandler;
+    KongsbergParser truncatedParser(truncatedHandler);
+    REQUIRE_THROWS_AS(truncatedParser.parse(filename),Exception*);
+    remove(filename.c_str());
+    REQUIRE(truncatedHandler.ids.empty());
+}
+
+/**Keeps the georeferenced soundings*/
+class XYZ88CapturingGeoreferencer : public DatagramGeoreferencer{
+public:
+    XYZ88CapturingGeoreferencer(Georeferencing & geo,SvpSelectionStrategy & svpStrat) : DatagramGeoreferencer(geo,svpStrat){}
+
+    void processGeoreferencedPing(Eigen::Vector3d & georeferencedPing,uint32_t quality,int32_t intensity,double horizontalUncertainty,double verticalUncertainty,int positionIndex,int attitudeIndex){
+        points.push_back(georeferencedPing);
+    }
+
+    std::vector<Eigen::Vector3d> points;
+};
+
+/**
+ * Receives simulated pings as the XYZ 88 soundings a sonar would compute from them, along the heading: along and
+ * across track from the vessel reference point, depth from the transducer
+ */
+class XYZ88SonarGeoreferencer : public XYZ88CapturingGeoreferencer{
+public:
+    XYZ88SonarGeoreferencer(Georeferencing & geo,SvpSelectionStrategy & svpStrat,const Eigen::Vector3d & leverArm) : XYZ88CapturingGeoreferencer(geo,svpStrat),attitude(0,0,0,0),leverArm(leverArm){
+        setBeamXYZ(true);
+    }
+
+    void processAttitude(uint64_t microEpoch,double heading,double pitch,double roll){
+        XYZ88CapturingGeoreferencer::processAttitude(microEpoch,heading,pitch,roll);
+        attitude = Attitude(microEpoch,roll,pitch,heading);
+    }
+
+    void processPing(uint64_t microEpoch,long id,double beamAngle,double tiltAngle,double twoWayTravelTime,uint32_t quality,int32_t intensity){
+        Eigen::Vector3d beam;
+        CoordinateTransform::sonar2cartesian(beam,tiltAngle,beamAngle,twoWayTravelTime * currentSurfaceSoundSpeed / 2);
+
+        Eigen::Matrix3d imu2ned,heading2ned;
+        CoordinateTransform::getDCM(imu2ned,attitude);
+        Attitude heading(0,0,0,attitude.getHeading());
+        CoordinateTransform::getDCM(heading2ned,heading);
+
+        Eigen::Vector3d horizontalLeverArm = imu2ned * leverArm;
+        horizontalLeverArm(2) = 0;
+
+        Eigen::Vector3d xyz = heading2ned.transpose() * (horizontalLeverArm + imu2ned * beam);
+        processBeamXYZ(microEpoch,id,xyz(0),xyz(1),xyz(2),quality,intensity);
+    }
+
+    Attitude attitude;
+    Eigen::Vector3d leverArm;
+};
+
+/**
+ * Simulates a line surveyed southward over a flat seafloor 30 m deep, with a constant sound speed of 1480 m/s
+ *
+ * @param line the georeferencer receiving the datagrams
+ * @param georef the local geographic frame, its centroid set
+ * @param leverArm the lever arm
+ */
+void simulateXYZ88Line(DatagramGeoreferencer & line,GeoreferencingLGF & georef,Eigen::Vector3d & leverArm){
+    Position * centroid = georef.getCentroid();
+    uint64_t start = 1000000000;
+    unsigned int swathCount = 120;
+
+    line.processSwathStart(1480);
+
+    for(unsigned int s=0;s<=swathCount;s++){
+        uint64_t timestamp = start + s * 500000;
+        double north = 60.0 - s;
+
+        Position position(timestamp,centroid->getLatitude() + north / 6371000 * R2D,centroid->getLongitude(),0);
+        Attitude attitude(timestamp,1.5 * sin(s / 7.0),0.8 * cos(s / 11.0),180);
+
+        line.processPosition(timestamp,position.getLongitude(),position.getLatitude(),0);
+        line.processAttitude(timestamp,attitude.getHeading(),attitude.getPitch(),attitude.getRoll());
+
+        if(s == swathCount){
+            break;
+        }
+
+        Eigen::Vector3d origin;
+        georef.getPositionNED(origin,position);
+
+        Eigen::Matrix3d imu2ned;
+        CoordinateTransform::getDCM(imu2ned,attitude);
+        origin += imu2ned * leverArm;
+
+        for(int beam=-100;beam<=100;beam++){
+            double beamAngle = beam * 0.6;
+            Eigen::Vector3d launch;
+            CoordinateTransform::sonar2cartesian(launch,0,beamAngle,1.0);
+            launch = imu2ned * launch;
+
+            double range = (30 - origin(2)) / launch(2);
+            line.processPing(timestamp,beam,beamAngle,0,2 * range / 1480,0,0);
+        }
+    }
+}
+
+/**
+ * Returns the largest distance from a point to the nearest point of the same swath in another georeferencing, the order
+ * of the pings of a swath depending on how they were sorted
+ *
+ * @param points the points
+ * @param otherPoints the other points
+ * @param swathSize number of points per swath
+ */
+double largestSwathMismatch(std::vector<Eigen::Vector3d> & points,std::vector<Eigen::Vector3d> & otherPoints,unsigned int swathSize){
+    if(points.size() != otherPoints.size()){
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double largest = 0;
+
+    for(unsigned int i=0;i<points.size();i++){
+        unsigned int first = i - i % swathSize;
+        double nearest = std::numeric_limits<double>::infinity();
+
+        for(unsigned int j=first;j<first + swathSize && j<otherPoints.size();j++){
+            nearest = std::min(nearest,(points[i] - otherPoints[j]).norm());
+        }
+
+        largest = std::max(largest,nearest);
+    }
+
+    return largest;
+}
+
+TEST_CASE ("test that georeferencing the XYZ 88 soundings of the sonar matches raytracing the pings")
+{
+    Eigen::Vector3d leverArm;
+    leverArm << 0.5,0.3,-1.0;
+
+    Eigen::Vector3d otherLeverArm;
+    otherLeverArm << -2.0,1.5,0.7;
+
+    //the sonar soundings are already corrected for its mounting
+    Eigen::Matrix3d identity = Eigen::Matrix3d::Identity();
+
+    SoundVelocityProfile * svp = new SoundVelocityProfile();
+    svp->setTimestamp(1000000000);
+    svp->add(0,1480);
+    svp->add(15000,1480);
+    std::vector<SoundVelocityProfile*> svps(1,svp);
+
+    GeoreferencingLGF georef;
+    Position centroid(0,48.4,-68.5,0);
+    georef.setCentroid(centroid);
+
+    SvpNearestByTime sonarStrategy,strategy,otherStrategy;
+    XYZ88SonarGeoreferencer sonar(georef,sonarStrategy,leverArm);
+    XYZ88CapturingGeoreferencer reference(georef,strategy);
+    XYZ88SonarGeoreferencer otherSonar(georef,otherStrategy,leverArm);
+
+    simulateXYZ88Line(sonar,georef,leverArm);
+    simulateXYZ88Line(reference,georef,leverArm);
+    simulateXYZ88Line(otherSonar,georef,leverArm);
+
+    //a boresight is ignored
+    Attitude angles(0,0.4,-0.2,0.9);
+    Eigen::Matrix3d boresight;
+    Boresight::buildMatrix(boresight,angles);
+
+    sonar.setBeamCache(true);
+    sonar.georeference(leverArm,boresight,svps);
+    reference.georeference(leverArm,identity,svps);
+    otherSonar.georeference(otherLeverArm,identity,svps);
+
+    REQUIRE(sonar.points.size() == 120 * 201);
+    REQUIRE(largestSwathMismatch(sonar.points,reference.points,201) < 1e-6);
+
+    //another lever arm, from the soundings kept
+    sonar.points.clear();
+    sonar.regeoreference(otherLeverArm,identity);
+
+    REQUIRE(largestSwathMismatch(sonar.points,otherSonar.points,201) < 1e-6);
+
+    delete svp;
+}
+
+TEST_CASE ("test that the horizontal lever arm is not applied again to the XYZ 88 soundings")
+{
+    //the sonar measures along and across track from the vessel reference point, depth from the transducer
+    Eigen::Vector3d leverArm;
+    leverArm << 2.0,1.0,3.0;
+
+    Eigen::Matrix3d identity = Eigen::Matrix3d::Identity();
+    std::vector<SoundVelocityProfile*> svps;
+
+    GeoreferencingLGF georef;
+    Position centroid(0,48.4,-68.5,0);
+    georef.setCentroid(centroid);
+
+    SvpNearestByTime strategy;
+    XYZ88CapturingGeoreferencer sonar(georef,strategy);
+    sonar.setBeamXYZ(true);
+
+    SoundVelocityProfile * svp = new SoundVelocityProfile();
+    svp->setTimestamp(1000000000);
+    svp->add(0,1480);
+    svp->add(15000,1480);
+    sonar.processSoundVelocityProfile(svp);
+
+    //heading east, level
+    for(uint64_t timestamp=1000000000;timestamp<=1002000000;timestamp+=1000000){
+        sonar.processPosition(timestamp,centroid.getLongitude(),centroid.getLatitude(),0);
+        sonar.processAttitude(timestamp,90,0,0);
+    }
+
+    sonar.processSwathStart(1480);
+    sonar.processBeamXYZ(1001000000,0,4.0,-6.0,25.0,0,0);
+    sonar.georeference(leverArm,identity,svps);
+
+    //4 m forward is east, 6 m to port is north
+    REQUIRE(sonar.points.size() == 1);
+    REQUIRE(std::fabs(sonar.points[0](0) - 6.0) < 1e-3);
+    REQUIRE(std::fabs(sonar.points[0](1) - 4.0) < 1e-3);
+    REQUIRE(std::fabs(sonar.points[0](2) - 28.0) < 1e-3);
+
+    delete svp;
+}
+
+/**
+ * Appends a water column datagram with some of the beams of a ping. Beam i has 20 + 5 * i samples from sample 3 + i,
+ * at -30 + 10 * i degrees, of amplitude (i * 7 + j) % 50 - 60 in 0.5 dB
+ *
+ * @param file the file
+ * @param counter the ping counter
+ * @param datagramNumber number of the datagram in the ping, from 1
+ * @param datagramCount number of datagrams of the ping
+ * @param firstBeam first beam of the datagram
+ * @param beamCount number of beams of the datagram
+ */
+void appendKongsbergWaterColumn(std::vector<unsigned char> & file,uint16_t counter,uint16_t datagramNumber,uint16_t datagramCount,unsigned int firstBeam,unsigned int beamCount){
+    std::vector<unsigned char> data(sizeof(KongsbergWaterColumn107) + 2 * sizeof(KongsbergWaterColumn107TxEntry),0);
+
+    KongsbergWaterColumn107 * header = (KongsbergWaterColumn107*)&data[0];
+    header->nbDatagrams = datagramCount;
+    header->datagramNumber = datagramNumber;
+    header->nbTxSectors = 2;
+    header->totalNbRxBeams = 6;
+    header->nbRxBeams = beamCount;
+    header->soundSpeed = 14800;
+    header->samplingFrequency = 1500000;
+
+    for(unsigned int i=firstBeam;i<firstBeam + beamCount;i++){
+        KongsbergWaterColumn107RxEntry beam;
+        beam.beamAngle = -3000 + 1000 * i;
+        beam.startRangeSampleNumber = 3 + i;
+        beam.nbSamples = 20 + 5 * i;
+        beam.detectedRange = 10 + i;
+        beam.txSectorNumber = i % 2;
+        beam.beamNumber = i;
+
+        size_t position = data.size();
+        data.resize(position + sizeof(KongsbergWaterColumn107RxEntry) + beam.nbSamples);
+        memcpy(&data[position],&beam,sizeof(KongsbergWaterColumn107RxEntry));
+
+        for(unsigned int j=0;j<beam.nbSamples;j++){
+            data[position + sizeof(KongsbergWaterColumn107RxEntry) + j] = (unsigned char)(int8_t)((i * 7 + j) % 50 - 60);
+        }
+    }
+
+    //even length
+    if(data.size() % 2 == 0){
+        data.push_back(0);
+    }
+
+    appendKongsbergDatagram(file,'k',&data[0],data.size(),counter);
+}
+
+/**Checks the water column pings decoded by a parser against appendKongsbergWaterColumn*/
+class KongsbergWaterColumnHandler : public DatagramEventHandler{
+public:
+    KongsbergWaterColumnHandler() : magnitudes(NULL) {}
+
+    void processWaterColumnData(WaterColumnPing & ping){
+        REQUIRE(ping.getSampleRate() == 15000);
+        REQUIRE(ping.isDecibel());
+        REQUIRE(!ping.hasPhase());
+        REQUIRE(ping.getBeamCount() == 6);
+
+        for(unsigned int i=0;i<ping.getBeamCount();i++){
+            WaterColumnBeam & beam = ping.getBeam(i);
+
+            REQUIRE(beam.beamNumber == i);
+            REQUIRE(beam.beamAngle == -30 + 10.0 * i);
+            REQUIRE(beam.firstSample == 3 + i);
+            REQUIRE(beam.sampleCount == 20 + 5 * i);
+
+            float * beamMagnitudes = ping.getMagnitudes(i);
+
+            for(uint32_t j=0;j<beam.sampleCount;j++){
+                REQUIRE(beamMagnitudes[j] == ((int)((i * 7 + j) % 50) - 60) * 0.5f);
+            }
+        }
+
+        //the same arrays for every ping
+        if(magnitudes){
+            REQUIRE(ping.getMagnitudes(0) == magnitudes);
+        }
+
+        magnitudes = ping.getMagnitudes(0);
+        pingNumbers.push_back(ping.getPingNumber());
+    }
+
+    float * magnitudes;
+    std::vector<uint32_t> pingNumbers;
+};
+
+TEST_CASE ("test that the Kongsberg parser reassembles the water column datagrams of a .wcd file")
+{
+    std::vector<unsigned char> file;
+
+    //a ping over two datagrams, another datagram in between
+    appendKongsbergWaterColumn(file,7,1,2,0,3);
+
+    std::vector<unsigned char> xyz(sizeof(KongsbergXYZ88) + 1,0);
+    appendKongsbergDatagram(file,'X',&xyz[0],xyz.size(),7);
+
+    appendKongsbergWaterColumn(file,7,2,2,3,3);
+
+    //missing its second datagram
+    appendKongsbergWaterColumn(file,8,1,2,0,3);
+
+    //in a single datagram
+    appendKongsbergWaterColumn(file,9,1,1,0,6);
+
+    //missing its first datagram
+    appendKongsbergWaterColumn(file,10,2,2,3,3);
+
+    for(uint16_t counter=11;counter<=60;counter++){
+        appendKongsbergWaterColumn(file,counter,1,3,0,2);
+        appendKongsbergWaterColumn(file,counter,2,3,2,2);
+        appendKongsbergWaterColumn(file,counter,3,3,4,2);
+    }
+
+    //missing its last datagram at the end of the file
+    appendKongsbergWaterColumn(file,61,1,2,0,3);
+
+    std::string filename("KongsbergParserTestWaterColumn.wcd");
+    writeKongsbergFile(filename,file);
+
+    KongsbergWaterColumnHandler handler;
+    DatagramParser * parser = DatagramParserFactory::build(filename,handler);
+    parser->parse(filename);
+    delete parser;
+    remove(filename.c_str());
+
+    REQUIRE(handler.pingNumbers.size() == 52);
+    REQUIRE(handler.pingNumbers[0] == 7);
+    REQUIRE(handler.pingNumbers[1] == 9);
+
+    for(unsigned int i=2;i<handler.pingNumbers.size();i++){
+        REQUIRE(handler.pingNumbers[i] == 9 + i);
+    }
+}
+
+/**
+ * Appends a seabed image datagram. Beam i has 8 + 2 * i samples, recorded from the farthest for the first half of
+ * the beams, of amplitude -300 - 10 * i - j in 0.1 dB for the j-th recorded sample, its detection at sample 4 + i
+ *
+ * @param file the file
+ * @param counter the ping counter
+ * @param beamCount the number of beams
+ */
+void appendKongsbergSeabedImage(std::vector<unsigned char> & file,uint16_t counter,unsigned int beamCount){
+    std::vector<unsigned char> data(sizeof(KongsbergSeabedImage89) + beamCount * sizeof(KongsbergSeabedImage89Entry),0);
+
+    KongsbergSeabedImage89 * header = (KongsbergSeabedImage89*)&data[0];
+    header->samplingFrequency = 15000;
+    header->nbValidBeams = beamCount;
+
+    for(unsigned int i=0;i<beamCount;i++){
+        KongsbergSeabedImage89Entry * entry = (KongsbergSeabedImage89Entry*)&data[sizeof(KongsbergSeabedImage89) + i * sizeof(KongsbergSeabedImage89Entry)];
+        entry->sortingDirection = (i < beamCount / 2) ? -1 : 1;
+        entry->nbSamples = 8 + 2 * i;
+        entry->centreSampleNumber = 4 + i;
+    }
+
+    for(unsigned int i=0;i<beamCount;i++){
+        for(unsigned int j=0;j<8 + 2 * i;j++){
+            int16_t amplitude = -300 - 10 * i - j;
+            size_t position = data.size();
+            data.resize(position + sizeof(int16_t));
+            memcpy(&data[position],&amplitude,sizeof(int16_t));
+        }
+    }
+
+    //odd length
+    data.push_back(0);
+
+    appendKongsbergDatagram(file,'Y',&data[0],data.size(),counter);
+}
+
+/**Checks the snippets decoded by a parser against appendKongsbergSeabedImage*/
+class KongsbergSnippetHandler : public DatagramEventHandler{
+public:
+    void processSnippetData(SnippetPing & ping){
+        REQUIRE(ping.getSampleType() == SNIPPET_INT16);
+        REQUIRE(ping.getBeamCount() == 10);
+
+        for(unsigned int i=0;i<ping.getBeamCount();i++){
+            SnippetBeam & beam = ping.getBeam(i);
+
+            REQUIRE(beam.beamNumber == i);
+            REQUIRE(beam.sampleCount == 8 + 2 * i);
+            REQUIRE(beam.detectionSample == 4 + i);
+            REQUIRE(beam.reversed == (i < 5));
+            REQUIRE(beam.footprints == NULL);
+
+            //the samples of the beams follow each other in the datagram
+            if(i > 0){
+                REQUIRE(ping.getSamples<int16_t>(i) == ping.getSamples<int16_t>(i - 1) + ping.getBeam(i - 1).sampleCount);
+            }
+
+            for(uint32_t j=0;j<beam.sampleCount;j++){
+                int recorded = beam.reversed ? beam.sampleCount - 1 - j : j;
+
+                REQUIRE(ping.getSamples<int16_t>(i)[j] == -300 - 10 * (int)i - (int)j);
+                REQUIRE(ping.getSample(i,j) == -300 - 10 * (int)i - recorded);
+            }
+        }
+
+        pingNumbers.push_back(ping.getPingNumber());
+    }
+
+    std::vector<uint32_t> pingNumbers;
+};
+
+TEST_CASE ("test the Kongsberg parser with seabed image 89 datagrams")
+{
+    std::vector<unsigned char> file;
+
+    for(uint16_t counter=1;counter<=3;counter++){
+        appendKongsbergSeabedImage(file,counter,10);
+    }
+
+    std::string filename("KongsbergParserTestSeabedImage.all");
+    writeKongsbergFile(filename,file);
+
+    KongsbergSnippetHandler handler;
+    KongsbergParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.pingNumbers.size() == 3);
+    REQUIRE(handler.pingNumbers[2] == 3);
+}
+
+TEST_CASE ("test that the Kongsberg parser finds the transmit sector of each beam of a raw range and beam 78 datagram")
+{
+    std::vector<unsigned char> data(sizeof(KongsbergRangeAndBeam78) + 2 * sizeof(KongsbergRangeAndBeam78TxEntry) + 5 * sizeof(KongsbergRangeAndBeam78RxEntry),0);
+
+    KongsbergRangeAndBeam78 * header = (KongsbergRangeAndBeam78*)&data[0];
+    header->surfaceSoundSpeed = 14800;
+    header->nbTxPackets = 2;
+    header->nbRxPackets = 5;
+
+    KongsbergRangeAndBeam78TxEntry * tx = (KongsbergRangeAndBeam78TxEntry*)&data[sizeof(KongsbergRangeAndBeam78)];
+    tx[0].txSectorNumber = 3;
+    tx[0].tiltAngle = 150;
+    tx[1].txSectorNumber = 0;
+    tx[1].tiltAngle = -75;
+
+    //the last two beams have a sector the datagram doesn't have, and one out of range
+    uint8_t sectors[5] = {0,3,0,7,250};
+
+    KongsbergRangeAndBeam78RxEntry * rx = (KongsbergRangeAndBeam78RxEntry*)&data[sizeof(KongsbergRangeAndBeam78) + 2 * sizeof(KongsbergRangeAndBeam78TxEntry)];
+
+    for(unsigned int i=0;i<5;i++){
+        rx[i].beamAngle = -4000 + 2000 * i;
+        rx[i].txSectorNumber = sectors[i];
+        rx[i].twoWayTravelTime = 0.01 * (i + 1);
+    }
+
+    std::vector<unsigned char> file;
+    appendKongsbergDatagram(file,'N',&data[0],data.size());
+
+    std::string filename("KongsbergParserTestRangeAndBeam78.all");
+    writeKongsbergFile(filename,file);
+
+    KongsbergTestHandler handler;
+    KongsbergParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.swathSoundSpeeds.size() == 1);
+    REQUIRE(handler.tiltAngles.size() == 3);
+
+    REQUIRE(handler.beamAngles[0] == -40);
+    REQUIRE(handler.tiltAngles[0] == -0.75);
+    REQUIRE(handler.beamAngles[1] == -20);
+    REQUIRE(handler.tiltAngles[1] == 1.5);
+    REQUIRE(handler.beamAngles[2] == 0);
+    REQUIRE(handler.tiltAngles[2] == -0.75);
+    REQUIRE(handler.twoWayTravelTimes[2] == (double)0.03f);
+}
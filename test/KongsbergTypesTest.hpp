@@ -25,6 +25,13 @@ TEST_CASE( "Les structs Kongsberg ont la bonne dimensions", "[xtfTypes]" ) {
     REQUIRE( sizeof(KongsbergRangeAndBeam78) == 16 );
     REQUIRE( sizeof(KongsbergRangeAndBeam78TxEntry) == 24 );
     REQUIRE( sizeof(KongsbergRangeAndBeam78RxEntry) == 16 );
+    REQUIRE( sizeof(KongsbergXYZ88) == 20 );
+    REQUIRE( sizeof(KongsbergXYZ88Entry) == 20 );
+    REQUIRE( sizeof(KongsbergWaterColumn107) == 24 );
+    REQUIRE( sizeof(KongsbergWaterColumn107TxEntry) == 6 );
+    REQUIRE( sizeof(KongsbergWaterColumn107RxEntry) == 10 );
+    REQUIRE( sizeof(KongsbergSeabedImage89) == 16 );
+    REQUIRE( sizeof(KongsbergSeabedImage89Entry) == 6 );
 }
 
 #endif /* KONGSBERGTYPESTEST_HPP */
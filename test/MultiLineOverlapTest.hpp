@@ -0,0 +1,143 @@
+/*
+ * File:   MultiLineOverlapTest.hpp
+ *
+ * Tests the overlap analysis between all the lines of a survey
+ */
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include "../src/geometry/BoundingBoxTree.hpp"
+#include "../src/geometry/MultiLineOverlap.hpp"
+#include "../src/PointRecord.hpp"
+#include "catch.hpp"
+
+TEST_CASE("Test that the bounding box tree finds the same boxes as a linear search")
+{
+    std::vector<BoundingBox> boxes;
+    srand(7);
+
+    for(unsigned int i=0;i<1000;i++){
+        double x = ((double)rand() / RAND_MAX) * 1000;
+        double y = ((double)rand() / RAND_MAX) * 1000;
+        BoundingBox box = {x,y,x + ((double)rand() / RAND_MAX) * 30,y + ((double)rand() / RAND_MAX) * 30};
+        boxes.push_back(box);
+    }
+
+    BoundingBoxTree tree(boxes);
+    std::vector<unsigned int> found;
+
+    for(unsigned int q=0;q<200;q++){
+        double x = ((double)rand() / RAND_MAX) * 1000;
+        double y = ((double)rand() / RAND_MAX) * 1000;
+        BoundingBox query = {x,y,x + ((double)rand() / RAND_MAX) * 100,y + ((double)rand() / RAND_MAX) * 100};
+
+        std::vector<unsigned int> expected;
+
+        for(unsigned int i=0;i<boxes.size();i++){
+            if(BoundingBoxTree::intersects(boxes[i],query)){
+                expected.push_back(i);
+            }
+        }
+
+        tree.query(query,found);
+        REQUIRE(found == expected);
+    }
+
+    //a single box, and no box at all
+    BoundingBoxTree single(std::vector<BoundingBox>(1,boxes[0]));
+    single.query(boxes[0],found);
+    REQUIRE(found.size() == 1);
+
+    BoundingBoxTree empty((std::vector<BoundingBox>()));
+    empty.query(boxes[0],found);
+    REQUIRE(found.empty());
+}
+
+/**Parallel strips of soundings in the local geographic frame, each one 100 m wide, 80 m apart, plus a distant line*/
+static void makeSurveyLines(std::vector<std::vector<PointRecord> > & lines){
+    srand(11);
+
+    for(unsigned int line=0;line<6;line++){
+        std::vector<PointRecord> points;
+
+        for(unsigned int i=0;i<20000;i++){
+            PointRecord point = {((double)rand() / RAND_MAX) * 500,80.0 * line + ((double)rand() / RAND_MAX) * 100,20 + 0.1 * line,0,0,NAN,NAN};
+            points.push_back(point);
+        }
+
+        lines.push_back(points);
+    }
+
+    std::vector<PointRecord> distant;
+
+    for(unsigned int i=0;i<1000;i++){
+        PointRecord point = {5000 + ((double)rand() / RAND_MAX) * 100,5000 + ((double)rand() / RAND_MAX) * 100,30,0,0,NAN,NAN};
+        distant.push_back(point);
+    }
+
+    lines.push_back(distant);
+}
+
+TEST_CASE("Test the overlap between all the lines of a survey")
+{
+    std::vector<std::vector<PointRecord> > lines;
+    makeSurveyLines(lines);
+
+    MultiLineOverlap overlap(0,0,1,0,true,3);
+
+    for(unsigned int i=0;i<lines.size();i++){
+        std::ostringstream name;
+        name << "line" << i;
+        REQUIRE(overlap.addLine(name.str(),lines[i]) == i);
+    }
+
+    overlap.computeOverlaps();
+
+    //only neighbouring strips overlap, the distant line overlaps nothing
+    const std::vector<LineOverlap> & overlaps = overlap.getOverlaps();
+    REQUIRE(overlaps.size() == 5);
+
+    for(unsigned int p=0;p<overlaps.size();p++){
+        REQUIRE(overlaps[p].first == p);
+        REQUIRE(overlaps[p].second == p + 1);
+
+        //20 m of 100 m
+        REQUIRE(std::fabs((double)overlaps[p].firstInSecond / lines[p].size() - 0.2) < 0.02);
+        REQUIRE(std::fabs((double)overlaps[p].secondInFirst / lines[p + 1].size() - 0.2) < 0.02);
+
+        //heights along the normal of the horizontal plane are the depths
+        REQUIRE(std::fabs(overlaps[p].firstMeanHeight - (20 + 0.1 * p)) < 1e-4);
+        REQUIRE(std::fabs(overlaps[p].secondMeanHeight - (20 + 0.1 * (p + 1))) < 1e-4);
+
+        //the kept points of the first line are inside the second line's hull, near its edge
+        REQUIRE(overlaps[p].firstIndices.size() == overlaps[p].firstInSecond);
+
+        for(unsigned int i=0;i<overlaps[p].firstIndices.size();i++){
+            REQUIRE(lines[p][overlaps[p].firstIndices[i]].y > 80.0 * (p + 1) - 0.5);
+        }
+    }
+
+    //the same pairs without threads
+    MultiLineOverlap sequential(0,0,2,0,false,1);
+
+    for(unsigned int i=0;i<lines.size();i++){
+        sequential.addLine("line",lines[i]);
+    }
+
+    sequential.computeOverlaps();
+    REQUIRE(sequential.getOverlaps().size() == overlaps.size());
+
+    for(unsigned int p=0;p<overlaps.size();p++){
+        REQUIRE(sequential.getOverlaps()[p].firstInSecond == overlaps[p].firstInSecond);
+        REQUIRE(sequential.getOverlaps()[p].secondInFirst == overlaps[p].secondInFirst);
+        REQUIRE(sequential.getOverlaps()[p].firstIndices.empty());
+    }
+
+    std::ostringstream matrix;
+    overlap.writeMatrix(matrix);
+
+    std::string header;
+    std::getline(std::istringstream(matrix.str()),header);
+    REQUIRE(header == "line,line0,line1,line2,line3,line4,line5,line6");
+}
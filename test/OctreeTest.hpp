@@ -0,0 +1,225 @@
+/*
+ * File:   OctreeTest.hpp
+ *
+ * Tests the out-of-core level of detail octree
+ */
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include "../src/octree/OctreeBuilder.hpp"
+#include "../src/octree/OctreeStore.hpp"
+#include "catch.hpp"
+
+#ifdef _WIN32
+static std::string octreeTestDirectory("octreeTest");
+#else
+static std::string octreeTestDirectory("build/test/octreeTest");
+#endif
+
+/**A sloping seabed in a projected frame, with large coordinates*/
+static void makeOctreePoints(std::vector<PointRecord> & points,unsigned int count,unsigned int seed){
+    srand(seed);
+
+    for(unsigned int i=0;i<count;i++){
+        PointRecord point;
+        point.x = 5000000 + ((double)rand() / RAND_MAX) * 400;
+        point.y = 300000 + ((double)rand() / RAND_MAX) * 250;
+        point.z = 20 + 0.02 * (point.x - 5000000) + ((double)rand() / RAND_MAX);
+        point.quality = i % 7;
+        point.intensity = i;
+        point.horizontalUncertainty = NAN;
+        point.verticalUncertainty = NAN;
+        points.push_back(point);
+    }
+}
+
+/**Builds an octree and reads back every node: points of each node, sorted by intensity*/
+static void buildOctree(std::vector<PointRecord> & points,unsigned int threadCount,std::vector<std::vector<PointRecord> > & nodes){
+    system(("rm -rf " + octreeTestDirectory).c_str());
+
+    {
+        OctreeBuilder builder(octreeTestDirectory,1000,5000,threadCount);
+        builder.addPoints(&points[0],points.size() / 2);
+        builder.addPoints(&points[points.size() / 2],points.size() - points.size() / 2);
+        builder.build();
+    }
+
+    OctreeStore store(octreeTestDirectory);
+    nodes.resize(store.getNodeCount());
+
+    for(unsigned int i=0;i<store.getNodeCount();i++){
+        store.readNode(i,nodes[i]);
+    }
+}
+
+TEST_CASE("Test that the octree stores every point exactly once, inside its node")
+{
+    std::vector<PointRecord> points;
+    makeOctreePoints(points,60000,1);
+
+    std::vector<std::vector<PointRecord> > nodes;
+    buildOctree(points,3,nodes);
+
+    OctreeStore store(octreeTestDirectory);
+    REQUIRE(store.getPointCount() == points.size());
+    REQUIRE(store.getNode(0).name == "r");
+    REQUIRE(store.getNodeCount() > 9);
+
+    //each intensity is unique: every point comes back once, within a millimeter
+    std::vector<int> found(points.size(),0);
+
+    for(unsigned int n=0;n<nodes.size();n++){
+        const OctreeNode & node = store.getNode(n);
+        REQUIRE(nodes[n].size() == node.pointCount);
+
+        //empty nodes are only kept to link their children
+        if(node.pointCount == 0){
+            bool hasChildren = false;
+
+            for(unsigned int c=0;c<8;c++){
+                hasChildren = hasChildren || (node.children[c] >= 0);
+            }
+
+            REQUIRE(hasChildren);
+        }
+
+        for(unsigned int i=0;i<nodes[n].size();i++){
+            const PointRecord & point = nodes[n][i];
+            const PointRecord & original = points[point.intensity];
+            found[point.intensity]++;
+
+            REQUIRE(std::fabs(point.x - original.x) <= 1e-3);
+            REQUIRE(std::fabs(point.y - original.y) <= 1e-3);
+            REQUIRE(std::fabs(point.z - original.z) <= 1e-3);
+            REQUIRE(point.quality == original.quality);
+
+            REQUIRE(point.x >= node.minimum(0) - 1e-6);
+            REQUIRE(point.x <= node.minimum(0) + node.size + 1e-6);
+            REQUIRE(point.y >= node.minimum(1) - 1e-6);
+            REQUIRE(point.y <= node.minimum(1) + node.size + 1e-6);
+            REQUIRE(point.z >= node.minimum(2) - 1e-6);
+            REQUIRE(point.z <= node.minimum(2) + node.size + 1e-6);
+        }
+    }
+
+    for(unsigned int i=0;i<found.size();i++){
+        REQUIRE(found[i] == 1);
+    }
+}
+
+TEST_CASE("Test that the octree does not depend on the number of threads")
+{
+    std::vector<PointRecord> points;
+    makeOctreePoints(points,30000,2);
+
+    std::vector<std::vector<PointRecord> > single,multiple;
+    buildOctree(points,1,single);
+    buildOctree(points,4,multiple);
+
+    REQUIRE(single.size() == multiple.size());
+
+    for(unsigned int n=0;n<single.size();n++){
+        REQUIRE(single[n].size() == multiple[n].size());
+
+        for(unsigned int i=0;i<single[n].size();i++){
+            REQUIRE(single[n][i].intensity == multiple[n][i].intensity);
+        }
+    }
+}
+
+TEST_CASE("Test that the octree node selection follows the camera distance and the point budget")
+{
+    std::vector<PointRecord> points;
+    makeOctreePoints(points,60000,3);
+
+    std::vector<std::vector<PointRecord> > nodes;
+    buildOctree(points,2,nodes);
+
+    OctreeStore store(octreeTestDirectory);
+    Eigen::Vector3d center = store.getNode(0).minimum + Eigen::Vector3d::Constant(store.getCubeSize() / 2);
+
+    std::vector<unsigned int> nearSelection,farSelection,budgetSelection;
+    store.selectNodes(center + Eigen::Vector3d(0,0,-50),0.05,1000000,nearSelection);
+    store.selectNodes(center + Eigen::Vector3d(0,0,-50000),0.05,1000000,farSelection);
+
+    //up close everything fits the budget, from afar only the root is worth drawing
+    REQUIRE(nearSelection.size() == store.getNodeCount());
+    REQUIRE(farSelection.size() == 1);
+    REQUIRE(farSelection[0] == 0);
+
+    //room for the root and its smallest child only
+    uint64_t smallestChild = points.size();
+
+    for(unsigned int c=0;c<8;c++){
+        if(store.getNode(0).children[c] >= 0){
+            smallestChild = std::min(smallestChild,store.getNode(store.getNode(0).children[c]).pointCount);
+        }
+    }
+
+    uint64_t budget = store.getNode(0).pointCount + smallestChild;
+    store.selectNodes(center + Eigen::Vector3d(0,0,-50),0.05,budget,budgetSelection);
+
+    uint64_t selectedPoints = 0;
+
+    for(unsigned int i=0;i<budgetSelection.size();i++){
+        selectedPoints += store.getNode(budgetSelection[i]).pointCount;
+
+        //the selection is a subtree: the parent of each node comes before it
+        if(i > 0){
+            const std::string & name = store.getNode(budgetSelection[i]).name;
+            bool parentFound = false;
+
+            for(unsigned int j=0;j<i;j++){
+                parentFound = parentFound || (store.getNode(budgetSelection[j]).name == name.substr(0,name.size() - 1));
+            }
+
+            REQUIRE(parentFound);
+        }
+    }
+
+    REQUIRE(budgetSelection[0] == 0);
+    REQUIRE(budgetSelection.size() > 1);
+    REQUIRE(budgetSelection.size() < store.getNodeCount());
+    REQUIRE(selectedPoints <= budget);
+}
+
+TEST_CASE("Test that a chunk that cannot be written throws to the caller of the parallel build")
+{
+    std::vector<PointRecord> points;
+    makeOctreePoints(points,30000,4);
+
+    std::vector<std::vector<PointRecord> > nodes;
+    buildOctree(points,4,nodes);
+
+    //the deepest node is written by the task of its chunk
+    std::ifstream header((octreeTestDirectory + "/octree.txt").c_str());
+    std::string line,deepest;
+
+    while(std::getline(header,line)){
+        std::string name = line.substr(0,line.find(' '));
+
+        if(name.size() > 0 && name[0] == 'r' && name.size() > deepest.size()){
+            deepest = name;
+        }
+    }
+
+    REQUIRE(deepest.size() > 1);
+
+    //a directory in the way of its file
+    system(("rm -rf " + octreeTestDirectory).c_str());
+#ifdef _WIN32
+    _mkdir(octreeTestDirectory.c_str());
+    _mkdir((octreeTestDirectory + "/" + deepest + ".bin").c_str());
+#else
+    mkdir(octreeTestDirectory.c_str(),0755);
+    mkdir((octreeTestDirectory + "/" + deepest + ".bin").c_str(),0755);
+#endif
+
+    OctreeBuilder builder(octreeTestDirectory,1000,5000,4);
+    builder.addPoints(&points[0],points.size());
+
+    REQUIRE_THROWS_AS(builder.build(),Exception*);
+}
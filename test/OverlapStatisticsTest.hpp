@@ -0,0 +1,131 @@
+/*
+ * File:   OverlapStatisticsTest.hpp
+ *
+ * Tests the gridded depth difference statistics of line overlaps
+ */
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "../src/gridding/OverlapStatistics.hpp"
+#include "../src/PointRecord.hpp"
+#include "catch.hpp"
+
+/**Makes a line of points on a regular 0.25 m spacing, with a constant depth*/
+std::vector<PointRecord> makeStatisticsLine(double minimumX,double maximumX,double depth){
+    std::vector<PointRecord> points;
+
+    for(double x=minimumX;x<maximumX;x+=0.25){
+        for(double y=0;y<50;y+=0.25){
+            PointRecord point = {x,y,depth,0,0,NAN,NAN};
+            points.push_back(point);
+        }
+    }
+
+    return points;
+}
+
+TEST_CASE("Test the overlap statistics of two lines with a known depth offset")
+{
+    std::vector<PointRecord> first = makeStatisticsLine(0,60,20.3);
+    std::vector<PointRecord> second = makeStatisticsLine(40,100,20.0);
+
+    OverlapStatistics statistics(1.0,1,4);
+    statistics.compute(first,second);
+
+    //only the intersection of the extents, x in [40,60[, is gridded
+    REQUIRE(statistics.getComparedCellCount() == 20 * 50);
+    REQUIRE(std::fabs(statistics.getMeanDifference() - 0.3) < 1e-9);
+    REQUIRE(std::fabs(statistics.getRmsDifference() - 0.3) < 1e-9);
+    REQUIRE(std::fabs(statistics.getMaximumAbsoluteDifference() - 0.3) < 1e-9);
+
+    //special order allows 0.29 m at 20 m, just below the offset, order 1 0.57 m
+    REQUIRE(statistics.getPassRate(IHO_SPECIAL_ORDER) == 0.0);
+    REQUIRE(statistics.getPassRate(IHO_ORDER_1) == 1.0);
+
+    //swapping the lines changes the sign of the differences only
+    statistics.compute(second,first);
+    REQUIRE(std::fabs(statistics.getMeanDifference() + 0.3) < 1e-9);
+    REQUIRE(std::fabs(statistics.getRmsDifference() - 0.3) < 1e-9);
+}
+
+TEST_CASE("Test the IHO pass rate of the overlap statistics")
+{
+    std::vector<PointRecord> first = makeStatisticsLine(0,20,10.0);
+    std::vector<PointRecord> second = makeStatisticsLine(0,20,10.0);
+
+    //half of the cells of the first line 0.4 m deeper: beyond special order, within order 1
+    for(unsigned int i=0;i<first.size();i++){
+        if(first[i].x >= 10){
+            first[i].z += 0.4;
+        }
+    }
+
+    OverlapStatistics statistics(2.0);
+    statistics.compute(first,second);
+
+    REQUIRE(statistics.getComparedCellCount() == 10 * 25);
+    REQUIRE(std::fabs(statistics.getPassRate(IHO_SPECIAL_ORDER) - 0.5) < 1e-9);
+    REQUIRE(statistics.getPassRate(IHO_ORDER_1) == 1.0);
+    REQUIRE(statistics.getPassRate(IHO_ORDER_2) == 1.0);
+    REQUIRE(std::fabs(statistics.getMeanDifference() - 0.2) < 1e-9);
+    REQUIRE(std::fabs(statistics.getRmsDifference() - std::sqrt(0.08)) < 1e-9);
+    REQUIRE(std::isnan(statistics.getDifference(0,0)) == false);
+
+    REQUIRE(std::fabs(OverlapStatistics::getAllowedUncertainty(IHO_ORDER_2,100) - std::sqrt(1 + 2.3 * 2.3)) < 1e-9);
+}
+
+TEST_CASE("Test the overlap statistics of disjoint and empty point sets")
+{
+    std::vector<PointRecord> first = makeStatisticsLine(0,10,10.0);
+    std::vector<PointRecord> second = makeStatisticsLine(20,30,10.0);
+    std::vector<PointRecord> none;
+
+    OverlapStatistics statistics(1.0);
+    statistics.compute(first,second);
+    REQUIRE(statistics.getComparedCellCount() == 0);
+    REQUIRE(std::isnan(statistics.getMeanDifference()));
+    REQUIRE(std::isnan(statistics.getPassRate(IHO_ORDER_1)));
+
+    statistics.compute(first,none);
+    REQUIRE(statistics.getComparedCellCount() == 0);
+
+    //a cell needing more soundings than the lines have is not compared
+    OverlapStatistics strict(1.0,100);
+    strict.compute(first,first);
+    REQUIRE(strict.getComparedCellCount() == 0);
+}
+
+TEST_CASE("Test the overlap statistics of a grid far larger than its soundings")
+{
+    //two soundings per line 100 km apart, on 1 mm cells: 10^16 cells, of which two are occupied
+    std::vector<PointRecord> first;
+    std::vector<PointRecord> second;
+
+    for(unsigned int i=0;i<2;i++){
+        PointRecord firstPoint = {i * 100000.0,i * 100000.0,10.5,0,0,NAN,NAN};
+        PointRecord secondPoint = {i * 100000.0,i * 100000.0,10.0,0,0,NAN,NAN};
+        first.push_back(firstPoint);
+        second.push_back(secondPoint);
+    }
+
+    OverlapStatistics statistics(0.001,1,4);
+    statistics.compute(first,second);
+
+    REQUIRE(statistics.getComparedCellCount() == 2);
+    REQUIRE(std::fabs(statistics.getMeanDifference() - 0.5) < 1e-9);
+    REQUIRE(std::fabs(statistics.getDifference(0,0) - 0.5) < 1e-9);
+    REQUIRE(std::isnan(statistics.getDifference(1,0)));
+
+    //the compared cells on the grid of all the multiples of the cell size, by row
+    std::vector<std::pair<int64_t,int64_t> > cells;
+    statistics.getComparedCells(cells);
+
+    REQUIRE(cells.size() == 2);
+    REQUIRE(cells[0] == std::make_pair((int64_t)0,(int64_t)0));
+    REQUIRE(std::llabs(cells[1].first - 100000000) <= 1);
+    REQUIRE(std::llabs(cells[1].second - 100000000) <= 1);
+
+    //more columns than an unsigned int can count
+    OverlapStatistics tiny(1e-6);
+    REQUIRE_THROWS_AS(tiny.compute(first,second),Exception*);
+}
@@ -0,0 +1,128 @@
+/*
+ * File:   PreparedPolygonTest.hpp
+ *
+ * Tests the prepared polygon point in polygon queries
+ */
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "../src/geometry/PreparedPolygon.hpp"
+#include "catch.hpp"
+
+/**2D point with float coordinates, as pcl::PointXYZ*/
+typedef struct{
+    float x;
+    float y;
+} PolygonTestPoint;
+
+/**The point in polygon test of pcl::isXYPointIn2DXYPolygon, against every edge*/
+static bool isPointInPolygonReference(const PolygonTestPoint & point,const std::vector<PolygonTestPoint> & polygon){
+    bool inside = false;
+    double xold = polygon[polygon.size() - 1].x;
+    double yold = polygon[polygon.size() - 1].y;
+
+    for(unsigned int i=0;i<polygon.size();i++){
+        double xnew = polygon[i].x;
+        double ynew = polygon[i].y;
+        double x1,x2,y1,y2;
+
+        if(xnew > xold){
+            x1 = xold; x2 = xnew; y1 = yold; y2 = ynew;
+        }
+        else{
+            x1 = xnew; x2 = xold; y1 = ynew; y2 = yold;
+        }
+
+        if((xnew < point.x) == (point.x <= xold) && (point.y - y1) * (x2 - x1) < (y2 - y1) * (point.x - x1)){
+            inside = !inside;
+        }
+
+        xold = xnew;
+        yold = ynew;
+    }
+
+    return inside;
+}
+
+/**A star shaped polygon with many vertices, some of them sharing x coordinates*/
+static void makeStarPolygon(std::vector<PolygonTestPoint> & polygon,unsigned int vertexCount){
+    for(unsigned int i=0;i<vertexCount;i++){
+        double angle = 2 * M_PI * i / vertexCount;
+        double radius = (i % 2 == 0) ? 100 : 40 + (i % 7) * 5;
+        PolygonTestPoint vertex = {(float)std::round(radius * std::cos(angle)),(float)(radius * std::sin(angle))};
+        polygon.push_back(vertex);
+    }
+}
+
+TEST_CASE("Test that the prepared polygon matches the point in polygon test on every edge")
+{
+    std::vector<PolygonTestPoint> polygon;
+    makeStarPolygon(polygon,500);
+
+    PreparedPolygon prepared(polygon);
+
+    //random points, then the vertices and points on vertical lines through the vertices
+    std::vector<PolygonTestPoint> points;
+    srand(3);
+
+    for(unsigned int i=0;i<200000;i++){
+        PolygonTestPoint point = {(float)(((double)rand() / RAND_MAX) * 240 - 120),(float)(((double)rand() / RAND_MAX) * 240 - 120)};
+        points.push_back(point);
+    }
+
+    for(unsigned int i=0;i<polygon.size();i++){
+        points.push_back(polygon[i]);
+
+        PolygonTestPoint above = {polygon[i].x,polygon[i].y + 0.5f};
+        PolygonTestPoint below = {polygon[i].x,polygon[i].y - 0.5f};
+        points.push_back(above);
+        points.push_back(below);
+    }
+
+    PolygonTestPoint invalid = {NAN,0};
+    points.push_back(invalid);
+
+    std::vector<uint64_t> expected;
+    unsigned int insideCount = 0;
+
+    for(uint64_t i=0;i<points.size();i++){
+        bool inside = isPointInPolygonReference(points[i],polygon);
+        REQUIRE(prepared.contains(points[i].x,points[i].y) == inside);
+
+        if(inside){
+            expected.push_back(i);
+            insideCount++;
+        }
+    }
+
+    REQUIRE(insideCount > 10000);
+    REQUIRE(insideCount < points.size() - 10000);
+
+    //same indices, in order, whatever the number of threads
+    for(unsigned int threadCount=1;threadCount<=4;threadCount+=3){
+        std::vector<uint64_t> inside;
+        prepared.findInside(points,inside,threadCount);
+        REQUIRE(inside == expected);
+    }
+}
+
+TEST_CASE("Test degenerate prepared polygons")
+{
+    //vertical segment only: no edge can be crossed
+    std::vector<double> x = {1,1,1};
+    std::vector<double> y = {0,1,2};
+    PreparedPolygon vertical(x,y);
+
+    REQUIRE(vertical.getEdgeCount() == 0);
+    REQUIRE(!vertical.contains(1,1));
+
+    //triangle
+    std::vector<double> triangleX = {0,10,0};
+    std::vector<double> triangleY = {0,0,10};
+    PreparedPolygon triangle(triangleX,triangleY);
+
+    REQUIRE(triangle.contains(2,2));
+    REQUIRE(!triangle.contains(8,8));
+    REQUIRE(!triangle.contains(-1,2));
+    REQUIRE(!triangle.contains(11,0));
+}
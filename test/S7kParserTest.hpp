@@ -13,6 +13,183 @@
 #include "catch.hpp"
 #include "../src/datagrams/DatagramEventHandler.hpp"
 #include "../src/datagrams/s7k/S7kParser.hpp"
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <Eigen/Dense>
+#include "../src/math/CoordinateTransform.hpp"
+
+/**
+ * Appends a record, its data record frame and checksum included, to a simulated s7k file
+ *
+ * @param file the bytes of the file
+ * @param type the record type identifier
+ * @param data the data section, without the checksum
+ * @param size the size of the data section
+ * @param optionalDataOffset offset of the optional data in the data section, 0 if none
+ * @param seconds the seconds of the record timestamp, at 12:30 on day 120 of 2019
+ */
+void appendS7kRecord(std::vector<unsigned char> & file,uint32_t type,const void * data,uint32_t size,uint32_t optionalDataOffset = 0,float seconds = 15){
+    S7kDataRecordFrame drf;
+    memset(&drf,0,sizeof(S7kDataRecordFrame));
+    drf.ProtocolVersion = 5;
+    drf.Offset = sizeof(S7kDataRecordFrame) - 4;
+    drf.SyncPattern = SYNC_PATTERN;
+    drf.Size = sizeof(S7kDataRecordFrame) + size + sizeof(uint32_t);
+    drf.Timestamp.Year = 2019;
+    drf.Timestamp.Day = 120;
+    drf.Timestamp.Hours = 12;
+    drf.Timestamp.Minutes = 30;
+    drf.Timestamp.Seconds = seconds;
+    drf.RecordTypeIdentifier = type;
+
+    if(optionalDataOffset){
+        drf.OptionalDataOffset = sizeof(S7kDataRecordFrame) + optionalDataOffset;
+        drf.OptionalDataIdentifier = type;
+    }
+
+    uint32_t checksum = 0;
+    unsigned char * drfBytes = (unsigned char *)&drf;
+    const unsigned char * dataBytes = (const unsigned char *)data;
+
+    file.insert(file.end(),drfBytes,drfBytes + sizeof(S7kDataRecordFrame));
+    file.insert(file.end(),dataBytes,dataBytes + size);
+
+    for(unsigned int i=file.size() - sizeof(S7kDataRecordFrame) - size;i<file.size();i++){
+        checksum += file[i];
+    }
+
+    unsigned char * checksumBytes = (unsigned char *)&checksum;
+    file.insert(file.end(),checksumBytes,checksumBytes + sizeof(uint32_t));
+}
+
+/**Appends a 7000 sonar settings record*/
+void appendS7kSonarSettings(std::vector<unsigned char> & file,uint32_t pingNumber,float soundVelocity){
+    S7kSonarSettings settings;
+    memset(&settings,0,sizeof(S7kSonarSettings));
+    settings.sequentialNumber = pingNumber;
+    settings.soundVelocity = soundVelocity;
+
+    appendS7kRecord(file,7000,&settings,sizeof(S7kSonarSettings));
+}
+
+/**Appends a 7027 raw detection record of beamCount beams*/
+void appendS7kRawDetection(std::vector<unsigned char> & file,uint32_t pingNumber,uint32_t beamCount){
+    std::vector<unsigned char> data(sizeof(S7kRawDetectionDataRTH) + beamCount * sizeof(S7kRawDetectionDataRD),0);
+
+    S7kRawDetectionDataRTH * swath = (S7kRawDetectionDataRTH *)&data[0];
+    swath->pingNumber = pingNumber;
+    swath->numberOfDetectionPoints = beamCount;
+    swath->dataFieldSize = sizeof(S7kRawDetectionDataRD);
+    swath->samplingRate = 10000;
+
+    for(uint32_t i=0;i<beamCount;i++){
+        S7kRawDetectionDataRD * beam = (S7kRawDetectionDataRD *)&data[sizeof(S7kRawDetectionDataRTH) + i * sizeof(S7kRawDetectionDataRD)];
+        beam->beamDescriptor = i;
+        beam->detectionPoint = 1000 + i;
+        beam->receptionAngle = -1.0 + 2.0 * i / beamCount;
+    }
+
+    appendS7kRecord(file,7027,&data[0],data.size());
+}
+
+/**
+ * Appends a 7004 beam geometry record, beam i at across track angle (i - beamCount / 2) / 100 and along track angle i / 1000 radians.
+ * The record has the vertical direction (along track) angles first, then the horizontal direction (across track) angles
+ */
+void appendS7kBeamGeometry(std::vector<unsigned char> & file,uint32_t beamCount){
+    std::vector<unsigned char> data(sizeof(S7kBeamGeometryRTH) + 4 * beamCount * sizeof(float),0);
+
+    S7kBeamGeometryRTH * geometry = (S7kBeamGeometryRTH *)&data[0];
+    geometry->numberOfBeams = beamCount;
+
+    float * angles = (float *)&data[sizeof(S7kBeamGeometryRTH)];
+
+    for(uint32_t i=0;i<beamCount;i++){
+        angles[i] = i / 1000.0;
+        angles[beamCount + i] = ((int)i - (int)beamCount / 2) / 100.0;
+        angles[2 * beamCount + i] = 0.01;
+        angles[3 * beamCount + i] = 0.01;
+    }
+
+    appendS7kRecord(file,7004,&data[0],data.size());
+}
+
+/**
+ * Appends a 7006 bathymetric data record, beam i at range (i + 1) / 1000 seconds, except every tenth beam without detection.
+ * With optional data, beam i points i / 100 radians from vertical, at azimuth i / 10 radians
+ */
+void appendS7kBathymetry(std::vector<unsigned char> & file,uint32_t pingNumber,uint32_t beamCount,float soundVelocity,bool optionalData){
+    uint32_t optionalStart = sizeof(S7kBathymetricDataRTH) + beamCount * (2 * sizeof(float) + sizeof(uint8_t));
+    std::vector<unsigned char> data(optionalStart + (optionalData ? sizeof(S7kBathymetricDataOD) + beamCount * sizeof(S7kBathymetricDataODRD) : 0),0);
+
+    S7kBathymetricDataRTH * swath = (S7kBathymetricDataRTH *)&data[0];
+    swath->pingNumber = pingNumber;
+    swath->numberOfReceiverBeams = beamCount;
+    swath->soundVelocity = soundVelocity;
+
+    float * ranges = (float *)&data[sizeof(S7kBathymetricDataRTH)];
+    uint8_t * quality = (uint8_t *)(ranges + beamCount);
+    float * intensities = (float *)(quality + beamCount);
+
+    for(uint32_t i=0;i<beamCount;i++){
+        ranges[i] = (i % 10 == 9) ? 0 : (i + 1) / 1000.0;
+        quality[i] = 3;
+        intensities[i] = i;
+    }
+
+    if(optionalData){
+        S7kBathymetricDataODRD * beams = (S7kBathymetricDataODRD *)&data[optionalStart + sizeof(S7kBathymetricDataOD)];
+
+        for(uint32_t i=0;i<beamCount;i++){
+            beams[i].pointingAngle = i / 100.0;
+            beams[i].azimuthAngle = i / 10.0;
+        }
+    }
+
+    appendS7kRecord(file,7006,&data[0],data.size(),optionalData ? optionalStart : 0);
+}
+
+/**Writes a simulated s7k file*/
+void writeS7kFile(std::string & filename,std::vector<unsigned char> & file){
+    FILE * out = fopen(filename.c_str(),"wb");
+    REQUIRE(out != NULL);
+    fwrite(&file[0],1,file.size(),out);
+    fclose(out);
+}
+
+/**Keeps the swaths and pings decoded by a parser*/
+class S7kTestHandler : public DatagramEventHandler{
+public:
+    void processSwathStart(double surfaceSoundSpeed){
+        swathSoundSpeeds.push_back(surfaceSoundSpeed);
+        swathPingCounts.push_back(0);
+    }
+
+    void processPing(uint64_t microEpoch,long id,double beamAngle,double tiltAngle,double twoWayTravelTime,uint32_t quality,int32_t intensity){
+        REQUIRE(swathPingCounts.size() > 0);
+        swathPingCounts.back()++;
+
+        ids.push_back(id);
+        beamAngles.push_back(beamAngle);
+        tiltAngles.push_back(tiltAngle);
+        twoWayTravelTimes.push_back(twoWayTravelTime);
+        qualities.push_back(quality);
+    }
+
+    void processPosition(uint64_t microEpoch,double longitude,double latitude,double height){
+        positionTimestamps.push_back(microEpoch);
+    }
+
+    std::vector<uint64_t> positionTimestamps;
+    std::vector<double> swathSoundSpeeds;
+    std::vector<unsigned int> swathPingCounts;
+    std::vector<long> ids;
+    std::vector<double> beamAngles;
+    std::vector<double> tiltAngles;
+    std::vector<double> twoWayTravelTimes;
+    std::vector<uint32_t> qualities;
+};
 
 TEST_CASE("test the function S7kParser::getName")
 {
@@ -139,3 +316,674 @@ TEST_CASE ("test the S7k parser with a valid file")
         REQUIRE(false);
     }
 }
+
+TEST_CASE ("test that the S7k parser matches each ping with its sonar settings")
+{
+    std::vector<unsigned char> file;
+
+    //settings immediately followed by their ping, with settings of pings never received in between
+    for(uint32_t ping=1;ping<=300;ping++){
+        appendS7kSonarSettings(file,ping,1400 + ping % 50);
+
+        if(ping % 3 == 0){
+            appendS7kSonarSettings(file,100000 + ping,1000);
+        }
+
+        appendS7kRawDetection(file,ping,10);
+    }
+
+    //a ping without settings
+    appendS7kRawDetection(file,301,10);
+
+    //settings of ping 400 evicted by those of ping 400 + S7K_SETTINGS_RING_SIZE, received before the ping
+    appendS7kSonarSettings(file,400,1450);
+    appendS7kSonarSettings(file,400 + S7K_SETTINGS_RING_SIZE,1460);
+    appendS7kRawDetection(file,400,10);
+    appendS7kRawDetection(file,400 + S7K_SETTINGS_RING_SIZE,10);
+
+    //settings are used once
+    appendS7kRawDetection(file,400 + S7K_SETTINGS_RING_SIZE,10);
+
+    //a few pings out of order
+    appendS7kSonarSettings(file,501,1470);
+    appendS7kSonarSettings(file,502,1471);
+    appendS7kSonarSettings(file,503,1472);
+    appendS7kRawDetection(file,503,10);
+    appendS7kRawDetection(file,501,10);
+    appendS7kRawDetection(file,502,10);
+
+    std::string filename("S7kParserTestSettings.s7k");
+    writeS7kFile(filename,file);
+
+    S7kTestHandler handler;
+    S7kParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.swathSoundSpeeds.size() == 304);
+
+    for(unsigned int i=0;i<300;i++){
+        REQUIRE(handler.swathSoundSpeeds[i] == 1400 + (i + 1) % 50);
+        REQUIRE(handler.swathPingCounts[i] == 10);
+    }
+
+    REQUIRE(handler.swathSoundSpeeds[300] == 1460);
+    REQUIRE(handler.swathSoundSpeeds[301] == 1472);
+    REQUIRE(handler.swathSoundSpeeds[302] == 1470);
+    REQUIRE(handler.swathSoundSpeeds[303] == 1471);
+}
+
+TEST_CASE ("test the S7k checksum verification modes")
+{
+    std::vector<unsigned char> file;
+
+    for(uint32_t ping=1;ping<=10;ping++){
+        appendS7kSonarSettings(file,ping,1480);
+        appendS7kRawDetection(file,ping,5);
+    }
+
+    //corrupt the checksum of the last raw detection record, then append a corrupted 7001 record
+    file[file.size() - 1] ^= 0xFF;
+
+    unsigned char configuration[40] = {0};
+    appendS7kRecord(file,7001,configuration,sizeof(configuration));
+    file[file.size() - 1] ^= 0xFF;
+
+    std::string filename("S7kParserTestChecksum.s7k");
+    writeS7kFile(filename,file);
+
+    S7kTestHandler always;
+    S7kParser alwaysParser(always);
+    alwaysParser.parse(filename);
+
+    REQUIRE(alwaysParser.getChecksumFailureCount() == 2);
+    REQUIRE(always.swathSoundSpeeds.size() == 9);
+
+    S7kTestHandler subscribed;
+    S7kParser subscribedParser(subscribed);
+    subscribedParser.setChecksumVerification(S7K_CHECKSUM_SUBSCRIBED);
+    subscribedParser.parse(filename);
+
+    REQUIRE(subscribedParser.getChecksumFailureCount() == 1);
+    REQUIRE(subscribed.swathSoundSpeeds.size() == 9);
+
+    S7kTestHandler never;
+    S7kParser neverParser(never);
+    neverParser.setChecksumVerification(S7K_CHECKSUM_NEVER);
+    neverParser.parse(filename);
+
+    REQUIRE(neverParser.getChecksumFailureCount() == 0);
+    REQUIRE(never.swathSoundSpeeds.size() == 10);
+
+    remove(filename.c_str());
+}
+
+TEST_CASE ("test that the S7k parser turns bathymetric data into pings when there are no raw detections")
+{
+    std::vector<unsigned char> file;
+
+    appendS7kBeamGeometry(file,50);
+
+    for(uint32_t ping=1;ping<=5;ping++){
+        appendS7kSonarSettings(file,ping,1480);
+        appendS7kBathymetry(file,ping,50,1490 + ping,false);
+    }
+
+    std::string filename("S7kParserTestBathymetry.s7k");
+    writeS7kFile(filename,file);
+
+    S7kTestHandler handler;
+    S7kParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.swathSoundSpeeds.size() == 5);
+
+    unsigned int p = 0;
+
+    for(uint32_t ping=1;ping<=5;ping++){
+        REQUIRE(handler.swathSoundSpeeds[ping - 1] == 1490 + ping);
+        REQUIRE(handler.swathPingCounts[ping - 1] == 45);
+
+        for(uint32_t i=0;i<50;i++){
+            if(i % 10 == 9){
+                continue;
+            }
+
+            REQUIRE(handler.ids[p] == i);
+            REQUIRE(handler.beamAngles[p] == Approx(((int)i - 25) / 100.0 * R2D).epsilon(1e-6));
+            REQUIRE(handler.tiltAngles[p] == Approx(i / 1000.0 * R2D).epsilon(1e-6));
+            REQUIRE(handler.twoWayTravelTimes[p] == Approx((i + 1) / 1000.0).epsilon(1e-6));
+            REQUIRE(handler.qualities[p] == 3);
+            p++;
+        }
+    }
+}
+
+TEST_CASE ("test that the S7k parser uses the bathymetric data optional beam angles without beam geometry")
+{
+    std::vector<unsigned char> file;
+    appendS7kBathymetry(file,1,40,1500,true);
+
+    //no beam geometry nor optional data: the ping is dropped
+    appendS7kBathymetry(file,2,40,1500,false);
+
+    std::string filename("S7kParserTestOptionalData.s7k");
+    writeS7kFile(filename,file);
+
+    S7kTestHandler handler;
+    S7kParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.swathSoundSpeeds.size() == 1);
+    REQUIRE(handler.swathPingCounts[0] == 36);
+
+    for(unsigned int p=0;p<handler.ids.size();p++){
+        double pointing = handler.ids[p] / 100.0;
+        double azimuth = handler.ids[p] / 10.0;
+
+        //the beam angles give back the pointing direction
+        Eigen::Vector3d beam;
+        CoordinateTransform::sonar2cartesian(beam,handler.tiltAngles[p],handler.beamAngles[p],1.0);
+
+        REQUIRE(beam(0) == Approx(sin(pointing) * cos(azimuth)).margin(1e-6));
+        REQUIRE(beam(1) == Approx(sin(pointing) * sin(azimuth)).margin(1e-6));
+        REQUIRE(beam(2) == Approx(cos(pointing)).margin(1e-6));
+    }
+}
+
+TEST_CASE ("test that the S7k parser prefers raw detections over bathymetric data")
+{
+    std::vector<unsigned char> file;
+
+    appendS7kBeamGeometry(file,10);
+
+    //bathymetric data before the raw detections of the same ping
+    appendS7kSonarSettings(file,1,1480);
+    appendS7kBathymetry(file,1,10,1490,false);
+    appendS7kRawDetection(file,1,10);
+
+    //and after
+    appendS7kSonarSettings(file,2,1480);
+    appendS7kRawDetection(file,2,10);
+    appendS7kBathymetry(file,2,10,1490,false);
+
+    std::string filename("S7kParserTestPreferRaw.s7k");
+    writeS7kFile(filename,file);
+
+    S7kTestHandler handler;
+    S7kParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.swathSoundSpeeds.size() == 2);
+    REQUIRE(handler.swathSoundSpeeds[0] == 1480);
+    REQUIRE(handler.swathSoundSpeeds[1] == 1480);
+    REQUIRE(handler.swathPingCounts[0] == 10);
+    REQUIRE(handler.swathPingCounts[1] == 10);
+}
+
+/**
+ * Simulates a file of 100 positions, one per second, each followed by a configuration record. With a catalog, the file
+ * starts with a file header and ends with the catalog of these 200 records
+ */
+void buildS7kCatalogTestFile(std::vector<unsigned char> & file,bool withCatalog){
+    uint32_t headerSize = sizeof(S7kDataRecordFrame) + sizeof(S7kFileHeader) + sizeof(S7kFileHeaderRecordDatum) + sizeof(S7kFileHeaderOptionalData) + sizeof(uint32_t);
+
+    std::vector<unsigned char> body;
+    std::vector<S7kFileCatalogRD> entries;
+
+    for(unsigned int i=0;i<100;i++){
+        S7kPosition position;
+        memset(&position,0,sizeof(S7kPosition));
+
+        unsigned char configuration[40] = {0};
+
+        S7kFileCatalogRD entry;
+        memset(&entry,0,sizeof(S7kFileCatalogRD));
+        entry.timestamp.Year = 2019;
+        entry.timestamp.Day = 120;
+        entry.timestamp.Hours = 12;
+        entry.timestamp.Minutes = 30;
+        entry.timestamp.Seconds = i;
+
+        entry.offset = (withCatalog ? headerSize : 0) + body.size();
+        entry.recordType = 1003;
+        appendS7kRecord(body,1003,&position,sizeof(S7kPosition),0,i);
+        entry.size = body.size() + (withCatalog ? headerSize : 0) - entry.offset;
+        entries.push_back(entry);
+
+        entry.offset = (withCatalog ? headerSize : 0) + body.size();
+        entry.recordType = 7001;
+        appendS7kRecord(body,7001,configuration,sizeof(configuration),0,i);
+        entry.size = body.size() + (withCatalog ? headerSize : 0) - entry.offset;
+        entries.push_back(entry);
+    }
+
+    file.clear();
+
+    if(withCatalog){
+        std::vector<unsigned char> header(sizeof(S7kFileHeader) + sizeof(S7kFileHeaderRecordDatum) + sizeof(S7kFileHeaderOptionalData),0);
+        ((S7kFileHeader *)&header[0])->NumberOfDevices = 1;
+
+        S7kFileHeaderOptionalData * catalogLocation = (S7kFileHeaderOptionalData *)&header[sizeof(S7kFileHeader) + sizeof(S7kFileHeaderRecordDatum)];
+        catalogLocation->Size = sizeof(S7kDataRecordFrame) + sizeof(S7kFileCatalogRTH) + entries.size() * sizeof(S7kFileCatalogRD) + sizeof(uint32_t);
+        catalogLocation->Offset = headerSize + body.size();
+
+        appendS7kRecord(file,7200,&header[0],header.size(),sizeof(S7kFileHeader) + sizeof(S7kFileHeaderRecordDatum));
+        REQUIRE(file.size() == headerSize);
+    }
+
+    file.insert(file.end(),body.begin(),body.end());
+
+    if(withCatalog){
+        std::vector<unsigned char> catalog(sizeof(S7kFileCatalogRTH) + entries.size() * sizeof(S7kFileCatalogRD));
+        S7kFileCatalogRTH * header = (S7kFileCatalogRTH *)&catalog[0];
+        header->size = sizeof(S7kFileCatalogRTH);
+        header->version = 1;
+        header->numberOfRecords = entries.size();
+        header->reserved = 0;
+        memcpy(&catalog[sizeof(S7kFileCatalogRTH)],&entries[0],entries.size() * sizeof(S7kFileCatalogRD));
+
+        appendS7kRecord(file,7300,&catalog[0],catalog.size());
+    }
+}
+
+TEST_CASE ("test that the S7k parser reads the file catalog")
+{
+    std::vector<unsigned char> file;
+    buildS7kCatalogTestFile(file,true);
+
+    std::string filename("S7kParserTestCatalog.s7k");
+    writeS7kFile(filename,file);
+
+    DatagramEventHandler handler;
+    S7kParser parser(handler);
+
+    REQUIRE(parser.readCatalog(filename));
+    REQUIRE(parser.getRecordCount() == 200);
+
+    for(unsigned int i=0;i<parser.getRecordCount();i++){
+        const S7kFileCatalogRD & entry = parser.getCatalog()[i];
+        S7kDataRecordFrame * drf = (S7kDataRecordFrame *)&file[entry.offset];
+
+        REQUIRE(drf->SyncPattern == SYNC_PATTERN);
+        REQUIRE(drf->RecordTypeIdentifier == entry.recordType);
+        REQUIRE(drf->Size == entry.size);
+    }
+
+    //a whole parse goes through every record
+    S7kTestHandler all;
+    S7kParser allParser(all);
+    allParser.parse(filename);
+
+    REQUIRE(all.positionTimestamps.size() == 100);
+
+    remove(filename.c_str());
+
+    //no catalog without a file header
+    buildS7kCatalogTestFile(file,false);
+    writeS7kFile(filename,file);
+
+    REQUIRE(!parser.readCatalog(filename));
+    REQUIRE(parser.getRecordCount() == 0);
+
+    remove(filename.c_str());
+}
+
+TEST_CASE ("test that the S7k parser filters records by type and time, with and without catalog")
+{
+    uint64_t start = TimeUtils::build_time(2019,120,12,30,10 * 1000000);
+    uint64_t end = TimeUtils::build_time(2019,120,12,30,19 * 1000000);
+
+    std::vector<uint32_t> positionsOnly(1,1003);
+
+    for(int withCatalog=0;withCatalog<2;withCatalog++){
+        std::vector<unsigned char> file;
+        buildS7kCatalogTestFile(file,withCatalog);
+
+        //with a catalog, a selective read never reaches the records filtered out: break the configuration records
+        if(withCatalog){
+            for(unsigned int offset=0;offset<file.size();){
+                S7kDataRecordFrame * drf = (S7kDataRecordFrame *)&file[offset];
+                offset += drf->Size;
+
+                if(drf->RecordTypeIdentifier == 7001){
+                    drf->SyncPattern = 0;
+                }
+            }
+        }
+
+        std::string filename("S7kParserTestFilter.s7k");
+        writeS7kFile(filename,file);
+
+        S7kTestHandler positions;
+        S7kParser positionsParser(positions);
+        positionsParser.setRecordTypeFilter(positionsOnly);
+        positionsParser.parse(filename);
+
+        REQUIRE(positions.positionTimestamps.size() == 100);
+
+        S7kTestHandler window;
+        S7kParser windowParser(window);
+        windowParser.setRecordTypeFilter(positionsOnly);
+        windowParser.setTimeWindow(start,end);
+        windowParser.parse(filename);
+
+        REQUIRE(window.positionTimestamps.size() == 10);
+        REQUIRE(window.positionTimestamps.front() == start);
+        REQUIRE(window.positionTimestamps.back() == end);
+
+        if(withCatalog){
+            S7kParser unfiltered(positions);
+            REQUIRE_THROWS(unfiltered.parse(filename));
+        }
+
+        remove(filename.c_str());
+    }
+}
+
+/**Appends a 7042 compressed water column record, beam i with 50 + 10 * i samples of magnitude (7 * i + j) % 200 and phase j % 100 - 50*/
+void appendS7kWaterColumn(std::vector<unsigned char> & file,uint32_t pingNumber,uint16_t beamCount,uint32_t flags){
+    bool magnitudeOnly = flags & S7K_WATERCOLUMN_MAGNITUDE_ONLY;
+    bool eightBit = flags & S7K_WATERCOLUMN_8_BIT;
+    bool segmentNumbers = flags & S7K_WATERCOLUMN_SEGMENT_NUMBERS;
+
+    std::vector<unsigned char> data(sizeof(S7kCompressedWaterColumnRTH),0);
+    S7kCompressedWaterColumnRTH * header = (S7kCompressedWaterColumnRTH *)&data[0];
+    header->pingNumber = pingNumber;
+    header->beams = beamCount;
+    header->flags = flags;
+    header->firstSample = 12;
+    header->sampleRate = 30000;
+
+    for(uint16_t i=0;i<beamCount;i++){
+        uint32_t sampleCount = 50 + 10 * i;
+
+        data.push_back(i & 0xFF);
+        data.push_back(i >> 8);
+
+        if(segmentNumbers){
+            data.push_back(1);
+        }
+
+        for(unsigned int b=0;b<4;b++){
+            data.push_back((sampleCount >> (8 * b)) & 0xFF);
+        }
+
+        for(uint32_t j=0;j<sampleCount;j++){
+            uint16_t magnitude = (7 * i + j) % 200;
+            int16_t phase = j % 100 - 50;
+
+            data.push_back(magnitude & 0xFF);
+
+            if(!eightBit){
+                data.push_back(magnitude >> 8);
+            }
+
+            if(!magnitudeOnly){
+                data.push_back(phase & 0xFF);
+
+                if(!eightBit){
+                    data.push_back((phase >> 8) & 0xFF);
+                }
+            }
+        }
+    }
+
+    appendS7kRecord(file,7042,&data[0],data.size());
+}
+
+/**Checks the water column pings decoded by a parser against appendS7kWaterColumn*/
+class S7kWaterColumnHandler : public DatagramEventHandler{
+public:
+    S7kWaterColumnHandler() : pingCount(0), largestCapacity(0), magnitudes(NULL) {}
+
+    void processWaterColumnData(WaterColumnPing & ping){
+        REQUIRE(ping.getFirstSample() == 12);
+        REQUIRE(ping.getSampleRate() == 30000);
+
+        for(unsigned int i=0;i<ping.getBeamCount();i++){
+            WaterColumnBeam & beam = ping.getBeam(i);
+
+            REQUIRE(beam.beamNumber == i);
+            REQUIRE(beam.sampleCount == 50 + 10 * i);
+
+            float * beamMagnitudes = ping.getMagnitudes(i);
+            float * beamPhases = ping.getPhases(i);
+
+            for(uint32_t j=0;j<beam.sampleCount;j++){
+                REQUIRE(beamMagnitudes[j] == (7 * i + j) % 200);
+
+                if(beamPhases){
+                    REQUIRE(beamPhases[j] == (int)(j % 100) - 50);
+                }
+            }
+        }
+
+        pingNumbers.push_back(ping.getPingNumber());
+        beamCounts.push_back(ping.getBeamCount());
+        strides.push_back(ping.getSampleStride());
+        decibels.push_back(ping.isDecibel());
+        phases.push_back(ping.hasPhase());
+        beamAngles.push_back(ping.getBeamCount() > 1 ? ping.getBeam(1).beamAngle : NAN);
+
+        //the same arrays, grown only by larger pings
+        if(ping.getBeamCount() > 0){
+            if(magnitudes && ping.getSampleCapacity() <= largestCapacity){
+                REQUIRE(ping.getMagnitudes(0) == magnitudes);
+            }
+
+            magnitudes = ping.getMagnitudes(0);
+            largestCapacity = std::max(largestCapacity,ping.getSampleCapacity());
+        }
+
+        pingCount++;
+    }
+
+    unsigned int pingCount;
+    uint64_t largestCapacity;
+    float * magnitudes;
+
+    std::vector<uint32_t> pingNumbers;
+    std::vector<unsigned int> beamCounts;
+    std::vector<unsigned int> strides;
+    std::vector<bool> decibels;
+    std::vector<bool> phases;
+    std::vector<double> beamAngles;
+};
+
+TEST_CASE ("test that the S7k parser decodes the compressed water column variants")
+{
+    std::vector<unsigned char> file;
+
+    //16 bit magnitudes and phases
+    appendS7kWaterColumn(file,1,20,0);
+
+    //magnitudes only
+    appendS7kWaterColumn(file,2,20,S7K_WATERCOLUMN_MAGNITUDE_ONLY);
+
+    //8 bit magnitudes and phases, with segment numbers
+    appendS7kWaterColumn(file,3,20,S7K_WATERCOLUMN_8_BIT | S7K_WATERCOLUMN_SEGMENT_NUMBERS);
+
+    //8 bit magnitudes only, downsampled by 4 (peak)
+    appendS7kWaterColumn(file,4,20,S7K_WATERCOLUMN_MAGNITUDE_ONLY | S7K_WATERCOLUMN_8_BIT | 0x0040 | 0x0200);
+
+    //after a beam geometry, smaller pings reuse the arrays
+    appendS7kBeamGeometry(file,20);
+
+    for(uint32_t ping=5;ping<=30;ping++){
+        appendS7kWaterColumn(file,ping,10 + ping % 7,S7K_WATERCOLUMN_MAGNITUDE_ONLY);
+    }
+
+    std::string filename("S7kParserTestWaterColumn.s7k");
+    writeS7kFile(filename,file);
+
+    S7kWaterColumnHandler handler;
+    S7kParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.pingCount == 30);
+
+    for(uint32_t ping=1;ping<=30;ping++){
+        REQUIRE(handler.pingNumbers[ping - 1] == ping);
+    }
+
+    REQUIRE(handler.beamCounts[0] == 20);
+    REQUIRE(handler.phases[0]);
+    REQUIRE(!handler.decibels[0]);
+    REQUIRE(!handler.phases[1]);
+    REQUIRE(handler.phases[2]);
+    REQUIRE(handler.decibels[2]);
+    REQUIRE(!handler.phases[3]);
+    REQUIRE(handler.decibels[3]);
+    REQUIRE(handler.strides[2] == 1);
+    REQUIRE(handler.strides[3] == 4);
+
+    REQUIRE(std::isnan(handler.beamAngles[0]));
+    REQUIRE(handler.beamAngles[4] == Approx((1 - 10) / 100.0 * R2D).epsilon(1e-6));
+
+    //one ping of memory: that of the largest ping
+    REQUIRE(handler.largestCapacity < 2 * 20 * (50 + 10 * 19));
+}
+
+/**
+ * Appends a 7028 snippet data or 7058 calibrated snippet data record. Beam i spans samples 100 + i to 120 + 2 * i,
+ * its detection at 110 + i. Sample j is 1000 * i + j, or i + j / 100 and its footprint j / 2 when calibrated
+ */
+void appendS7kSnippets(std::vector<unsigned char> & file,uint32_t pingNumber,uint16_t beamCount,bool calibrated,bool thirtyTwoBit,bool footprints){
+    unsigned int headerSize = calibrated ? sizeof(S7kCalibratedSnippetRTH) : sizeof(S7kSnippetRTH);
+    std::vector<unsigned char> data(headerSize + beamCount * sizeof(S7kSnippetRD),0);
+
+    if(calibrated){
+        S7kCalibratedSnippetRTH * header = (S7kCalibratedSnippetRTH *)&data[0];
+        header->pingNumber = pingNumber;
+        header->numberOfDetectionPoints = beamCount;
+        header->flags = footprints ? 1 : 0;
+    }
+    else{
+        S7kSnippetRTH * header = (S7kSnippetRTH *)&data[0];
+        header->pingNumber = pingNumber;
+        header->numberOfDetectionPoints = beamCount;
+        header->flags = thirtyTwoBit ? 1 : 0;
+    }
+
+    for(uint16_t i=0;i<beamCount;i++){
+        S7kSnippetRD * descriptor = (S7kSnippetRD *)&data[headerSize + i * sizeof(S7kSnippetRD)];
+        descriptor->beamDescriptor = i;
+        descriptor->snippetStart = 100 + i;
+        descriptor->detectionSample = 110 + i;
+        descriptor->snippetEnd = 120 + 2 * i;
+    }
+
+    for(unsigned int pass=0;pass<(footprints ? 2 : 1);pass++){
+        for(uint16_t i=0;i<beamCount;i++){
+            for(uint32_t j=0;j<21u + i;j++){
+                unsigned char bytes[4];
+
+                if(calibrated){
+                    float value = (pass == 0) ? i + j / 100.0f : j / 2.0f;
+                    memcpy(bytes,&value,4);
+                    data.insert(data.end(),bytes,bytes + 4);
+                }
+                else if(thirtyTwoBit){
+                    uint32_t value = 1000 * i + j;
+                    memcpy(bytes,&value,4);
+                    data.insert(data.end(),bytes,bytes + 4);
+                }
+                else{
+                    uint16_t value = 1000 * i + j;
+                    memcpy(bytes,&value,2);
+                    data.insert(data.end(),bytes,bytes + 2);
+                }
+            }
+        }
+    }
+
+    appendS7kRecord(file,calibrated ? 7058 : 7028,&data[0],data.size());
+}
+
+/**Checks the snippet pings decoded by a parser against appendS7kSnippets*/
+class S7kSnippetHandler : public DatagramEventHandler{
+public:
+    void processSnippetData(SnippetPing & ping){
+        unsigned int sampleSize = ping.getSampleType() == SNIPPET_UINT16 ? 2 : 4;
+
+        for(unsigned int i=0;i<ping.getBeamCount();i++){
+            SnippetBeam & beam = ping.getBeam(i);
+
+            REQUIRE(beam.beamNumber == i);
+            REQUIRE(beam.firstSample == 100 + i);
+            REQUIRE(beam.detectionSample == 110 + i);
+            REQUIRE(beam.sampleCount == 21 + i);
+
+            //the samples are those of the datagram, one beam after the other
+            if(i > 0){
+                REQUIRE((const unsigned char *)beam.samples == (const unsigned char *)ping.getBeam(i - 1).samples + ping.getBeam(i - 1).sampleCount * sampleSize);
+            }
+
+            for(uint32_t j=0;j<beam.sampleCount;j++){
+                if(ping.isCalibrated()){
+                    REQUIRE(ping.getSamples<float>(i)[j] == i + j / 100.0f);
+                }
+                else if(ping.getSampleType() == SNIPPET_UINT32){
+                    REQUIRE(ping.getSamples<uint32_t>(i)[j] == 1000 * i + j);
+                }
+                else{
+                    REQUIRE(ping.getSamples<uint16_t>(i)[j] == 1000 * i + j);
+                }
+
+                if(beam.footprints){
+                    REQUIRE(beam.footprints[j] == j / 2.0f);
+                }
+            }
+        }
+
+        pingNumbers.push_back(ping.getPingNumber());
+        sampleTypes.push_back(ping.getSampleType());
+        calibrated.push_back(ping.isCalibrated());
+        footprints.push_back(ping.getBeamCount() > 0 && ping.getBeam(0).footprints != NULL);
+        lastSamples.push_back(ping.getBeamCount() > 0 ? ping.getSample(ping.getBeamCount() - 1,0) : NAN);
+    }
+
+    std::vector<uint32_t> pingNumbers;
+    std::vector<SnippetSampleType> sampleTypes;
+    std::vector<bool> calibrated;
+    std::vector<bool> footprints;
+    std::vector<double> lastSamples;
+};
+
+TEST_CASE ("test that the S7k parser decodes snippets without copying their samples")
+{
+    std::vector<unsigned char> file;
+
+    appendS7kSnippets(file,1,30,false,false,false);
+    appendS7kSnippets(file,2,30,false,true,false);
+    appendS7kSnippets(file,3,30,true,false,false);
+    appendS7kSnippets(file,4,30,true,false,true);
+
+    std::string filename("S7kParserTestSnippets.s7k");
+    writeS7kFile(filename,file);
+
+    S7kSnippetHandler handler;
+    S7kParser parser(handler);
+    parser.parse(filename);
+    remove(filename.c_str());
+
+    REQUIRE(handler.pingNumbers.size() == 4);
+    REQUIRE(handler.pingNumbers[3] == 4);
+
+    REQUIRE(handler.sampleTypes[0] == SNIPPET_UINT16);
+    REQUIRE(handler.sampleTypes[1] == SNIPPET_UINT32);
+    REQUIRE(handler.sampleTypes[2] == SNIPPET_FLOAT32);
+    REQUIRE(!handler.calibrated[1]);
+    REQUIRE(handler.calibrated[2]);
+    REQUIRE(!handler.footprints[2]);
+    REQUIRE(handler.footprints[3]);
+
+    REQUIRE(handler.lastSamples[0] == 29000);
+    REQUIRE(handler.lastSamples[1] == 29000);
+    REQUIRE(handler.lastSamples[2] == Approx(29));
+}
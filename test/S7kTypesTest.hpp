@@ -22,6 +22,8 @@ TEST_CASE( "Les structs S7k ont la bonne dimensions", "[xtfTypes]" ) {
     REQUIRE( sizeof(S7kFileHeader) == 316 );
     REQUIRE( sizeof(S7kFileHeaderRecordDatum) == 6 );
     REQUIRE( sizeof(S7kFileHeaderOptionalData) == 12 );
+    REQUIRE( sizeof(S7kFileCatalogRTH) == 14 );
+    REQUIRE( sizeof(S7kFileCatalogRD) == 48 );
     REQUIRE( sizeof(S7kPosition) == 37 );
     REQUIRE( sizeof(S7kDepth) == 8 );
     REQUIRE( sizeof(S7kNavigation) == 41 );
@@ -30,6 +32,14 @@ TEST_CASE( "Les structs S7k ont la bonne dimensions", "[xtfTypes]" ) {
     REQUIRE( sizeof(S7kRawDetectionDataRTH) == 99 );
     REQUIRE( sizeof(S7kRawDetectionDataRD) == 26 );
     REQUIRE( sizeof(S7kSonarSettings) == 156 );
+    REQUIRE( sizeof(S7kBeamGeometryRTH) == 12 );
+    REQUIRE( sizeof(S7kBathymetricDataRTH) == 24 );
+    REQUIRE( sizeof(S7kBathymetricDataOD) == 45 );
+    REQUIRE( sizeof(S7kBathymetricDataODRD) == 20 );
+    REQUIRE( sizeof(S7kCompressedWaterColumnRTH) == 44 );
+    REQUIRE( sizeof(S7kSnippetRTH) == 46 );
+    REQUIRE( sizeof(S7kSnippetRD) == 14 );
+    REQUIRE( sizeof(S7kCalibratedSnippetRTH) == 49 );
     REQUIRE( sizeof(S7kSoundVelocity) == 12 );
     REQUIRE( sizeof(S7kCtdRTH) == 36 );
     REQUIRE( sizeof(S7kCtdRD) == 20 );
@@ -0,0 +1,128 @@
+/*
+ * File:   TiledGridTest.hpp
+ *
+ * Tests the tiled bathymetric grid
+ */
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <fstream>
+#include <string>
+#include "../src/gridding/TiledGrid.hpp"
+#include "catch.hpp"
+
+#ifdef _WIN32
+static std::string gridTestDirectory("gridTest");
+#else
+static std::string gridTestDirectory("build/test/gridTest");
+#endif
+
+/**Soundings spread over several tiles, on both sides of the origin*/
+static void makeGridSoundings(std::vector<double> & eastings,std::vector<double> & northings,std::vector<double> & depths,unsigned int count,unsigned int seed){
+    srand(seed);
+
+    for(unsigned int i=0;i<count;i++){
+        eastings.push_back(((double)rand() / RAND_MAX) * 1200 - 600);
+        northings.push_back(((double)rand() / RAND_MAX) * 700 - 200);
+        depths.push_back(20 + ((double)rand() / RAND_MAX) * 5);
+    }
+}
+
+TEST_CASE("Test that the tiled grid statistics match a direct computation, with tiles spilled to disk")
+{
+    system(("rm -rf " + gridTestDirectory).c_str());
+
+    std::vector<double> eastings,northings,depths;
+    makeGridSoundings(eastings,northings,depths,20000,1);
+
+    //two lines added separately, the second one after reopening the grid
+    {
+        TiledGrid grid(gridTestDirectory,2.0,2,3);
+        grid.addSoundings(&eastings[0],&northings[0],&depths[0],10000);
+        REQUIRE(grid.getTilesInMemory() <= 2);
+    }
+
+    {
+        TiledGrid grid(gridTestDirectory,2.0,2,3);
+        grid.addSoundings(&eastings[10000],&northings[10000],&depths[10000],10000);
+        REQUIRE(grid.getTileCount() == 8);
+    }
+
+    TiledGrid grid(gridTestDirectory,2.0,3);
+
+    for(unsigned int i=0;i<200;i++){
+        double easting = eastings[i];
+        double northing = northings[i];
+
+        unsigned int count = 0;
+        double sum = 0;
+        double minimum = 1e9;
+        double maximum = -1e9;
+
+        for(unsigned int j=0;j<eastings.size();j++){
+            if(std::floor(eastings[j] / 2.0) == std::floor(easting / 2.0) && std::floor(northings[j] / 2.0) == std::floor(northing / 2.0)){
+                count++;
+                sum += depths[j];
+                minimum = std::min(minimum,depths[j]);
+                maximum = std::max(maximum,depths[j]);
+            }
+        }
+
+        GridCell cell = grid.getCell(easting,northing);
+        REQUIRE(cell.count == count);
+        REQUIRE(std::fabs(TiledGrid::getStatistic(cell,GRID_MEAN) - sum / count) < 1e-9);
+        REQUIRE(TiledGrid::getStatistic(cell,GRID_MINIMUM) == minimum);
+        REQUIRE(TiledGrid::getStatistic(cell,GRID_MAXIMUM) == maximum);
+    }
+
+    REQUIRE(grid.getCell(1e6,1e6).count == 0);
+}
+
+TEST_CASE("Test the tiled grid ESRI exports")
+{
+    system(("rm -rf " + gridTestDirectory).c_str());
+
+    TiledGrid grid(gridTestDirectory,1.0);
+
+    double eastings[] = {0.5,0.5,-0.5,300.5};
+    double northings[] = {0.5,0.5,-0.5,0.5};
+    double depths[] = {10,12,5,7};
+    grid.addSoundings(eastings,northings,depths,4);
+
+    std::string asciiFilename = gridTestDirectory + "/dem.asc";
+    grid.writeEsriAscii(asciiFilename,GRID_MEAN);
+
+    std::ifstream ascii(asciiFilename.c_str());
+    std::string key;
+    double value;
+
+    ascii >> key >> value;
+    REQUIRE(key == "ncols");
+    REQUIRE(value == 3 * TiledGrid::TILE_SIZE);
+    ascii >> key >> value;
+    REQUIRE(key == "nrows");
+    REQUIRE(value == 2 * TiledGrid::TILE_SIZE);
+    ascii >> key >> value;
+    REQUIRE(key == "xllcorner");
+    REQUIRE(value == -TiledGrid::TILE_SIZE);
+    ascii >> key >> value;
+    REQUIRE(key == "yllcorner");
+    REQUIRE(value == -TiledGrid::TILE_SIZE);
+
+    grid.writeEsriBinary(gridTestDirectory + "/dem",GRID_COUNT);
+
+    std::ifstream binary((gridTestDirectory + "/dem.flt").c_str(),std::ios::binary);
+    std::vector<float> raster(6 * TiledGrid::TILE_SIZE * TiledGrid::TILE_SIZE);
+    binary.read((char *)&raster[0],raster.size() * sizeof(float));
+    REQUIRE(binary);
+
+    //rows go from north to south: the cell north-east of the origin is on the last row of the northern tiles
+    unsigned int columns = 3 * TiledGrid::TILE_SIZE;
+    unsigned int originRow = TiledGrid::TILE_SIZE - 1;
+    unsigned int originColumn = TiledGrid::TILE_SIZE;
+
+    REQUIRE(raster[originRow * columns + originColumn] == 2);
+    REQUIRE(raster[(originRow + 1) * columns + originColumn - 1] == 1);
+    REQUIRE(raster[originRow * columns + originColumn + 300] == 1);
+    REQUIRE(raster[0] == GRID_NODATA);
+}
@@ -0,0 +1,103 @@
+/*
+ * File:   TotalPropagatedUncertaintyTest.hpp
+ *
+ * Tests the total propagated uncertainty of the soundings
+ */
+#include <cmath>
+#include <vector>
+#include "../src/math/TotalPropagatedUncertainty.hpp"
+#include "../src/SurveySystem.hpp"
+#include "catch.hpp"
+
+TEST_CASE("Test the total propagated uncertainty of a level swath")
+{
+    //2 sigma accuracies
+    TotalPropagatedUncertainty tpu(0.2,0.3,0.1,0.2,0.4,3.0);
+    Attitude level(0,0,0,0);
+
+    double roll = 0.05 * D2R;
+    double pitch = 0.1 * D2R;
+    double heading = 0.2 * D2R;
+    double soundSpeed = 1.5 / 1500;
+
+    double north[] = {0,0};
+    double east[] = {0,30};
+    double down[] = {20,20};
+    double horizontal[2];
+    double vertical[2];
+
+    tpu.computeSwath(level,1500,north,east,down,2,horizontal,vertical);
+
+    //nadir: roll and pitch only move the sounding horizontally
+    REQUIRE(std::fabs(vertical[0] - 2 * std::sqrt(0.15 * 0.15 + std::pow(20 * soundSpeed,2))) < 1e-12);
+    REQUIRE(std::fabs(horizontal[0] - 2 * std::sqrt(0.1 * 0.1 + std::pow(20 * roll,2) + std::pow(20 * pitch,2))) < 1e-12);
+
+    //across track: roll moves the sounding vertically, heading and sound speed stretch it horizontally
+    REQUIRE(std::fabs(vertical[1] - 2 * std::sqrt(0.15 * 0.15 + std::pow(30 * roll,2) + std::pow(20 * soundSpeed,2))) < 1e-12);
+    REQUIRE(std::fabs(horizontal[1] - 2 * std::sqrt(0.1 * 0.1 + std::pow(20 * roll,2) + std::pow(20 * pitch,2) + std::pow(30 * heading,2) + std::pow(30 * soundSpeed,2))) < 1e-12);
+}
+
+TEST_CASE("Test that the total propagated uncertainty follows the heading and does not depend on the batch")
+{
+    TotalPropagatedUncertainty tpu(0.2,0.3,0.1,0.2,0.4,3.0);
+
+    std::vector<double> north,east,down;
+
+    for(unsigned int i=0;i<7;i++){
+        north.push_back(-3.0 + i);
+        east.push_back(-60.0 + 20 * i);
+        down.push_back(20.0 + i);
+    }
+
+    Attitude attitude(0,2,-1,0);
+    std::vector<double> horizontal(7),vertical(7);
+    tpu.computeSwath(attitude,1480,&north[0],&east[0],&down[0],7,&horizontal[0],&vertical[0]);
+
+    //the same swath, turned by 90 degrees with the vessel
+    Attitude turned(0,2,-1,90);
+    std::vector<double> turnedNorth(7),turnedEast(7);
+
+    for(unsigned int i=0;i<7;i++){
+        turnedNorth[i] = -east[i];
+        turnedEast[i] = north[i];
+    }
+
+    std::vector<double> turnedHorizontal(7),turnedVertical(7);
+    tpu.computeSwath(turned,1480,&turnedNorth[0],&turnedEast[0],&down[0],7,&turnedHorizontal[0],&turnedVertical[0]);
+
+    for(unsigned int i=0;i<7;i++){
+        REQUIRE(std::fabs(turnedHorizontal[i] - horizontal[i]) < 1e-9);
+        REQUIRE(std::fabs(turnedVertical[i] - vertical[i]) < 1e-9);
+
+        //one beam at a time goes through the scalar path
+        double singleHorizontal,singleVertical;
+        tpu.computeSwath(attitude,1480,&north[i],&east[i],&down[i],1,&singleHorizontal,&singleVertical);
+        REQUIRE(std::fabs(singleHorizontal - horizontal[i]) < 1e-12);
+        REQUIRE(std::fabs(singleVertical - vertical[i]) < 1e-12);
+    }
+
+    //outer beams are less accurate
+    REQUIRE(vertical[0] > vertical[3]);
+    REQUIRE(horizontal[6] > horizontal[3]);
+}
+
+TEST_CASE("Test the total propagated uncertainty from a survey system file")
+{
+    SurveySystem system;
+    REQUIRE_THROWS(TotalPropagatedUncertainty(system));
+
+    REQUIRE(system.readFile("test/data/metadata/TestMetaData.txt"));
+    REQUIRE(system.getSoundSpeedAccuracy() == 0);
+
+    TotalPropagatedUncertainty tpu(system);
+    Attitude level(0,0,0,0);
+
+    double north = 0;
+    double east = 0;
+    double down = 20;
+    double horizontal,vertical;
+    tpu.computeSwath(level,1500,&north,&east,&down,1,&horizontal,&vertical);
+
+    REQUIRE(std::fabs(vertical - system.getPositionAccuracy()(2)) < 1e-12);
+    REQUIRE(horizontal > system.getPositionAccuracy()(0));
+}
@@ -13,9 +13,21 @@
 #include "KongsbergTypesTest.hpp"
 #include "S7kTypesTest.hpp"
 #include "StringUtilsTest.hpp"
+#include "ByteSumTest.hpp"
 #include "InterpolationTest.hpp"
 #include "RaytracingTest.hpp"
 #include "GeoreferencingTest.hpp"
 #include "TimeUtilsTest.hpp"
 #include "CarisSvpTest.hpp"
 #include "SvpStrategyTest.hpp"
+#include "FloatFormatterTest.hpp"
+#include "TiledGridTest.hpp"
+#include "HypothesisSurfaceTest.hpp"
+#include "TotalPropagatedUncertaintyTest.hpp"
+#include "OctreeTest.hpp"
+#include "PreparedPolygonTest.hpp"
+#include "ConvexHullTest.hpp"
+#include "MultiLineOverlapTest.hpp"
+#include "OverlapStatisticsTest.hpp"
+#include "DatagramGeoreferencerTest.hpp"
+#include "BoresightCalibratorTest.hpp"